@@ -0,0 +1,128 @@
+// Measures ParallelCsvParser throughput on a generated CSV file.
+//
+//   csv_parser_benchmark [size-in-MB] [file]
+//
+// Generates the file (4096 MB by default, in the temp directory) unless it already
+// exists, then parses it single-threaded and on all cores and reports GB/s.
+
+#include "core/parallel_csv_parser.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QRandomGenerator>
+#include <QThread>
+#include <cstdio>
+
+namespace {
+constexpr qint64 kMegabyte = 1024 * 1024;
+
+bool generate(const QString &filePath, qint64 targetBytes) {
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        std::fprintf(stderr, "Could not create %s: %s\n", qPrintable(filePath), qPrintable(file.errorString()));
+        return false;
+    }
+
+    QRandomGenerator random(42);
+    QByteArray buffer;
+    buffer.reserve(int(8 * kMegabyte));
+    buffer.append("id,price,name,comment,created_at,active\n");
+
+    qint64 written = 0;
+    for (qint64 id = 1; written < targetBytes; ++id) {
+        buffer.append(QByteArray::number(id)).append(',');
+        buffer.append(QByteArray::number(random.bounded(100000) / 100.0, 'f', 2)).append(',');
+        buffer.append("customer_").append(QByteArray::number(random.bounded(1000000))).append(',');
+        // Every few rows a quoted comment with delimiters, doubled quotes and a line break
+        switch (random.bounded(8)) {
+            case 0:
+                buffer.append("\"said \"\"hello, world\"\"\nand left\"");
+                break;
+            case 1:
+                buffer.append("\"a, b, c\"");
+                break;
+            case 2:
+                break;
+            default:
+                buffer.append("plain comment text");
+                break;
+        }
+        buffer.append(',');
+        buffer.append(QString("2024-%1-%2 %3:%4:%5")
+                          .arg(random.bounded(1, 13), 2, 10, QLatin1Char('0'))
+                          .arg(random.bounded(1, 29), 2, 10, QLatin1Char('0'))
+                          .arg(random.bounded(24), 2, 10, QLatin1Char('0'))
+                          .arg(random.bounded(60), 2, 10, QLatin1Char('0'))
+                          .arg(random.bounded(60), 2, 10, QLatin1Char('0'))
+                          .toLatin1());
+        buffer.append(random.bounded(2) ? ",true\n" : ",false\n");
+
+        if (buffer.size() >= 8 * kMegabyte) {
+            written += file.write(buffer);
+            buffer.resize(0);
+        }
+    }
+    written += file.write(buffer);
+    return file.error() == QFileDevice::NoError;
+}
+
+void run(const QString &filePath, int threads) {
+    ParallelCsvParser::Options options;
+    options.threads = threads;
+
+    QElapsedTimer timer;
+    timer.start();
+    ParallelCsvParser parser;
+    QString error;
+    if (!parser.open(filePath, options, &error)) {
+        std::fprintf(stderr, "%s\n", qPrintable(error));
+        return;
+    }
+    const qint64 openMs = timer.elapsed();
+
+    qint64 rows = 0;
+    parser.parse([&rows](CsvBatch &&batch) {
+        rows += batch.rowCount;
+        return true;
+    });
+    const qint64 totalMs = qMax<qint64>(1, timer.elapsed());
+
+    const double gigabytes = double(parser.getFileSize()) / (1024.0 * 1024.0 * 1024.0);
+    std::printf("%3d thread(s): %lld rows in %lld ms (open %lld ms, %d chunks) - %.2f GB/s\n",
+                threads, static_cast<long long>(rows), static_cast<long long>(totalMs),
+                static_cast<long long>(openMs), parser.getChunkCount(), gigabytes * 1000.0 / totalMs);
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    const QStringList args = app.arguments();
+
+    const qint64 sizeMb = args.size() > 1 ? args.at(1).toLongLong() : 4096;
+    const QString filePath = args.size() > 2 ? args.at(2)
+                                             : QDir::temp().filePath("dbclient_csv_benchmark.csv");
+
+    if (!QFileInfo::exists(filePath)) {
+        std::printf("Generating %lld MB into %s...\n", static_cast<long long>(sizeMb), qPrintable(filePath));
+        if (!generate(filePath, sizeMb * kMegabyte)) {
+            return 1;
+        }
+    }
+
+    ParallelCsvParser::Options defaults;
+    ParallelCsvParser inspector;
+    QString error;
+    if (inspector.open(filePath, defaults, &error)) {
+        const QStringList names = inspector.getColumnNames();
+        const QVector<CsvColumnType> types = inspector.getColumnTypes();
+        for (int i = 0; i < names.size(); ++i) {
+            std::printf("  %s: %s\n", qPrintable(names.at(i)), qPrintable(ParallelCsvParser::typeName(types.at(i))));
+        }
+    }
+
+    run(filePath, 1);
+    run(filePath, QThread::idealThreadCount());
+    return 0;
+}
@@ -0,0 +1,39 @@
+#ifndef ARROW_IO_H
+#define ARROW_IO_H
+
+#include <QString>
+#include <QFuture>
+#include "core/query_executor.h"
+#include "core/transfer_progress.h"
+
+// Apache Arrow IPC file (Feather v2) export and import. Exports stream a
+// forward-only query into record batches as rows arrive (on MySQL the driver has
+// buffered the whole result by then); imports memory-map the file and insert one
+// record batch per transaction, binding whole columns at once.
+// Requires building with Arrow (HAVE_ARROW); otherwise every call fails cleanly.
+class ArrowIO {
+public:
+    static constexpr int kBatchRows = 65536;
+
+    static bool isAvailable();
+    // .arrow, .feather or .ipc
+    static bool isArrowPath(const QString &filePath);
+
+    static QFuture<QueryResult> startExport(const ConnectionInfo &connInfo, const QString &query,
+                                            const QString &filePath, const TransferProgressPtr &progress,
+                                            const CancelTokenPtr &token);
+    static QueryResult exportQuery(const ConnectionInfo &connInfo, const QString &query,
+                                   const QString &filePath, const TransferProgressPtr &progress,
+                                   const CancelTokenPtr &token);
+
+    // Appends the file's rows to tableName, creating the table from the Arrow schema
+    // if it doesn't exist
+    static QFuture<QueryResult> startImport(const ConnectionInfo &connInfo, DatabaseType dialect,
+                                            const QString &filePath, const QString &tableName,
+                                            const TransferProgressPtr &progress, const CancelTokenPtr &token);
+    static QueryResult importFile(const ConnectionInfo &connInfo, DatabaseType dialect,
+                                  const QString &filePath, const QString &tableName,
+                                  const TransferProgressPtr &progress, const CancelTokenPtr &token);
+};
+
+#endif // ARROW_IO_H
@@ -0,0 +1,65 @@
+#ifndef BOUNDED_QUEUE_H
+#define BOUNDED_QUEUE_H
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QQueue>
+#include <QWaitCondition>
+
+// Fixed-capacity, thread-safe FIFO used between pipeline stages. push() blocks while
+// the queue is full, which is what gives producers backpressure against a slower
+// consumer. close() wakes everyone up: further pushes fail and pop() drains what is
+// left before returning false.
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(int capacity) : capacity(qMax(1, capacity)) {}
+
+    bool push(T item) {
+        QMutexLocker locker(&mutex);
+        while (items.size() >= capacity && !closed) {
+            notFull.wait(&mutex);
+        }
+        if (closed) {
+            return false;
+        }
+        items.enqueue(std::move(item));
+        notEmpty.wakeOne();
+        return true;
+    }
+
+    bool pop(T &item) {
+        QMutexLocker locker(&mutex);
+        while (items.isEmpty() && !closed) {
+            notEmpty.wait(&mutex);
+        }
+        if (items.isEmpty()) {
+            return false;
+        }
+        item = items.dequeue();
+        notFull.wakeOne();
+        return true;
+    }
+
+    void close() {
+        QMutexLocker locker(&mutex);
+        closed = true;
+        notEmpty.wakeAll();
+        notFull.wakeAll();
+    }
+
+    bool isClosed() const {
+        QMutexLocker locker(&mutex);
+        return closed;
+    }
+
+private:
+    mutable QMutex mutex;
+    QWaitCondition notEmpty;
+    QWaitCondition notFull;
+    QQueue<T> items;
+    const int capacity;
+    bool closed = false;
+};
+
+#endif // BOUNDED_QUEUE_H
@@ -0,0 +1,62 @@
+#ifndef BULK_WRITER_H
+#define BULK_WRITER_H
+
+#include <QSqlDatabase>
+#include <QString>
+#include <QStringList>
+#include <QVariantList>
+#include <memory>
+#include "database/database_connection.h"
+#include "core/query_executor.h"
+
+// One row of values in target column order; null or invalid variants become NULL
+using BulkRow = QVariantList;
+
+// Loads rows into a table through the fastest path a backend offers:
+// COPY ... FROM STDIN on PostgreSQL (when built with libpq), batched LOAD DATA LOCAL
+// INFILE on MySQL, and one reused prepared INSERT per transaction on SQLite. Anything
+// else, and MySQL servers that refuse LOAD DATA LOCAL, falls back to multi-row INSERT
+// statements with literal values.
+// A writer is bound to the session it was created with and must stay on that thread.
+class BulkWriter {
+public:
+    BulkWriter(QSqlDatabase db, DatabaseType type, const QString &tableName, const QStringList &columns);
+    virtual ~BulkWriter() = default;
+
+    virtual bool begin(QString *errorMessage) = 0;
+    // Writes one batch; each call is committed before it returns (COPY commits at finish)
+    virtual bool writeRows(const QList<BulkRow> &rows, QString *errorMessage) = 0;
+    // Makes every row written so far durable, for callers that checkpoint progress.
+    // Only COPY needs to end its stream and start a new one.
+    virtual bool commit(QString *errorMessage);
+    virtual bool finish(QString *errorMessage) = 0;
+    virtual void abort() = 0;
+
+    // Short description of the load path, for status messages
+    virtual QString method() const = 0;
+    // False when rows only become durable at commit() or finish(), so a failed load
+    // leaves nothing behind
+    virtual bool commitsEachBatch() const { return true; }
+
+    static std::unique_ptr<BulkWriter> create(QSqlDatabase db, DatabaseType type, const QString &tableName,
+                                              const QStringList &columns);
+
+    // Session settings the bulk paths need (MySQL must allow LOCAL INFILE). Use the
+    // returned info to open the session passed to create().
+    static ConnectionInfo bulkConnectionInfo(const ConnectionInfo &connInfo, DatabaseType type);
+
+    // Runs a COPY ... FROM STDIN statement with the text-format rows that go with it,
+    // as a script carries them. Needs PostgreSQL and a build with libpq.
+    static bool copyFromStdin(QSqlDatabase db, const QByteArray &statement, const QByteArray &rows,
+                              QString *errorMessage);
+
+protected:
+    QString columnList() const;
+
+    QSqlDatabase db;
+    DatabaseType type;
+    QString target;  // quoted, qualified table name
+    QStringList columns;
+};
+
+#endif // BULK_WRITER_H
@@ -0,0 +1,43 @@
+#ifndef CATALOG_CACHE_H
+#define CATALOG_CACHE_H
+
+#include <QHash>
+#include <QList>
+#include <QSqlDatabase>
+#include <QString>
+#include <QStringList>
+#include "database/database_connection.h"
+
+// Catalog snapshots of every saved connection, one per schema, kept in
+// catalog_cache.db next to connections.db so the tree can be drawn before the
+// server has answered. Each snapshot carries the version string the server
+// reported when it was fetched; DatabaseConnection::revalidateCatalog compares
+// those to refetch only the schemas that changed. Safe to call from worker threads.
+class CatalogCache {
+public:
+    static CatalogCache& instance();
+
+    bool initialize();
+
+    // Snapshots of the connection keyed by schema; empty when nothing is cached
+    QHash<QString, CatalogSnapshot> load(const QString &connection);
+    // Replaces the changed snapshots and deletes the dropped schemas in one transaction
+    bool store(const QString &connection, const QList<CatalogSnapshot> &changed, const QStringList &dropped);
+    bool remove(const QString &connection);
+
+private:
+    CatalogCache() = default;
+    ~CatalogCache() = default;
+    CatalogCache(const CatalogCache&) = delete;
+    CatalogCache& operator=(const CatalogCache&) = delete;
+
+    QSqlDatabase threadCacheDatabase();
+
+    // Bumped whenever the payload layout changes; older payloads are discarded
+    static constexpr qint32 kPayloadFormat = 3;
+
+    QSqlDatabase cacheDb;
+    const QString CACHE_DB_NAME = "catalog_cache";
+};
+
+#endif // CATALOG_CACHE_H
@@ -0,0 +1,70 @@
+#ifndef CHUNKED_SCAN_H
+#define CHUNKED_SCAN_H
+
+#include <QList>
+#include <QSqlDatabase>
+#include <QSqlRecord>
+#include <QString>
+#include <QStringList>
+#include <functional>
+#include "core/query_executor.h"
+
+struct ChunkedScanOptions {
+    QString table;             // optionally schema-qualified
+    QString keyColumn;         // range-partitioned column; one chunk when empty
+    QStringList columns;       // all columns when empty
+    QString filter;            // extra predicate ANDed to every chunk
+    int concurrency = 4;       // sessions fetching at once
+    int chunksPerSession = 4;  // more chunks than sessions evens out skewed ranges
+    bool ordered = true;       // deliver in key order
+    int batchRows = 2000;
+    // HighPrecision keeps DECIMAL/NUMERIC values as exact text instead of doubles
+    QSql::NumericalPrecisionPolicy precision = QSql::LowPrecisionDouble;
+};
+
+// Reads a whole table through several sessions at once. plan() cuts the key space
+// into ranges at the planner's histogram bounds when the catalog has them, else at
+// even steps between MIN and MAX of a numeric key. run() fetches up to concurrency
+// ranges in parallel, each on its own pooled session, and hands the record batches
+// to the consumer on the calling thread. Ordered scans deliver ranges one after
+// another in key order while later ranges are already fetching into bounded queues;
+// unordered ones deliver batches as they arrive.
+//
+// All sessions read one snapshot where the backend can share it, so the ranges add
+// up to the table as of a single moment (see run()), and cancelling the token
+// interrupts the statements running on the server.
+class ChunkedScan {
+public:
+    static constexpr int kQueueBatches = 4;
+
+    // Return false to stop the scan
+    using BatchConsumer = std::function<bool(QList<QSqlRecord> &&)>;
+
+    ChunkedScan(const ConnectionInfo &connInfo, DatabaseType type, const ChunkedScanOptions &options);
+
+    // Single-column primary key of table, or empty when there is none
+    static QString keyColumn(QSqlDatabase db, const QString &table);
+
+    // Reads the layout and key ranges through db, a session on the same connection
+    bool plan(QSqlDatabase db, QString *errorMessage = nullptr);
+
+    QStringList getColumnNames() const { return columnNames; }
+    int getChunkCount() const { return conditions.size(); }
+
+    // Holds a transaction (PostgreSQL) or a brief table lock (MySQL) on the calling
+    // thread's session for connInfo while the sessions take their snapshots, so don't
+    // call it with a transaction open there. Sets token's cancel handler.
+    bool run(const BatchConsumer &consumer, const CancelTokenPtr &token, QString *errorMessage = nullptr);
+
+private:
+    QStringList keyBounds(QSqlDatabase db, QMetaType keyType, int chunkCount) const;
+    QString chunkQuery(int chunk) const;
+
+    ConnectionInfo connInfo;
+    DatabaseType type;
+    ChunkedScanOptions options;
+    QStringList columnNames;
+    QStringList conditions;  // one WHERE predicate per key range
+};
+
+#endif // CHUNKED_SCAN_H
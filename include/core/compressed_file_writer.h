@@ -0,0 +1,55 @@
+#ifndef COMPRESSED_FILE_WRITER_H
+#define COMPRESSED_FILE_WRITER_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <memory>
+
+enum class Compression {
+    None,
+    Gzip,
+    Zstd
+};
+
+// Buffered file writer with optional streaming gzip/zstd compression. Input is
+// collected into a fixed-size buffer and compressed a buffer at a time, so memory use
+// doesn't depend on how much is written. Not thread-safe; owned by a single writer.
+class CompressedFileWriter {
+public:
+    static constexpr int kBufferBytes = 1 << 20;
+
+    CompressedFileWriter();
+    ~CompressedFileWriter();
+
+    bool open(const QString &filePath, Compression compression, QString *errorMessage = nullptr);
+    bool write(const QByteArray &data, QString *errorMessage = nullptr);
+    // Flushes buffered data, finishes the compressed stream and closes the file
+    bool close(QString *errorMessage = nullptr);
+
+    // Uncompressed bytes accepted / bytes written to disk so far
+    qint64 getBytesIn() const { return bytesIn; }
+    qint64 getBytesOut() const { return bytesOut; }
+
+    // Whether support for compression was compiled in
+    static bool isAvailable(Compression compression);
+    // Picks the compression from a ".gz" / ".zst" suffix
+    static Compression compressionForPath(const QString &filePath);
+    // File path with the compression suffix removed, for format detection
+    static QString stripCompressionSuffix(const QString &filePath);
+
+private:
+    struct Codec;
+
+    bool flushBuffer(bool finish, QString *errorMessage);
+    bool writeOut(const char *data, qint64 size, QString *errorMessage);
+
+    QFile file;
+    Compression compression;
+    QByteArray buffer;
+    std::unique_ptr<Codec> codec;
+    qint64 bytesIn;
+    qint64 bytesOut;
+};
+
+#endif // COMPRESSED_FILE_WRITER_H
@@ -2,10 +2,25 @@
 #define CONNECTION_STORAGE_H
 
 #include <QString>
+#include <QVariant>
 #include <QVector>
 #include <QSqlDatabase>
 #include "database/database_connection.h"
 
+// Progress of a table copy as of its last committed batch: every source row with
+// keyColumn <= lastKey is in the target
+struct CopyCheckpoint {
+    QString sourceConnection;
+    QString sourceTable;
+    QString targetConnection;
+    QString targetTable;
+    QString keyColumn;
+    QVariant lastKey;
+    qint64 rowsCopied = 0;
+
+    bool isValid() const { return lastKey.isValid(); }
+};
+
 class ConnectionStorage {
 public:
     static ConnectionStorage& instance();
@@ -16,6 +31,13 @@ public:
     QVector<ConnectionConfig> loadAllConnections();
     bool updateConnection(const QString &oldName, const ConnectionConfig &config);
 
+    // Table copy checkpoints; safe to call from worker threads
+    CopyCheckpoint loadCopyCheckpoint(const QString &sourceConnection, const QString &sourceTable,
+                                      const QString &targetConnection, const QString &targetTable);
+    bool saveCopyCheckpoint(const CopyCheckpoint &checkpoint);
+    bool removeCopyCheckpoint(const QString &sourceConnection, const QString &sourceTable,
+                              const QString &targetConnection, const QString &targetTable);
+
 private:
     ConnectionStorage() = default;
     ~ConnectionStorage() = default;
@@ -23,6 +45,7 @@ private:
     ConnectionStorage& operator=(const ConnectionStorage&) = delete;
 
     bool createTables();
+    QSqlDatabase threadStorageDatabase();
     QString encryptPassword(const QString &password) const;
     QString decryptPassword(const QString &encrypted) const;
 
@@ -0,0 +1,40 @@
+#ifndef CSV_IMPORTER_H
+#define CSV_IMPORTER_H
+
+#include <QFuture>
+#include <QString>
+#include <QStringList>
+#include "core/query_executor.h"
+#include "core/transfer_progress.h"
+
+struct CsvImportOptions {
+    QString filePath;
+    char delimiter = ',';
+    bool hasHeader = true;
+    QString tableName;        // created with inferred column types when it doesn't exist
+    bool emptyIsNull = true;  // unquoted empty fields load as NULL
+    int batchRows = 50000;
+};
+
+// Loads a CSV file into a table. A ParallelCsvParser parses the file on all cores and
+// a reader thread turns its batches into rows that flow through a bounded queue to a
+// BulkWriter on the importing thread, so parsing overlaps with the server applying
+// the previous batch.
+class CsvImporter {
+public:
+    static constexpr int kDefaultBatchRows = 50000;
+    static constexpr int kQueueBatches = 4;
+
+    // First maxRows records of the file, for previews
+    static QList<QStringList> preview(const QString &filePath, char delimiter, int maxRows,
+                                      QString *errorMessage = nullptr);
+
+    static QFuture<QueryResult> start(const ConnectionInfo &connInfo, DatabaseType type,
+                                      const CsvImportOptions &options, const TransferProgressPtr &progress,
+                                      const CancelTokenPtr &token);
+    static QueryResult run(const ConnectionInfo &connInfo, DatabaseType type,
+                           const CsvImportOptions &options, const TransferProgressPtr &progress,
+                           const CancelTokenPtr &token);
+};
+
+#endif // CSV_IMPORTER_H
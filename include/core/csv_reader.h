@@ -0,0 +1,37 @@
+#ifndef CSV_READER_H
+#define CSV_READER_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QStringList>
+
+// Sequential RFC 4180 reader over a UTF-8 file, reading it in fixed-size chunks.
+// Quoted fields may contain delimiters, doubled quotes and line breaks. An empty
+// unquoted field comes back as a null QString and an empty quoted field ("") as an
+// empty one, so callers can tell NULL from empty string.
+class CsvReader {
+public:
+    static constexpr int kChunkBytes = 1 << 20;
+
+    explicit CsvReader(char delimiter = ',');
+
+    bool open(const QString &filePath, QString *errorMessage = nullptr);
+    // Reads the next record; false at end of file
+    bool readRecord(QStringList *fields);
+
+    qint64 getBytesRead() const { return consumed; }
+    qint64 getFileSize() const { return fileSize; }
+
+private:
+    bool fillBuffer();
+
+    QFile file;
+    QByteArray buffer;
+    int position;
+    char delimiter;
+    qint64 consumed;
+    qint64 fileSize;
+};
+
+#endif // CSV_READER_H
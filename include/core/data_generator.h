@@ -0,0 +1,89 @@
+#ifndef DATA_GENERATOR_H
+#define DATA_GENERATOR_H
+
+#include <QFuture>
+#include <QList>
+#include <QMetaType>
+#include <QPair>
+#include <QSqlDatabase>
+#include <QString>
+#include <QVariant>
+#include "core/query_executor.h"
+#include "core/transfer_progress.h"
+
+enum class GeneratorKind {
+    Skip,      // left to the column default (auto-increment, serial, identity)
+    Sequence,  // minimum, minimum + 1, ... in row order
+    Uniform,   // evenly between minimum and maximum
+    Normal,    // bell curve centred between minimum and maximum
+    Zipf,      // skewed towards minimum (or the first parent values)
+    Sample,    // values of the referenced parent column
+    Constant   // always minimum
+};
+
+// Text columns produce words unless their name suggests something more specific
+enum class TextStyle {
+    Words,
+    Name,
+    Email,
+    Phone,
+    City
+};
+
+struct ColumnGeneratorSpec {
+    QString column;
+    QMetaType type;            // value type the driver reports
+    GeneratorKind kind = GeneratorKind::Uniform;
+    QVariant minimum;          // value range; text length range for text columns
+    QVariant maximum;
+    double nullRatio = 0.0;    // 0..1
+    bool unique = false;       // Uniform becomes a shuffled permutation of the range
+    TextStyle textStyle = TextStyle::Words;
+    int maxLength = 0;         // declared text length, 0 when unlimited
+    QString parentTable;       // Sample: optionally schema-qualified
+    QString parentColumn;
+};
+
+struct DataGeneratorOptions {
+    QString table;             // optionally schema-qualified
+    qint64 rowCount = 1000000;
+    int workers = 4;           // generating threads
+    int writerSessions = 4;    // bulk-loading sessions; SQLite always uses one
+    int batchRows = 10000;
+    quint64 seed = 1;          // the same seed gives the same rows
+    QList<ColumnGeneratorSpec> columns;
+};
+
+// Fills a table with synthetic rows described per column. Worker threads generate
+// batches (each batch from its own seeded generator, so the output doesn't depend on
+// the thread count) into a bounded queue that writer sessions drain through the
+// backend's BulkWriter. Foreign key columns sample the parent's existing values, and
+// unique columns draw from sequences or permutations so they never collide.
+class DataGenerator {
+public:
+    static constexpr int kQueueBatches = 8;
+    static constexpr int kMaxParentValues = 1000000;
+
+    // Generators suggested by the table's metadata: serial keys are skipped, other
+    // keys and columns with a unique index of their own continue after the current
+    // maximum or never repeat, foreign keys sample their parent, nullable columns get
+    // some NULLs. Runs on db; indexes are the table's as the catalog lists them.
+    static QList<ColumnGeneratorSpec> defaultSpecs(QSqlDatabase db, DatabaseType type, const QString &table,
+                                                   const QList<IndexInfo> &indexes,
+                                                   QString *errorMessage = nullptr);
+    // defaultSpecs() on a pool thread's session once indexes has arrived; the second
+    // member is the error when the list is empty
+    static QFuture<QPair<QList<ColumnGeneratorSpec>, QString>> startDefaultSpecs(
+        const ConnectionInfo &connInfo, DatabaseType type, const QString &table,
+        const QFuture<QList<IndexInfo>> &indexes);
+
+    static QString kindName(GeneratorKind kind);
+
+    static QFuture<QueryResult> start(const ConnectionInfo &connInfo, DatabaseType type,
+                                      const DataGeneratorOptions &options, const TransferProgressPtr &progress,
+                                      const CancelTokenPtr &token);
+    static QueryResult run(const ConnectionInfo &connInfo, DatabaseType type, const DataGeneratorOptions &options,
+                           const TransferProgressPtr &progress, const CancelTokenPtr &token);
+};
+
+#endif // DATA_GENERATOR_H
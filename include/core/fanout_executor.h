@@ -0,0 +1,61 @@
+#ifndef FANOUT_EXECUTOR_H
+#define FANOUT_EXECUTOR_H
+
+#include <QMutex>
+#include <QObject>
+#include <QStringList>
+#include <QThreadPool>
+#include "core/query_executor.h"
+
+struct ShardResult {
+    QString connectionName;
+    bool success;
+    QString errorMessage;
+    int rowCount;
+    qint64 latencyMs;
+};
+
+// Runs one query on many saved connections. Shards execute on a private thread pool
+// capped at the requested concurrency, each through QueryExecutor's per-thread
+// sessions, so at most maxConcurrency queries are in flight. A pool thread keeps only
+// the session of its latest shard, so no more than maxConcurrency sessions stay open
+// however many connections take part, and those are dropped when the threads expire.
+// Results are delivered on the GUI thread one shard at a time, with a leading
+// source_connection column. Cancelling interrupts the statements still running on
+// their servers. Destroying the executor cancels the run without waiting for the
+// shards to come back; their results are dropped.
+class FanOutExecutor : public QObject {
+    Q_OBJECT
+
+public:
+    static constexpr const char *kSourceColumn = "source_connection";
+
+    explicit FanOutExecutor(QObject *parent = nullptr);
+    ~FanOutExecutor() override;
+
+    void run(const QStringList &connectionNames, const QString &query, int maxConcurrency);
+    void cancel();
+    bool isRunning() const { return pending > 0; }
+
+signals:
+    void shardFinished(const ShardResult &shard, const QueryResult &result);
+    void finished();
+
+private:
+    void finishShard(const ShardResult &shard, const QueryResult &result);
+    static QueryResult withSourceColumn(const QString &connectionName, const QueryResult &result);
+
+    // Shards reach the executor through this, so those finishing after it is gone
+    // find no owner instead of a dangling one
+    struct Relay {
+        QMutex mutex;
+        FanOutExecutor *owner = nullptr;
+    };
+
+    QThreadPool *pool;  // not a child: it is deleted once its shards are done
+    std::shared_ptr<Relay> relay;
+    CancelTokenPtr token;
+    int pending;
+};
+
+#endif // FANOUT_EXECUTOR_H
@@ -0,0 +1,47 @@
+#ifndef FEDERATED_QUERY_H
+#define FEDERATED_QUERY_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QFuture>
+#include "core/query_executor.h"
+
+// A relation from a saved connection referenced in an editor query as
+// @connection.relation (or @"Connection Name".schema.relation)
+struct FederatedSource {
+    QString connectionName;
+    QString relation;
+    DatabaseType type;
+    ConnectionInfo connInfo;
+    QString stagingTable;
+    QStringList pushedFilters;  // column predicates evaluated on the source server
+    QString pullQuery;
+};
+
+// Runs queries that join relations from several connections. Each referenced relation
+// is pulled from its server in parallel (with equality and numeric WHERE predicates
+// pushed down), streamed into a private in-memory SQLite staging database, and the
+// rewritten query runs there. Cancelling interrupts the pulls on their servers.
+class FederatedQuery {
+public:
+    static constexpr int kDefaultRowCap = 1000000;
+
+    // True when query references at least one known saved connection
+    static bool hasReferences(const QString &query);
+
+    // Resolves references, builds the pull queries and rewrites query to use staging
+    // tables. Must be called on the GUI thread (reads ConnectionManager).
+    static bool plan(const QString &query, int rowCap, QVector<FederatedSource> *sources,
+                     QString *stagingQuery, QString *errorMessage);
+
+    static QFuture<QueryResult> execute(const QString &query, const CancelTokenPtr &token,
+                                        int rowCap = kDefaultRowCap);
+
+private:
+    static QueryResult run(const QVector<FederatedSource> &sources, const QString &stagingQuery,
+                           int rowCap, const CancelTokenPtr &token);
+    static QStringList topLevelConjuncts(const QString &query);
+};
+
+#endif // FEDERATED_QUERY_H
@@ -0,0 +1,77 @@
+#ifndef OBJECT_SEARCH_INDEX_H
+#define OBJECT_SEARCH_INDEX_H
+
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QString>
+#include "database/database_connection.h"
+
+struct ObjectSearchResult {
+    QString connection;
+    QString schema;      // database for MySQL, empty for SQLite
+    QString name;
+    RelationKind kind = RelationKind::Table;
+    int score = 0;
+};
+
+// Relation names of every catalog the tree holds, for the go-to-object palette.
+// Names are matched as case-insensitive subsequences ("usord" finds user_orders),
+// ranked so contiguous matches, word starts and short names come first.
+//
+// Each name is posted under its lowercase trigrams. A query of three or more
+// characters first collects the substring matches from its rarest trigram's
+// postings; when those fill the result, nothing else is scanned. Otherwise the
+// names holding the query's rarest character are scanned for subsequences. The
+// matches of every prefix typed are kept, so a query that extends one of them only
+// rescans its matches: typing narrows, and deleting goes back to a kept prefix
+// instead of starting over.
+//
+// Schemas are replaced or dropped as a whole when their catalog changes. Dropped
+// entries are tombstoned and the index is rebuilt once half of it is dead.
+// Not thread-safe; the model owning it updates and queries it on the GUI thread.
+class ObjectSearchIndex {
+public:
+    void setSchema(const QString &connection, const QString &schema, const QList<RelationInfo> &relations);
+    void removeSchema(const QString &connection, const QString &schema);
+    void removeConnection(const QString &connection);
+
+    int size() const { return liveCount; }
+
+    // Best matches first, at most limit of them
+    QList<ObjectSearchResult> search(const QString &query, int limit);
+
+    // -1 when queryLower isn't a subsequence of lowered (the lowercase name)
+    static int matchScore(const QString &name, const QString &lowered, const QString &queryLower);
+
+private:
+    struct Entry {
+        QString connection;
+        QString schema;
+        QString name;
+        QString lowered;
+        RelationKind kind = RelationKind::Table;
+        bool alive = true;
+    };
+
+    static quint64 trigramKey(const QChar *chars);
+    // Entries holding the query's rarest character, none when one is missing
+    const QList<int> *rarestCharacterPostings(const QString &queryLower) const;
+    void addEntry(const QString &connection, const QString &schema, const RelationInfo &relation);
+    // Tombstones ids; compactIfSparse() rebuilds once half of the entries are dead
+    void dropEntries(const QList<int> &ids);
+    void compactIfSparse();
+    void compact();
+    void invalidateNarrowing();
+
+    QList<Entry> entries;
+    int liveCount = 0;
+    QHash<QPair<QString, QString>, QList<int>> bySchema;   // (connection, schema) -> entries
+    QHash<quint64, QList<int>> trigrams;                  // ascending entry ids
+    QHash<QChar, QList<int>> characters;                  // ascending entry ids
+
+    // Subsequence matches of the scanned queries, each a prefix of the next
+    QList<QPair<QString, QList<int>>> narrowing;
+};
+
+#endif // OBJECT_SEARCH_INDEX_H
@@ -0,0 +1,107 @@
+#ifndef PARALLEL_CSV_PARSER_H
+#define PARALLEL_CSV_PARSER_H
+
+#include <QFile>
+#include <QMetaType>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QVariant>
+#include <QVector>
+#include <functional>
+
+enum class CsvColumnType {
+    Integer,
+    Real,
+    Boolean,
+    Date,
+    DateTime,
+    Text
+};
+
+// One column of a parsed batch. Values live in the vector matching the column's type:
+// ints for Integer/Boolean/Date (Julian day)/DateTime (ms since epoch, wall clock),
+// reals for Real and texts for Text.
+struct CsvColumn {
+    CsvColumnType type = CsvColumnType::Text;
+    QVector<qint64> ints;
+    QVector<double> reals;
+    QVector<QString> texts;
+    QVector<bool> nulls;
+
+    QVariant value(int row) const;
+};
+
+// Consecutive records of the file in column-major form
+struct CsvBatch {
+    qint64 byteOffset = 0;  // where the batch's first record starts
+    qint64 byteLength = 0;
+    int rowCount = 0;
+    QVector<CsvColumn> columns;
+    // First record whose field count didn't match the header (-1 if none)
+    qint64 raggedRecordOffset = -1;
+    int raggedFieldCount = 0;
+};
+
+// Multi-threaded CSV parser for large files. The file is memory-mapped and cut into
+// chunks at record boundaries: quote counts per chunk (counted in parallel) give the
+// quoting state at every nominal cut, from which the next unquoted newline is found.
+// Stray quotes in unquoted fields can mislead the count, so the cuts are checked
+// against a parallel parse and found again sequentially when one is off.
+// Chunks are then parsed in parallel using SSE2/NEON scanning for structural
+// characters and handed to the consumer in file order as typed column batches.
+// Column types are inferred from every record, one chunk per thread, so a table
+// created from them holds the whole file.
+// Parsing follows RFC 4180 (quoted fields with doubled quotes and line breaks).
+class ParallelCsvParser {
+public:
+    struct Options {
+        char delimiter = ',';
+        bool hasHeader = true;
+        bool emptyIsNull = true;  // unquoted empty text fields become NULL
+        qint64 chunkBytes = 16 * 1024 * 1024;
+        int inferenceRows = 0;    // records sampled for column types; 0 reads them all
+        int threads = 0;  // 0: one per core
+    };
+
+    ParallelCsvParser();
+    ~ParallelCsvParser();
+
+    bool open(const QString &filePath, const Options &options, QString *errorMessage = nullptr);
+
+    QStringList getColumnNames() const { return columnNames; }
+    QVector<CsvColumnType> getColumnTypes() const { return columnTypes; }
+    // Overrides the inferred types, e.g. all Text to hand the fields to an existing
+    // table as written and let the server cast them
+    void setColumnTypes(const QVector<CsvColumnType> &types) { columnTypes = types; }
+    qint64 getFileSize() const { return size; }
+    int getChunkCount() const { return int(chunkStarts.size()) - 1; }
+
+    // Parses every chunk and calls consumer with the batches in file order, with at
+    // most two chunks per thread in flight. Runs the consumer on the calling thread;
+    // returns false when the consumer stopped early by returning false.
+    bool parse(const std::function<bool(CsvBatch &&)> &consumer);
+
+    static QMetaType metaType(CsvColumnType type);
+    static QString typeName(CsvColumnType type);
+
+private:
+    void inferColumnTypes(qint64 dataStart);
+    void splitIntoChunks(qint64 dataStart);
+    // Whether every chunk starts where parsing the one before it ends
+    bool chunksAligned();
+    // Cuts at record starts found by parsing the whole file on one thread
+    void splitSequentially(qint64 dataStart, qint64 chunkBytes);
+    CsvBatch parseChunk(qint64 begin, qint64 end) const;
+
+    QThreadPool pool;
+    QFile file;
+    const char *data;
+    qint64 size;
+    Options options;
+    QStringList columnNames;
+    QVector<CsvColumnType> columnTypes;
+    QVector<qint64> chunkStarts;  // chunk i is [chunkStarts[i], chunkStarts[i + 1])
+};
+
+#endif // PARALLEL_CSV_PARSER_H
@@ -8,14 +8,20 @@
 #include <QVariantList>
 #include <QFuture>
 #include <QtConcurrent>
+#include <QMutex>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include "database/database_connection.h"
 
 struct ConnectionInfo {
+    QString name;
     QString driverName;
     QString databaseName;
     QString hostName;
     QString userName;
     QString password;
-    int port;
+    int port = -1;
     QString connectOptions;
 };
 
@@ -28,6 +34,79 @@ struct QueryResult {
     qint64 executionTimeMs;
 };
 
+// Lets the caller abandon a running query; workers poll it between fetched rows.
+// Statements that return nothing until they finish (COUNT(*), DDL) can also register a
+// handler that interrupts them on the server.
+class CancelToken {
+public:
+    void cancel() {
+        cancelled.store(true);
+        std::function<void()> handler;
+        {
+            QMutexLocker locker(&mutex);
+            handler = std::move(cancelHandler);
+            cancelHandler = nullptr;
+        }
+        if (handler) {
+            handler();
+        }
+    }
+    bool isCancelled() const { return cancelled.load(); }
+
+    // Runs handler on cancel(), or right away if already cancelled
+    void setCancelHandler(std::function<void()> handler) {
+        {
+            QMutexLocker locker(&mutex);
+            if (!cancelled.load()) {
+                cancelHandler = std::move(handler);
+                return;
+            }
+        }
+        handler();
+    }
+    void clearCancelHandler() {
+        QMutexLocker locker(&mutex);
+        cancelHandler = nullptr;
+    }
+
+private:
+    std::atomic<bool> cancelled{false};
+    QMutex mutex;
+    std::function<void()> cancelHandler;
+};
+
+using CancelTokenPtr = std::shared_ptr<CancelToken>;
+
+// Server-side cancel for jobs that spread their statements over several sessions,
+// where QueryExecutor::enableServerCancel()'s one session per token doesn't do.
+// Cancelling the token interrupts the statement of every session registered at the
+// time; sessions are removed again before they go back to serving other work.
+// Takes over the token's cancel handler for its lifetime.
+class ServerCancelGroup {
+public:
+    explicit ServerCancelGroup(const CancelTokenPtr &token);
+    ~ServerCancelGroup();
+
+    // Registers db's backend; returns the id to remove() it with, empty when the
+    // backend can't be interrupted (SQLite)
+    QString add(QSqlDatabase db, const ConnectionInfo &connInfo);
+    void remove(const QString &id);
+
+private:
+    struct Session {
+        QString id;
+        ConnectionInfo connInfo;
+        QString cancelQuery;
+    };
+    struct State {
+        QMutex mutex;
+        QList<Session> sessions;
+    };
+
+    CancelTokenPtr token;
+    std::shared_ptr<State> state;
+};
+
 class QueryExecutor : public QObject {
     Q_OBJECT
 
@@ -40,14 +119,35 @@ public:
                                            const QString &databaseName = QString(), const QString &schemaName = QString(),
                                            int limit = 1000, int offset = 0);
 
+    static ConnectionInfo getConnectionInfo(const QString &connectionName);
+    static ConnectionInfo connectionInfoFromConfig(const ConnectionConfig &config);
+
+    // Returns the calling thread's session for connInfo, opening it on first use.
+    // Sessions are per thread and per connection, as QtSql requires.
+    static QSqlDatabase threadDatabase(const ConnectionInfo &connInfo, QString *errorMessage = nullptr);
+    // Closes and forgets the calling thread's session for the named connection, for
+    // long-lived threads that move on to other connections
+    static void closeThreadDatabase(const QString &connectionName);
+
+    // Synchronous execution on the calling thread
+    static QueryResult runQuery(const ConnectionInfo &connInfo, const QString &query,
+                                const CancelTokenPtr &token = nullptr);
+    static QueryResult runQuery(QSqlDatabase db, const QString &query,
+                                const CancelTokenPtr &token = nullptr);
+
+    // Looks up db's server-side session id and makes token interrupt the statement
+    // running there, from a separate session. A no-op for SQLite, where queries are
+    // local and can only be abandoned.
+    static void enableServerCancel(QSqlDatabase db, const ConnectionInfo &connInfo,
+                                   const CancelTokenPtr &token);
+    // The statement that interrupts what db's session is running, sent from another
+    // session; empty for SQLite or when the session id can't be read
+    static QString cancelStatement(QSqlDatabase db, const ConnectionInfo &connInfo);
+
 signals:
     void queryStarted();
     void queryFinished(const QueryResult &result);
     void queryError(const QString &error);
-
-private:
-    static ConnectionInfo getConnectionInfo(const QString &connectionName);
-    static QueryResult runQuery(const ConnectionInfo &connInfo, const QString &query);
 };
 
 #endif // QUERY_EXECUTOR_H
@@ -0,0 +1,66 @@
+#ifndef RESULT_EXPORTER_H
+#define RESULT_EXPORTER_H
+
+#include <QString>
+#include <QFuture>
+#include <QSqlRecord>
+#include <functional>
+#include "core/query_executor.h"
+#include "core/transfer_progress.h"
+#include "core/result_serializer.h"
+#include "core/compressed_file_writer.h"
+
+struct ExportOptions {
+    QString filePath;
+    ResultFormat format = ResultFormat::CSV;
+    Compression compression = Compression::None;
+    QString tableName;  // INSERT target for SQL output
+    DatabaseType dialect = DatabaseType::SQLite;
+    int rowsPerInsert = 500;
+    int scanSessions = 4;  // sessions reading a table export's key ranges at once
+};
+
+// Streams a query or a whole table straight to a file. A forward-only fetch loop (or
+// a ChunkedScan reading key ranges over several sessions, for tables) hands row
+// batches through a bounded queue to a writer thread that serializes them and pushes
+// them through a CompressedFileWriter, so memory stays constant no matter how many
+// rows are exported. The exception is a query export on MySQL, whose driver buffers
+// the whole result on exec; table exports only buffer one key range per session.
+class ResultExporter {
+public:
+    static constexpr int kBatchRows = 2000;
+    static constexpr int kQueueBatches = 8;
+
+    // Format from the file extension (.csv, .tsv, .ndjson/.jsonl, .sql), ignoring
+    // any compression suffix; CSV when unknown
+    static ResultFormat formatForPath(const QString &filePath);
+
+    static QFuture<QueryResult> start(const ConnectionInfo &connInfo, const QString &query,
+                                      const ExportOptions &options, const TransferProgressPtr &progress,
+                                      const CancelTokenPtr &token);
+
+    // Synchronous export on the calling thread. The result carries no records, only
+    // the row count, timing and any error; the partial file is removed on failure.
+    static QueryResult run(const ConnectionInfo &connInfo, const QString &query,
+                           const ExportOptions &options, const TransferProgressPtr &progress,
+                           const CancelTokenPtr &token);
+
+    // Whole-table export; rows come out in no particular order
+    static QFuture<QueryResult> startTable(const ConnectionInfo &connInfo, DatabaseType type,
+                                           const QString &table, const ExportOptions &options,
+                                           const TransferProgressPtr &progress, const CancelTokenPtr &token);
+    static QueryResult runTable(const ConnectionInfo &connInfo, DatabaseType type, const QString &table,
+                                const ExportOptions &options, const TransferProgressPtr &progress,
+                                const CancelTokenPtr &token);
+
+private:
+    using BatchSink = std::function<bool(QList<QSqlRecord> &&)>;
+
+    // Serializes whatever fetch hands to its sink into options.filePath on a writer
+    // thread. fetch stops when the sink returns false and reports fetch errors.
+    static QueryResult writeFile(const ExportOptions &options, const QStringList &columns,
+                                 const std::function<void(const BatchSink &, QString *)> &fetch,
+                                 const TransferProgressPtr &progress, const CancelTokenPtr &token);
+};
+
+#endif // RESULT_EXPORTER_H
@@ -0,0 +1,55 @@
+#ifndef RESULT_SERIALIZER_H
+#define RESULT_SERIALIZER_H
+
+#include <QString>
+#include <QStringList>
+#include <QSqlRecord>
+#include "database/database_connection.h"
+
+enum class ResultFormat {
+    TSV,
+    CSV,
+    Markdown,
+    SqlInsert,
+    NDJson
+};
+
+// Turns result rows into text. Instances are immutable once constructed, so the
+// same serializer can be shared by worker threads serializing different chunks.
+class ResultSerializer {
+public:
+    ResultSerializer(ResultFormat format, const QStringList &columns,
+                     const QString &tableName = QString(),
+                     DatabaseType dialect = DatabaseType::SQLite,
+                     int rowsPerStatement = 1);
+
+    // Text emitted once before the first row (column header, markdown separator, ...)
+    QString header() const;
+    void appendRecord(QString &out, const QSqlRecord &record) const;
+    // Serializes a run of rows; SQL INSERT output groups up to rowsPerStatement rows
+    // into each multi-row statement
+    void appendRecords(QString &out, const QList<QSqlRecord> &records) const;
+
+    ResultFormat getFormat() const { return format; }
+
+    static QString formatName(ResultFormat format);
+
+private:
+    QString fieldText(const QSqlRecord &record, int column) const;
+    QString csvEscape(const QString &text) const;
+    // Pipes escaped and line breaks as <br>, so the text stays in its table cell
+    QString markdownEscape(const QString &text) const;
+    void appendValues(QString &out, const QSqlRecord &record) const;
+    void appendJsonObject(QString &out, const QSqlRecord &record) const;
+    static QString jsonString(const QString &text);
+    static QString jsonValue(const QVariant &value);
+
+    ResultFormat format;
+    QStringList columns;
+    DatabaseType dialect;
+    QString insertPrefix;
+    int rowsPerStatement;
+    QStringList jsonKeys;
+};
+
+#endif // RESULT_SERIALIZER_H
@@ -0,0 +1,80 @@
+#ifndef SCHEMA_DIFFER_H
+#define SCHEMA_DIFFER_H
+
+#include <QFuture>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include "database/database_connection.h"
+
+struct SchemaDiffOptions {
+    QString sourceConnection;  // the wanted state, e.g. staging
+    QString sourceSchema;      // database for MySQL, empty for SQLite
+    QString targetConnection;  // the one the migration applies to, e.g. production; may be the source
+    QString targetSchema;
+};
+
+struct SchemaDifference {
+    enum Kind {
+        Added,      // only in the source
+        Removed,    // only in the target
+        Changed
+    };
+
+    enum ObjectType {
+        Table,
+        View,
+        Sequence,
+        Column,
+        Index,
+        ForeignKey
+    };
+
+    Kind kind = Changed;
+    ObjectType objectType = Table;
+    QString table;             // the relation, or the one the column, index or key belongs to
+    QString name;              // column, index or key; empty for relations
+    QString sourceDefinition;  // empty when only in the target
+    QString targetDefinition;  // empty when only in the source
+};
+
+struct SchemaDiff {
+    bool success = false;
+    QString errorMessage;
+    // A relation only on one side is a single entry; a table on both gets one entry
+    // per column, index and foreign key that differs. By table, then type and name.
+    QList<SchemaDifference> differences;
+    int objectsCompared = 0;   // relations, columns, indexes and keys of both sides
+    int tablesCompared = 0;    // relations on both sides
+    int tablesChanged = 0;
+    QStringList migration;     // statements turning the target into the source, in run order
+    qint64 elapsedMs = 0;
+};
+
+// Compares one schema of a connection with one schema of another (or the same)
+// connection. Both catalogs are read at once, each through its connection's bulk
+// metadata queries (see DatabaseConnection::fetchCatalog()), so no per-table round
+// trips are made and unchanged schemas come from the metadata cache.
+//
+// Every column, index and foreign key is reduced to a canonical definition and a
+// hash of it; a relation's hash combines those of its members regardless of column
+// order. Relations whose hashes match are done, so only the changed ones are walked
+// member by member, which keeps schemas of tens of thousands of objects well under a
+// second once the catalogs are in.
+//
+// Views and sequences are compared by presence only, the catalog doesn't hold their
+// definitions. The migration is written for the target's backend with the source's
+// type names; what that backend can't alter in place (most table changes on SQLite)
+// is left as a comment.
+class SchemaDiffer {
+public:
+    static QString kindName(SchemaDifference::Kind kind);
+    static QString objectTypeName(SchemaDifference::ObjectType type);
+
+    // Looks up both connections, so call it from the GUI thread
+    static QFuture<SchemaDiff> start(const SchemaDiffOptions &options);
+    static SchemaDiff compare(const CatalogSnapshot &source, const CatalogSnapshot &target,
+                              DatabaseType targetType);
+};
+
+#endif // SCHEMA_DIFFER_H
@@ -0,0 +1,53 @@
+#ifndef SCHEMA_DUMPER_H
+#define SCHEMA_DUMPER_H
+
+#include <QFuture>
+#include <QString>
+#include <QStringList>
+#include "core/compressed_file_writer.h"
+#include "core/query_executor.h"
+#include "core/transfer_progress.h"
+
+struct DumpOptions {
+    QStringList schemas;       // MySQL databases or PostgreSQL schemas; unused for SQLite
+    QString outputPath;        // the dump file, or the directory for one file per table
+    bool filePerTable = false;
+    Compression compression = Compression::None;
+    bool includeData = true;
+    bool useCopy = true;       // PostgreSQL: COPY ... FROM stdin blocks instead of INSERTs
+    int rowsPerInsert = 500;
+    int parallelTables = 4;
+};
+
+// Logical dump of one or more schemas as SQL: DDL plus data as multi-row INSERTs or
+// COPY blocks. Worker threads dump whole tables concurrently, each on its own session,
+// and all of them read the same consistent snapshot where the backend can share one:
+// an exported REPEATABLE READ snapshot on PostgreSQL, START TRANSACTION WITH
+// CONSISTENT SNAPSHOT taken under a brief FLUSH TABLES WITH READ LOCK on MySQL.
+// SQLite is dumped by a single reader inside one transaction. Values are read as the
+// server's own text where the driver would round them, and MySQL tables with a
+// single-column primary key are read in pages of kPageRows.
+//
+// A single-file dump interleaves the tables' statements as workers produce them (each
+// INSERT or COPY block stands alone); per-table dumps also write _pre_data.sql
+// (schemas, extensions, types, domains, sequences) and _post_data.sql (foreign keys,
+// partition attachments, sequence values, views). A partitioned table is created with
+// its key and holds no data of its own; each partition is dumped as a table and
+// attached afterwards.
+class SchemaDumper {
+public:
+    static constexpr int kBatchRows = 2000;
+    static constexpr int kPageRows = 50000;  // MySQL rows per keyed page
+    static constexpr int kQueueChunks = 16;
+
+    static QFuture<QueryResult> start(const ConnectionInfo &connInfo, DatabaseType type,
+                                      const DumpOptions &options, const TransferProgressPtr &progress,
+                                      const CancelTokenPtr &token);
+    static QueryResult run(const ConnectionInfo &connInfo, DatabaseType type, const DumpOptions &options,
+                           const TransferProgressPtr &progress, const CancelTokenPtr &token);
+
+    // File name suffix for a compression (".gz", ".zst" or empty)
+    static QString compressionSuffix(Compression compression);
+};
+
+#endif // SCHEMA_DUMPER_H
@@ -0,0 +1,41 @@
+#ifndef SCRATCHPAD_H
+#define SCRATCHPAD_H
+
+#include <QString>
+#include <QMetaType>
+#include "core/query_executor.h"
+
+// Scratchpads are in-process, in-memory SQLite databases holding copies of query
+// results, so follow-up GROUP BY / JOIN work runs locally instead of on the source
+// server. Each scratchpad is a shared-cache memory database registered with
+// ConnectionManager; the GUI-side connection keeps it alive and worker threads open
+// their own sessions to it through QueryExecutor::threadDatabase(). The connection is
+// removed when the last editor on it closes, which frees the memory once the worker
+// sessions are gone.
+class Scratchpad {
+public:
+    // Registers and opens a new scratchpad connection, returning its name
+    static QString create(QString *errorMessage = nullptr);
+
+    // Bulk-loads result into a new table using prepared, batched inserts inside a
+    // single transaction. Runs on the calling thread.
+    static bool loadResult(const ConnectionInfo &connInfo, const QString &tableName,
+                           const QueryResult &result, QString *errorMessage = nullptr);
+
+    // Lower-level pieces shared with other loaders that stream rows in batches.
+    // createTable() derives column affinities from layout's field types and returns
+    // the (deduplicated) column names it used.
+    static bool createTable(QSqlDatabase db, const QString &tableName, const QSqlRecord &layout,
+                            QStringList *columns = nullptr, QString *errorMessage = nullptr);
+    static bool prepareInsert(QSqlQuery &query, const QString &tableName, int columnCount,
+                              QString *errorMessage = nullptr);
+    static bool insertRecords(QSqlQuery &query, const QList<QSqlRecord> &records, int columnCount,
+                              QString *errorMessage = nullptr);
+
+    static QString sqliteType(QMetaType type);
+
+private:
+    static constexpr int kInsertBatchRows = 5000;
+};
+
+#endif // SCRATCHPAD_H
@@ -0,0 +1,53 @@
+#ifndef SCRIPT_RUNNER_H
+#define SCRIPT_RUNNER_H
+
+#include <QFuture>
+#include <QString>
+#include <QStringList>
+#include <atomic>
+#include <memory>
+#include "core/query_executor.h"
+#include "core/transfer_progress.h"
+
+struct ScriptRunOptions {
+    QString filePath;
+    qint64 startOffset = 0;              // resume: statements starting before it are skipped
+    int statementsPerTransaction = 500;  // 1 runs every statement on its own
+    bool stopOnError = true;
+};
+
+// What a run got through beyond QueryResult. resumeOffset is live; the rest is final
+// once the run has returned.
+struct ScriptRunReport {
+    std::atomic<qint64> resumeOffset{0};  // everything before it is committed
+    int failedStatements = 0;
+    QStringList errors;                   // the first ScriptRunner::kMaxErrors
+};
+
+using ScriptRunReportPtr = std::shared_ptr<ScriptRunReport>;
+
+// Executes an SQL script file of any size: the file is memory-mapped and split into
+// statements as it is read (SqlScriptSplitter), and statements are committed in
+// transactions of statementsPerTransaction. Scripts with their own BEGIN/COMMIT run
+// as written from the first such statement on; resumeOffset then only moves past
+// their transactions once they commit, and one left open is rolled back. MySQL DDL,
+// LOCK/UNLOCK TABLES and the like commit implicitly, so they run between batches
+// and resumeOffset moves past them. On errors the run either stops, with the open
+// batch rolled back so resumeOffset is a clean restart point, or records the failure
+// and goes on; on PostgreSQL, where an error aborts the transaction, the batch is
+// then replayed statement by statement.
+//
+// Progress: rows counts executed statements, bytes the offset reached in the file.
+class ScriptRunner {
+public:
+    static constexpr int kMaxErrors = 100;
+
+    static QFuture<QueryResult> start(const ConnectionInfo &connInfo, DatabaseType type,
+                                      const ScriptRunOptions &options, const TransferProgressPtr &progress,
+                                      const ScriptRunReportPtr &report, const CancelTokenPtr &token);
+    static QueryResult run(const ConnectionInfo &connInfo, DatabaseType type, const ScriptRunOptions &options,
+                           const TransferProgressPtr &progress, const ScriptRunReportPtr &report,
+                           const CancelTokenPtr &token);
+};
+
+#endif // SCRIPT_RUNNER_H
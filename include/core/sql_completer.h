@@ -0,0 +1,130 @@
+#ifndef SQL_COMPLETER_H
+#define SQL_COMPLETER_H
+
+#include <QList>
+#include <QString>
+#include <memory>
+#include "database/database_connection.h"
+
+struct SqlCompletion {
+    enum Kind {
+        Keyword,
+        Function,
+        Schema,
+        Table,
+        View,
+        Column
+    };
+
+    QString text;      // what is inserted; quoted when the name needs it
+    Kind kind = Keyword;
+    QString detail;    // column type and table, relation kind, ...
+};
+
+// One connection's catalog arranged for prefix lookups. Schemas, the relations of
+// each schema and the keyword and function lists are sorted case-insensitively, so
+// the names starting with a prefix are one binary search away and contiguous.
+// Immutable once built, so it is built on a worker thread and shared.
+struct SqlCompletionCatalog {
+    struct Column {
+        QString name;
+        QString dataType;
+    };
+    struct Relation {
+        QString name;
+        RelationKind kind = RelationKind::Table;
+        QList<Column> columns;  // in table order
+    };
+    struct Schema {
+        QString name;
+        QList<Relation> relations;
+    };
+
+    DatabaseType type = DatabaseType::SQLite;
+    QList<Schema> schemas;
+
+    static std::shared_ptr<const SqlCompletionCatalog> build(DatabaseType type,
+                                                             const QList<CatalogSnapshot> &snapshots);
+
+    // Case-insensitive; an exact match wins over one differing in case
+    const Schema *findSchema(const QString &name) const;
+    static const Relation *findRelation(const Schema &schema, const QString &name);
+};
+
+using SqlCompletionCatalogPtr = std::shared_ptr<const SqlCompletionCatalog>;
+
+// Completion for the SQL editor, answered from a SqlCompletionCatalog without going
+// to the server. Only the statement under the cursor is tokenized: statement
+// boundaries found earlier are kept and the editor reports edits through
+// invalidateFrom(), so a keystroke rescans from the start of its own statement, not
+// from the top of the script.
+//
+// The token before the cursor picks what is offered: relations and schemas after
+// FROM, JOIN, INTO and UPDATE; columns of the tables in scope (the statement's FROM
+// and JOIN items at the cursor's parenthesis level and the levels around it),
+// functions and keywords in expressions; only keywords elsewhere. "x." completes the
+// columns of alias or table x, or the relations of schema x.
+class SqlCompleter {
+public:
+    static constexpr int kMaxCompletions = 100;
+    // Text past the cursor scanned for the FROM clause of the current statement
+    static constexpr int kMaxLookahead = 64 * 1024;
+
+    void setCatalog(const SqlCompletionCatalogPtr &catalog, DatabaseType type, const QString &defaultSchema);
+    bool hasCatalog() const { return catalog != nullptr; }
+
+    // The text changed at position; what lies before it is still valid
+    void invalidateFrom(int position);
+
+    // Best completions for the word ending at cursor, most likely kinds first
+    QList<SqlCompletion> complete(const QString &text, int cursor, int limit = kMaxCompletions);
+
+    // Start of the identifier that ends at cursor, which a completion replaces
+    static int wordStart(const QString &text, int cursor);
+
+private:
+    struct Token {
+        enum Kind {
+            Word,
+            Quoted,     // quoted identifier; text is unquoted
+            String,
+            Number,
+            Symbol,
+            Comment
+        };
+
+        Kind kind = Symbol;
+        int start = 0;
+        int end = 0;
+        QString text;
+        bool unterminated = false;  // string, identifier or comment running to the end
+        int group = 0;              // parenthesis level it sits in, see scanScopes()
+    };
+
+    struct TableRef {
+        QString schema;
+        QString name;
+        QString alias;
+        int group = 0;
+    };
+
+    static bool nextToken(const QString &text, int *pos, DatabaseType type, Token *token);
+    int statementStart(const QString &text, int cursor);
+    // The statement from start to its terminator after cursor
+    QList<Token> tokenize(const QString &text, int start, int cursor) const;
+    // Numbers the parenthesis groups (groupParents[g] encloses g) and collects the FROM
+    // and JOIN items with the group they appear in
+    QList<TableRef> scanScopes(QList<Token> *tokens, QList<int> *groupParents, int cursorIndex,
+                               int *cursorGroup) const;
+    const SqlCompletionCatalog::Relation *resolve(const TableRef &ref) const;
+    QString quoted(const QString &name) const;
+
+    SqlCompletionCatalogPtr catalog;
+    DatabaseType type = DatabaseType::SQLite;
+    QString defaultSchema;
+
+    QList<int> boundaries;  // statement starts found so far, ascending
+    int scannedTo = 0;      // every boundary before this is in boundaries
+};
+
+#endif // SQL_COMPLETER_H
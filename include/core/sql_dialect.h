@@ -0,0 +1,83 @@
+#ifndef SQL_DIALECT_H
+#define SQL_DIALECT_H
+
+#include <QString>
+#include <QVariant>
+#include "database/database_connection.h"
+
+namespace SqlDialect {
+    /**
+     * Quotes an identifier for the given backend (backticks for MySQL, double quotes otherwise)
+     * @param type Backend the identifier is used with
+     * @param identifier Unquoted identifier
+     * @return Quoted identifier with embedded quote characters escaped
+     */
+    QString quoteIdentifier(DatabaseType type, const QString &identifier);
+
+    /**
+     * Builds a quoted, optionally schema-qualified relation name
+     * @param type Backend the name is used with
+     * @param name Relation name, may already be qualified as "schema.name"
+     * @param schema Schema to qualify with when name is unqualified
+     * @return Quoted relation name
+     */
+    QString qualifiedName(DatabaseType type, const QString &name, const QString &schema = QString());
+
+    /**
+     * Renders a value as an SQL literal that can be pasted into a statement
+     * @param type Backend the literal is used with
+     * @param value Value to render; null variants become NULL
+     * @return SQL literal
+     */
+    QString literal(DatabaseType type, const QVariant &value);
+
+    /**
+     * Column type used when creating a table to hold values of a Qt type
+     * @param type Backend the table is created on
+     * @param valueType Type of the values, as reported by QSqlField::metaType()
+     * @return SQL type name
+     */
+    QString columnType(DatabaseType type, QMetaType valueType);
+
+    /**
+     * Query returning the server-side id of the current session
+     * @param type Backend to query
+     * @return SQL, or an empty string for SQLite which has no server session
+     */
+    QString backendIdQuery(DatabaseType type);
+
+    /**
+     * Statement interrupting whatever the given session is running
+     * @param type Backend to query
+     * @param backendId Session id returned by backendIdQuery()
+     * @return SQL, or an empty string for SQLite
+     */
+    QString cancelBackendQuery(DatabaseType type, qint64 backendId);
+
+    /**
+     * Query returning a catalog-statistics row count estimate for a table in one
+     * column of one row (pg_class.reltuples, information_schema.TABLES.TABLE_ROWS or
+     * the first sqlite_stat1 figure, which must be parsed by the caller)
+     * @param type Backend to query
+     * @param table Unquoted table name
+     * @param schema Unquoted schema (database for MySQL); the current one when empty
+     * @return SQL
+     */
+    QString estimatedRowCountQuery(DatabaseType type, const QString &table, const QString &schema);
+
+    /**
+     * Query returning the planner's histogram for a column: one bound per row as text
+     * for PostgreSQL (pg_stats.histogram_bounds), the JSON histogram in one row for
+     * MySQL 8 (information_schema.COLUMN_STATISTICS, filled by ANALYZE ... UPDATE
+     * HISTOGRAM)
+     * @param type Backend to query
+     * @param table Unquoted table name
+     * @param schema Unquoted schema (database for MySQL); the current one when empty
+     * @param column Unquoted column name
+     * @return SQL, or an empty string for SQLite
+     */
+    QString histogramBoundsQuery(DatabaseType type, const QString &table, const QString &schema,
+                                 const QString &column);
+} // namespace SqlDialect
+
+#endif // SQL_DIALECT_H
@@ -0,0 +1,53 @@
+#ifndef SQL_SCRIPT_SPLITTER_H
+#define SQL_SCRIPT_SPLITTER_H
+
+#include <QByteArray>
+#include "database/database_connection.h"
+
+// One statement of a script. The byte arrays point into the splitter's input, which
+// must outlive them.
+struct ScriptStatement {
+    QByteArray sql;       // without its terminator
+    QByteArray copyData;  // rows that followed a COPY ... FROM stdin
+    bool copyIn = false;  // whether sql is such a COPY
+    qint64 offset = 0;    // byte offset of the statement's first character
+    qint64 endOffset = 0; // just past the terminator (and COPY data): where the next one starts
+};
+
+// Splits an SQL script into statements one at a time, without copying it, so a
+// memory-mapped multi-GB dump can be executed as it is read. Semicolons inside string
+// literals, quoted identifiers, comments and PostgreSQL dollar-quoted bodies don't end
+// a statement. Dialect specifics: MySQL backslash escapes, # comments and DELIMITER
+// lines; PostgreSQL E'' strings, nested block comments, COPY FROM stdin data blocks
+// and psql meta-commands (skipped); SQLite [identifiers] and CREATE TRIGGER bodies.
+class SqlScriptSplitter {
+public:
+    SqlScriptSplitter(DatabaseType type, const char *data, qint64 size);
+
+    // Fills statement with the next one; false at the end of the input
+    bool next(ScriptStatement *statement);
+
+    qint64 position() const { return pos; }
+
+private:
+    void skipSpaceAndComments();
+    bool skipLineComment();
+    bool skipBlockComment();
+    void skipQuoted(char quote, bool backslashEscapes);
+    bool skipDollarQuoted();
+    bool readDelimiterCommand();
+    bool atDelimiter() const;
+    bool endsInsideTrigger(qint64 start) const;
+    void readCopyData(ScriptStatement *statement);
+    void updateSpecial();
+
+    DatabaseType type;
+    QByteArray input;  // raw view of data, for searching
+    const char *data;
+    qint64 size;
+    qint64 pos;
+    QByteArray delimiter;
+    bool special[256];  // bytes the scan has to stop at
+};
+
+#endif // SQL_SCRIPT_SPLITTER_H
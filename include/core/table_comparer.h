@@ -0,0 +1,77 @@
+#ifndef TABLE_COMPARER_H
+#define TABLE_COMPARER_H
+
+#include <QFuture>
+#include <QList>
+#include <QString>
+#include <QVariant>
+#include <atomic>
+#include <memory>
+#include "core/query_executor.h"
+#include "core/transfer_progress.h"
+
+struct TableCompareOptions {
+    QString sourceConnection;
+    QString sourceTable;      // optionally schema-qualified; needs a single-column primary key
+    QString targetConnection; // may be the source connection
+    QString targetTable;
+    int workers = 2;          // ranges checksummed at once, each on a session per side
+    int loadPercent = 50;     // share of each worker's time spent running queries
+};
+
+struct RowDifference {
+    enum Kind {
+        MissingInTarget,
+        MissingInSource,
+        Changed
+    };
+
+    QVariant key;
+    Kind kind = Changed;
+};
+
+// What a comparison found beyond QueryResult. The counters are live; differences is
+// final once the run has returned.
+struct TableCompareReport {
+    std::atomic<qint64> chunksCompared{0};
+    std::atomic<qint64> mismatchedChunks{0};
+    std::atomic<qint64> differenceCount{0};
+    QList<RowDifference> differences;  // the first TableComparer::kMaxDifferences
+    bool serverChecksums = false;      // false when rows were hashed locally
+};
+
+using TableCompareReportPtr = std::shared_ptr<TableCompareReport>;
+
+// Finds the rows that differ between two copies of a table without pulling either
+// one. The key space is cut into ranges (even steps of an integer key, the planner's
+// histogram otherwise) and each side returns COUNT(*) and a sum of per-row MD5s for
+// every range. Matching ranges are done; mismatching ones are split in two, at the
+// midpoint of an integer key or at the median key otherwise, until a range holds at
+// most kLeafRows rows, whose per-row hashes are then compared by key.
+//
+// Both sides must be the same backend for the hashes to be computed on the servers;
+// SQLite, which has no hash function, and mixed backends hash normalized values
+// locally instead, which reads the rows but still only keeps one range in memory.
+// Workers sleep between queries so they spend at most loadPercent of their time on
+// the servers. The tables are read live, so rows changing during the run can show
+// up as differences.
+//
+// Progress: rows counts source rows verified, bytes what was fetched to do it.
+class TableComparer {
+public:
+    static constexpr int kChunksPerWorker = 8;
+    static constexpr qint64 kLeafRows = 1000;
+    static constexpr int kMaxDifferences = 1000;
+
+    static QString kindName(RowDifference::Kind kind);
+
+    // Looks up both connections, so call it from the GUI thread
+    static QFuture<QueryResult> start(const TableCompareOptions &options, const TransferProgressPtr &progress,
+                                      const TableCompareReportPtr &report, const CancelTokenPtr &token);
+    static QueryResult run(const ConnectionInfo &sourceInfo, DatabaseType sourceType,
+                           const ConnectionInfo &targetInfo, DatabaseType targetType,
+                           const TableCompareOptions &options, const TransferProgressPtr &progress,
+                           const TableCompareReportPtr &report, const CancelTokenPtr &token);
+};
+
+#endif // TABLE_COMPARER_H
@@ -0,0 +1,40 @@
+#ifndef TABLE_COPIER_H
+#define TABLE_COPIER_H
+
+#include <QFuture>
+#include <QString>
+#include "core/query_executor.h"
+#include "core/transfer_progress.h"
+
+struct TableCopyOptions {
+    QString sourceConnection;
+    QString sourceTable;      // optionally schema-qualified
+    QString targetConnection;
+    QString targetTable;      // created with mapped column types when it doesn't exist
+    int batchRows = 20000;
+    int scanSessions = 4;     // source sessions reading key ranges in parallel
+    bool resume = false;      // continue after the highest key already in the target
+};
+
+// Copies a table between two connections through three stages joined by bounded
+// queues: a reader thread streams the source in key order (an ordered ChunkedScan
+// over several sessions), a converter thread turns records into rows the target
+// accepts, and the calling thread loads them with the target's BulkWriter. When the
+// source has a single-column primary key, each committed batch records its last key
+// in a checkpoint so a failed copy can resume; resuming starts after the target's
+// highest key, which is exact even when the copy stopped before saving a checkpoint.
+class TableCopier {
+public:
+    static constexpr int kDefaultBatchRows = 20000;
+    static constexpr int kQueueBatches = 4;
+
+    // Looks up both connections, so call it from the GUI thread
+    static QFuture<QueryResult> start(const TableCopyOptions &options, const TransferProgressPtr &progress,
+                                      const CancelTokenPtr &token);
+    static QueryResult run(const ConnectionInfo &sourceInfo, DatabaseType sourceType,
+                           const ConnectionInfo &targetInfo, DatabaseType targetType,
+                           const TableCopyOptions &options, const TransferProgressPtr &progress,
+                           const CancelTokenPtr &token);
+};
+
+#endif // TABLE_COPIER_H
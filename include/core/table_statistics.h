@@ -0,0 +1,47 @@
+#ifndef TABLE_STATISTICS_H
+#define TABLE_STATISTICS_H
+
+#include <QString>
+#include <QStringList>
+#include "core/query_executor.h"
+
+// Cheap ways to size up a large table without scanning it. All functions run
+// synchronously on the calling thread through its QueryExecutor session.
+class TableStatistics {
+public:
+    static constexpr int kDefaultSampleSize = 1000;
+
+    // Row count from catalog statistics, or -1 when the backend has none
+    // (never analyzed, no sqlite_stat1, views)
+    static qint64 estimateRowCount(const ConnectionInfo &connInfo, DatabaseType type,
+                                   const QString &table, const QString &schema = QString());
+
+    // COUNT(*). Cancelling token interrupts the statement on the server.
+    static QueryResult exactRowCount(const ConnectionInfo &connInfo, DatabaseType type,
+                                     const QString &table, const QString &schema,
+                                     const CancelTokenPtr &token);
+
+    // Roughly sampleSize rows spread over the whole table: TABLESAMPLE SYSTEM on
+    // PostgreSQL, random primary key / rowid seeks on MySQL and SQLite. Small tables
+    // are sampled exactly with ORDER BY random().
+    static QueryResult samplePeek(const ConnectionInfo &connInfo, DatabaseType type,
+                                  const QString &table, const QString &schema,
+                                  qint64 estimatedRows, int sampleSize = kDefaultSampleSize);
+
+    // Ascending histogram bounds the planner keeps for column, as text; empty when the
+    // catalog has none (never analyzed, MySQL before 8.0, SQLite). Runs on db.
+    static QStringList histogramBounds(QSqlDatabase db, DatabaseType type, const QString &table,
+                                       const QString &schema, const QString &column);
+
+    // Splits "schema.table" as shown in the tree into its parts
+    static void splitTableName(const QString &qualifiedTable, QString *table, QString *schema);
+
+private:
+    static QString mysqlSampleQuery(QSqlDatabase db, const QString &table, const QString &schema,
+                                    qint64 estimatedRows, int sampleSize);
+
+    static constexpr int kSeekCount = 50;
+    static constexpr int kExactSampleThreshold = 10;  // x sampleSize
+};
+
+#endif // TABLE_STATISTICS_H
@@ -0,0 +1,18 @@
+#ifndef TRANSFER_PROGRESS_H
+#define TRANSFER_PROGRESS_H
+
+#include <QtGlobal>
+#include <atomic>
+#include <memory>
+
+// Live counters shared between export/import worker threads and whoever displays
+// progress. Workers add to them; the GUI polls.
+struct TransferProgress {
+    std::atomic<qint64> rows{0};
+    std::atomic<qint64> bytes{0};  // uncompressed payload bytes
+    std::atomic<qint64> totalBytes{0};  // bytes the job will reach when known, for a percentage
+};
+
+using TransferProgressPtr = std::shared_ptr<TransferProgress>;
+
+#endif // TRANSFER_PROGRESS_H
@@ -15,6 +15,8 @@ public:
     void addConnection(const ConnectionConfig &config);
     void removeConnection(const QString &name);
     DatabaseConnection* getConnection(const QString &name);
+    // For work that may outlive the connection's removal, such as connecting
+    std::shared_ptr<DatabaseConnection> getSharedConnection(const QString &name);
     QVector<DatabaseConnection*> getAllConnections() const;
 
     std::shared_ptr<DatabaseConnection> createConnection(const ConnectionConfig &config);
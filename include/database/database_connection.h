@@ -2,10 +2,19 @@
 #define DATABASE_CONNECTION_H
 
 #include <QObject>
+#include <QFuture>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QMutex>
 #include <QString>
 #include <QSqlDatabase>
 #include <QSqlError>
 #include <QStringList>
+#include <QThreadPool>
+#include <any>
+#include <atomic>
+#include <functional>
 
 enum class DatabaseType {
     SQLite,
@@ -22,6 +31,84 @@ struct ConnectionConfig {
     QString username;
     QString password;
     QString filePath; // For SQLite
+    bool scratchpad = false; // In-memory copy of a result; never saved or offered as a target
+};
+
+enum class RelationKind {
+    Table,
+    View,
+    Sequence
+};
+
+// A relation as listed by the bulk catalog query
+struct RelationInfo {
+    QString schema;             // database for MySQL, empty for SQLite
+    QString name;
+    RelationKind kind = RelationKind::Table;
+    qint64 estimatedRows = -1;  // from catalog statistics, -1 when unknown
+    qint64 sizeBytes = -1;      // estimated on-disk size, -1 when unknown
+};
+
+struct ColumnInfo {
+    QString schema;
+    QString table;
+    QString name;
+    QString dataType;
+    bool nullable = true;
+    QString defaultValue;       // SQL expression, empty when there is none
+    QString extra;              // further attributes as DDL: MySQL's AUTO_INCREMENT, ON UPDATE ...,
+                                // GENERATED ALWAYS AS (...); empty elsewhere
+};
+
+struct IndexInfo {
+    QString schema;
+    QString table;
+    QString name;
+    QStringList columns;        // expressions for expression indexes
+    bool unique = false;
+    bool primary = false;
+    bool constraint = false;    // backs a PostgreSQL UNIQUE or PRIMARY KEY constraint
+};
+
+struct ForeignKeyInfo {
+    QString schema;
+    QString table;
+    QString name;               // empty for SQLite, whose foreign keys are unnamed
+    QStringList columns;
+    QString referencedSchema;
+    QString referencedTable;
+    QStringList referencedColumns;  // empty when SQLite refers to the primary key implicitly
+};
+
+// Catalog of one schema (a database for MySQL, the whole file for SQLite). Columns,
+// indexes and foreign keys are ordered by table.
+struct CatalogSnapshot {
+    QString schema;
+    QString version;            // change indicator the snapshot was taken at
+    QList<RelationInfo> relations;
+    QList<ColumnInfo> columns;
+    QList<IndexInfo> indexes;
+    QList<ForeignKeyInfo> foreignKeys;
+
+    // Makes repeated schema, table and type names share one string each; the driver
+    // hands out a separate copy per row
+    void shareStrings();
+};
+
+// Where each table's entries start and end in a snapshot's lists, as [first, last)
+// pairs. The lists come ordered by table, so each table's entries are one range.
+struct CatalogTableRanges {
+    QHash<QString, QPair<int, int>> columns;
+    QHash<QString, QPair<int, int>> indexes;
+    QHash<QString, QPair<int, int>> foreignKeys;
+
+    static CatalogTableRanges of(const CatalogSnapshot &snapshot);
+};
+
+struct CatalogRevalidation {
+    bool valid = false;               // false when the catalog couldn't be read
+    QStringList schemas;              // every current schema, sorted
+    QList<CatalogSnapshot> changed;   // schemas new or changed since the known version
 };
 
 struct SchemaInfo {
@@ -35,6 +122,8 @@ class DatabaseConnection : public QObject {
     Q_OBJECT
 
 public:
+    static constexpr int kMetadataRecheckMs = 2000;
+
     explicit DatabaseConnection(const ConnectionConfig &config, QObject *parent = nullptr);
     virtual ~DatabaseConnection();
 
@@ -42,14 +131,54 @@ public:
     virtual void disconnect() = 0;
     virtual bool isConnected() const = 0;
 
-    virtual QStringList getDatabases() = 0;
-    virtual QStringList getSchemas(const QString &database = QString()) = 0;
-    virtual QStringList getTables(const QString &schema = QString(), const QString &database = QString()) = 0;
-    virtual QStringList getViews(const QString &schema = QString(), const QString &database = QString()) = 0;
-    virtual QStringList getSequences(const QString &schema = QString(), const QString &database = QString()) = 0;
+    // Catalog lists. They are queried on the connection's metadata thread, which owns a
+    // session of its own, so the GUI thread never waits on a round trip and never
+    // touches a session opened elsewhere; watch the futures from the GUI thread.
+    QFuture<QStringList> fetchDatabases();
+    QFuture<QStringList> fetchSchemas(const QString &database = QString());
+    // Compares knownVersions (schema -> version of a cached snapshot) with the server's
+    // per-schema change indicators and re-reads relations, columns, indexes and foreign
+    // keys, one query each, for the schemas that are new or changed
+    QFuture<CatalogRevalidation> revalidateCatalog(const QHash<QString, QString> &knownVersions);
+
+    // Column, index and foreign key metadata of one table. A schema is read in bulk the
+    // first time any of its tables is asked for and kept on the connection; later calls
+    // recheck the schema versions at most every kMetadataRecheckMs and refetch a schema
+    // only when its version moved. An empty schema is the connection's default one.
+    QFuture<QList<ColumnInfo>> fetchColumns(const QString &schema, const QString &table);
+    QFuture<QList<IndexInfo>> fetchIndexes(const QString &schema, const QString &table);
+    QFuture<QList<ForeignKeyInfo>> fetchForeignKeys(const QString &schema, const QString &table);
+    // Every schema from that cache, brought up to date the same way; for lookups that
+    // must not wait on the server each time, such as editor completion
+    QFuture<QList<CatalogSnapshot>> fetchCatalog();
+    // Seeds that cache with snapshots already at hand, such as the persisted catalog
+    void primeCatalog(const QList<CatalogSnapshot> &snapshots);
+    // Schema unqualified names resolve to: the configured database for MySQL, public
+    // for PostgreSQL, none for SQLite
+    QString defaultSchema() const;
+
+    // Catalog requests still queued finish with empty results without reaching the
+    // server, and later requests don't join them; the one running is interrupted on
+    // the server. Called when the connection closes; the tree calls it when the
+    // connection goes away mid-load. Call it from the GUI thread.
+    void cancelCatalogQueries();
+
+    // Blocking versions of the above, for worker threads and one-off lookups
+    QStringList getDatabases() { return fetchDatabases().result(); }
+    QStringList getSchemas(const QString &database = QString()) { return fetchSchemas(database).result(); }
+    QList<ColumnInfo> getColumns(const QString &schema, const QString &table) {
+        return fetchColumns(schema, table).result();
+    }
+    QList<IndexInfo> getIndexes(const QString &schema, const QString &table) {
+        return fetchIndexes(schema, table).result();
+    }
+    QList<ForeignKeyInfo> getForeignKeys(const QString &schema, const QString &table) {
+        return fetchForeignKeys(schema, table).result();
+    }
 
     QString getName() const { return config.name; }
     DatabaseType getType() const { return config.type; }
+    bool isScratchpad() const { return config.scratchpad; }
     QString getLastError() const { return lastError; }
     QString getConnectionName() const { return db.connectionName(); }
     QSqlDatabase getDatabase() const { return db; }
@@ -61,11 +190,77 @@ signals:
     void errorOccurred(const QString &error);
 
 protected:
+    // A new, unopened session configured for this connection
+    virtual QSqlDatabase createSession(const QString &connectionName) const = 0;
+
+    // Catalog queries; only ever called on the metadata thread with its session
+    virtual QStringList queryDatabases(QSqlDatabase session) = 0;
+    virtual QStringList querySchemas(QSqlDatabase session, const QString &database) = 0;
+    // Bulk catalog queries over the given schemas, all of them when schemas is empty.
+    // querySchemaVersions must be cheap: it runs on every revalidation.
+    virtual bool querySchemaVersions(QSqlDatabase session, QHash<QString, QString> *versions) = 0;
+    virtual bool queryRelations(QSqlDatabase session, const QStringList &schemas, QList<RelationInfo> *relations) = 0;
+    virtual bool queryColumns(QSqlDatabase session, const QStringList &schemas, QList<ColumnInfo> *columns) = 0;
+    virtual bool queryIndexes(QSqlDatabase session, const QStringList &schemas, QList<IndexInfo> *indexes) = 0;
+    virtual bool queryForeignKeys(QSqlDatabase session, const QStringList &schemas,
+                                  QList<ForeignKeyInfo> *foreignKeys) = 0;
+
+    // "('a', 'b')" for an IN predicate, quoted for this backend
+    QString sqlStringList(const QStringList &values) const;
+
+    // Closes the metadata session; the next catalog call reopens it
+    void closeMetadataSession();
+    // Lets queued catalog calls return empty, interrupts the running one and waits for
+    // them. Subclass destructors call it so no query runs while the object is half
+    // destroyed.
+    void stopMetadataThread();
+
     ConnectionConfig config;
     QSqlDatabase db;
     QString lastError;
 
     QString generateConnectionName() const;
+
+private:
+    // Identical requests (same key: kind and arguments) made while one is queued or
+    // running share its future instead of querying again
+    template <typename T>
+    QFuture<T> runCatalogQuery(const QString &key, std::function<T(QSqlDatabase)> query);
+    void forgetCatalogQuery(const QString &key, int generation);
+    // Remembers the metadata session's server-side id, for interruptCatalogQuery()
+    void readMetadataBackendId(QSqlDatabase session);
+    // Interrupts the catalog query running on the server if it was requested before
+    // generation, from a session on a pool thread
+    void interruptCatalogQuery(int generation);
+
+    // Reads the given schemas with one query per kind of object
+    bool readSnapshots(QSqlDatabase session, const QStringList &schemas, const QHash<QString, QString> &versions,
+                       QList<CatalogSnapshot> *snapshots);
+
+    // A cached schema and where each table's entries start and end in its lists
+    struct SchemaMetadata {
+        CatalogSnapshot snapshot;
+        CatalogTableRanges ranges;
+    };
+    void storeSchemaMetadata(const CatalogSnapshot &snapshot);
+    const SchemaMetadata *schemaMetadata(QSqlDatabase session, const QString &schema);
+    void recheckServerVersions(QSqlDatabase session);
+
+    // Only touched on the metadata thread
+    QHash<QString, SchemaMetadata> metadataCache;
+    QHash<QString, QString> serverVersions;
+    QElapsedTimer serverVersionsAge;
+
+    QMutex inFlightMutex;
+    QHash<QString, std::any> inFlight;     // key -> QFuture<T> of the request
+    std::atomic<int> catalogGeneration{0}; // bumped by cancelCatalogQueries()
+    std::atomic<int> runningGeneration{-1}; // of the query on the server, -1 when idle
+    std::atomic<qint64> metadataBackendId{-1};
+
+    // One thread that never expires, so the session stays on the thread that opened it
+    QThreadPool metadataPool;
+    QString metadataConnectionName;
+    std::atomic<bool> stopping{false};
 };
 
 #endif // DATABASE_CONNECTION_H
@@ -8,16 +8,23 @@ class MySQLConnection : public DatabaseConnection {
 
 public:
     explicit MySQLConnection(const ConnectionConfig &config, QObject *parent = nullptr);
+    ~MySQLConnection() override;
 
     bool connect() override;
     void disconnect() override;
     bool isConnected() const override;
 
-    QStringList getDatabases() override;
-    QStringList getSchemas(const QString &database = QString()) override;
-    QStringList getTables(const QString &schema = QString(), const QString &database = QString()) override;
-    QStringList getViews(const QString &schema = QString(), const QString &database = QString()) override;
-    QStringList getSequences(const QString &schema = QString(), const QString &database = QString()) override;
+protected:
+    QSqlDatabase createSession(const QString &connectionName) const override;
+
+    QStringList queryDatabases(QSqlDatabase session) override;
+    QStringList querySchemas(QSqlDatabase session, const QString &database) override;
+    bool querySchemaVersions(QSqlDatabase session, QHash<QString, QString> *versions) override;
+    bool queryRelations(QSqlDatabase session, const QStringList &schemas, QList<RelationInfo> *relations) override;
+    bool queryColumns(QSqlDatabase session, const QStringList &schemas, QList<ColumnInfo> *columns) override;
+    bool queryIndexes(QSqlDatabase session, const QStringList &schemas, QList<IndexInfo> *indexes) override;
+    bool queryForeignKeys(QSqlDatabase session, const QStringList &schemas,
+                          QList<ForeignKeyInfo> *foreignKeys) override;
 };
 
 #endif // MYSQL_CONNECTION_H
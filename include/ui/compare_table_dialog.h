@@ -0,0 +1,38 @@
+#ifndef COMPARE_TABLE_DIALOG_H
+#define COMPARE_TABLE_DIALOG_H
+
+#include <QDialog>
+#include <QComboBox>
+#include <QLineEdit>
+#include <QSpinBox>
+#include <QPushButton>
+#include "core/table_comparer.h"
+
+// Picks the table to compare a table against, on the same or another connection, and
+// how hard the comparison may load the servers.
+class CompareTableDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    CompareTableDialog(const QString &sourceConnection, const QString &sourceTable, QWidget *parent = nullptr);
+
+    TableCompareOptions getCompareOptions() const;
+
+private slots:
+    void updateButtons();
+
+private:
+    void setupUI();
+
+    QString sourceConnection;
+    QString sourceTable;
+
+    QComboBox *targetConnectionCombo;
+    QLineEdit *targetTableEdit;
+    QSpinBox *workersSpin;
+    QSpinBox *loadSpin;
+    QPushButton *okButton;
+    QPushButton *cancelButton;
+};
+
+#endif // COMPARE_TABLE_DIALOG_H
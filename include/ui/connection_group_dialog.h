@@ -0,0 +1,36 @@
+#ifndef CONNECTION_GROUP_DIALOG_H
+#define CONNECTION_GROUP_DIALOG_H
+
+#include <QDialog>
+#include <QListWidget>
+#include <QSpinBox>
+#include <QPushButton>
+#include <QStringList>
+
+// Picks a set of saved connections (shards, replicas, tenants) to run one query on,
+// plus how many of them may execute at once.
+class ConnectionGroupDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    static constexpr int kDefaultConcurrency = 8;
+
+    explicit ConnectionGroupDialog(const QString &initialConnection = QString(), QWidget *parent = nullptr);
+
+    QStringList getSelectedConnections() const;
+    int getMaxConcurrency() const;
+
+private slots:
+    void setAllChecked(bool checked);
+    void updateOkButton();
+
+private:
+    void setupUI(const QString &initialConnection);
+
+    QListWidget *connectionList;
+    QSpinBox *concurrencySpin;
+    QPushButton *okButton;
+    QPushButton *cancelButton;
+};
+
+#endif // CONNECTION_GROUP_DIALOG_H
@@ -1,10 +1,17 @@
 #ifndef CONNECTION_TREE_MODEL_H
 #define CONNECTION_TREE_MODEL_H
 
-#include <QStandardItemModel>
-#include <QStandardItem>
-#include <QTimer>
+#include <QAbstractItemModel>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QIcon>
+#include <QList>
+#include <QMap>
+#include <QSet>
+#include <QtAlgorithms>
+#include <functional>
 #include "database/database_connection.h"
+#include "core/object_search_index.h"
 #include "spinner_icon.h"
 
 enum class TreeItemType {
@@ -16,14 +23,24 @@ enum class TreeItemType {
     SequencesFolder,
     Table,
     View,
-    Sequence
+    Sequence,
+    Column,
+    Index,
+    ForeignKey,
+    Placeholder   // "Loading...", "Not connected" and similar status rows
 };
 
-class TreeItem : public QStandardItem {
+// What a row of the tree stands for. The model keeps no object per table, view or
+// sequence until one is expanded, so these are built on demand by
+// ConnectionTreeModel::itemAt().
+class TreeItem {
 public:
+    TreeItem() = default;
     TreeItem(const QString &text, TreeItemType type)
-        : QStandardItem(text), itemType(type), loaded(false) {}
+        : itemText(text), itemType(type), valid(true) {}
 
+    bool isValid() const { return valid; }
+    QString text() const { return itemText; }
     TreeItemType getType() const { return itemType; }
     void setConnectionName(const QString &name) { connectionName = name; }
     QString getConnectionName() const { return connectionName; }
@@ -31,57 +48,191 @@ public:
     QString getDatabaseName() const { return databaseName; }
     void setSchemaName(const QString &name) { schemaName = name; }
     QString getSchemaName() const { return schemaName; }
+    // What objects under the item are qualified with: the schema, or the database on MySQL
+    QString getOwnerName() const { return schemaName.isEmpty() ? databaseName : schemaName; }
 
     bool isLoaded() const { return loaded; }
     void setLoaded(bool value) { loaded = value; }
 
 private:
-    TreeItemType itemType;
+    QString itemText;
+    TreeItemType itemType = TreeItemType::Placeholder;
     QString connectionName;
     QString databaseName;
     QString schemaName;
-    bool loaded;
+    bool loaded = false;
+    bool valid = false;
 };
 
-class ConnectionTreeModel : public QStandardItemModel {
+// Connections, their databases or schemas and the object folders are nodes; the
+// objects inside a folder are rows over the owning schema's catalog snapshot, which
+// the folder shares rather than copies. Folders hand their rows to the view in
+// batches of kFetchBatchSize through canFetchMore()/fetchMore(), so expanding one
+// costs what is shown, not what it holds. A table or view gets a node of its own the
+// first time it is expanded, holding its columns, indexes and foreign keys from the
+// same snapshot.
+class ConnectionTreeModel : public QAbstractItemModel {
     Q_OBJECT
 
 public:
+    static constexpr int kFetchBatchSize = 500;
+
     explicit ConnectionTreeModel(QObject *parent = nullptr);
+    ~ConnectionTreeModel() override;
+
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex &child) const override;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    bool hasChildren(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    Qt::ItemFlags flags(const QModelIndex &index) const override;
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+
+    TreeItem itemAt(const QModelIndex &index) const;
 
     void addConnection(DatabaseConnection *connection);
     void addConnectionPlaceholder(const QString &connectionName, DatabaseType dbType);
     void removeConnection(const QString &connectionName);
+    // Refetches the schemas that changed and applies the differences as row inserts
+    // and removals, keeping expansion and selection. Open folders are updated right
+    // away, collapsed ones when next expanded.
     void refreshConnection(const QString &connectionName);
-    void loadFolderContents(TreeItem *folderItem);
-    void loadFolderContentsAsync(TreeItem *folderItem);
-    void connectToDatabase(TreeItem *connectionItem);
-
-    TreeItem* findConnectionItem(const QString &connectionName);
+    // The view reports expansion so refreshes know which folders are on screen
+    void setExpanded(const QModelIndex &index, bool expanded);
+    void loadFolderContentsAsync(const QModelIndex &folderIndex);
+    void connectToDatabase(const QModelIndex &connectionIndex);
+
+    QModelIndex findConnectionIndex(const QString &connectionName) const;
+
+    // Names of every relation in the catalogs held, kept in step with them
+    ObjectSearchIndex *objectIndex() { return &searchIndex; }
+    // Reads the cached catalogs of connections not opened yet on worker threads, so they
+    // can be searched; objectIndexChanged() follows each one that arrives
+    void indexCachedCatalogs();
+    // Index of the object's row, drawing its connection from the cache and paging its
+    // folder as needed; the folder or schema when the object isn't listed (yet)
+    QModelIndex revealObject(const QString &connectionName, const QString &schema, RelationKind kind,
+                             const QString &name);
 
 signals:
-    void folderLoadingStarted(TreeItem *folderItem);
-    void folderLoadingFinished(TreeItem *folderItem);
+    void folderLoadingStarted(const QModelIndex &folderIndex);
+    void folderLoadingFinished(const QModelIndex &folderIndex);
     void connectionStarted(const QString &connectionName);
     void connectionFinished(const QString &connectionName, bool success, const QString &error);
+    void objectIndexChanged();
 
 private:
-    void loadConnectionStructure(TreeItem *connectionItem, DatabaseConnection *connection);
-    void loadSQLiteStructure(TreeItem *connectionItem, DatabaseConnection *connection);
-    void loadMySQLStructure(TreeItem *connectionItem, DatabaseConnection *connection);
-    void loadPostgreSQLStructure(TreeItem *connectionItem, DatabaseConnection *connection);
-
-    QIcon getIconForDatabaseType(DatabaseType type);
-    QIcon getIconForType(TreeItemType type);
-    void startSpinner(TreeItem *item);
-    void stopSpinner(TreeItem *item);
+    struct Node {
+        TreeItemType type;
+        QString text;
+        Node *parent = nullptr;
+        QList<Node*> children;           // databases, schemas and folders
+        DatabaseType databaseType = DatabaseType::SQLite;  // connections only
+
+        // Folders: the owning snapshot's relations and the ones listed here
+        QList<RelationInfo> relations;
+        QList<int> leaves;               // indexes into relations
+        int fetched = 0;                 // leaves handed to the view so far
+        QHash<QString, Node*> tables;    // leaves that have been expanded, by name
+
+        int leafRow = 0;                 // tables and views: row in the folder
+        QString toolTip;                 // columns, indexes and foreign keys
+
+        QString placeholder;             // status row, shown only while there are no others
+        bool placeholderBusy = false;    // spinner on the status row; a folder waiting for its catalog
+        bool busy = false;               // spinner instead of the node's icon
+        bool loaded = false;
+        bool expanded = false;
+        bool stale = false;              // loaded folder whose schema changed while collapsed
+
+        Node(TreeItemType type, const QString &text) : type(type), text(text) {}
+        ~Node() {
+            qDeleteAll(children);
+            qDeleteAll(tables);
+        }
+        int row() const {
+            if (parent && parent->isFolder()) {
+                return leafRow;
+            }
+            return parent ? parent->children.indexOf(const_cast<Node*>(this)) : 0;
+        }
+        bool isFolder() const {
+            return type == TreeItemType::TablesFolder || type == TreeItemType::ViewsFolder
+                || type == TreeItemType::SequencesFolder;
+        }
+    };
+
+    // nullptr for status rows and for leaves that have no node of their own (yet)
+    Node *nodeAt(const QModelIndex &index) const;
+    // Tables and views can be expanded, sequences can't
+    bool isExpandableLeaf(const QModelIndex &index) const;
+    QModelIndex indexOf(Node *node) const;
+    Node *findConnectionNode(const QString &connectionName) const;
+    QString connectionNameOf(const Node *node) const;
+    QString ownerOf(const Node *folder) const;
+    int rowCountOf(const Node *node) const;
+
+    Node *appendNode(Node *parent, TreeItemType type, const QString &text);
+    void insertNode(Node *parent, int row, Node *child);
+    void removeNode(Node *node);
+    void clearRows(Node *node);
+    void setPlaceholder(Node *node, const QString &text, bool busy);
+    void setBusy(Node *node, bool busy);
+    void forgetSpinners(Node *node);
+
+    void loadConnectionStructure(Node *connectionNode, DatabaseConnection *connection);
+    void addFolders(Node *parent, DatabaseType type);
+    void addSchemaNode(Node *connectionNode, int row, const QString &schema);
+
+    // Reads the connection's snapshots from the catalog cache in the background unless
+    // they are held already; connections in drawWhenCached are drawn when they arrive
+    void loadCachedCatalog(const QString &connectionName);
+    // Draws the connection from its cached catalog; false when nothing is cached (yet)
+    bool showCachedCatalog(Node *connectionNode);
+    // Asks the server which schemas changed since the snapshots held, refetches only
+    // those, updates the tree and persists the new snapshots
+    void revalidateCatalog(const QString &connectionName);
+    void syncSchemaNodes(Node *connectionNode, const QStringList &schemas);
+    void forEachFolder(Node *parent, const std::function<void(Node*)> &visit);
+    void loadFolder(Node *folder);
+    // A schema's snapshot and where each table's details are in it
+    struct SchemaCatalog {
+        CatalogSnapshot snapshot;
+        CatalogTableRanges ranges;
+    };
+    // The catalog the folder's relations come from; null until it is held
+    const SchemaCatalog *catalogOf(Node *folder) const;
+    void fillFolder(Node *folder, const SchemaCatalog &catalog);
+    void updateFolder(Node *folder, const QList<RelationInfo> &relations, const QList<int> &leaves);
+    void fetchLeaves(Node *folder, int count);
+    void fillDetails(Node *table, const SchemaCatalog &catalog);
+
+    QIcon getIconForDatabaseType(DatabaseType type) const;
+    QIcon getIconForType(TreeItemType type) const;
+
+    Node *root;
 
     // Store connections for lazy loading
     QMap<QString, DatabaseConnection*> connections;
+    QMap<QString, QHash<QString, SchemaCatalog>> catalogs;  // by connection, then schema
+    // Loads in flight, one of each per connection at most; later requests wait for it.
+    // A finished watcher no longer listed belongs to a connection that was removed
+    // meanwhile, and its result is dropped.
+    QHash<QString, QFutureWatcher<CatalogRevalidation>*> revalidations;
+    QHash<QString, QFutureWatcher<QPair<bool, QString>>*> connectAttempts;
+    QHash<QString, QFutureWatcher<QHash<QString, SchemaCatalog>>*> cacheLoads;
+    QSet<QString> drawWhenCached;
+    ObjectSearchIndex searchIndex;
+
+    // One icon per kind, shared by every row
+    mutable QHash<int, QIcon> typeIcons;
 
     // Spinner
     SpinnerIcon *spinnerIcon;
-    QMap<TreeItem*, bool> spinningItems;  // items currently showing spinner
+    QSet<Node*> spinningNodes;  // nodes showing a spinner on themselves or their status row
 };
 
 #endif // CONNECTION_TREE_MODEL_H
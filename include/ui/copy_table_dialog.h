@@ -0,0 +1,39 @@
+#ifndef COPY_TABLE_DIALOG_H
+#define COPY_TABLE_DIALOG_H
+
+#include <QDialog>
+#include <QCheckBox>
+#include <QComboBox>
+#include <QLineEdit>
+#include <QSpinBox>
+#include <QPushButton>
+#include "core/table_copier.h"
+
+// Picks the target connection and table for copying a table to another connection,
+// and offers to resume when an earlier copy of the same pair left a checkpoint.
+class CopyTableDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    CopyTableDialog(const QString &sourceConnection, const QString &sourceTable, QWidget *parent = nullptr);
+
+    TableCopyOptions getCopyOptions() const;
+
+private slots:
+    void updateCheckpoint();
+
+private:
+    void setupUI();
+
+    QString sourceConnection;
+    QString sourceTable;
+
+    QComboBox *targetConnectionCombo;
+    QLineEdit *targetTableEdit;
+    QSpinBox *batchRowsSpin;
+    QCheckBox *resumeCheck;
+    QPushButton *okButton;
+    QPushButton *cancelButton;
+};
+
+#endif // COPY_TABLE_DIALOG_H
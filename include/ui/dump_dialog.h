@@ -0,0 +1,46 @@
+#ifndef DUMP_DIALOG_H
+#define DUMP_DIALOG_H
+
+#include <QDialog>
+#include <QLineEdit>
+#include <QComboBox>
+#include <QCheckBox>
+#include <QSpinBox>
+#include <QPushButton>
+#include "core/schema_dumper.h"
+
+// Collects the output location and format for a logical dump of the given schemas
+class DumpDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    DumpDialog(DatabaseType type, const QStringList &schemas, const QString &suggestedName,
+               QWidget *parent = nullptr);
+
+    DumpOptions getDumpOptions() const;
+
+private slots:
+    void browseForOutput();
+    void updateState();
+
+private:
+    void setupUI();
+
+    DatabaseType type;
+    QStringList schemas;
+    QString suggestedName;
+
+    QComboBox *modeCombo;
+    QLineEdit *outputEdit;
+    QPushButton *browseButton;
+    QComboBox *compressionCombo;
+    QCheckBox *dataCheck;
+    QCheckBox *copyCheck;
+    QSpinBox *rowsPerInsertSpin;
+    QSpinBox *parallelSpin;
+
+    QPushButton *okButton;
+    QPushButton *cancelButton;
+};
+
+#endif // DUMP_DIALOG_H
@@ -0,0 +1,37 @@
+#ifndef GENERATE_DATA_DIALOG_H
+#define GENERATE_DATA_DIALOG_H
+
+#include <QDialog>
+#include <QSpinBox>
+#include <QTableWidget>
+#include <QPushButton>
+#include "core/data_generator.h"
+
+// Edits the per-column generators suggested for a table and how many rows to make
+class GenerateDataDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    GenerateDataDialog(DatabaseType type, const QString &table, const QList<ColumnGeneratorSpec> &specs,
+                       QWidget *parent = nullptr);
+
+    DataGeneratorOptions getGeneratorOptions() const;
+
+private:
+    void setupUI();
+
+    DatabaseType type;
+    QString table;
+    QList<ColumnGeneratorSpec> specs;
+
+    QSpinBox *rowsSpin;
+    QSpinBox *workersSpin;
+    QSpinBox *writersSpin;
+    QSpinBox *seedSpin;
+    QTableWidget *columnTable;
+
+    QPushButton *okButton;
+    QPushButton *cancelButton;
+};
+
+#endif // GENERATE_DATA_DIALOG_H
@@ -0,0 +1,46 @@
+#ifndef IMPORT_DIALOG_H
+#define IMPORT_DIALOG_H
+
+#include <QDialog>
+#include <QLineEdit>
+#include <QComboBox>
+#include <QCheckBox>
+#include <QSpinBox>
+#include <QPushButton>
+#include <QTableWidget>
+#include "core/csv_importer.h"
+
+// Collects the settings for a CSV import and previews the first rows of the file
+class ImportDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    explicit ImportDialog(const QString &schema = QString(), QWidget *parent = nullptr);
+
+    CsvImportOptions getImportOptions() const;
+
+private slots:
+    void browseForFile();
+    void updatePreview();
+    void onAccept();
+
+private:
+    void setupUI();
+    char delimiter() const;
+
+    QString schema;
+
+    QLineEdit *fileEdit;
+    QPushButton *browseButton;
+    QComboBox *delimiterCombo;
+    QCheckBox *headerCheck;
+    QLineEdit *tableEdit;
+    QCheckBox *emptyIsNullCheck;
+    QSpinBox *batchSpin;
+    QTableWidget *previewTable;
+
+    QPushButton *okButton;
+    QPushButton *cancelButton;
+};
+
+#endif // IMPORT_DIALOG_H
@@ -24,6 +24,7 @@ private slots:
     void onTreeItemDoubleClicked(const QModelIndex &index);
     void onTreeItemContextMenu(const QPoint &pos);
     void openSQLEditor(const QString &connectionName = QString(), const QString &database = QString(), const QString &schema = QString());
+    void openObjectPalette();
 
 private:
     void setupUI();
@@ -31,7 +32,11 @@ private:
     void loadSavedConnections();
     void openTableInTab(const QString &connectionName, const QString &tableName,
                         const QString &databaseName = QString(), const QString &schemaName = QString());
+    void openGroupSQLEditor(const QString &initialConnection);
+    void openSchemaDiff(const TreeItem &item);
     int findTab(const QString &tabName);
+    // Drops a scratchpad connection once no editor tab uses it any more
+    void releaseScratchpad(const QString &connectionName);
 
     QSplitter *splitter;
     QWidget *sidebarWidget;
@@ -0,0 +1,42 @@
+#ifndef OBJECT_PALETTE_H
+#define OBJECT_PALETTE_H
+
+#include <QDialog>
+#include <QLineEdit>
+#include <QListWidget>
+#include "core/object_search_index.h"
+
+// Ctrl+P "go to object": type part of a table, view or sequence name from any
+// connection's catalog and pick it with Enter. Results are recomputed on every
+// keystroke from the index, and when catalogs still being read arrive.
+class ObjectPalette : public QDialog {
+    Q_OBJECT
+
+public:
+    static constexpr int kMaxResults = 50;
+
+    explicit ObjectPalette(ObjectSearchIndex *index, QWidget *parent = nullptr);
+
+    ObjectSearchResult getSelectedObject() const;
+
+public slots:
+    // Searches again after the index gained or lost objects
+    void refresh();
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private slots:
+    void updateResults(const QString &query);
+
+private:
+    void setupUI();
+
+    ObjectSearchIndex *index;
+    QList<ObjectSearchResult> results;
+
+    QLineEdit *queryEdit;
+    QListWidget *resultList;
+};
+
+#endif // OBJECT_PALETTE_H
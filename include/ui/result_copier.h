@@ -0,0 +1,47 @@
+#ifndef RESULT_COPIER_H
+#define RESULT_COPIER_H
+
+#include <QObject>
+#include <QTableView>
+#include <QMenu>
+#include "core/query_executor.h"
+#include "core/result_serializer.h"
+
+// Copies the selected rows of a result grid. Rows are serialized straight from the
+// QueryResult (not the view model) in chunks on worker threads, so large selections
+// don't stall the GUI thread and can be cancelled from the progress dialog.
+class ResultCopier : public QObject {
+    Q_OBJECT
+
+public:
+    explicit ResultCopier(QTableView *view, QWidget *dialogParent);
+
+    void setResult(const QueryResult &result, const QString &tableName, DatabaseType dialect);
+    void clear();
+    void addCopyActions(QMenu *menu);
+    bool isBusy() const { return busy; }
+
+public slots:
+    void copySelection(ResultFormat format = ResultFormat::TSV);
+
+signals:
+    void statusMessage(const QString &message);
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    QVector<int> selectedRows() const;
+    void copyToClipboard(const ResultSerializer &serializer, const QVector<int> &rows);
+    void copyToFile(const ResultSerializer &serializer, const QVector<int> &rows,
+                    const QString &filePath);
+
+    QTableView *view;
+    QWidget *dialogParent;
+    QueryResult result;
+    QString tableName;
+    DatabaseType dialect;
+    bool busy;
+};
+
+#endif // RESULT_COPIER_H
@@ -0,0 +1,41 @@
+#ifndef RUN_SCRIPT_DIALOG_H
+#define RUN_SCRIPT_DIALOG_H
+
+#include <QDialog>
+#include <QLineEdit>
+#include <QComboBox>
+#include <QSpinBox>
+#include <QPushButton>
+#include "core/script_runner.h"
+
+// Picks an SQL script to execute and how: transaction size, what to do on errors,
+// and the byte offset to start at. Offsets where earlier runs of a file stopped are
+// remembered for the session and offered again.
+class RunScriptDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    explicit RunScriptDialog(QWidget *parent = nullptr);
+
+    ScriptRunOptions getRunOptions() const;
+
+    static void rememberResumeOffset(const QString &filePath, qint64 offset);
+
+private slots:
+    void browseForFile();
+    void updateState();
+
+private:
+    void setupUI();
+
+    QLineEdit *fileEdit;
+    QPushButton *browseButton;
+    QSpinBox *batchSpin;
+    QComboBox *errorCombo;
+    QLineEdit *offsetEdit;
+
+    QPushButton *okButton;
+    QPushButton *cancelButton;
+};
+
+#endif // RUN_SCRIPT_DIALOG_H
@@ -0,0 +1,51 @@
+#ifndef SCHEMA_DIFF_DIALOG_H
+#define SCHEMA_DIFF_DIALOG_H
+
+#include <QDialog>
+#include <QCheckBox>
+#include <QComboBox>
+#include <QFutureWatcher>
+#include <QLabel>
+#include <QLineEdit>
+#include <QPlainTextEdit>
+#include <QPushButton>
+#include <QTreeWidget>
+#include "core/schema_differ.h"
+
+// Compares a schema with one on another (or the same) connection and lists what was
+// added, removed or changed by table, with the DDL that brings the target in line.
+// Stays open, so the comparison can be run again after applying the migration.
+class SchemaDiffDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    SchemaDiffDialog(const QString &sourceConnection, const QString &sourceSchema, QWidget *parent = nullptr);
+
+signals:
+    // The migration, to be opened in an editor on the target connection
+    void migrationRequested(const QString &connectionName, const QString &schema, const QString &script);
+
+private slots:
+    void updateButtons();
+    void runCompare();
+    void showDiff();
+
+private:
+    void setupUI();
+
+    QString sourceConnection;
+    QString sourceSchema;
+    SchemaDiffOptions comparedOptions;
+
+    QComboBox *targetConnectionCombo;
+    QLineEdit *targetSchemaEdit;
+    QPushButton *compareButton;
+    QLabel *summaryLabel;
+    QTreeWidget *differenceTree;
+    QCheckBox *migrationCheck;
+    QPlainTextEdit *migrationEdit;
+    QPushButton *openMigrationButton;
+    QFutureWatcher<SchemaDiff> *watcher;
+};
+
+#endif // SCHEMA_DIFF_DIALOG_H
@@ -10,7 +10,13 @@
 #include <QLabel>
 #include <QSplitter>
 #include <QSyntaxHighlighter>
+#include <QListWidget>
+#include <QCompleter>
+#include <QElapsedTimer>
 #include "core/query_executor.h"
+#include "core/sql_completer.h"
+#include "core/fanout_executor.h"
+#include "result_copier.h"
 
 class SQLHighlighter : public QSyntaxHighlighter {
     Q_OBJECT
@@ -34,6 +40,34 @@ private:
     QTextCharFormat numberFormat;
 };
 
+// Query text editor with catalog-driven completion. The list pops up once an
+// identifier has kMinPrefixLength characters or right after a ".", and on Ctrl+Space.
+class SQLTextEdit : public QPlainTextEdit {
+    Q_OBJECT
+
+public:
+    static constexpr int kMinPrefixLength = 2;
+
+    explicit SQLTextEdit(QWidget *parent = nullptr);
+
+    SqlCompleter *sqlCompleter() { return &completionEngine; }
+
+signals:
+    // Completions were looked up; lets the owner refresh the catalog behind them
+    void completionRequested();
+
+protected:
+    void keyPressEvent(QKeyEvent *event) override;
+
+private:
+    void updateCompletions(bool explicitRequest);
+    void insertCompletion(const QString &completion);
+
+    SqlCompleter completionEngine;
+    QCompleter *completer;
+    QStandardItemModel *completionModel;
+};
+
 class SQLEditor : public QWidget {
     Q_OBJECT
 
@@ -41,29 +75,66 @@ public:
     explicit SQLEditor(QWidget *parent = nullptr);
 
     void setDatabaseContext(const QString &connectionName, const QString &database = QString(), const QString &schema = QString());
+    void setQueryText(const QString &text);
+    // Switches the editor to group mode: queries run on every connection in the group
+    // and the results are merged with a source_connection column
+    void setConnectionGroup(const QStringList &connectionNames, int maxConcurrency);
+    QString getConnectionName() const { return currentConnectionName; }
 
 signals:
     void errorOccurred(const QString &error);
+    void scratchpadReady(const QString &connectionName, const QString &tableName);
 
 private slots:
     void executeQuery();
+    void cancelQuery();
+    void runQueryToFile();
+    void runScriptFile();
     void displayQueryResult(const QueryResult &result);
+    void showResultContextMenu(const QPoint &pos);
+    void openResultInScratchpad();
+    void onShardFinished(const ShardResult &shard, const QueryResult &result);
+    void onGroupFinished();
 
 private:
+    // How old the completion catalog may get before using it triggers a reload
+    static constexpr int kCatalogRefreshMs = 30000;
+
     void setupUI();
+    void executeGroupQuery(const QString &query);
+    void refreshCompletionCatalog();
 
     QComboBox *contextCombo;
-    QPlainTextEdit *editor;
+    SQLTextEdit *editor;
     QPushButton *executeButton;
+    QPushButton *cancelButton;
+    QPushButton *runToFileButton;
+    QPushButton *runFileButton;
     QTableView *resultView;
     QStandardItemModel *resultModel;
     QLabel *statusLabel;
     SQLHighlighter *highlighter;
     QueryExecutor *queryExecutor;
+    ResultCopier *resultCopier;
+    QueryResult lastResult;
+    CancelTokenPtr runningToken;
+
+    // Group mode
+    QListWidget *shardList;
+    FanOutExecutor *fanOutExecutor;
+    QStringList groupConnections;
+    int groupConcurrency;
+    QueryResult groupResult;
+    int groupShardsDone;
+    int groupShardsFailed;
 
     QString currentConnectionName;
     QString currentDatabase;
     QString currentSchema;
+
+    // Completion catalog
+    QElapsedTimer catalogAge;
+    bool catalogLoading;
 };
 
 #endif // SQL_EDITOR_H
@@ -10,12 +10,14 @@
 #include <QVBoxLayout>
 #include <QQuickWidget>
 #include "core/query_executor.h"
+#include "result_copier.h"
 
 class TableViewer : public QWidget {
     Q_OBJECT
 
 public:
     explicit TableViewer(QWidget *parent = nullptr);
+    ~TableViewer() override;
 
     void loadTableData(const QString &connectionName, const QString &tableName,
                        const QString &databaseName = QString(), const QString &schemaName = QString());
@@ -28,10 +30,18 @@ private slots:
     void nextPage();
     void previousPage();
     void goToPage();
+    void showContextMenu(const QPoint &pos);
+    void countRows();
+    void setQuickPeek(bool enabled);
 
 private:
     void setupUI();
+    void loadPage();
+    void loadEstimatedRowCount();
+    // The table name and its schema (database for MySQL) for the statistics queries
+    void splitCurrentTable(DatabaseType type, QString *table, QString *schema) const;
     void updatePaginationInfo();
+    void updateRowCountLabel();
     void showLoadingSpinner();
     void hideLoadingSpinner();
 
@@ -43,14 +53,27 @@ private:
     QPushButton *nextButton;
     QSpinBox *pageSpinBox;
     QLabel *pageLabel;
+    QLabel *pageCountLabel;
+    QLabel *rowCountLabel;
+    QPushButton *countButton;
+    QPushButton *peekButton;
     QQuickWidget *loadingSpinner;
 
     QueryExecutor *queryExecutor;
+    ResultCopier *resultCopier;
     QString currentConnectionName;
     QString currentTableName;
+    QString currentDatabaseName;
+    QString currentSchemaName;
     int currentPage;
     int pageSize;
     int totalRows;
+
+    // Table size: catalog estimate (-1 if unknown) and exact count once requested
+    qint64 estimatedRows;
+    qint64 exactRows;
+    CancelTokenPtr countToken;
+    bool quickPeek;
 };
 
 #endif // TABLE_VIEWER_H
@@ -0,0 +1,46 @@
+#ifndef TRANSFER_PROGRESS_DIALOG_H
+#define TRANSFER_PROGRESS_DIALOG_H
+
+#include <QProgressDialog>
+#include <QElapsedTimer>
+#include <QFuture>
+#include <QTimer>
+#include <functional>
+#include "core/query_executor.h"
+#include "core/transfer_progress.h"
+
+// Busy dialog for long-running exports and imports: shows rows, rows/s and MB/s from
+// shared counters while a background job runs, and cancels the job through its token.
+// Jobs that know their total size also get a percentage bar. A job still running when
+// the dialog goes away with its parent (an editor tab being closed) is cancelled.
+class TransferProgressDialog : public QProgressDialog {
+    Q_OBJECT
+
+public:
+    TransferProgressDialog(const QString &title, const TransferProgressPtr &progress,
+                           const CancelTokenPtr &token, QWidget *parent = nullptr);
+    ~TransferProgressDialog() override;
+
+    // Shows the dialog until future finishes, then calls onFinished with its result and
+    // deletes itself
+    void watch(const QFuture<QueryResult> &future, std::function<void(const QueryResult &)> onFinished);
+
+    // What the rows counter counts ("rows" unless set)
+    void setUnit(const QString &unit);
+
+    static QString throughputText(qint64 rows, qint64 bytes, qint64 elapsedMs, const QString &unit = "rows");
+
+private slots:
+    void updateLabel();
+
+private:
+    QString title;
+    QString unit;
+    TransferProgressPtr progress;
+    CancelTokenPtr token;
+    QElapsedTimer elapsed;
+    QTimer *timer;
+    bool running = false;
+};
+
+#endif // TRANSFER_PROGRESS_DIALOG_H
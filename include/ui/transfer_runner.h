@@ -0,0 +1,48 @@
+#ifndef TRANSFER_RUNNER_H
+#define TRANSFER_RUNNER_H
+
+#include <QWidget>
+#include <QString>
+
+// GUI front end for the export, import, copy, compare, dump, script and data
+// generation engines: asks for a file, runs the transfer in the background and shows live
+// rows/s and MB/s with a cancel button.
+class TransferRunner {
+public:
+    // Format and compression are taken from the chosen file name (e.g. orders.csv.zst,
+    // orders.arrow). tableName is used as the INSERT target for SQL output.
+    static void exportQuery(QWidget *parent, const QString &connectionName, const QString &query,
+                            const QString &suggestedFileName, const QString &tableName = QString());
+
+    // Exports a whole table, reading key ranges over several sessions
+    static void exportTable(QWidget *parent, const QString &connectionName, const QString &table,
+                            const QString &schema = QString());
+
+    // Loads an Arrow IPC file into a table (new or existing) in schema
+    static void importArrowFile(QWidget *parent, const QString &connectionName,
+                                const QString &schema = QString());
+
+    // Runs the CSV import wizard and loads the file through the backend's bulk path
+    static void importCsvFile(QWidget *parent, const QString &connectionName,
+                              const QString &schema = QString());
+
+    // Copies a table to another open connection, resuming an interrupted copy on request
+    static void copyTable(QWidget *parent, const QString &connectionName, const QString &table);
+
+    // Compares a table's rows with a copy on the same or another connection by key-range checksums
+    static void compareTable(QWidget *parent, const QString &connectionName, const QString &table);
+
+    // Fills a table with synthetic rows from per-column generators
+    static void generateData(QWidget *parent, const QString &connectionName, const QString &table);
+
+    // Executes an SQL script file statement by statement, in transaction batches,
+    // without loading it into an editor
+    static void runScriptFile(QWidget *parent, const QString &connectionName);
+
+    // Dumps schema to SQL files; an empty schema dumps every user schema (or database)
+    // the connection can see
+    static void dumpSchema(QWidget *parent, const QString &connectionName, const QString &database = QString(),
+                           const QString &schema = QString());
+};
+
+#endif // TRANSFER_RUNNER_H
@@ -0,0 +1,581 @@
+#include "core/arrow_io.h"
+#include "core/sql_dialect.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QSqlError>
+#include <QSqlField>
+#include <QTimeZone>
+
+#ifdef HAVE_ARROW
+#include <arrow/api.h>
+#include <arrow/io/file.h>
+#include <arrow/ipc/api.h>
+#endif
+
+namespace {
+QueryResult failure(const QString &message, qint64 elapsedMs = 0) {
+    QueryResult result;
+    result.success = false;
+    result.errorMessage = message;
+    result.rowCount = 0;
+    result.executionTimeMs = elapsedMs;
+    return result;
+}
+
+#ifdef HAVE_ARROW
+const QDate kEpochDate(1970, 1, 1);
+
+QString statusText(const arrow::Status &status) {
+    return QString::fromStdString(status.ToString());
+}
+
+std::shared_ptr<arrow::DataType> arrowType(QMetaType type) {
+    switch (type.id()) {
+        case QMetaType::Bool:
+            return arrow::boolean();
+        case QMetaType::Int:
+        case QMetaType::Short:
+        case QMetaType::UShort:
+        case QMetaType::Char:
+        case QMetaType::SChar:
+        case QMetaType::UChar:
+            return arrow::int32();
+        case QMetaType::UInt:
+        case QMetaType::Long:
+        case QMetaType::LongLong:
+            return arrow::int64();
+        case QMetaType::ULong:
+        case QMetaType::ULongLong:
+            return arrow::uint64();
+        case QMetaType::Float:
+            return arrow::float32();
+        case QMetaType::Double:
+            return arrow::float64();
+        case QMetaType::QDate:
+            return arrow::date32();
+        case QMetaType::QTime:
+            return arrow::time64(arrow::TimeUnit::MICRO);
+        case QMetaType::QDateTime:
+            return arrow::timestamp(arrow::TimeUnit::MICRO);
+        case QMetaType::QByteArray:
+            return arrow::binary();
+        default:
+            return arrow::utf8();
+    }
+}
+
+// Type of the column created for an Arrow field on import
+QMetaType qtType(const arrow::DataType &type) {
+    switch (type.id()) {
+        case arrow::Type::BOOL:
+            return QMetaType::fromType<bool>();
+        case arrow::Type::INT8:
+        case arrow::Type::INT16:
+        case arrow::Type::INT32:
+        case arrow::Type::UINT8:
+        case arrow::Type::UINT16:
+            return QMetaType::fromType<int>();
+        case arrow::Type::INT64:
+        case arrow::Type::UINT32:
+        case arrow::Type::UINT64:
+            return QMetaType::fromType<qint64>();
+        case arrow::Type::HALF_FLOAT:
+        case arrow::Type::FLOAT:
+            return QMetaType::fromType<float>();
+        case arrow::Type::DOUBLE:
+            return QMetaType::fromType<double>();
+        case arrow::Type::DATE32:
+        case arrow::Type::DATE64:
+            return QMetaType::fromType<QDate>();
+        case arrow::Type::TIME32:
+        case arrow::Type::TIME64:
+            return QMetaType::fromType<QTime>();
+        case arrow::Type::TIMESTAMP:
+            return QMetaType::fromType<QDateTime>();
+        case arrow::Type::BINARY:
+        case arrow::Type::LARGE_BINARY:
+        case arrow::Type::FIXED_SIZE_BINARY:
+            return QMetaType::fromType<QByteArray>();
+        default:
+            return QMetaType::fromType<QString>();
+    }
+}
+
+qint64 toMicros(qint64 value, arrow::TimeUnit::type unit) {
+    switch (unit) {
+        case arrow::TimeUnit::SECOND:
+            return value * 1000000;
+        case arrow::TimeUnit::MILLI:
+            return value * 1000;
+        case arrow::TimeUnit::MICRO:
+            return value;
+        case arrow::TimeUnit::NANO:
+            return value / 1000;
+    }
+    return value;
+}
+
+arrow::Status appendValue(arrow::ArrayBuilder *builder, const QVariant &value, bool *converted) {
+    *converted = true;
+    if (!value.isValid() || value.isNull()) {
+        return builder->AppendNull();
+    }
+
+    bool ok = true;
+    switch (builder->type()->id()) {
+        case arrow::Type::BOOL:
+            return static_cast<arrow::BooleanBuilder *>(builder)->Append(value.toBool());
+        case arrow::Type::INT32: {
+            const int number = value.toInt(&ok);
+            *converted = ok;
+            return static_cast<arrow::Int32Builder *>(builder)->Append(number);
+        }
+        case arrow::Type::INT64: {
+            const qint64 number = value.toLongLong(&ok);
+            *converted = ok;
+            return static_cast<arrow::Int64Builder *>(builder)->Append(number);
+        }
+        case arrow::Type::UINT64: {
+            const quint64 number = value.toULongLong(&ok);
+            *converted = ok;
+            return static_cast<arrow::UInt64Builder *>(builder)->Append(number);
+        }
+        case arrow::Type::FLOAT: {
+            const float number = value.toFloat(&ok);
+            *converted = ok;
+            return static_cast<arrow::FloatBuilder *>(builder)->Append(number);
+        }
+        case arrow::Type::DOUBLE: {
+            const double number = value.toDouble(&ok);
+            *converted = ok;
+            return static_cast<arrow::DoubleBuilder *>(builder)->Append(number);
+        }
+        case arrow::Type::DATE32: {
+            const QDate date = value.toDate();
+            *converted = date.isValid();
+            return static_cast<arrow::Date32Builder *>(builder)->Append(int32_t(kEpochDate.daysTo(date)));
+        }
+        case arrow::Type::TIME64: {
+            const QTime time = value.toTime();
+            *converted = time.isValid();
+            return static_cast<arrow::Time64Builder *>(builder)->Append(time.msecsSinceStartOfDay() * qint64(1000));
+        }
+        case arrow::Type::TIMESTAMP: {
+            // Timestamps are written without a time zone, so keep the wall-clock value
+            const QDateTime dateTime = value.toDateTime();
+            *converted = dateTime.isValid();
+            const QDateTime wallClock(dateTime.date(), dateTime.time(), QTimeZone::utc());
+            return static_cast<arrow::TimestampBuilder *>(builder)->Append(wallClock.toMSecsSinceEpoch() * 1000);
+        }
+        case arrow::Type::BINARY: {
+            const QByteArray bytes = value.toByteArray();
+            return static_cast<arrow::BinaryBuilder *>(builder)->Append(
+                reinterpret_cast<const uint8_t *>(bytes.constData()), int32_t(bytes.size()));
+        }
+        default: {
+            const QByteArray utf8 = value.toString().toUtf8();
+            return static_cast<arrow::StringBuilder *>(builder)->Append(utf8.constData(), int32_t(utf8.size()));
+        }
+    }
+}
+
+template <typename ArrayType, typename Convert>
+void appendColumn(const arrow::Array &array, QMetaType nullType, QVariantList &out, Convert convert) {
+    const auto &typed = static_cast<const ArrayType &>(array);
+    for (int64_t i = 0; i < typed.length(); ++i) {
+        out.append(typed.IsNull(i) ? QVariant(nullType) : convert(typed, i));
+    }
+}
+
+QVariantList columnValues(const arrow::Array &array) {
+    QVariantList values;
+    values.reserve(array.length());
+    const QMetaType nullType = qtType(*array.type());
+
+    switch (array.type_id()) {
+        case arrow::Type::BOOL:
+            appendColumn<arrow::BooleanArray>(array, nullType, values, [](const auto &a, int64_t i) {
+                return QVariant(a.Value(i));
+            });
+            break;
+        case arrow::Type::INT8:
+            appendColumn<arrow::Int8Array>(array, nullType, values, [](const auto &a, int64_t i) {
+                return QVariant(int(a.Value(i)));
+            });
+            break;
+        case arrow::Type::INT16:
+            appendColumn<arrow::Int16Array>(array, nullType, values, [](const auto &a, int64_t i) {
+                return QVariant(int(a.Value(i)));
+            });
+            break;
+        case arrow::Type::INT32:
+            appendColumn<arrow::Int32Array>(array, nullType, values, [](const auto &a, int64_t i) {
+                return QVariant(int(a.Value(i)));
+            });
+            break;
+        case arrow::Type::INT64:
+            appendColumn<arrow::Int64Array>(array, nullType, values, [](const auto &a, int64_t i) {
+                return QVariant(qint64(a.Value(i)));
+            });
+            break;
+        case arrow::Type::UINT8:
+            appendColumn<arrow::UInt8Array>(array, nullType, values, [](const auto &a, int64_t i) {
+                return QVariant(int(a.Value(i)));
+            });
+            break;
+        case arrow::Type::UINT16:
+            appendColumn<arrow::UInt16Array>(array, nullType, values, [](const auto &a, int64_t i) {
+                return QVariant(int(a.Value(i)));
+            });
+            break;
+        case arrow::Type::UINT32:
+            appendColumn<arrow::UInt32Array>(array, nullType, values, [](const auto &a, int64_t i) {
+                return QVariant(qint64(a.Value(i)));
+            });
+            break;
+        case arrow::Type::UINT64:
+            appendColumn<arrow::UInt64Array>(array, nullType, values, [](const auto &a, int64_t i) {
+                return QVariant(quint64(a.Value(i)));
+            });
+            break;
+        case arrow::Type::FLOAT:
+            appendColumn<arrow::FloatArray>(array, nullType, values, [](const auto &a, int64_t i) {
+                return QVariant(a.Value(i));
+            });
+            break;
+        case arrow::Type::DOUBLE:
+            appendColumn<arrow::DoubleArray>(array, nullType, values, [](const auto &a, int64_t i) {
+                return QVariant(a.Value(i));
+            });
+            break;
+        case arrow::Type::STRING:
+            appendColumn<arrow::StringArray>(array, nullType, values, [](const auto &a, int64_t i) {
+                const std::string_view view = a.GetView(i);
+                return QVariant(QString::fromUtf8(view.data(), qsizetype(view.size())));
+            });
+            break;
+        case arrow::Type::LARGE_STRING:
+            appendColumn<arrow::LargeStringArray>(array, nullType, values, [](const auto &a, int64_t i) {
+                const std::string_view view = a.GetView(i);
+                return QVariant(QString::fromUtf8(view.data(), qsizetype(view.size())));
+            });
+            break;
+        case arrow::Type::BINARY:
+            appendColumn<arrow::BinaryArray>(array, nullType, values, [](const auto &a, int64_t i) {
+                const std::string_view view = a.GetView(i);
+                return QVariant(QByteArray(view.data(), qsizetype(view.size())));
+            });
+            break;
+        case arrow::Type::LARGE_BINARY:
+            appendColumn<arrow::LargeBinaryArray>(array, nullType, values, [](const auto &a, int64_t i) {
+                const std::string_view view = a.GetView(i);
+                return QVariant(QByteArray(view.data(), qsizetype(view.size())));
+            });
+            break;
+        case arrow::Type::DATE32:
+            appendColumn<arrow::Date32Array>(array, nullType, values, [](const auto &a, int64_t i) {
+                return QVariant(kEpochDate.addDays(a.Value(i)));
+            });
+            break;
+        case arrow::Type::DATE64:
+            appendColumn<arrow::Date64Array>(array, nullType, values, [](const auto &a, int64_t i) {
+                return QVariant(QDateTime::fromMSecsSinceEpoch(a.Value(i), QTimeZone::utc()).date());
+            });
+            break;
+        case arrow::Type::TIME32: {
+            const auto unit = static_cast<const arrow::Time32Type &>(*array.type()).unit();
+            appendColumn<arrow::Time32Array>(array, nullType, values, [unit](const auto &a, int64_t i) {
+                return QVariant(QTime::fromMSecsSinceStartOfDay(int(toMicros(a.Value(i), unit) / 1000)));
+            });
+            break;
+        }
+        case arrow::Type::TIME64: {
+            const auto unit = static_cast<const arrow::Time64Type &>(*array.type()).unit();
+            appendColumn<arrow::Time64Array>(array, nullType, values, [unit](const auto &a, int64_t i) {
+                return QVariant(QTime::fromMSecsSinceStartOfDay(int(toMicros(a.Value(i), unit) / 1000)));
+            });
+            break;
+        }
+        case arrow::Type::TIMESTAMP: {
+            const auto unit = static_cast<const arrow::TimestampType &>(*array.type()).unit();
+            appendColumn<arrow::TimestampArray>(array, nullType, values, [unit](const auto &a, int64_t i) {
+                const QDateTime utc = QDateTime::fromMSecsSinceEpoch(toMicros(a.Value(i), unit) / 1000,
+                                                                     QTimeZone::utc());
+                // Naive timestamps carry wall-clock values; bind them as such
+                return QVariant(QDateTime(utc.date(), utc.time()));
+            });
+            break;
+        }
+        default:
+            // Decimals, dictionaries, nested types: bind their text form
+            for (int64_t i = 0; i < array.length(); ++i) {
+                if (array.IsNull(i)) {
+                    values.append(QVariant(nullType));
+                    continue;
+                }
+                auto scalar = array.GetScalar(i);
+                values.append(scalar.ok() ? QString::fromStdString((*scalar)->ToString()) : QString());
+            }
+            break;
+    }
+    return values;
+}
+#endif
+} // namespace
+
+bool ArrowIO::isAvailable() {
+#ifdef HAVE_ARROW
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool ArrowIO::isArrowPath(const QString &filePath) {
+    return filePath.endsWith(".arrow", Qt::CaseInsensitive)
+        || filePath.endsWith(".feather", Qt::CaseInsensitive)
+        || filePath.endsWith(".ipc", Qt::CaseInsensitive);
+}
+
+QFuture<QueryResult> ArrowIO::startExport(const ConnectionInfo &connInfo, const QString &query,
+                                          const QString &filePath, const TransferProgressPtr &progress,
+                                          const CancelTokenPtr &token) {
+    return QtConcurrent::run([connInfo, query, filePath, progress, token]() {
+        return exportQuery(connInfo, query, filePath, progress, token);
+    });
+}
+
+QFuture<QueryResult> ArrowIO::startImport(const ConnectionInfo &connInfo, DatabaseType dialect,
+                                          const QString &filePath, const QString &tableName,
+                                          const TransferProgressPtr &progress, const CancelTokenPtr &token) {
+    return QtConcurrent::run([connInfo, dialect, filePath, tableName, progress, token]() {
+        return importFile(connInfo, dialect, filePath, tableName, progress, token);
+    });
+}
+
+QueryResult ArrowIO::exportQuery(const ConnectionInfo &connInfo, const QString &query,
+                                 const QString &filePath, const TransferProgressPtr &progress,
+                                 const CancelTokenPtr &token) {
+#ifndef HAVE_ARROW
+    Q_UNUSED(connInfo);
+    Q_UNUSED(query);
+    Q_UNUSED(filePath);
+    Q_UNUSED(progress);
+    Q_UNUSED(token);
+    return failure("This build has no Apache Arrow support");
+#else
+    QElapsedTimer timer;
+    timer.start();
+
+    QString openError;
+    QSqlDatabase db = QueryExecutor::threadDatabase(connInfo, &openError);
+    if (!db.isValid() || !db.isOpen()) {
+        return failure(openError);
+    }
+
+    QSqlQuery sqlQuery(db);
+    sqlQuery.setForwardOnly(true);
+    QueryExecutor::enableServerCancel(db, connInfo, token);
+    const bool executed = sqlQuery.exec(query);
+    if (!executed) {
+        token->clearCancelHandler();
+        return failure(sqlQuery.lastError().text(), timer.elapsed());
+    }
+
+    const QSqlRecord layout = sqlQuery.record();
+    QStringList columnNames;
+    arrow::FieldVector fields;
+    for (int i = 0; i < layout.count(); ++i) {
+        columnNames << layout.fieldName(i);
+        fields.push_back(arrow::field(layout.fieldName(i).toStdString(), arrowType(layout.field(i).metaType())));
+    }
+    const std::shared_ptr<arrow::Schema> schema = arrow::schema(fields);
+
+    auto output = arrow::io::FileOutputStream::Open(QFile::encodeName(filePath).toStdString());
+    if (!output.ok()) {
+        token->clearCancelHandler();
+        return failure(statusText(output.status()));
+    }
+    auto writer = arrow::ipc::MakeFileWriter(*output, schema);
+    auto builder = arrow::RecordBatchBuilder::Make(schema, arrow::default_memory_pool(), kBatchRows);
+    if (!writer.ok() || !builder.ok()) {
+        token->clearCancelHandler();
+        (*output)->Close().ok();
+        QFile::remove(filePath);
+        return failure(statusText(!writer.ok() ? writer.status() : builder.status()));
+    }
+
+    QueryResult result;
+    result.success = false;
+    result.rowCount = 0;
+    result.columnNames = columnNames;
+
+    auto writeBatch = [&]() -> arrow::Status {
+        ARROW_ASSIGN_OR_RAISE(auto batch, (*builder)->Flush());
+        ARROW_RETURN_NOT_OK((*writer)->WriteRecordBatch(*batch));
+        ARROW_ASSIGN_OR_RAISE(const int64_t position, (*output)->Tell());
+        progress->bytes = position;
+        return arrow::Status::OK();
+    };
+
+    int batchRows = 0;
+    arrow::Status status;
+    while (status.ok() && sqlQuery.next()) {
+        if (token->isCancelled()) {
+            result.errorMessage = "Export cancelled";
+            break;
+        }
+
+        for (int i = 0; i < layout.count() && status.ok(); ++i) {
+            bool converted = true;
+            status = appendValue((*builder)->GetField(i), sqlQuery.value(i), &converted);
+            if (status.ok() && !converted) {
+                status = arrow::Status::Invalid(
+                    QString("Value '%1' in column %2 does not match its %3 type")
+                        .arg(sqlQuery.value(i).toString(), columnNames.at(i),
+                             QString::fromStdString(fields[i]->type()->ToString()))
+                        .toStdString());
+            }
+        }
+
+        ++result.rowCount;
+        if (status.ok() && ++batchRows == kBatchRows) {
+            status = writeBatch();
+            progress->rows += batchRows;
+            batchRows = 0;
+        }
+    }
+    token->clearCancelHandler();
+
+    if (status.ok() && result.errorMessage.isEmpty() && sqlQuery.lastError().isValid()) {
+        result.errorMessage = sqlQuery.lastError().text();
+    }
+    if (status.ok() && result.errorMessage.isEmpty() && batchRows > 0) {
+        status = writeBatch();
+        progress->rows += batchRows;
+    }
+    if (status.ok() && result.errorMessage.isEmpty()) {
+        status = (*writer)->Close();
+    }
+    const arrow::Status closeStatus = (*output)->Close();
+    if (status.ok()) {
+        status = closeStatus;
+    }
+
+    result.executionTimeMs = timer.elapsed();
+    if (!status.ok()) {
+        result.errorMessage = statusText(status);
+    }
+    if (!result.errorMessage.isEmpty()) {
+        QFile::remove(filePath);
+        return result;
+    }
+
+    result.success = true;
+    return result;
+#endif
+}
+
+QueryResult ArrowIO::importFile(const ConnectionInfo &connInfo, DatabaseType dialect,
+                                const QString &filePath, const QString &tableName,
+                                const TransferProgressPtr &progress, const CancelTokenPtr &token) {
+#ifndef HAVE_ARROW
+    Q_UNUSED(connInfo);
+    Q_UNUSED(dialect);
+    Q_UNUSED(filePath);
+    Q_UNUSED(tableName);
+    Q_UNUSED(progress);
+    Q_UNUSED(token);
+    return failure("This build has no Apache Arrow support");
+#else
+    QElapsedTimer timer;
+    timer.start();
+
+    // Memory-mapped, so record batches are read straight from the page cache
+    auto file = arrow::io::MemoryMappedFile::Open(QFile::encodeName(filePath).toStdString(),
+                                                  arrow::io::FileMode::READ);
+    if (!file.ok()) {
+        return failure(statusText(file.status()));
+    }
+    auto reader = arrow::ipc::RecordBatchFileReader::Open(*file);
+    if (!reader.ok()) {
+        return failure(statusText(reader.status()));
+    }
+    const std::shared_ptr<arrow::Schema> schema = (*reader)->schema();
+
+    QString openError;
+    QSqlDatabase db = QueryExecutor::threadDatabase(connInfo, &openError);
+    if (!db.isValid() || !db.isOpen()) {
+        return failure(openError);
+    }
+
+    const QString target = SqlDialect::qualifiedName(dialect, tableName);
+    QStringList columns;
+    QStringList definitions;
+    for (const auto &field : schema->fields()) {
+        const QString column = SqlDialect::quoteIdentifier(dialect, QString::fromStdString(field->name()));
+        columns << column;
+        definitions << QString("%1 %2").arg(column, SqlDialect::columnType(dialect, qtType(*field->type())));
+    }
+
+    if (db.record(tableName).isEmpty()) {
+        QSqlQuery create(db);
+        if (!create.exec(QString("CREATE TABLE %1 (%2)").arg(target, definitions.join(", ")))) {
+            return failure("Failed to create table: " + create.lastError().text(), timer.elapsed());
+        }
+    }
+
+    QSqlQuery insert(db);
+    QStringList placeholders;
+    for (int i = 0; i < columns.size(); ++i) {
+        placeholders << "?";
+    }
+    if (!insert.prepare(QString("INSERT INTO %1 (%2) VALUES (%3)")
+                            .arg(target, columns.join(", "), placeholders.join(", ")))) {
+        return failure("Failed to prepare insert: " + insert.lastError().text(), timer.elapsed());
+    }
+
+    QueryResult result;
+    result.success = false;
+    result.rowCount = 0;
+    for (const auto &field : schema->fields()) {
+        result.columnNames << QString::fromStdString(field->name());
+    }
+
+    const int batchCount = (*reader)->num_record_batches();
+    const qint64 fileSize = QFileInfo(filePath).size();
+    for (int b = 0; b < batchCount; ++b) {
+        if (token->isCancelled()) {
+            result.errorMessage = "Import cancelled";
+            break;
+        }
+
+        auto batch = (*reader)->ReadRecordBatch(b);
+        if (!batch.ok()) {
+            result.errorMessage = statusText(batch.status());
+            break;
+        }
+
+        // Whole columns are bound at once; each record batch is one transaction
+        for (int c = 0; c < (*batch)->num_columns(); ++c) {
+            insert.addBindValue(columnValues(*(*batch)->column(c)));
+        }
+        db.transaction();
+        if (!insert.execBatch()) {
+            result.errorMessage = insert.lastError().text();
+            db.rollback();
+            break;
+        }
+        db.commit();
+
+        result.rowCount += int((*batch)->num_rows());
+        progress->rows += (*batch)->num_rows();
+        progress->bytes = fileSize * (b + 1) / qMax(1, batchCount);
+    }
+
+    result.executionTimeMs = timer.elapsed();
+    result.success = result.errorMessage.isEmpty();
+    return result;
+#endif
+}
@@ -0,0 +1,517 @@
+#include "core/bulk_writer.h"
+#include "core/sql_dialect.h"
+#include <QDate>
+#include <QDateTime>
+#include <QDir>
+#include <QLocale>
+#include <QSqlDriver>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QTemporaryFile>
+#include <QTime>
+
+#ifdef HAVE_LIBPQ
+#include <libpq-fe.h>
+#endif
+
+namespace {
+constexpr int kInsertRowsPerStatement = 1000;
+
+// Text form of a value as COPY / LOAD DATA expect it
+QByteArray bulkText(DatabaseType type, const QVariant &value) {
+    switch (value.metaType().id()) {
+        case QMetaType::Bool:
+            if (type == DatabaseType::PostgreSQL) {
+                return value.toBool() ? "t" : "f";
+            }
+            return value.toBool() ? "1" : "0";
+        case QMetaType::Double:
+        case QMetaType::Float:
+            // Shortest text that reads back as the same double
+            return QString::number(value.toDouble(), 'g', QLocale::FloatingPointShortest).toLatin1();
+        case QMetaType::QByteArray:
+            if (type == DatabaseType::PostgreSQL) {
+                return "\\x" + value.toByteArray().toHex();
+            }
+            return value.toByteArray();
+        case QMetaType::QDate:
+            return value.toDate().toString(Qt::ISODate).toUtf8();
+        case QMetaType::QTime:
+            return value.toTime().toString(Qt::ISODateWithMs).toUtf8();
+        case QMetaType::QDateTime:
+            return value.toDateTime().toString("yyyy-MM-dd HH:mm:ss.zzz").toUtf8();
+        default:
+            return value.toString().toUtf8();
+    }
+}
+
+void appendQuoted(QByteArray &out, const QByteArray &text) {
+    out += '"';
+    for (const char ch : text) {
+        if (ch == '"') {
+            out += '"';
+        }
+        out += ch;
+    }
+    out += '"';
+}
+
+bool isNullValue(const QVariant &value) {
+    return !value.isValid() || value.isNull();
+}
+
+// SQLite: one prepared INSERT reused for every row, a transaction per batch, and a
+// larger page cache for the duration of the load
+class PreparedInsertWriter : public BulkWriter {
+public:
+    using BulkWriter::BulkWriter;
+
+    bool begin(QString *errorMessage) override {
+        QSqlQuery pragma(db);
+        if (pragma.exec("PRAGMA synchronous") && pragma.next()) {
+            previousSynchronous = pragma.value(0).toString();
+        }
+        if (pragma.exec("PRAGMA journal_mode") && pragma.next()) {
+            previousJournalMode = pragma.value(0).toString();
+        }
+        if (pragma.exec("PRAGMA cache_size") && pragma.next()) {
+            previousCacheSize = pragma.value(0).toString();
+        }
+
+        // The file is the user's own database, so the journal stays as it is: without it
+        // a crash mid-load could corrupt the whole file, not just the import. Only WAL
+        // databases may skip the fsync per commit, since NORMAL is crash-safe there.
+        if (previousJournalMode.compare("wal", Qt::CaseInsensitive) == 0 && previousSynchronous.toInt() > 1) {
+            pragma.exec("PRAGMA synchronous = NORMAL");
+        }
+        pragma.exec("PRAGMA cache_size = -65536");
+
+        QStringList placeholders;
+        for (int i = 0; i < columns.size(); ++i) {
+            placeholders << "?";
+        }
+        insert = std::make_unique<QSqlQuery>(db);
+        if (!insert->prepare(QString("INSERT INTO %1 (%2) VALUES (%3)")
+                                 .arg(target, columnList(), placeholders.join(", ")))) {
+            if (errorMessage) {
+                *errorMessage = "Failed to prepare insert: " + insert->lastError().text();
+            }
+            restorePragmas();
+            return false;
+        }
+        return true;
+    }
+
+    bool writeRows(const QList<BulkRow> &rows, QString *errorMessage) override {
+        // execBatch binds whole columns
+        QVector<QVariantList> columnValues(columns.size());
+        for (QVariantList &values : columnValues) {
+            values.reserve(rows.size());
+        }
+        for (const BulkRow &row : rows) {
+            for (int i = 0; i < columns.size(); ++i) {
+                columnValues[i].append(row.value(i));
+            }
+        }
+        for (const QVariantList &values : columnValues) {
+            insert->addBindValue(values);
+        }
+
+        db.transaction();
+        if (!insert->execBatch()) {
+            if (errorMessage) {
+                *errorMessage = insert->lastError().text();
+            }
+            db.rollback();
+            return false;
+        }
+        return db.commit();
+    }
+
+    bool finish(QString *) override {
+        insert.reset();
+        restorePragmas();
+        return true;
+    }
+
+    void abort() override {
+        insert.reset();
+        restorePragmas();
+    }
+
+    QString method() const override {
+        return "prepared INSERT in batched transactions";
+    }
+
+private:
+    void restorePragmas() {
+        QSqlQuery pragma(db);
+        if (!previousSynchronous.isEmpty()) {
+            pragma.exec(QString("PRAGMA synchronous = %1").arg(previousSynchronous.toInt()));
+        }
+        if (!previousCacheSize.isEmpty()) {
+            pragma.exec(QString("PRAGMA cache_size = %1").arg(previousCacheSize.toInt()));
+        }
+        previousSynchronous.clear();
+        previousJournalMode.clear();
+        previousCacheSize.clear();
+    }
+
+    std::unique_ptr<QSqlQuery> insert;
+    QString previousSynchronous;
+    QString previousJournalMode;
+    QString previousCacheSize;
+};
+
+// Fallback for servers without a native path: multi-row INSERT statements with
+// literal values, which are far cheaper than QtSql's row-at-a-time batch emulation
+class MultiRowInsertWriter : public BulkWriter {
+public:
+    using BulkWriter::BulkWriter;
+
+    bool begin(QString *) override {
+        return true;
+    }
+
+    bool writeRows(const QList<BulkRow> &rows, QString *errorMessage) override {
+        const QString prefix = QString("INSERT INTO %1 (%2) VALUES ").arg(target, columnList());
+
+        db.transaction();
+        QSqlQuery query(db);
+        for (int start = 0; start < rows.size(); start += kInsertRowsPerStatement) {
+            const int end = qMin(start + kInsertRowsPerStatement, int(rows.size()));
+            QString statement = prefix;
+            for (int r = start; r < end; ++r) {
+                statement += r > start ? ",(" : "(";
+                const BulkRow &row = rows.at(r);
+                for (int i = 0; i < columns.size(); ++i) {
+                    if (i > 0) statement += ',';
+                    statement += SqlDialect::literal(type, row.value(i));
+                }
+                statement += ')';
+            }
+            if (!query.exec(statement)) {
+                if (errorMessage) {
+                    *errorMessage = query.lastError().text();
+                }
+                db.rollback();
+                return false;
+            }
+        }
+        return db.commit();
+    }
+
+    bool finish(QString *) override {
+        return true;
+    }
+
+    void abort() override {
+    }
+
+    QString method() const override {
+        return "multi-row INSERT";
+    }
+};
+
+// MySQL: each batch is written to a temporary file and loaded with LOAD DATA LOCAL
+// INFILE. ESCAPED BY '' keeps backslashes literal; NULL is the bare word NULL.
+// With LOCAL the server turns duplicate keys and bad values into warnings and skips
+// or converts the rows, so a batch that raised any is rolled back and fails. Servers
+// refusing LOCAL (local_infile is off by default since MySQL 8) get multi-row INSERTs.
+class LoadDataWriter : public BulkWriter {
+public:
+    LoadDataWriter(QSqlDatabase db, DatabaseType type, const QString &tableName, const QStringList &columns)
+        : BulkWriter(db, type, tableName, columns), tableName(tableName) {}
+
+    bool begin(QString *) override {
+        return true;
+    }
+
+    bool writeRows(const QList<BulkRow> &rows, QString *errorMessage) override {
+        if (fallback) {
+            return fallback->writeRows(rows, errorMessage);
+        }
+
+        QTemporaryFile file;
+        if (!file.open()) {
+            if (errorMessage) {
+                *errorMessage = "Failed to create temporary file: " + file.errorString();
+            }
+            return false;
+        }
+
+        QByteArray data;
+        for (const BulkRow &row : rows) {
+            for (int i = 0; i < columns.size(); ++i) {
+                if (i > 0) data += ',';
+                const QVariant value = row.value(i);
+                if (isNullValue(value)) {
+                    data += "NULL";
+                } else {
+                    appendQuoted(data, bulkText(type, value));
+                }
+            }
+            data += '\n';
+            if (data.size() >= (1 << 20)) {
+                file.write(data);
+                data.clear();
+            }
+        }
+        file.write(data);
+        file.flush();
+
+        QSqlQuery query(db);
+        const QString statement = QString(
+            "LOAD DATA LOCAL INFILE %1 INTO TABLE %2 CHARACTER SET utf8mb4 "
+            "FIELDS TERMINATED BY ',' ENCLOSED BY '\"' ESCAPED BY '' "
+            "LINES TERMINATED BY '\\n' (%3)")
+            .arg(SqlDialect::literal(type, QDir::fromNativeSeparators(file.fileName())), target, columnList());
+        db.transaction();
+        if (!query.exec(statement)) {
+            const QString error = query.lastError().text();
+            db.rollback();
+            if (localInfileRefused(query.lastError().nativeErrorCode())) {
+                fallback = std::make_unique<MultiRowInsertWriter>(db, type, tableName, columns);
+                return fallback->writeRows(rows, errorMessage);
+            }
+            if (errorMessage) {
+                *errorMessage = error;
+            }
+            return false;
+        }
+
+        // Any warning stands for a row skipped or changed
+        if (query.exec("SHOW COUNT(*) WARNINGS") && query.next() && query.value(0).toLongLong() > 0) {
+            const qint64 warnings = query.value(0).toLongLong();
+            QString first;
+            if (query.exec("SHOW WARNINGS LIMIT 1") && query.next()) {
+                first = query.value(2).toString();
+            }
+            db.rollback();
+            if (errorMessage) {
+                *errorMessage = QString("LOAD DATA raised %1 warnings, so the batch was rolled back: %2")
+                                    .arg(warnings).arg(first);
+            }
+            return false;
+        }
+        if (!db.commit()) {
+            if (errorMessage) {
+                *errorMessage = db.lastError().text();
+            }
+            return false;
+        }
+        return true;
+    }
+
+    bool finish(QString *) override {
+        return true;
+    }
+
+    void abort() override {
+    }
+
+    QString method() const override {
+        return fallback ? fallback->method() + " (LOAD DATA LOCAL is disabled on the server)"
+                        : QString("LOAD DATA LOCAL INFILE");
+    }
+
+private:
+    // 1148: the used command is not allowed; 3948: local data is disabled on the
+    // server; 2068: the client refused the file request
+    static bool localInfileRefused(const QString &code) {
+        return code == "1148" || code == "3948" || code == "2068";
+    }
+
+    QString tableName;
+    std::unique_ptr<MultiRowInsertWriter> fallback;
+};
+
+#ifdef HAVE_LIBPQ
+PGconn *postgresHandle(QSqlDatabase db) {
+    const QVariant handle = db.driver()->handle();
+    if (handle.isValid() && qstrcmp(handle.typeName(), "PGconn*") == 0) {
+        return *static_cast<PGconn *const *>(handle.data());
+    }
+    return nullptr;
+}
+
+// PostgreSQL: a single COPY ... FROM STDIN (FORMAT csv) stream for the whole load,
+// driven through the QPSQL session's libpq connection
+class CopyWriter : public BulkWriter {
+public:
+    CopyWriter(QSqlDatabase db, DatabaseType type, const QString &tableName, const QStringList &columns,
+               PGconn *connection)
+        : BulkWriter(db, type, tableName, columns), connection(connection), copying(false) {}
+
+    bool begin(QString *errorMessage) override {
+        const QByteArray statement = QString("COPY %1 (%2) FROM STDIN WITH (FORMAT csv)")
+                                         .arg(target, columnList()).toUtf8();
+        PGresult *result = PQexec(connection, statement.constData());
+        const bool ok = PQresultStatus(result) == PGRES_COPY_IN;
+        PQclear(result);
+        if (!ok) {
+            if (errorMessage) {
+                *errorMessage = QString::fromUtf8(PQerrorMessage(connection)).trimmed();
+            }
+            return false;
+        }
+        copying = true;
+        return true;
+    }
+
+    bool writeRows(const QList<BulkRow> &rows, QString *errorMessage) override {
+        QByteArray data;
+        for (const BulkRow &row : rows) {
+            for (int i = 0; i < columns.size(); ++i) {
+                if (i > 0) data += ',';
+                const QVariant value = row.value(i);
+                // Unquoted empty is NULL in CSV COPY; everything else is quoted
+                if (!isNullValue(value)) {
+                    appendQuoted(data, bulkText(type, value));
+                }
+            }
+            data += '\n';
+        }
+
+        if (PQputCopyData(connection, data.constData(), int(data.size())) != 1) {
+            if (errorMessage) {
+                *errorMessage = QString::fromUtf8(PQerrorMessage(connection)).trimmed();
+            }
+            return false;
+        }
+        return true;
+    }
+
+    bool commit(QString *errorMessage) override {
+        return endCopy(nullptr, errorMessage) && begin(errorMessage);
+    }
+
+    bool finish(QString *errorMessage) override {
+        return endCopy(nullptr, errorMessage);
+    }
+
+    void abort() override {
+        endCopy("import cancelled", nullptr);
+    }
+
+    QString method() const override {
+        return "COPY FROM STDIN";
+    }
+
+    bool commitsEachBatch() const override {
+        return false;
+    }
+
+private:
+    bool endCopy(const char *failure, QString *errorMessage) {
+        if (!copying) {
+            return true;
+        }
+        copying = false;
+
+        bool ok = PQputCopyEnd(connection, failure) == 1;
+        while (PGresult *result = PQgetResult(connection)) {
+            if (PQresultStatus(result) != PGRES_COMMAND_OK) {
+                ok = false;
+            }
+            PQclear(result);
+        }
+        if (!ok && errorMessage) {
+            *errorMessage = QString::fromUtf8(PQerrorMessage(connection)).trimmed();
+        }
+        return ok && !failure;
+    }
+
+    PGconn *connection;
+    bool copying;
+};
+#endif
+} // namespace
+
+BulkWriter::BulkWriter(QSqlDatabase db, DatabaseType type, const QString &tableName, const QStringList &columns)
+    : db(db), type(type), target(SqlDialect::qualifiedName(type, tableName)), columns(columns) {
+}
+
+bool BulkWriter::commit(QString *) {
+    return true;
+}
+
+QString BulkWriter::columnList() const {
+    QStringList quoted;
+    for (const QString &column : columns) {
+        quoted << SqlDialect::quoteIdentifier(type, column);
+    }
+    return quoted.join(", ");
+}
+
+std::unique_ptr<BulkWriter> BulkWriter::create(QSqlDatabase db, DatabaseType type, const QString &tableName,
+                                               const QStringList &columns) {
+    switch (type) {
+        case DatabaseType::SQLite:
+            return std::make_unique<PreparedInsertWriter>(db, type, tableName, columns);
+        case DatabaseType::MySQL:
+            return std::make_unique<LoadDataWriter>(db, type, tableName, columns);
+        case DatabaseType::PostgreSQL:
+#ifdef HAVE_LIBPQ
+            if (PGconn *connection = postgresHandle(db)) {
+                return std::make_unique<CopyWriter>(db, type, tableName, columns, connection);
+            }
+#endif
+            break;
+    }
+    return std::make_unique<MultiRowInsertWriter>(db, type, tableName, columns);
+}
+
+ConnectionInfo BulkWriter::bulkConnectionInfo(const ConnectionInfo &connInfo, DatabaseType type) {
+    ConnectionInfo info = connInfo;
+    if (type == DatabaseType::MySQL) {
+        // LOAD DATA LOCAL is refused unless the client enables it; use a separate
+        // session name so regular sessions keep their options
+        info.connectOptions = info.connectOptions.isEmpty()
+            ? QString("MYSQL_OPT_LOCAL_INFILE=1")
+            : info.connectOptions + ";MYSQL_OPT_LOCAL_INFILE=1";
+        info.name += "#bulk";
+    }
+    return info;
+}
+
+bool BulkWriter::copyFromStdin(QSqlDatabase db, const QByteArray &statement, const QByteArray &rows,
+                               QString *errorMessage) {
+#ifdef HAVE_LIBPQ
+    if (PGconn *connection = postgresHandle(db)) {
+        // statement may be a view into a mapped file, so give libpq a terminated copy
+        const QByteArray sql(statement.constData(), statement.size());
+        PGresult *result = PQexec(connection, sql.constData());
+        const bool started = PQresultStatus(result) == PGRES_COPY_IN;
+        PQclear(result);
+
+        bool ok = started;
+        constexpr qsizetype kChunkBytes = 1 << 20;
+        for (qsizetype offset = 0; ok && offset < rows.size(); offset += kChunkBytes) {
+            const int length = int(qMin(kChunkBytes, rows.size() - offset));
+            ok = PQputCopyData(connection, rows.constData() + offset, length) == 1;
+        }
+        if (started) {
+            ok = PQputCopyEnd(connection, ok ? nullptr : "copy data could not be sent") == 1 && ok;
+        }
+        while (PGresult *pending = PQgetResult(connection)) {
+            if (PQresultStatus(pending) != PGRES_COMMAND_OK) {
+                ok = false;
+            }
+            PQclear(pending);
+        }
+        if (!ok && errorMessage) {
+            *errorMessage = QString::fromUtf8(PQerrorMessage(connection)).trimmed();
+        }
+        return ok;
+    }
+#else
+    Q_UNUSED(db);
+    Q_UNUSED(statement);
+    Q_UNUSED(rows);
+#endif
+    if (errorMessage) {
+        *errorMessage = "COPY ... FROM stdin needs a PostgreSQL connection and a build with libpq";
+    }
+    return false;
+}
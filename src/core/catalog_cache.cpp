@@ -0,0 +1,216 @@
+#include "core/catalog_cache.h"
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QStandardPaths>
+#include <QDir>
+#include <QDebug>
+#include <QDataStream>
+#include <QThread>
+#include <QCoreApplication>
+
+// Found by argument-dependent lookup from QDataStream's QList operators, so they
+// can't live in an anonymous namespace
+static QDataStream &operator<<(QDataStream &out, const RelationInfo &relation) {
+    return out << relation.schema << relation.name << static_cast<qint32>(relation.kind)
+               << relation.estimatedRows << relation.sizeBytes;
+}
+
+static QDataStream &operator>>(QDataStream &in, RelationInfo &relation) {
+    qint32 kind = 0;
+    in >> relation.schema >> relation.name >> kind >> relation.estimatedRows >> relation.sizeBytes;
+    relation.kind = static_cast<RelationKind>(kind);
+    return in;
+}
+
+static QDataStream &operator<<(QDataStream &out, const ColumnInfo &column) {
+    return out << column.schema << column.table << column.name << column.dataType
+               << column.nullable << column.defaultValue << column.extra;
+}
+
+static QDataStream &operator>>(QDataStream &in, ColumnInfo &column) {
+    return in >> column.schema >> column.table >> column.name >> column.dataType
+              >> column.nullable >> column.defaultValue >> column.extra;
+}
+
+static QDataStream &operator<<(QDataStream &out, const IndexInfo &index) {
+    return out << index.schema << index.table << index.name << index.columns << index.unique << index.primary
+               << index.constraint;
+}
+
+static QDataStream &operator>>(QDataStream &in, IndexInfo &index) {
+    return in >> index.schema >> index.table >> index.name >> index.columns >> index.unique >> index.primary
+              >> index.constraint;
+}
+
+static QDataStream &operator<<(QDataStream &out, const ForeignKeyInfo &foreignKey) {
+    return out << foreignKey.schema << foreignKey.table << foreignKey.name << foreignKey.columns
+               << foreignKey.referencedSchema << foreignKey.referencedTable << foreignKey.referencedColumns;
+}
+
+static QDataStream &operator>>(QDataStream &in, ForeignKeyInfo &foreignKey) {
+    return in >> foreignKey.schema >> foreignKey.table >> foreignKey.name >> foreignKey.columns
+              >> foreignKey.referencedSchema >> foreignKey.referencedTable >> foreignKey.referencedColumns;
+}
+
+CatalogCache& CatalogCache::instance() {
+    static CatalogCache instance;
+    return instance;
+}
+
+bool CatalogCache::initialize() {
+    // A separate file from connections.db: it can grow large and is safe to delete
+    QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir dir(dataDir);
+    if (!dir.exists()) {
+        dir.mkpath(dataDir);
+    }
+
+    QString dbPath = dataDir + "/catalog_cache.db";
+    qDebug() << "Catalog cache path:" << dbPath;
+
+    cacheDb = QSqlDatabase::addDatabase("QSQLITE", CACHE_DB_NAME);
+    cacheDb.setDatabaseName(dbPath);
+
+    if (!cacheDb.open()) {
+        qWarning() << "Failed to open catalog cache:" << cacheDb.lastError().text();
+        return false;
+    }
+
+    QSqlQuery query(cacheDb);
+    QString createTableSQL = R"(
+        CREATE TABLE IF NOT EXISTS catalog_snapshots (
+            connection TEXT NOT NULL,
+            schema_name TEXT NOT NULL,
+            version TEXT NOT NULL,
+            payload BLOB NOT NULL,
+            updated_at DATETIME DEFAULT CURRENT_TIMESTAMP,
+            PRIMARY KEY (connection, schema_name)
+        )
+    )";
+
+    if (!query.exec(createTableSQL)) {
+        qWarning() << "Failed to create catalog_snapshots table:" << query.lastError().text();
+        return false;
+    }
+
+    return true;
+}
+
+QSqlDatabase CatalogCache::threadCacheDatabase() {
+    if (QThread::currentThread() == QCoreApplication::instance()->thread()) {
+        return cacheDb;
+    }
+
+    const QString name = QString("%1_%2").arg(CACHE_DB_NAME).arg((quintptr)QThread::currentThreadId());
+    if (!QSqlDatabase::contains(name)) {
+        QSqlDatabase db = QSqlDatabase::cloneDatabase(CACHE_DB_NAME, name);
+        db.setConnectOptions("QSQLITE_BUSY_TIMEOUT=5000");
+        QObject::connect(QThread::currentThread(), &QThread::finished, [name]() {
+            {
+                QSqlDatabase threadDb = QSqlDatabase::database(name, false);
+                threadDb.close();
+            }
+            QSqlDatabase::removeDatabase(name);
+        });
+    }
+
+    QSqlDatabase db = QSqlDatabase::database(name, false);
+    if (!db.isOpen() && !db.open()) {
+        qWarning() << "Failed to open catalog cache:" << db.lastError().text();
+    }
+    return db;
+}
+
+QHash<QString, CatalogSnapshot> CatalogCache::load(const QString &connection) {
+    QHash<QString, CatalogSnapshot> snapshots;
+
+    QSqlQuery query(threadCacheDatabase());
+    query.setForwardOnly(true);
+    query.prepare("SELECT schema_name, version, payload FROM catalog_snapshots WHERE connection = ?");
+    query.addBindValue(connection);
+
+    if (!query.exec()) {
+        qWarning() << "Failed to load catalog cache:" << query.lastError().text();
+        return snapshots;
+    }
+
+    while (query.next()) {
+        CatalogSnapshot snapshot;
+        snapshot.schema = query.value(0).toString();
+        snapshot.version = query.value(1).toString();
+
+        QDataStream in(query.value(2).toByteArray());
+        qint32 format = 0;
+        in >> format;
+        if (format != kPayloadFormat) {
+            continue;
+        }
+        in >> snapshot.relations >> snapshot.columns >> snapshot.indexes >> snapshot.foreignKeys;
+        if (in.status() != QDataStream::Ok) {
+            qWarning() << "Discarding corrupt catalog cache entry for" << connection << snapshot.schema;
+            continue;
+        }
+
+        snapshot.shareStrings();
+        snapshots.insert(snapshot.schema, snapshot);
+    }
+
+    return snapshots;
+}
+
+bool CatalogCache::store(const QString &connection, const QList<CatalogSnapshot> &changed,
+                         const QStringList &dropped) {
+    QSqlDatabase db = threadCacheDatabase();
+    if (!db.transaction()) {
+        qWarning() << "Failed to update catalog cache:" << db.lastError().text();
+        return false;
+    }
+
+    QSqlQuery query(db);
+    query.prepare("DELETE FROM catalog_snapshots WHERE connection = ? AND schema_name = ?");
+    for (const QString &schema : dropped) {
+        query.addBindValue(connection);
+        query.addBindValue(schema);
+        if (!query.exec()) {
+            qWarning() << "Failed to update catalog cache:" << query.lastError().text();
+            db.rollback();
+            return false;
+        }
+    }
+
+    query.prepare(R"(
+        INSERT OR REPLACE INTO catalog_snapshots (connection, schema_name, version, payload, updated_at)
+        VALUES (?, ?, ?, ?, CURRENT_TIMESTAMP)
+    )");
+    for (const CatalogSnapshot &snapshot : changed) {
+        QByteArray payload;
+        QDataStream out(&payload, QIODevice::WriteOnly);
+        out << kPayloadFormat << snapshot.relations << snapshot.columns << snapshot.indexes
+            << snapshot.foreignKeys;
+
+        query.addBindValue(connection);
+        query.addBindValue(snapshot.schema);
+        query.addBindValue(snapshot.version);
+        query.addBindValue(payload);
+        if (!query.exec()) {
+            qWarning() << "Failed to update catalog cache:" << query.lastError().text();
+            db.rollback();
+            return false;
+        }
+    }
+
+    return db.commit();
+}
+
+bool CatalogCache::remove(const QString &connection) {
+    QSqlQuery query(threadCacheDatabase());
+    query.prepare("DELETE FROM catalog_snapshots WHERE connection = ?");
+    query.addBindValue(connection);
+
+    if (!query.exec()) {
+        qWarning() << "Failed to remove catalog cache:" << query.lastError().text();
+        return false;
+    }
+
+    return true;
+}
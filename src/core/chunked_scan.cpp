@@ -0,0 +1,354 @@
+#include "core/chunked_scan.h"
+#include "core/bounded_queue.h"
+#include "core/sql_dialect.h"
+#include "core/table_statistics.h"
+#include <QMutex>
+#include <QSemaphore>
+#include <QSqlError>
+#include <QSqlField>
+#include <QSqlIndex>
+#include <QSqlQuery>
+#include <QThreadPool>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace {
+bool isIntegerType(QMetaType type) {
+    switch (type.id()) {
+        case QMetaType::Int:
+        case QMetaType::UInt:
+        case QMetaType::Short:
+        case QMetaType::UShort:
+        case QMetaType::Long:
+        case QMetaType::ULong:
+        case QMetaType::LongLong:
+        case QMetaType::ULongLong:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool isRealType(QMetaType type) {
+    return type.id() == QMetaType::Double || type.id() == QMetaType::Float;
+}
+} // namespace
+
+ChunkedScan::ChunkedScan(const ConnectionInfo &connInfo, DatabaseType type, const ChunkedScanOptions &options)
+    : connInfo(connInfo), type(type), options(options) {
+}
+
+QString ChunkedScan::keyColumn(QSqlDatabase db, const QString &table) {
+    const QSqlIndex primaryKey = db.primaryIndex(table);
+    return primaryKey.count() == 1 ? primaryKey.fieldName(0) : QString();
+}
+
+bool ChunkedScan::plan(QSqlDatabase db, QString *errorMessage) {
+    const QSqlRecord layout = db.record(options.table);
+    if (layout.isEmpty()) {
+        if (errorMessage) {
+            *errorMessage = QString("Table '%1' was not found").arg(options.table);
+        }
+        return false;
+    }
+
+    columnNames = options.columns;
+    if (columnNames.isEmpty()) {
+        for (int i = 0; i < layout.count(); ++i) {
+            columnNames << layout.fieldName(i);
+        }
+    }
+
+    conditions.clear();
+    const int chunkCount = qMax(1, options.concurrency) * qMax(1, options.chunksPerSession);
+    const QStringList bounds = options.keyColumn.isEmpty() || !layout.contains(options.keyColumn) || chunkCount == 1
+        ? QStringList()
+        : keyBounds(db, layout.field(options.keyColumn).metaType(), chunkCount);
+    if (bounds.isEmpty()) {
+        conditions << QString();
+        return true;
+    }
+
+    // The first and last ranges are open-ended so rows outside stale statistics are
+    // still read
+    const QString key = SqlDialect::quoteIdentifier(type, options.keyColumn);
+    conditions << QString("(%1 < %2 OR %1 IS NULL)").arg(key, bounds.first());
+    for (int i = 1; i < bounds.size(); ++i) {
+        conditions << QString("%1 >= %2 AND %1 < %3").arg(key, bounds.at(i - 1), bounds.at(i));
+    }
+    conditions << QString("%1 >= %2").arg(key, bounds.last());
+    return true;
+}
+
+QStringList ChunkedScan::keyBounds(QSqlDatabase db, QMetaType keyType, int chunkCount) const {
+    QString table;
+    QString schema;
+    TableStatistics::splitTableName(options.table, &table, &schema);
+
+    QVariantList values;
+    const QStringList histogram = TableStatistics::histogramBounds(db, type, table, schema, options.keyColumn);
+    if (histogram.size() > 2) {
+        // Histogram buckets hold roughly equal row counts, so evenly spaced bounds
+        // give evenly sized ranges even for skewed keys
+        for (int i = 1; i < chunkCount; ++i) {
+            QVariant value = histogram.at(int(qint64(i) * (histogram.size() - 1) / chunkCount));
+            if ((isIntegerType(keyType) || isRealType(keyType)) && !value.convert(keyType)) {
+                return QStringList();
+            }
+            values << value;
+        }
+    } else if (isIntegerType(keyType) || isRealType(keyType)) {
+        QString sql = QString("SELECT MIN(%1), MAX(%1) FROM %2")
+                          .arg(SqlDialect::quoteIdentifier(type, options.keyColumn),
+                               SqlDialect::qualifiedName(type, options.table));
+        if (!options.filter.isEmpty()) {
+            sql += QString(" WHERE %1").arg(options.filter);
+        }
+        QSqlQuery query(db);
+        if (!query.exec(sql) || !query.next() || query.isNull(0) || query.isNull(1)) {
+            return QStringList();
+        }
+
+        if (isIntegerType(keyType)) {
+            const qint64 low = query.value(0).toLongLong();
+            const qint64 high = query.value(1).toLongLong();
+            const double step = (double(high) - double(low)) / chunkCount;
+            for (int i = 1; i < chunkCount && step >= 1.0; ++i) {
+                values << QVariant(low + qint64(step * i));
+            }
+        } else {
+            const double low = query.value(0).toDouble();
+            const double high = query.value(1).toDouble();
+            const double step = (high - low) / chunkCount;
+            for (int i = 1; i < chunkCount && step > 0.0; ++i) {
+                values << QVariant(low + step * i);
+            }
+        }
+    }
+
+    // Ranges need strictly increasing bounds; repeated histogram values collapse
+    QStringList bounds;
+    QString previous;
+    for (const QVariant &value : values) {
+        const QString bound = SqlDialect::literal(type, value);
+        if (bound != previous) {
+            bounds << bound;
+            previous = bound;
+        }
+    }
+    return bounds;
+}
+
+QString ChunkedScan::chunkQuery(int chunk) const {
+    QStringList quoted;
+    for (const QString &column : columnNames) {
+        quoted << SqlDialect::quoteIdentifier(type, column);
+    }
+    QString sql = QString("SELECT %1 FROM %2").arg(quoted.join(", "), SqlDialect::qualifiedName(type, options.table));
+
+    QStringList predicates;
+    if (!conditions.at(chunk).isEmpty()) {
+        predicates << conditions.at(chunk);
+    }
+    if (!options.filter.isEmpty()) {
+        predicates << QString("(%1)").arg(options.filter);
+    }
+    if (!predicates.isEmpty()) {
+        sql += " WHERE " + predicates.join(" AND ");
+    }
+    if (options.ordered && !options.keyColumn.isEmpty()) {
+        sql += " ORDER BY " + SqlDialect::quoteIdentifier(type, options.keyColumn);
+    }
+    return sql;
+}
+
+bool ChunkedScan::run(const BatchConsumer &consumer, const CancelTokenPtr &token, QString *errorMessage) {
+    using RecordQueue = BoundedQueue<QList<QSqlRecord>>;
+
+    const int chunks = conditions.size();
+    const int workers = qBound(1, options.concurrency, chunks);
+    const int batchRows = qMax(1, options.batchRows);
+
+    // Ordered scans give every range its own queue and drain them in turn; unordered
+    // ones share a single queue
+    std::vector<std::unique_ptr<RecordQueue>> queues;
+    if (options.ordered) {
+        for (int i = 0; i < chunks; ++i) {
+            queues.push_back(std::make_unique<RecordQueue>(kQueueBatches));
+        }
+    } else {
+        queues.push_back(std::make_unique<RecordQueue>(kQueueBatches * workers));
+    }
+
+    std::atomic<bool> stop{false};
+    std::atomic<int> remaining{chunks};
+    std::atomic<int> nextChunk{0};
+    QMutex errorMutex;
+    QString scanError;
+    auto fail = [&](const QString &message) {
+        QMutexLocker locker(&errorMutex);
+        if (scanError.isEmpty()) {
+            scanError = message;
+        }
+        stop = true;
+    };
+    auto cancelled = [&token]() {
+        return token && token->isCancelled();
+    };
+
+    // Every session reads the same snapshot: one exported by the calling thread's
+    // session on PostgreSQL; on MySQL each session starts its own while the calling
+    // session holds the table read-locked, so no write commits in between. Without the
+    // privileges, ranges are read in separate snapshots.
+    QString openError;
+    QSqlDatabase control = QueryExecutor::threadDatabase(connInfo, &openError);
+    if (!control.isValid() || !control.isOpen()) {
+        if (errorMessage) {
+            *errorMessage = openError;
+        }
+        return false;
+    }
+    QSqlQuery controlQuery(control);
+    QString snapshotId;
+    bool tableLocked = false;
+    if (type == DatabaseType::PostgreSQL) {
+        if (controlQuery.exec("BEGIN ISOLATION LEVEL REPEATABLE READ READ ONLY")) {
+            if (controlQuery.exec("SELECT pg_export_snapshot()") && controlQuery.next()) {
+                snapshotId = controlQuery.value(0).toString();
+            } else {
+                controlQuery.exec("ROLLBACK");
+            }
+        }
+    } else if (type == DatabaseType::MySQL) {
+        tableLocked = controlQuery.exec(QString("LOCK TABLES %1 READ")
+                                            .arg(SqlDialect::qualifiedName(type, options.table)));
+    }
+
+    // Cancelling interrupts the statement of every session still reading, from a
+    // separate session
+    ServerCancelGroup sessions(token);
+
+    // Each worker keeps one session and one transaction for all the ranges it picks
+    // up. Ranges are taken in order, so the one an ordered consumer is waiting for is
+    // always being read.
+    QSemaphore started;
+    QThreadPool pool;
+    pool.setMaxThreadCount(workers);
+    for (int w = 0; w < workers; ++w) {
+        pool.start([&]() {
+            QString workerError;
+            QSqlDatabase db = QueryExecutor::threadDatabase(connInfo, &workerError);
+            bool open = db.isValid() && db.isOpen();
+            QSqlQuery query(db);
+            query.setNumericalPrecisionPolicy(options.precision);
+            if (open && type == DatabaseType::PostgreSQL && !snapshotId.isEmpty()) {
+                open = query.exec("BEGIN ISOLATION LEVEL REPEATABLE READ READ ONLY")
+                    && query.exec(QString("SET TRANSACTION SNAPSHOT %1").arg(SqlDialect::literal(type, snapshotId)));
+                workerError = query.lastError().text();
+            } else if (open && type == DatabaseType::MySQL && tableLocked) {
+                open = query.exec("SET SESSION TRANSACTION ISOLATION LEVEL REPEATABLE READ")
+                    && query.exec("START TRANSACTION WITH CONSISTENT SNAPSHOT, READ ONLY");
+                workerError = query.lastError().text();
+            }
+            started.release();
+
+            const QString session = open ? sessions.add(db, connInfo) : QString();
+            if (!open) {
+                fail(workerError);
+            }
+
+            for (int chunk = nextChunk++; chunk < chunks; chunk = nextChunk++) {
+                RecordQueue *queue = queues.at(options.ordered ? chunk : 0).get();
+                auto done = [&]() {
+                    if (options.ordered || --remaining == 0) {
+                        queue->close();
+                    }
+                };
+                if (stop || cancelled()) {
+                    done();
+                    continue;
+                }
+
+                query.setForwardOnly(true);
+                if (!query.exec(chunkQuery(chunk))) {
+                    fail(query.lastError().text());
+                    done();
+                    continue;
+                }
+
+                QList<QSqlRecord> batch;
+                batch.reserve(batchRows);
+                bool pushed = true;
+                while (!stop && !cancelled() && query.next()) {
+                    batch.append(query.record());
+                    if (batch.size() == batchRows) {
+                        if (!(pushed = queue->push(std::move(batch)))) {
+                            break;
+                        }
+                        batch = QList<QSqlRecord>();
+                        batch.reserve(batchRows);
+                    }
+                }
+                if (query.lastError().isValid()) {
+                    if (!cancelled()) {
+                        fail(query.lastError().text());
+                    }
+                } else if (pushed && !stop && !cancelled() && !batch.isEmpty()) {
+                    queue->push(std::move(batch));
+                }
+                query.finish();
+                done();
+            }
+
+            // An idle session must not be interrupted once it serves other work
+            sessions.remove(session);
+            if (open && (!snapshotId.isEmpty() || tableLocked)) {
+                query.exec("ROLLBACK");
+            }
+        });
+    }
+
+    // Writes to the table can resume once every session holds its snapshot
+    started.acquire(workers);
+    if (tableLocked) {
+        controlQuery.exec("UNLOCK TABLES");
+    }
+
+    bool consumed = true;
+    for (const std::unique_ptr<RecordQueue> &queue : queues) {
+        QList<QSqlRecord> batch;
+        while (!stop && queue->pop(batch)) {
+            if (!consumer(std::move(batch))) {
+                consumed = false;
+                break;
+            }
+        }
+        if (!consumed || stop) {
+            break;
+        }
+    }
+
+    stop = true;
+    for (const std::unique_ptr<RecordQueue> &queue : queues) {
+        queue->close();
+    }
+    pool.waitForDone();
+    if (!snapshotId.isEmpty()) {
+        controlQuery.exec("ROLLBACK");
+    }
+
+    if (cancelled()) {
+        if (errorMessage) {
+            *errorMessage = "Scan cancelled";
+        }
+        return false;
+    }
+    if (!scanError.isEmpty()) {
+        if (errorMessage) {
+            *errorMessage = scanError;
+        }
+        return false;
+    }
+    return consumed;
+}
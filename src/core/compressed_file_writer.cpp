@@ -0,0 +1,220 @@
+#include "core/compressed_file_writer.h"
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace {
+constexpr int kOutputChunkBytes = 256 * 1024;
+}
+
+struct CompressedFileWriter::Codec {
+    QByteArray output = QByteArray(kOutputChunkBytes, Qt::Uninitialized);
+#ifdef HAVE_ZLIB
+    z_stream zlib{};
+    bool zlibActive = false;
+#endif
+#ifdef HAVE_ZSTD
+    ZSTD_CCtx *zstd = nullptr;
+#endif
+
+    ~Codec() {
+#ifdef HAVE_ZLIB
+        if (zlibActive) {
+            deflateEnd(&zlib);
+        }
+#endif
+#ifdef HAVE_ZSTD
+        ZSTD_freeCCtx(zstd);
+#endif
+    }
+};
+
+CompressedFileWriter::CompressedFileWriter()
+    : compression(Compression::None), bytesIn(0), bytesOut(0) {
+}
+
+CompressedFileWriter::~CompressedFileWriter() {
+    if (file.isOpen()) {
+        close();
+    }
+}
+
+bool CompressedFileWriter::isAvailable(Compression compression) {
+    switch (compression) {
+        case Compression::None:
+            return true;
+        case Compression::Gzip:
+#ifdef HAVE_ZLIB
+            return true;
+#else
+            return false;
+#endif
+        case Compression::Zstd:
+#ifdef HAVE_ZSTD
+            return true;
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+Compression CompressedFileWriter::compressionForPath(const QString &filePath) {
+    if (filePath.endsWith(".gz", Qt::CaseInsensitive)) {
+        return Compression::Gzip;
+    }
+    if (filePath.endsWith(".zst", Qt::CaseInsensitive)) {
+        return Compression::Zstd;
+    }
+    return Compression::None;
+}
+
+QString CompressedFileWriter::stripCompressionSuffix(const QString &filePath) {
+    switch (compressionForPath(filePath)) {
+        case Compression::Gzip:
+            return filePath.chopped(3);
+        case Compression::Zstd:
+            return filePath.chopped(4);
+        case Compression::None:
+            break;
+    }
+    return filePath;
+}
+
+bool CompressedFileWriter::open(const QString &filePath, Compression compression, QString *errorMessage) {
+    if (!isAvailable(compression)) {
+        if (errorMessage) {
+            *errorMessage = "This build has no support for the requested compression";
+        }
+        return false;
+    }
+
+    file.setFileName(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        if (errorMessage) {
+            *errorMessage = file.errorString();
+        }
+        return false;
+    }
+
+    this->compression = compression;
+    bytesIn = 0;
+    bytesOut = 0;
+    buffer.clear();
+    buffer.reserve(kBufferBytes);
+    codec = std::make_unique<Codec>();
+
+#ifdef HAVE_ZLIB
+    if (compression == Compression::Gzip) {
+        // windowBits + 16 selects the gzip container instead of raw zlib
+        if (deflateInit2(&codec->zlib, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+                         Z_DEFAULT_STRATEGY) != Z_OK) {
+            if (errorMessage) {
+                *errorMessage = "Failed to initialize gzip compression";
+            }
+            file.close();
+            return false;
+        }
+        codec->zlibActive = true;
+    }
+#endif
+#ifdef HAVE_ZSTD
+    if (compression == Compression::Zstd) {
+        codec->zstd = ZSTD_createCCtx();
+        ZSTD_CCtx_setParameter(codec->zstd, ZSTD_c_compressionLevel, 3);
+    }
+#endif
+
+    return true;
+}
+
+bool CompressedFileWriter::write(const QByteArray &data, QString *errorMessage) {
+    bytesIn += data.size();
+    buffer.append(data);
+    if (buffer.size() >= kBufferBytes) {
+        return flushBuffer(false, errorMessage);
+    }
+    return true;
+}
+
+bool CompressedFileWriter::close(QString *errorMessage) {
+    if (!file.isOpen()) {
+        return true;
+    }
+
+    const bool flushed = flushBuffer(true, errorMessage);
+    file.close();
+    codec.reset();
+    return flushed;
+}
+
+bool CompressedFileWriter::writeOut(const char *data, qint64 size, QString *errorMessage) {
+    if (file.write(data, size) != size) {
+        if (errorMessage) {
+            *errorMessage = file.errorString();
+        }
+        return false;
+    }
+    bytesOut += size;
+    return true;
+}
+
+bool CompressedFileWriter::flushBuffer(bool finish, QString *errorMessage) {
+    bool ok = true;
+
+    switch (compression) {
+        case Compression::None:
+            ok = writeOut(buffer.constData(), buffer.size(), errorMessage);
+            break;
+        case Compression::Gzip: {
+#ifdef HAVE_ZLIB
+            z_stream &stream = codec->zlib;
+            stream.next_in = reinterpret_cast<Bytef *>(buffer.data());
+            stream.avail_in = uInt(buffer.size());
+            const int flush = finish ? Z_FINISH : Z_NO_FLUSH;
+            int status = Z_OK;
+            do {
+                stream.next_out = reinterpret_cast<Bytef *>(codec->output.data());
+                stream.avail_out = uInt(codec->output.size());
+                status = deflate(&stream, flush);
+                if (status == Z_STREAM_ERROR) {
+                    if (errorMessage) {
+                        *errorMessage = "gzip compression failed";
+                    }
+                    ok = false;
+                    break;
+                }
+                ok = writeOut(codec->output.constData(), codec->output.size() - stream.avail_out, errorMessage);
+            } while (ok && (stream.avail_out == 0 || (finish && status != Z_STREAM_END)));
+#endif
+            break;
+        }
+        case Compression::Zstd: {
+#ifdef HAVE_ZSTD
+            ZSTD_inBuffer input = {buffer.constData(), size_t(buffer.size()), 0};
+            const ZSTD_EndDirective mode = finish ? ZSTD_e_end : ZSTD_e_continue;
+            size_t remaining = 0;
+            do {
+                ZSTD_outBuffer output = {codec->output.data(), size_t(codec->output.size()), 0};
+                remaining = ZSTD_compressStream2(codec->zstd, &output, &input, mode);
+                if (ZSTD_isError(remaining)) {
+                    if (errorMessage) {
+                        *errorMessage = QString("zstd compression failed: %1").arg(ZSTD_getErrorName(remaining));
+                    }
+                    ok = false;
+                    break;
+                }
+                ok = writeOut(codec->output.constData(), qint64(output.pos), errorMessage);
+            } while (ok && (finish ? remaining != 0 : input.pos < input.size));
+#endif
+            break;
+        }
+    }
+
+    buffer.resize(0);  // keeps the allocation for the next round
+    return ok;
+}
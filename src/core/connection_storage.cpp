@@ -7,6 +7,8 @@
 #include <QCryptographicHash>
 #include <QByteArray>
 #include <QSysInfo>
+#include <QThread>
+#include <QCoreApplication>
 
 ConnectionStorage& ConnectionStorage::instance() {
     static ConnectionStorage instance;
@@ -59,9 +61,56 @@ bool ConnectionStorage::createTables() {
         return false;
     }
 
+    QString createCheckpointsSQL = R"(
+        CREATE TABLE IF NOT EXISTS copy_checkpoints (
+            source_connection TEXT NOT NULL,
+            source_table TEXT NOT NULL,
+            target_connection TEXT NOT NULL,
+            target_table TEXT NOT NULL,
+            key_column TEXT NOT NULL,
+            last_key TEXT,
+            key_type INTEGER,
+            rows_copied INTEGER DEFAULT 0,
+            updated_at DATETIME DEFAULT CURRENT_TIMESTAMP,
+            PRIMARY KEY (source_connection, source_table, target_connection, target_table)
+        )
+    )";
+
+    if (!query.exec(createCheckpointsSQL)) {
+        qWarning() << "Failed to create copy_checkpoints table:" << query.lastError().text();
+        return false;
+    }
+
     return true;
 }
 
+QSqlDatabase ConnectionStorage::threadStorageDatabase() {
+    if (QThread::currentThread() == QCoreApplication::instance()->thread()) {
+        return storageDb;
+    }
+
+    // QSqlDatabase handles can't cross threads; workers get their own session on the
+    // same file, dropped together with the thread
+    const QString name = QString("%1_%2").arg(STORAGE_DB_NAME).arg((quintptr)QThread::currentThreadId());
+    if (!QSqlDatabase::contains(name)) {
+        QSqlDatabase db = QSqlDatabase::cloneDatabase(STORAGE_DB_NAME, name);
+        db.setConnectOptions("QSQLITE_BUSY_TIMEOUT=5000");
+        QObject::connect(QThread::currentThread(), &QThread::finished, [name]() {
+            {
+                QSqlDatabase threadDb = QSqlDatabase::database(name, false);
+                threadDb.close();
+            }
+            QSqlDatabase::removeDatabase(name);
+        });
+    }
+
+    QSqlDatabase db = QSqlDatabase::database(name, false);
+    if (!db.isOpen() && !db.open()) {
+        qWarning() << "Failed to open storage database:" << db.lastError().text();
+    }
+    return db;
+}
+
 QString ConnectionStorage::encryptPassword(const QString &password) const {
     if (password.isEmpty()) {
         return QString();
@@ -173,3 +222,84 @@ bool ConnectionStorage::updateConnection(const QString &oldName, const Connectio
     }
     return saveConnection(config);
 }
+
+CopyCheckpoint ConnectionStorage::loadCopyCheckpoint(const QString &sourceConnection, const QString &sourceTable,
+                                                     const QString &targetConnection, const QString &targetTable) {
+    CopyCheckpoint checkpoint;
+    checkpoint.sourceConnection = sourceConnection;
+    checkpoint.sourceTable = sourceTable;
+    checkpoint.targetConnection = targetConnection;
+    checkpoint.targetTable = targetTable;
+
+    QSqlQuery query(threadStorageDatabase());
+    query.prepare(R"(
+        SELECT key_column, last_key, key_type, rows_copied FROM copy_checkpoints
+        WHERE source_connection = ? AND source_table = ? AND target_connection = ? AND target_table = ?
+    )");
+    query.addBindValue(sourceConnection);
+    query.addBindValue(sourceTable);
+    query.addBindValue(targetConnection);
+    query.addBindValue(targetTable);
+
+    if (query.exec() && query.next() && !query.isNull(1)) {
+        checkpoint.keyColumn = query.value(0).toString();
+        // Keys are stored as text and converted back to the key column's type
+        QVariant lastKey = query.value(1).toString();
+        const QMetaType keyType(query.value(2).toInt());
+        if (keyType.isValid() && lastKey.convert(keyType)) {
+            checkpoint.lastKey = lastKey;
+        } else {
+            checkpoint.lastKey = query.value(1).toString();
+        }
+        checkpoint.rowsCopied = query.value(3).toLongLong();
+    }
+
+    return checkpoint;
+}
+
+bool ConnectionStorage::saveCopyCheckpoint(const CopyCheckpoint &checkpoint) {
+    QSqlQuery query(threadStorageDatabase());
+
+    query.prepare(R"(
+        INSERT OR REPLACE INTO copy_checkpoints
+        (source_connection, source_table, target_connection, target_table, key_column,
+         last_key, key_type, rows_copied, updated_at)
+        VALUES (?, ?, ?, ?, ?, ?, ?, ?, CURRENT_TIMESTAMP)
+    )");
+
+    query.addBindValue(checkpoint.sourceConnection);
+    query.addBindValue(checkpoint.sourceTable);
+    query.addBindValue(checkpoint.targetConnection);
+    query.addBindValue(checkpoint.targetTable);
+    query.addBindValue(checkpoint.keyColumn);
+    query.addBindValue(checkpoint.lastKey.toString());
+    query.addBindValue(checkpoint.lastKey.metaType().id());
+    query.addBindValue(checkpoint.rowsCopied);
+
+    if (!query.exec()) {
+        qWarning() << "Failed to save copy checkpoint:" << query.lastError().text();
+        return false;
+    }
+
+    return true;
+}
+
+bool ConnectionStorage::removeCopyCheckpoint(const QString &sourceConnection, const QString &sourceTable,
+                                             const QString &targetConnection, const QString &targetTable) {
+    QSqlQuery query(threadStorageDatabase());
+    query.prepare(R"(
+        DELETE FROM copy_checkpoints
+        WHERE source_connection = ? AND source_table = ? AND target_connection = ? AND target_table = ?
+    )");
+    query.addBindValue(sourceConnection);
+    query.addBindValue(sourceTable);
+    query.addBindValue(targetConnection);
+    query.addBindValue(targetTable);
+
+    if (!query.exec()) {
+        qWarning() << "Failed to remove copy checkpoint:" << query.lastError().text();
+        return false;
+    }
+
+    return true;
+}
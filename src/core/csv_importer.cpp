@@ -0,0 +1,182 @@
+#include "core/csv_importer.h"
+#include "core/bounded_queue.h"
+#include "core/bulk_writer.h"
+#include "core/csv_reader.h"
+#include "core/parallel_csv_parser.h"
+#include "core/sql_dialect.h"
+#include <QElapsedTimer>
+#include <QSqlError>
+#include <QSqlRecord>
+#include <QThread>
+
+namespace {
+QueryResult failure(const QString &message, qint64 elapsedMs = 0) {
+    QueryResult result;
+    result.success = false;
+    result.errorMessage = message;
+    result.rowCount = 0;
+    result.executionTimeMs = elapsedMs;
+    return result;
+}
+} // namespace
+
+QList<QStringList> CsvImporter::preview(const QString &filePath, char delimiter, int maxRows,
+                                        QString *errorMessage) {
+    QList<QStringList> rows;
+    CsvReader reader(delimiter);
+    if (!reader.open(filePath, errorMessage)) {
+        return rows;
+    }
+
+    QStringList fields;
+    while (rows.size() < maxRows && reader.readRecord(&fields)) {
+        rows.append(fields);
+    }
+    return rows;
+}
+
+QFuture<QueryResult> CsvImporter::start(const ConnectionInfo &connInfo, DatabaseType type,
+                                        const CsvImportOptions &options, const TransferProgressPtr &progress,
+                                        const CancelTokenPtr &token) {
+    return QtConcurrent::run([connInfo, type, options, progress, token]() {
+        return run(connInfo, type, options, progress, token);
+    });
+}
+
+QueryResult CsvImporter::run(const ConnectionInfo &connInfo, DatabaseType type,
+                             const CsvImportOptions &options, const TransferProgressPtr &progress,
+                             const CancelTokenPtr &token) {
+    QElapsedTimer timer;
+    timer.start();
+
+    QString error;
+    QSqlDatabase db = QueryExecutor::threadDatabase(BulkWriter::bulkConnectionInfo(connInfo, type), &error);
+    if (!db.isValid() || !db.isOpen()) {
+        return failure(error);
+    }
+    const QSqlRecord existing = db.record(options.tableName);
+
+    ParallelCsvParser::Options parserOptions;
+    parserOptions.delimiter = options.delimiter;
+    parserOptions.hasHeader = options.hasHeader;
+    parserOptions.emptyIsNull = options.emptyIsNull;
+    // A new table takes its types from the whole file; an existing one needs none
+    parserOptions.inferenceRows = existing.isEmpty() ? 0 : 1;
+    ParallelCsvParser parser;
+    if (!parser.open(options.filePath, parserOptions, &error)) {
+        return failure(error);
+    }
+
+    // Target columns: the header, the existing table's columns, or col1..colN
+    QStringList columns = parser.getColumnNames();
+    if (!options.hasHeader && !existing.isEmpty()) {
+        const int count = columns.size();
+        columns.clear();
+        for (int i = 0; i < existing.count() && i < count; ++i) {
+            columns << existing.fieldName(i);
+        }
+    }
+
+    if (!existing.isEmpty()) {
+        // The table's own types decide; the server converts the text as written, so
+        // "0.10" or "007" isn't reformatted on the way
+        parser.setColumnTypes(QVector<CsvColumnType>(parser.getColumnNames().size(), CsvColumnType::Text));
+    } else {
+        const QVector<CsvColumnType> types = parser.getColumnTypes();
+        QStringList definitions;
+        for (int i = 0; i < columns.size(); ++i) {
+            definitions << QString("%1 %2").arg(
+                SqlDialect::quoteIdentifier(type, columns.at(i)),
+                SqlDialect::columnType(type, ParallelCsvParser::metaType(types.at(i))));
+        }
+        QSqlQuery create(db);
+        if (!create.exec(QString("CREATE TABLE %1 (%2)")
+                             .arg(SqlDialect::qualifiedName(type, options.tableName), definitions.join(", ")))) {
+            return failure("Failed to create table: " + create.lastError().text(), timer.elapsed());
+        }
+    }
+
+    std::unique_ptr<BulkWriter> writer = BulkWriter::create(db, type, options.tableName, columns);
+    if (!writer->begin(&error)) {
+        return failure(error, timer.elapsed());
+    }
+
+    const int batchRows = qMax(1, options.batchRows);
+    const int expectedFields = parser.getColumnNames().size();
+    BoundedQueue<QList<BulkRow>> queue(kQueueBatches);
+    QString readError;
+
+    // The parser splits the file into chunks parsed on all cores; this thread turns
+    // its in-order column batches into rows for the writer
+    std::unique_ptr<QThread> readerThread(QThread::create([&]() {
+        QList<BulkRow> batch;
+        batch.reserve(batchRows);
+        const bool complete = parser.parse([&](CsvBatch &&parsed) {
+            if (parsed.raggedRecordOffset >= 0) {
+                readError = QString("Record at byte %1 has %2 fields, expected %3")
+                                .arg(parsed.raggedRecordOffset).arg(parsed.raggedFieldCount).arg(expectedFields);
+                return false;
+            }
+            for (int row = 0; row < parsed.rowCount; ++row) {
+                BulkRow values;
+                values.reserve(columns.size());
+                for (int column = 0; column < columns.size(); ++column) {
+                    values.append(parsed.columns.at(column).value(row));
+                }
+                batch.append(std::move(values));
+                if (batch.size() == batchRows) {
+                    if (!queue.push(std::move(batch))) {
+                        return false;
+                    }
+                    batch = QList<BulkRow>();
+                    batch.reserve(batchRows);
+                }
+            }
+            progress->bytes = parsed.byteOffset + parsed.byteLength;
+            return true;
+        });
+        if (complete && !batch.isEmpty()) {
+            queue.push(std::move(batch));
+        }
+        queue.close();
+    }));
+    readerThread->start();
+
+    QueryResult result;
+    result.success = false;
+    result.rowCount = 0;
+    result.columnNames = columns;
+
+    QList<BulkRow> batch;
+    while (queue.pop(batch)) {
+        if (token->isCancelled()) {
+            error = "Import cancelled";
+            break;
+        }
+        if (!writer->writeRows(batch, &error)) {
+            break;
+        }
+        result.rowCount += batch.size();
+        progress->rows += batch.size();
+    }
+    queue.close();
+    readerThread->wait();
+
+    if (error.isEmpty() && !readError.isEmpty()) {
+        error = readError;
+    }
+    if (error.isEmpty()) {
+        writer->finish(&error);
+    } else {
+        writer->abort();
+    }
+    // rowCount is what stays in the table; a failed COPY stream keeps none of it
+    if (!error.isEmpty() && !writer->commitsEachBatch()) {
+        result.rowCount = 0;
+    }
+
+    result.executionTimeMs = timer.elapsed();
+    result.errorMessage = error;
+    result.success = error.isEmpty();
+    return result;
+}
@@ -0,0 +1,109 @@
+#include "core/csv_reader.h"
+
+CsvReader::CsvReader(char delimiter)
+    : position(0), delimiter(delimiter), consumed(0), fileSize(0) {
+}
+
+bool CsvReader::open(const QString &filePath, QString *errorMessage) {
+    file.setFileName(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (errorMessage) {
+            *errorMessage = file.errorString();
+        }
+        return false;
+    }
+    fileSize = file.size();
+    buffer.clear();
+    position = 0;
+    consumed = 0;
+
+    // Skip a UTF-8 byte order mark
+    if (fillBuffer() && buffer.startsWith("\xEF\xBB\xBF")) {
+        position = 3;
+        consumed = 3;
+    }
+    return true;
+}
+
+bool CsvReader::fillBuffer() {
+    if (position < buffer.size()) {
+        return true;
+    }
+    buffer = file.read(kChunkBytes);
+    position = 0;
+    return !buffer.isEmpty();
+}
+
+bool CsvReader::readRecord(QStringList *fields) {
+    fields->clear();
+    if (!fillBuffer()) {
+        return false;
+    }
+
+    QByteArray field;
+    bool quoted = false;      // field started with a quote
+    bool inQuotes = false;    // currently between quotes
+    bool fieldStarted = false;
+
+    auto endField = [&]() {
+        if (field.isEmpty()) {
+            fields->append(quoted ? QString("") : QString());
+        } else {
+            fields->append(QString::fromUtf8(field));
+        }
+        field.clear();
+        quoted = false;
+        fieldStarted = false;
+    };
+
+    while (fillBuffer()) {
+        const char ch = buffer.at(position++);
+        ++consumed;
+
+        if (inQuotes) {
+            if (ch == '"') {
+                if (!fillBuffer()) {
+                    inQuotes = false;
+                    continue;
+                }
+                if (buffer.at(position) == '"') {
+                    field.append('"');
+                    ++position;
+                    ++consumed;
+                } else {
+                    inQuotes = false;
+                }
+            } else {
+                field.append(ch);
+            }
+            continue;
+        }
+
+        if (ch == '"' && !fieldStarted) {
+            quoted = true;
+            inQuotes = true;
+            fieldStarted = true;
+        } else if (ch == delimiter) {
+            endField();
+        } else if (ch == '\n' || ch == '\r') {
+            if (ch == '\r' && fillBuffer() && buffer.at(position) == '\n') {
+                ++position;
+                ++consumed;
+            }
+            if (fields->isEmpty() && !fieldStarted && field.isEmpty()) {
+                continue;  // blank line
+            }
+            endField();
+            return true;
+        } else {
+            field.append(ch);
+            fieldStarted = true;
+        }
+    }
+
+    // Last record without a trailing newline
+    if (fieldStarted || !field.isEmpty() || !fields->isEmpty()) {
+        endField();
+    }
+    return !fields->isEmpty();
+}
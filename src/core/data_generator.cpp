@@ -0,0 +1,857 @@
+#include "core/data_generator.h"
+#include "core/bounded_queue.h"
+#include "core/bulk_writer.h"
+#include "core/sql_dialect.h"
+#include "core/table_statistics.h"
+#include <QDate>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QSet>
+#include <QSqlError>
+#include <QSqlField>
+#include <QSqlIndex>
+#include <QSqlQuery>
+#include <QSqlRecord>
+#include <QThread>
+#include <QTime>
+#include <QTimeZone>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace {
+constexpr double kZipfExponent = 1.1;
+
+QueryResult failure(const QString &message, qint64 elapsedMs = 0) {
+    QueryResult result;
+    result.success = false;
+    result.errorMessage = message;
+    result.rowCount = 0;
+    result.executionTimeMs = elapsedMs;
+    return result;
+}
+
+const char *const kWords[] = {
+    "alpha", "amber", "anchor", "apple", "arrow", "autumn", "bamboo", "beacon", "birch", "breeze",
+    "bridge", "cactus", "canyon", "cedar", "cobalt", "comet", "copper", "coral", "crystal", "delta",
+    "desert", "ember", "falcon", "fern", "forest", "garnet", "glacier", "granite", "harbor", "hazel",
+    "horizon", "island", "ivory", "jasper", "lagoon", "lantern", "maple", "meadow", "meteor", "mist",
+    "nectar", "oasis", "onyx", "orchid", "pebble", "pine", "prairie", "quartz", "raven", "ridge",
+    "river", "saffron", "sage", "shadow", "silver", "summit", "thunder", "tundra", "valley", "willow"
+};
+const char *const kFirstNames[] = {
+    "Ada", "Alan", "Amara", "Ben", "Carla", "Chen", "Diego", "Elena", "Farah", "Grace", "Hana", "Ivan",
+    "James", "Kai", "Lena", "Liam", "Maya", "Mohammed", "Nina", "Omar", "Priya", "Rosa", "Sam", "Sofia",
+    "Tom", "Uma", "Victor", "Wei", "Yara", "Zoe"
+};
+const char *const kLastNames[] = {
+    "Anderson", "Brown", "Costa", "Dubois", "Evans", "Fischer", "Garcia", "Hansen", "Ito", "Jensen",
+    "Kim", "Lopez", "Martin", "Nguyen", "Okafor", "Patel", "Quinn", "Rossi", "Schmidt", "Silva",
+    "Tanaka", "Usman", "Virtanen", "Wang", "Xu", "Yilmaz", "Zhang"
+};
+const char *const kCities[] = {
+    "Amsterdam", "Austin", "Bangalore", "Berlin", "Bogota", "Cairo", "Chicago", "Dublin", "Hanoi",
+    "Helsinki", "Lagos", "Lisbon", "London", "Madrid", "Melbourne", "Montreal", "Nairobi", "Osaka",
+    "Paris", "Prague", "Seoul", "Stockholm", "Toronto", "Vienna", "Warsaw", "Zurich"
+};
+
+template <size_t N>
+QLatin1String pick(const char *const (&list)[N], std::mt19937_64 &rng) {
+    return QLatin1String(list[rng() % N]);
+}
+
+enum class ValueClass {
+    Integer,
+    Real,
+    Boolean,
+    Date,
+    DateTime,
+    Time,
+    Text,
+    Bytes
+};
+
+ValueClass valueClass(QMetaType type) {
+    switch (type.id()) {
+        case QMetaType::Int:
+        case QMetaType::UInt:
+        case QMetaType::Short:
+        case QMetaType::UShort:
+        case QMetaType::Long:
+        case QMetaType::ULong:
+        case QMetaType::LongLong:
+        case QMetaType::ULongLong:
+            return ValueClass::Integer;
+        case QMetaType::Double:
+        case QMetaType::Float:
+            return ValueClass::Real;
+        case QMetaType::Bool:
+            return ValueClass::Boolean;
+        case QMetaType::QDate:
+            return ValueClass::Date;
+        case QMetaType::QDateTime:
+            return ValueClass::DateTime;
+        case QMetaType::QTime:
+            return ValueClass::Time;
+        case QMetaType::QByteArray:
+            return ValueClass::Bytes;
+        default:
+            return ValueClass::Text;
+    }
+}
+
+struct ForeignKey {
+    QString column;
+    QString parentTable;  // schema-qualified where the backend has schemas
+    QString parentColumn;
+};
+
+// Single-column foreign keys of table; multi-column ones can't be sampled per column
+QList<ForeignKey> foreignKeys(QSqlDatabase db, DatabaseType type, const QString &table) {
+    QString name;
+    QString schema;
+    TableStatistics::splitTableName(table, &name, &schema);
+
+    QString sql;
+    switch (type) {
+        case DatabaseType::SQLite:
+            sql = QString("SELECT \"from\", \"table\", \"to\" FROM pragma_foreign_key_list(%1) "
+                          "WHERE id IN (SELECT id FROM pragma_foreign_key_list(%1) GROUP BY id HAVING COUNT(*) = 1)")
+                      .arg(SqlDialect::literal(type, name));
+            break;
+        case DatabaseType::MySQL:
+            sql = QString("SELECT k.COLUMN_NAME, CONCAT(k.REFERENCED_TABLE_SCHEMA, '.', k.REFERENCED_TABLE_NAME), "
+                          "k.REFERENCED_COLUMN_NAME FROM information_schema.KEY_COLUMN_USAGE k "
+                          "WHERE k.TABLE_SCHEMA = %1 AND k.TABLE_NAME = %2 AND k.REFERENCED_TABLE_NAME IS NOT NULL "
+                          "AND (SELECT COUNT(*) FROM information_schema.KEY_COLUMN_USAGE o "
+                          "WHERE o.CONSTRAINT_SCHEMA = k.CONSTRAINT_SCHEMA AND o.TABLE_NAME = k.TABLE_NAME "
+                          "AND o.CONSTRAINT_NAME = k.CONSTRAINT_NAME) = 1")
+                      .arg(schema.isEmpty() ? QString("DATABASE()") : SqlDialect::literal(type, schema),
+                           SqlDialect::literal(type, name));
+            break;
+        case DatabaseType::PostgreSQL:
+            sql = QString("SELECT a.attname, fn.nspname || '.' || fc.relname, fa.attname FROM pg_constraint c "
+                          "JOIN pg_attribute a ON a.attrelid = c.conrelid AND a.attnum = c.conkey[1] "
+                          "JOIN pg_class fc ON fc.oid = c.confrelid "
+                          "JOIN pg_namespace fn ON fn.oid = fc.relnamespace "
+                          "JOIN pg_attribute fa ON fa.attrelid = c.confrelid AND fa.attnum = c.confkey[1] "
+                          "WHERE c.conrelid = %1::regclass AND c.contype = 'f' AND cardinality(c.conkey) = 1")
+                      .arg(SqlDialect::literal(type, SqlDialect::qualifiedName(type, table)));
+            break;
+    }
+
+    QList<ForeignKey> keys;
+    QSqlQuery query(db);
+    if (!query.exec(sql)) {
+        return keys;
+    }
+    while (query.next()) {
+        ForeignKey key;
+        key.column = query.value(0).toString();
+        key.parentTable = query.value(1).toString();
+        key.parentColumn = query.value(2).toString();
+        // SQLite leaves "to" empty when the key references the parent's primary key
+        if (key.parentColumn.isEmpty()) {
+            const QSqlIndex parentKey = db.primaryIndex(key.parentTable);
+            key.parentColumn = parentKey.count() == 1 ? parentKey.fieldName(0) : QString("rowid");
+        }
+        keys << key;
+    }
+    return keys;
+}
+
+// Zipf-distributed ranks 1..n by rejection-inversion (Hormann and Derflinger), which
+// needs no table however large n is
+class ZipfSampler {
+public:
+    ZipfSampler(qint64 n, double exponent)
+        : n(qMax<qint64>(1, n)), s(exponent) {
+        hIntegralX1 = hIntegral(1.5) - 1.0;
+        hIntegralN = hIntegral(double(this->n) + 0.5);
+        threshold = 2.0 - hIntegralInverse(hIntegral(2.5) - h(2.0));
+    }
+
+    qint64 sample(std::mt19937_64 &rng) const {
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+        for (;;) {
+            const double u = hIntegralN + uniform(rng) * (hIntegralX1 - hIntegralN);
+            const double x = hIntegralInverse(u);
+            const qint64 k = qBound<qint64>(1, qint64(x + 0.5), n);
+            if (double(k) - x <= threshold || u >= hIntegral(double(k) + 0.5) - h(double(k))) {
+                return k;
+            }
+        }
+    }
+
+private:
+    double hIntegral(double x) const {
+        const double logX = std::log(x);
+        return helper2((1.0 - s) * logX) * logX;
+    }
+    double h(double x) const {
+        return std::exp(-s * std::log(x));
+    }
+    double hIntegralInverse(double x) const {
+        const double t = qMax(-1.0, x * (1.0 - s));
+        return std::exp(helper1(t) * x);
+    }
+    static double helper1(double x) {
+        return std::abs(x) > 1e-8 ? std::log1p(x) / x : 1.0 - x * (0.5 - x * (1.0 / 3.0 - 0.25 * x));
+    }
+    static double helper2(double x) {
+        return std::abs(x) > 1e-8 ? std::expm1(x) / x : 1.0 + x * 0.5 * (1.0 + x * (1.0 / 3.0) * (1.0 + 0.25 * x));
+    }
+
+    qint64 n;
+    double s;
+    double hIntegralX1;
+    double hIntegralN;
+    double threshold;
+};
+
+quint64 mulMod(quint64 a, quint64 b, quint64 m) {
+    if (m <= (quint64(1) << 32)) {
+        return (a % m) * (b % m) % m;
+    }
+    quint64 result = 0;
+    a %= m;
+    while (b > 0) {
+        if (b & 1) {
+            result = (result + a) % m;
+        }
+        a = (a << 1) % m;
+        b >>= 1;
+    }
+    return result;
+}
+
+// One column's generator, prepared once and then shared read-only by the workers
+class ColumnGenerator {
+public:
+    bool prepare(const ColumnGeneratorSpec &spec, qint64 rowCount, quint64 seed, const QVariantList *parentValues,
+                 QString *errorMessage) {
+        this->spec = spec;
+        this->parentValues = parentValues;
+        valueKind = valueClass(spec.type);
+
+        auto fail = [&](const QString &message) {
+            if (errorMessage) {
+                *errorMessage = QString("Column '%1': %2").arg(spec.column, message);
+            }
+            return false;
+        };
+
+        if (spec.kind == GeneratorKind::Sample) {
+            if (!parentValues || parentValues->isEmpty()) {
+                return fail(QString("%1 has no values to reference").arg(spec.parentTable));
+            }
+            low = 0;
+            high = parentValues->size() - 1;
+        } else if (spec.kind == GeneratorKind::Sequence && valueKind == ValueClass::Text) {
+            // Numbered text: the range is where numbering starts, not a length
+            bool ok = true;
+            low = spec.minimum.isValid() ? spec.minimum.toLongLong(&ok) : 1;
+            if (!ok) {
+                return fail("the sequence start is not a number");
+            }
+        } else if (spec.kind == GeneratorKind::Constant && (valueKind == ValueClass::Text
+                                                             || valueKind == ValueClass::Bytes)) {
+            constant = spec.minimum;
+        } else if (!bounds(&low, &high)) {
+            return fail("the minimum and maximum don't fit the column type");
+        }
+        if (high < low && spec.kind != GeneratorKind::Sequence) {
+            std::swap(low, high);
+            std::swap(realLow, realHigh);
+        }
+
+        if (spec.unique && valueKind != ValueClass::Text) {
+            const quint64 range = quint64(high - low) + 1;
+            switch (spec.kind) {
+                case GeneratorKind::Sequence:
+                    break;
+                case GeneratorKind::Uniform:
+                case GeneratorKind::Sample:
+                    if (valueKind == ValueClass::Real || range < quint64(rowCount)) {
+                        return fail(QString("the range holds fewer than %1 distinct values").arg(rowCount));
+                    }
+                    // Row i maps to (a * i + b) mod range, a bijection when a and range
+                    // are coprime: every value at most once, in scattered order
+                    multiplier = 0x9E3779B97F4A7C15ULL % range;
+                    while (multiplier == 0 || std::gcd(multiplier, range) != 1) {
+                        multiplier = (multiplier + 1) % range;
+                    }
+                    offset = seed % range;
+                    break;
+                default:
+                    return fail("only sequences, uniform ranges and parent samples can be unique");
+            }
+        }
+
+        if (spec.kind == GeneratorKind::Zipf) {
+            zipf = std::make_shared<ZipfSampler>(high - low + 1, kZipfExponent);
+        }
+        return true;
+    }
+
+    QVariant value(std::mt19937_64 &rng, qint64 row) const {
+        if (spec.nullRatio > 0.0 && std::uniform_real_distribution<double>(0.0, 1.0)(rng) < spec.nullRatio) {
+            return QVariant();
+        }
+        if (spec.kind == GeneratorKind::Constant && constant.isValid()) {
+            return constant;
+        }
+        if (spec.kind == GeneratorKind::Sample) {
+            return parentValues->at(draw(rng, row));
+        }
+        if (valueKind == ValueClass::Real && spec.kind != GeneratorKind::Sequence) {
+            return QVariant(drawReal(rng));
+        }
+
+        const qint64 drawn = draw(rng, row);
+        switch (valueKind) {
+            case ValueClass::Integer:
+            case ValueClass::Real:
+                return QVariant(qlonglong(drawn));
+            case ValueClass::Boolean:
+                return QVariant(drawn != 0);
+            case ValueClass::Date:
+                return QVariant(QDate::fromJulianDay(drawn));
+            case ValueClass::DateTime:
+                return QVariant(QDateTime::fromSecsSinceEpoch(drawn, QTimeZone::utc()));
+            case ValueClass::Time:
+                return QVariant(QTime(0, 0).addSecs(int(drawn)));
+            case ValueClass::Bytes: {
+                QByteArray bytes(int(drawn), Qt::Uninitialized);
+                for (char &byte : bytes) {
+                    byte = char(rng());
+                }
+                return QVariant(bytes);
+            }
+            case ValueClass::Text:
+                return QVariant(text(rng, row, drawn));
+        }
+        return QVariant();
+    }
+
+private:
+    // The spec's range on the integer scale the column type is drawn on
+    bool bounds(qint64 *lowOut, qint64 *highOut) {
+        bool lowOk = true;
+        bool highOk = true;
+        switch (valueKind) {
+            case ValueClass::Integer:
+                *lowOut = spec.minimum.toLongLong(&lowOk);
+                *highOut = spec.maximum.isValid() ? spec.maximum.toLongLong(&highOk) : *lowOut;
+                break;
+            case ValueClass::Real:
+                realLow = spec.minimum.toDouble(&lowOk);
+                realHigh = spec.maximum.isValid() ? spec.maximum.toDouble(&highOk) : realLow;
+                *lowOut = qint64(realLow);
+                *highOut = qint64(realHigh);
+                break;
+            case ValueClass::Boolean:
+                *lowOut = 0;
+                *highOut = 1;
+                break;
+            case ValueClass::Date: {
+                const QDate from = spec.minimum.toDate();
+                const QDate to = spec.maximum.isValid() ? spec.maximum.toDate() : from;
+                lowOk = from.isValid();
+                highOk = to.isValid();
+                *lowOut = from.toJulianDay();
+                *highOut = to.toJulianDay();
+                break;
+            }
+            case ValueClass::DateTime: {
+                QDateTime from = spec.minimum.toDateTime();
+                QDateTime to = spec.maximum.isValid() ? spec.maximum.toDateTime() : from;
+                lowOk = from.isValid();
+                highOk = to.isValid();
+                *lowOut = from.toSecsSinceEpoch();
+                *highOut = to.toSecsSinceEpoch();
+                break;
+            }
+            case ValueClass::Time: {
+                const QTime from = spec.minimum.toTime();
+                const QTime to = spec.maximum.isValid() ? spec.maximum.toTime() : from;
+                lowOk = from.isValid();
+                highOk = to.isValid();
+                *lowOut = from.msecsSinceStartOfDay() / 1000;
+                *highOut = to.msecsSinceStartOfDay() / 1000;
+                break;
+            }
+            case ValueClass::Text:
+            case ValueClass::Bytes:
+                // Lengths
+                *lowOut = spec.minimum.isValid() ? spec.minimum.toLongLong(&lowOk) : 8;
+                *highOut = spec.maximum.isValid() ? spec.maximum.toLongLong(&highOk) : *lowOut;
+                if (spec.maxLength > 0) {
+                    *highOut = qMin<qint64>(*highOut, spec.maxLength);
+                    *lowOut = qMin(*lowOut, *highOut);
+                }
+                lowOk = lowOk && *lowOut >= 0;
+                break;
+        }
+        return lowOk && highOk;
+    }
+
+    qint64 draw(std::mt19937_64 &rng, qint64 row) const {
+        switch (spec.kind) {
+            case GeneratorKind::Sequence:
+                return low + row;
+            case GeneratorKind::Constant:
+                return low;
+            case GeneratorKind::Zipf:
+                return low + zipf->sample(rng) - 1;
+            case GeneratorKind::Normal: {
+                const double mean = (double(low) + double(high)) / 2.0;
+                const double deviation = qMax(1e-9, (double(high) - double(low)) / 6.0);
+                const double value = std::normal_distribution<double>(mean, deviation)(rng);
+                return qBound(low, qint64(std::llround(value)), high);
+            }
+            case GeneratorKind::Uniform:
+            case GeneratorKind::Sample:
+            case GeneratorKind::Skip:
+                break;
+        }
+        if (multiplier != 0) {
+            const quint64 range = quint64(high - low) + 1;
+            return low + qint64((mulMod(multiplier, quint64(row), range) + offset) % range);
+        }
+        return std::uniform_int_distribution<qint64>(low, high)(rng);
+    }
+
+    double drawReal(std::mt19937_64 &rng) const {
+        switch (spec.kind) {
+            case GeneratorKind::Normal: {
+                const double mean = (realLow + realHigh) / 2.0;
+                const double deviation = qMax(1e-9, (realHigh - realLow) / 6.0);
+                return qBound(realLow, std::normal_distribution<double>(mean, deviation)(rng), realHigh);
+            }
+            case GeneratorKind::Zipf:
+                return realLow + double(zipf->sample(rng) - 1);
+            case GeneratorKind::Constant:
+                return realLow;
+            default:
+                return std::uniform_real_distribution<double>(realLow, realHigh)(rng);
+        }
+    }
+
+    QString text(std::mt19937_64 &rng, qint64 row, qint64 length) const {
+        QString value;
+        if (spec.kind == GeneratorKind::Sequence) {
+            value = QString("%1-%2").arg(spec.column).arg(low + row);
+        } else {
+            switch (spec.textStyle) {
+                case TextStyle::Name:
+                    value = QString("%1 %2").arg(pick(kFirstNames, rng), pick(kLastNames, rng));
+                    break;
+                case TextStyle::Email:
+                    value = QString("%1.%2%3@example.com")
+                                .arg(pick(kFirstNames, rng), pick(kLastNames, rng))
+                                .arg(rng() % 1000)
+                                .toLower();
+                    break;
+                case TextStyle::Phone:
+                    value = QString("+1-%1-%2-%3")
+                                .arg(200 + rng() % 800)
+                                .arg(rng() % 1000, 3, 10, QChar('0'))
+                                .arg(rng() % 10000, 4, 10, QChar('0'));
+                    break;
+                case TextStyle::City:
+                    value = pick(kCities, rng);
+                    break;
+                case TextStyle::Words:
+                    while (value.size() < length) {
+                        if (!value.isEmpty()) {
+                            value += ' ';
+                        }
+                        value += pick(kWords, rng);
+                    }
+                    value.truncate(int(length));
+                    break;
+            }
+        }
+
+        // Unique text carries the row number, which has to survive the length limit
+        const QString suffix = spec.unique && spec.kind != GeneratorKind::Sequence
+            ? QString("-%1").arg(row + 1) : QString();
+        if (spec.maxLength > 0 && value.size() + suffix.size() > spec.maxLength) {
+            value.truncate(qMax(0, spec.maxLength - int(suffix.size())));
+        }
+        return value + suffix;
+    }
+
+    ColumnGeneratorSpec spec;
+    ValueClass valueKind = ValueClass::Text;
+    const QVariantList *parentValues = nullptr;
+    QVariant constant;
+    qint64 low = 0;
+    qint64 high = 0;
+    double realLow = 0.0;
+    double realHigh = 0.0;
+    quint64 multiplier = 0;
+    quint64 offset = 0;
+    std::shared_ptr<ZipfSampler> zipf;
+};
+
+qint64 payloadBytes(const QVariant &value) {
+    switch (value.metaType().id()) {
+        case QMetaType::QString:
+            return value.toString().size();
+        case QMetaType::QByteArray:
+            return value.toByteArray().size();
+        default:
+            return value.isValid() ? 8 : 0;
+    }
+}
+} // namespace
+
+QString DataGenerator::kindName(GeneratorKind kind) {
+    switch (kind) {
+        case GeneratorKind::Skip:
+            return "Column default";
+        case GeneratorKind::Sequence:
+            return "Sequence";
+        case GeneratorKind::Uniform:
+            return "Uniform";
+        case GeneratorKind::Normal:
+            return "Normal";
+        case GeneratorKind::Zipf:
+            return "Zipf (skewed)";
+        case GeneratorKind::Sample:
+            return "Parent values";
+        case GeneratorKind::Constant:
+            return "Constant";
+    }
+    return QString();
+}
+
+QFuture<QPair<QList<ColumnGeneratorSpec>, QString>> DataGenerator::startDefaultSpecs(
+    const ConnectionInfo &connInfo, DatabaseType type, const QString &table,
+    const QFuture<QList<IndexInfo>> &indexes) {
+    return QtConcurrent::run([connInfo, type, table, indexes]() {
+        QString error;
+        QSqlDatabase db = QueryExecutor::threadDatabase(connInfo, &error);
+        if (!db.isValid() || !db.isOpen()) {
+            return qMakePair(QList<ColumnGeneratorSpec>(), error);
+        }
+        const QList<ColumnGeneratorSpec> specs = defaultSpecs(db, type, table, indexes.result(), &error);
+        return qMakePair(specs, error);
+    });
+}
+
+QList<ColumnGeneratorSpec> DataGenerator::defaultSpecs(QSqlDatabase db, DatabaseType type, const QString &table,
+                                                       const QList<IndexInfo> &indexes, QString *errorMessage) {
+    QList<ColumnGeneratorSpec> specs;
+    const QSqlRecord layout = db.record(table);
+    if (layout.isEmpty()) {
+        if (errorMessage) {
+            *errorMessage = QString("Table '%1' was not found").arg(table);
+        }
+        return specs;
+    }
+
+    const QSqlIndex primaryKey = db.primaryIndex(table);
+    QSet<QString> uniqueColumns;
+    for (const IndexInfo &index : indexes) {
+        if (index.unique && index.columns.size() == 1) {
+            uniqueColumns.insert(index.columns.first());
+        }
+    }
+    QHash<QString, ForeignKey> references;
+    for (const ForeignKey &key : foreignKeys(db, type, table)) {
+        references.insert(key.column, key);
+    }
+
+    const QDate today = QDate::currentDate();
+    for (int i = 0; i < layout.count(); ++i) {
+        const QSqlField field = layout.field(i);
+        ColumnGeneratorSpec spec;
+        spec.column = field.name();
+        spec.type = field.metaType();
+        const ValueClass valueKind = valueClass(spec.type);
+        const bool isKey = primaryKey.contains(spec.column);
+        const bool isUnique = isKey || uniqueColumns.contains(spec.column);
+        if (valueKind == ValueClass::Text && field.length() > 0) {
+            spec.maxLength = field.length();
+        }
+
+        if (references.contains(spec.column)) {
+            const ForeignKey &key = references.value(spec.column);
+            spec.kind = GeneratorKind::Sample;
+            spec.parentTable = key.parentTable;
+            spec.parentColumn = key.parentColumn;
+            specs << spec;
+            continue;
+        }
+
+        if (isUnique) {
+            if (field.isAutoValue()) {
+                spec.kind = GeneratorKind::Skip;
+                specs << spec;
+                continue;
+            }
+            spec.unique = true;
+            spec.kind = GeneratorKind::Sequence;
+            if (valueKind == ValueClass::Integer) {
+                // Continue after the rows already there
+                QSqlQuery query(db);
+                qint64 next = 1;
+                if (query.exec(QString("SELECT MAX(%1) FROM %2")
+                                   .arg(SqlDialect::quoteIdentifier(type, spec.column),
+                                        SqlDialect::qualifiedName(type, table)))
+                    && query.next() && !query.isNull(0)) {
+                    next = query.value(0).toLongLong() + 1;
+                }
+                spec.minimum = next;
+                specs << spec;
+                continue;
+            }
+            if (valueKind == ValueClass::Text) {
+                spec.minimum = QDateTime::currentSecsSinceEpoch();
+                specs << spec;
+                continue;
+            }
+            spec.kind = GeneratorKind::Uniform;
+        }
+
+        if (field.requiredStatus() != QSqlField::Required && !isKey) {
+            spec.nullRatio = 0.1;
+        }
+
+        switch (valueKind) {
+            case ValueClass::Integer:
+                spec.minimum = 1;
+                spec.maximum = 100000;
+                break;
+            case ValueClass::Real:
+                spec.minimum = 0.0;
+                spec.maximum = 1000.0;
+                break;
+            case ValueClass::Boolean:
+                break;
+            case ValueClass::Date:
+                spec.minimum = today.addYears(-5);
+                spec.maximum = today;
+                break;
+            case ValueClass::DateTime:
+                spec.minimum = QDateTime(today.addYears(-5), QTime(0, 0), QTimeZone::utc());
+                spec.maximum = QDateTime(today, QTime(0, 0), QTimeZone::utc());
+                break;
+            case ValueClass::Time:
+                spec.minimum = QTime(0, 0);
+                spec.maximum = QTime(23, 59, 59);
+                break;
+            case ValueClass::Bytes:
+                spec.minimum = 16;
+                spec.maximum = 64;
+                break;
+            case ValueClass::Text: {
+                const QString name = spec.column.toLower();
+                if (name.contains("mail")) {
+                    spec.textStyle = TextStyle::Email;
+                } else if (name.contains("phone") || name.contains("tel")) {
+                    spec.textStyle = TextStyle::Phone;
+                } else if (name.contains("city")) {
+                    spec.textStyle = TextStyle::City;
+                } else if (name.contains("name")) {
+                    spec.textStyle = TextStyle::Name;
+                }
+                spec.minimum = 8;
+                spec.maximum = 40;
+                break;
+            }
+        }
+        specs << spec;
+    }
+    return specs;
+}
+
+QFuture<QueryResult> DataGenerator::start(const ConnectionInfo &connInfo, DatabaseType type,
+                                          const DataGeneratorOptions &options, const TransferProgressPtr &progress,
+                                          const CancelTokenPtr &token) {
+    return QtConcurrent::run([connInfo, type, options, progress, token]() {
+        return run(connInfo, type, options, progress, token);
+    });
+}
+
+QueryResult DataGenerator::run(const ConnectionInfo &connInfo, DatabaseType type, const DataGeneratorOptions &options,
+                               const TransferProgressPtr &progress, const CancelTokenPtr &token) {
+    QElapsedTimer timer;
+    timer.start();
+
+    QString error;
+    QSqlDatabase db = QueryExecutor::threadDatabase(connInfo, &error);
+    if (!db.isValid() || !db.isOpen()) {
+        return failure(error);
+    }
+
+    QList<ColumnGeneratorSpec> specs;
+    for (const ColumnGeneratorSpec &spec : options.columns) {
+        if (spec.kind != GeneratorKind::Skip) {
+            specs << spec;
+        }
+    }
+    if (specs.isEmpty()) {
+        return failure("Every column is left to its default; nothing to generate");
+    }
+
+    // Parent values are read once; workers only index into them
+    std::vector<QVariantList> parentValues(specs.size());
+    for (int i = 0; i < specs.size(); ++i) {
+        const ColumnGeneratorSpec &spec = specs.at(i);
+        if (spec.kind != GeneratorKind::Sample) {
+            continue;
+        }
+        const QString column = SqlDialect::quoteIdentifier(type, spec.parentColumn);
+        QSqlQuery query(db);
+        query.setForwardOnly(true);
+        if (!query.exec(QString("SELECT DISTINCT %1 FROM %2 WHERE %1 IS NOT NULL LIMIT %3")
+                            .arg(column, SqlDialect::qualifiedName(type, spec.parentTable))
+                            .arg(kMaxParentValues))) {
+            return failure(QString("Reading %1: %2").arg(spec.parentTable, query.lastError().text()));
+        }
+        while (query.next()) {
+            parentValues[i].append(query.value(0));
+        }
+    }
+
+    std::vector<ColumnGenerator> generators(specs.size());
+    QStringList columns;
+    for (int i = 0; i < specs.size(); ++i) {
+        if (!generators[i].prepare(specs.at(i), options.rowCount, options.seed, &parentValues[i], &error)) {
+            return failure(error);
+        }
+        columns << specs.at(i).column;
+    }
+
+    const int batchRows = qMax(1, options.batchRows);
+    const qint64 batches = (options.rowCount + batchRows - 1) / batchRows;
+    const int workers = qBound(1, options.workers, 64);
+    // SQLite takes one writer at a time; more sessions would only wait on its lock
+    const int writers = type == DatabaseType::SQLite ? 1 : qBound(1, options.writerSessions, 64);
+
+    BoundedQueue<QList<BulkRow>> queue(kQueueBatches);
+    std::atomic<qint64> nextBatch{0};
+    std::atomic<int> generatorsLeft{workers};
+    std::atomic<qint64> written{0};
+    std::atomic<bool> stop{false};
+    QMutex errorMutex;
+    QString runError;
+    auto fail = [&](const QString &message) {
+        QMutexLocker locker(&errorMutex);
+        if (runError.isEmpty()) {
+            runError = message;
+        }
+        stop = true;
+        queue.close();
+    };
+
+    std::vector<std::unique_ptr<QThread>> threads;
+    for (int w = 0; w < workers; ++w) {
+        threads.push_back(std::unique_ptr<QThread>(QThread::create([&]() {
+            for (qint64 batch = nextBatch++; batch < batches && !stop && !token->isCancelled(); batch = nextBatch++) {
+                // Seeded per batch, so the rows don't depend on which thread makes them
+                std::mt19937_64 rng(options.seed ^ (0x9E3779B97F4A7C15ULL * quint64(batch + 1)));
+                const qint64 first = batch * batchRows;
+                const qint64 last = qMin(options.rowCount, first + batchRows);
+                QList<BulkRow> rows;
+                rows.reserve(int(last - first));
+                for (qint64 row = first; row < last; ++row) {
+                    BulkRow values;
+                    values.reserve(int(generators.size()));
+                    for (const ColumnGenerator &generator : generators) {
+                        values.append(generator.value(rng, row));
+                    }
+                    rows.append(std::move(values));
+                }
+                if (!queue.push(std::move(rows))) {
+                    break;
+                }
+            }
+            if (--generatorsLeft == 0) {
+                queue.close();
+            }
+        })));
+    }
+
+    for (int w = 0; w < writers; ++w) {
+        threads.push_back(std::unique_ptr<QThread>(QThread::create([&]() {
+            QString writeError;
+            QSqlDatabase writerDb = QueryExecutor::threadDatabase(BulkWriter::bulkConnectionInfo(connInfo, type),
+                                                                  &writeError);
+            if (!writerDb.isValid() || !writerDb.isOpen()) {
+                fail(writeError);
+                return;
+            }
+            std::unique_ptr<BulkWriter> writer = BulkWriter::create(writerDb, type, options.table, columns);
+            if (!writer->begin(&writeError)) {
+                fail(writeError);
+                return;
+            }
+
+            // A COPY stream keeps its rows only if it finishes
+            const bool committing = writer->commitsEachBatch();
+            qint64 pending = 0;
+            QList<BulkRow> rows;
+            while (queue.pop(rows)) {
+                if (stop || token->isCancelled()) {
+                    break;
+                }
+                if (!writer->writeRows(rows, &writeError)) {
+                    writer->abort();
+                    fail(writeError);
+                    return;
+                }
+                qint64 bytes = 0;
+                for (const BulkRow &row : rows) {
+                    for (const QVariant &value : row) {
+                        bytes += payloadBytes(value);
+                    }
+                }
+                if (committing) {
+                    written += rows.size();
+                } else {
+                    pending += rows.size();
+                }
+                progress->rows += rows.size();
+                progress->bytes += bytes;
+            }
+
+            if (stop || token->isCancelled()) {
+                writer->abort();
+            } else if (!writer->finish(&writeError)) {
+                fail(writeError);
+            } else {
+                written += pending;
+            }
+        })));
+    }
+
+    for (const std::unique_ptr<QThread> &thread : threads) {
+        thread->start();
+    }
+    for (const std::unique_ptr<QThread> &thread : threads) {
+        thread->wait();
+    }
+
+    if (runError.isEmpty() && token->isCancelled()) {
+        runError = "Generation cancelled";
+    }
+
+    QueryResult result;
+    result.success = runError.isEmpty();
+    result.errorMessage = runError;
+    result.rowCount = int(qMin<qint64>(written, std::numeric_limits<int>::max()));
+    result.columnNames = columns;
+    result.executionTimeMs = timer.elapsed();
+    return result;
+}
@@ -0,0 +1,137 @@
+#include "core/fanout_executor.h"
+#include "database/connection_manager.h"
+#include <QElapsedTimer>
+#include <QSqlField>
+#include <QtConcurrent>
+
+namespace {
+constexpr int kIdleSessionExpiryMs = 60000;
+}
+
+FanOutExecutor::FanOutExecutor(QObject *parent)
+    : QObject(parent), relay(std::make_shared<Relay>()), pending(0) {
+    relay->owner = this;
+    pool = new QThreadPool();
+    pool->setExpiryTimeout(kIdleSessionExpiryMs);
+}
+
+FanOutExecutor::~FanOutExecutor() {
+    cancel();
+    {
+        QMutexLocker locker(&relay->mutex);
+        relay->owner = nullptr;
+    }
+
+    // Waiting here would block the GUI thread until every server answered
+    QThreadPool *detached = pool;
+    QtConcurrent::run([detached]() {
+        detached->waitForDone();
+        detached->deleteLater();
+    });
+}
+
+void FanOutExecutor::run(const QStringList &connectionNames, const QString &query, int maxConcurrency) {
+    if (isRunning()) {
+        return;
+    }
+
+    token = std::make_shared<CancelToken>();
+    // Shared by the shards, so cancelling interrupts every statement on its server
+    // until the last shard is done
+    const auto cancelGroup = std::make_shared<ServerCancelGroup>(token);
+    pool->setMaxThreadCount(qMax(1, maxConcurrency));
+    pending = connectionNames.size();
+
+    for (const QString &name : connectionNames) {
+        DatabaseConnection *conn = ConnectionManager::instance().getConnection(name);
+        if (!conn) {
+            ShardResult shard{name, false, "Connection not found", 0, 0};
+            QueryResult result;
+            result.success = false;
+            result.errorMessage = shard.errorMessage;
+            result.rowCount = 0;
+            result.executionTimeMs = 0;
+            QMetaObject::invokeMethod(this, [this, shard, result]() {
+                finishShard(shard, result);
+            }, Qt::QueuedConnection);
+            continue;
+        }
+
+        // Saved connections don't need to be open in the sidebar to take part
+        const ConnectionInfo connInfo = QueryExecutor::connectionInfoFromConfig(conn->getConfig());
+        const CancelTokenPtr runToken = token;
+
+        pool->start([relay = relay, name, connInfo, query, runToken, cancelGroup]() {
+            // The thread's previous shard may have been on another connection
+            thread_local QString sessionConnection;
+            if (!sessionConnection.isEmpty() && sessionConnection != connInfo.name) {
+                QueryExecutor::closeThreadDatabase(sessionConnection);
+            }
+            sessionConnection = connInfo.name;
+
+            QElapsedTimer timer;
+            timer.start();
+
+            QueryResult result;
+            if (runToken->isCancelled()) {
+                result.success = false;
+                result.errorMessage = "Query cancelled";
+                result.rowCount = 0;
+                result.executionTimeMs = 0;
+            } else {
+                QSqlDatabase db = QueryExecutor::threadDatabase(connInfo);
+                const QString session = db.isValid() && db.isOpen() ? cancelGroup->add(db, connInfo) : QString();
+                result = withSourceColumn(name, QueryExecutor::runQuery(connInfo, query, runToken));
+                cancelGroup->remove(session);
+            }
+
+            ShardResult shard{name, result.success, result.errorMessage, result.rowCount, timer.elapsed()};
+            QMutexLocker locker(&relay->mutex);
+            if (FanOutExecutor *owner = relay->owner) {
+                QMetaObject::invokeMethod(owner, [owner, shard, result]() {
+                    owner->finishShard(shard, result);
+                }, Qt::QueuedConnection);
+            }
+        });
+    }
+
+    if (pending == 0) {
+        emit finished();
+    }
+}
+
+void FanOutExecutor::cancel() {
+    if (token) {
+        token->cancel();
+    }
+}
+
+void FanOutExecutor::finishShard(const ShardResult &shard, const QueryResult &result) {
+    emit shardFinished(shard, result);
+    if (--pending == 0) {
+        emit finished();
+    }
+}
+
+QueryResult FanOutExecutor::withSourceColumn(const QString &connectionName, const QueryResult &result) {
+    if (!result.success) {
+        return result;
+    }
+
+    QueryResult tagged = result;
+    tagged.columnNames.prepend(kSourceColumn);
+    tagged.records.clear();
+    tagged.records.reserve(result.records.size());
+
+    for (const QSqlRecord &record : result.records) {
+        QSqlRecord taggedRecord;
+        QSqlField sourceField(kSourceColumn, QMetaType::fromType<QString>());
+        sourceField.setValue(connectionName);
+        taggedRecord.append(sourceField);
+        for (int i = 0; i < record.count(); ++i) {
+            taggedRecord.append(record.field(i));
+        }
+        tagged.records.append(taggedRecord);
+    }
+    return tagged;
+}
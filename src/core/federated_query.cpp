@@ -0,0 +1,568 @@
+#include "core/federated_query.h"
+#include "core/bounded_queue.h"
+#include "core/scratchpad.h"
+#include "core/sql_dialect.h"
+#include "database/connection_manager.h"
+#include <QElapsedTimer>
+#include <QHash>
+#include <QRegularExpression>
+#include <QScopeGuard>
+#include <QSet>
+#include <QSqlError>
+#include <QThreadPool>
+#include <QUuid>
+#include <memory>
+#include <vector>
+
+namespace {
+constexpr int kPullBatchRows = 2000;
+constexpr int kQueuedBatchesPerSource = 4;
+
+// @connection.relation, @connection.schema.relation or @"Connection Name".relation
+const QRegularExpression kReferencePattern(
+    R"(@("(?:[^"]|"")+"|[A-Za-z_][\w\-]*)\.((?:[A-Za-z_]\w*\.)?[A-Za-z_]\w*))");
+const QRegularExpression kAliasPattern(R"(\s+(?:AS\s+)?([A-Za-z_]\w*))",
+                                       QRegularExpression::CaseInsensitiveOption);
+const QRegularExpression kPredicatePattern(
+    R"(^\s*([A-Za-z_]\w*)\.([A-Za-z_]\w*)\s*(=|<>|!=|<=|>=|<|>|IS\s+NOT\s+NULL\b|IS\s+NULL\b)\s*('(?:[^']|'')*'|-?\d+(?:\.\d+)?)?\s*$)",
+    QRegularExpression::CaseInsensitiveOption);
+
+const QSet<QString> kNonAliasWords = {
+    "WHERE", "JOIN", "LEFT", "RIGHT", "INNER", "OUTER", "FULL", "CROSS", "NATURAL", "ON",
+    "USING", "GROUP", "ORDER", "LIMIT", "OFFSET", "HAVING", "UNION", "EXCEPT", "INTERSECT",
+    "WINDOW", "FETCH", "FOR", "AS"
+};
+
+const QSet<QString> kClauseEndWords = {
+    "GROUP", "ORDER", "LIMIT", "OFFSET", "HAVING", "UNION", "EXCEPT", "INTERSECT", "WINDOW",
+    "FETCH", "RETURNING"
+};
+
+struct SourceBatch {
+    int source = -1;
+    QSqlRecord layout;
+    QList<QSqlRecord> rows;
+    bool finished = false;
+    QString error;
+};
+
+bool isWordChar(QChar ch) {
+    return ch.isLetterOrNumber() || ch == '_';
+}
+
+// Returns the index just past the quoted run starting at start (standard doubled-quote escaping)
+int skipQuoted(const QString &text, int start) {
+    const QChar quote = text.at(start);
+    int i = start + 1;
+    while (i < text.size()) {
+        if (text.at(i) == quote) {
+            if (i + 1 < text.size() && text.at(i + 1) == quote) {
+                i += 2;
+                continue;
+            }
+            return i + 1;
+        }
+        ++i;
+    }
+    return text.size();
+}
+
+// Returns the index just past a comment starting at start, or start when there is none
+int skipComment(const QString &text, int start) {
+    if (start + 1 >= text.size()) {
+        return start;
+    }
+    if (text.at(start) == '-' && text.at(start + 1) == '-') {
+        int end = text.indexOf('\n', start);
+        return end < 0 ? text.size() : end + 1;
+    }
+    if (text.at(start) == '/' && text.at(start + 1) == '*') {
+        int end = text.indexOf("*/", start + 2);
+        return end < 0 ? text.size() : end + 2;
+    }
+    return start;
+}
+
+QVector<QPair<int, int>> literalRanges(const QString &text) {
+    QVector<QPair<int, int>> ranges;
+    int i = 0;
+    while (i < text.size()) {
+        const QChar ch = text.at(i);
+        if (ch == '\'' || ch == '"' || ch == '`') {
+            int end = skipQuoted(text, i);
+            ranges.append({i, end});
+            i = end;
+            continue;
+        }
+        int end = skipComment(text, i);
+        if (end != i) {
+            ranges.append({i, end});
+            i = end;
+            continue;
+        }
+        ++i;
+    }
+    return ranges;
+}
+
+bool insideRanges(const QVector<QPair<int, int>> &ranges, int position) {
+    for (const auto &range : ranges) {
+        if (position >= range.first && position < range.second) {
+            return true;
+        }
+    }
+    return false;
+}
+
+QString unquoteConnectionName(const QString &name) {
+    if (name.startsWith('"') && name.endsWith('"') && name.size() >= 2) {
+        QString unquoted = name.mid(1, name.size() - 2);
+        unquoted.replace("\"\"", "\"");
+        return unquoted;
+    }
+    return name;
+}
+
+void pullSource(const FederatedSource &source, int index, int rowCap,
+                BoundedQueue<SourceBatch> &queue, ServerCancelGroup &pulls, const CancelTokenPtr &token,
+                const CancelTokenPtr &abort) {
+    auto report = [&queue, index](const QString &error) {
+        SourceBatch batch;
+        batch.source = index;
+        batch.error = error;
+        queue.push(batch);
+    };
+
+    QString error;
+    QSqlDatabase db = QueryExecutor::threadDatabase(source.connInfo, &error);
+    if (!db.isOpen()) {
+        report(error);
+        return;
+    }
+
+    // Registered before the abort check, so a cancel either finds the session or is
+    // seen here
+    const QString session = pulls.add(db, source.connInfo);
+    const auto unregister = qScopeGuard([&pulls, &session]() {
+        pulls.remove(session);
+    });
+    if (token->isCancelled() || abort->isCancelled()) {
+        report("Query cancelled");
+        return;
+    }
+
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    if (!query.exec(source.pullQuery)) {
+        report(query.lastError().text());
+        return;
+    }
+
+    SourceBatch batch;
+    batch.source = index;
+    batch.layout = query.record();
+
+    int rows = 0;
+    while (query.next()) {
+        if (token->isCancelled() || abort->isCancelled()) {
+            report("Query cancelled");
+            return;
+        }
+        if (++rows > rowCap) {
+            report(QString("more than %1 rows; add a filter to narrow the pull").arg(rowCap));
+            return;
+        }
+
+        batch.rows.append(query.record());
+        if (batch.rows.size() >= kPullBatchRows) {
+            if (!queue.push(std::move(batch))) {
+                return;
+            }
+            batch = SourceBatch();
+            batch.source = index;
+        }
+    }
+
+    batch.finished = true;
+    queue.push(std::move(batch));
+}
+
+QueryResult stageAndRun(QSqlDatabase staging, const QVector<FederatedSource> &sources,
+                        const QString &stagingQuery, int rowCap, const CancelTokenPtr &token) {
+    QueryResult failed;
+    failed.success = false;
+    failed.rowCount = 0;
+    failed.executionTimeMs = 0;
+
+    const int sourceCount = sources.size();
+    auto abort = std::make_shared<CancelToken>();
+    BoundedQueue<SourceBatch> queue(sourceCount * kQueuedBatchesPerSource);
+
+    // Cancelling, or one source failing, interrupts the pulls still running on their
+    // servers, so waiting for the pool below doesn't wait for them to finish
+    ServerCancelGroup pulls(abort);
+    token->setCancelHandler([abort]() {
+        abort->cancel();
+    });
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(sourceCount);
+    for (int i = 0; i < sourceCount; ++i) {
+        const FederatedSource source = sources.at(i);
+        pool.start([source, i, rowCap, &queue, &pulls, token, abort]() {
+            pullSource(source, i, rowCap, queue, pulls, token, abort);
+        });
+    }
+
+    // Single writer: pulls run in parallel, the staging database is filled from here
+    std::vector<std::unique_ptr<QSqlQuery>> inserts(sourceCount);
+    QVector<int> columnCounts(sourceCount, -1);
+    int finishedSources = 0;
+    QString error;
+
+    staging.transaction();
+    SourceBatch batch;
+    while (finishedSources < sourceCount && queue.pop(batch)) {
+        const FederatedSource &source = sources.at(batch.source);
+        if (!batch.error.isEmpty()) {
+            error = QString("@%1.%2: %3").arg(source.connectionName, source.relation, batch.error);
+            break;
+        }
+        if (token->isCancelled()) {
+            error = "Query cancelled";
+            break;
+        }
+
+        if (columnCounts[batch.source] < 0) {
+            QStringList columns;
+            if (!Scratchpad::createTable(staging, source.stagingTable, batch.layout, &columns, &error)) {
+                break;
+            }
+            inserts[batch.source] = std::make_unique<QSqlQuery>(staging);
+            if (!Scratchpad::prepareInsert(*inserts[batch.source], source.stagingTable,
+                                           columns.size(), &error)) {
+                break;
+            }
+            columnCounts[batch.source] = columns.size();
+        }
+
+        if (!Scratchpad::insertRecords(*inserts[batch.source], batch.rows,
+                                       columnCounts[batch.source], &error)) {
+            break;
+        }
+        if (batch.finished) {
+            ++finishedSources;
+        }
+    }
+
+    // Stop the remaining pulls (a no-op when all finished) before tearing the queue down
+    abort->cancel();
+    queue.close();
+    pool.waitForDone();
+    token->clearCancelHandler();
+    inserts.clear();
+
+    if (!error.isEmpty() || finishedSources < sourceCount) {
+        staging.rollback();
+        failed.errorMessage = error.isEmpty() ? QString("Query cancelled") : error;
+        return failed;
+    }
+
+    if (!staging.commit()) {
+        failed.errorMessage = staging.lastError().text();
+        return failed;
+    }
+
+    return QueryExecutor::runQuery(staging, stagingQuery, token);
+}
+} // namespace
+
+bool FederatedQuery::hasReferences(const QString &query) {
+    const auto literals = literalRanges(query);
+    auto matches = kReferencePattern.globalMatch(query);
+    while (matches.hasNext()) {
+        const QRegularExpressionMatch match = matches.next();
+        if (insideRanges(literals, match.capturedStart())) {
+            continue;
+        }
+        if (ConnectionManager::instance().getConnection(unquoteConnectionName(match.captured(1)))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+QStringList FederatedQuery::topLevelConjuncts(const QString &query) {
+    // Splits the outermost WHERE clause on AND. Returns nothing when the clause has a
+    // top-level OR, since then no single conjunct is safe to evaluate on its own.
+    QStringList conjuncts;
+    int depth = 0;
+    int clauseStart = -1;
+    int partStart = -1;
+    int clauseEnd = query.size();
+    bool pendingBetween = false;
+
+    int i = 0;
+    while (i < query.size()) {
+        const QChar ch = query.at(i);
+        if (ch == '\'' || ch == '"' || ch == '`') {
+            i = skipQuoted(query, i);
+            continue;
+        }
+        const int commentEnd = skipComment(query, i);
+        if (commentEnd != i) {
+            i = commentEnd;
+            continue;
+        }
+        if (ch == '(') {
+            ++depth;
+        } else if (ch == ')') {
+            --depth;
+        } else if (ch == ';' && depth == 0) {
+            clauseEnd = i;
+            break;
+        } else if ((ch.isLetter() || ch == '_') && (i == 0 || !isWordChar(query.at(i - 1)))) {
+            int end = i;
+            while (end < query.size() && isWordChar(query.at(end))) {
+                ++end;
+            }
+
+            if (depth == 0) {
+                const QString word = query.mid(i, end - i).toUpper();
+                if (clauseStart < 0) {
+                    if (word == "WHERE") {
+                        clauseStart = partStart = end;
+                    }
+                } else if (kClauseEndWords.contains(word)) {
+                    clauseEnd = i;
+                    break;
+                } else if (word == "OR") {
+                    return QStringList();
+                } else if (word == "BETWEEN") {
+                    pendingBetween = true;
+                } else if (word == "AND") {
+                    if (pendingBetween) {
+                        pendingBetween = false;
+                    } else {
+                        conjuncts << query.mid(partStart, i - partStart);
+                        partStart = end;
+                    }
+                }
+            }
+            i = end;
+            continue;
+        }
+        ++i;
+    }
+
+    if (clauseStart < 0) {
+        return QStringList();
+    }
+    conjuncts << query.mid(partStart, clauseEnd - partStart);
+    return conjuncts;
+}
+
+bool FederatedQuery::plan(const QString &query, int rowCap, QVector<FederatedSource> *sources,
+                          QString *stagingQuery, QString *errorMessage) {
+    struct Occurrence {
+        int start;
+        int length;
+        int source;
+        QString alias;
+        bool hasAlias;
+    };
+
+    QVector<Occurrence> occurrences;
+    QHash<QString, int> sourceIndex;
+    QSet<QString> stagingNames;
+    QVector<int> occurrenceCounts;
+
+    const auto literals = literalRanges(query);
+    auto matches = kReferencePattern.globalMatch(query);
+    while (matches.hasNext()) {
+        const QRegularExpressionMatch match = matches.next();
+        if (insideRanges(literals, match.capturedStart())) {
+            continue;
+        }
+
+        const QString connectionName = unquoteConnectionName(match.captured(1));
+        DatabaseConnection *conn = ConnectionManager::instance().getConnection(connectionName);
+        if (!conn) {
+            continue;
+        }
+
+        const QString relation = match.captured(2);
+        const QString key = connectionName + '\n' + relation;
+        if (!sourceIndex.contains(key)) {
+            FederatedSource source;
+            source.connectionName = connectionName;
+            source.relation = relation;
+            source.type = conn->getType();
+            source.connInfo = QueryExecutor::connectionInfoFromConfig(conn->getConfig());
+
+            QString stagingTable = QString("%1__%2").arg(connectionName, relation);
+            stagingTable.replace(QRegularExpression(R"([^\w])"), "_");
+            const QString base = stagingTable;
+            int suffix = 2;
+            while (stagingNames.contains(stagingTable)) {
+                stagingTable = QString("%1_%2").arg(base).arg(suffix++);
+            }
+            stagingNames.insert(stagingTable);
+            source.stagingTable = stagingTable;
+
+            sourceIndex.insert(key, sources->size());
+            sources->append(source);
+            occurrenceCounts.append(0);
+        }
+
+        Occurrence occurrence;
+        occurrence.start = match.capturedStart();
+        occurrence.length = match.capturedLength();
+        occurrence.source = sourceIndex.value(key);
+        occurrence.hasAlias = false;
+
+        const QRegularExpressionMatch aliasMatch = kAliasPattern.match(
+            query, match.capturedEnd(), QRegularExpression::NormalMatch,
+            QRegularExpression::AnchorAtOffsetMatchOption);
+        if (aliasMatch.hasMatch() && !kNonAliasWords.contains(aliasMatch.captured(1).toUpper())) {
+            occurrence.alias = aliasMatch.captured(1);
+            occurrence.hasAlias = true;
+        } else {
+            occurrence.alias = relation.section('.', -1);
+        }
+
+        occurrenceCounts[occurrence.source]++;
+        occurrences.append(occurrence);
+    }
+
+    if (sources->isEmpty()) {
+        if (errorMessage) {
+            *errorMessage = "The query doesn't reference any saved connection";
+        }
+        return false;
+    }
+
+    // Push WHERE predicates down to sources that appear exactly once and are addressed
+    // through an unambiguous qualifier. Predicates stay in the local query as well;
+    // IS NULL is never pushed, see below.
+    QHash<QString, int> qualifierSource;
+    QSet<QString> ambiguousQualifiers;
+    for (const Occurrence &occurrence : occurrences) {
+        const QString qualifier = occurrence.alias.toLower();
+        if (qualifierSource.contains(qualifier) && qualifierSource.value(qualifier) != occurrence.source) {
+            ambiguousQualifiers.insert(qualifier);
+        }
+        qualifierSource.insert(qualifier, occurrence.source);
+    }
+
+    for (const QString &conjunct : topLevelConjuncts(query)) {
+        const QRegularExpressionMatch predicate = kPredicatePattern.match(conjunct);
+        if (!predicate.hasMatch()) {
+            continue;
+        }
+
+        const QString qualifier = predicate.captured(1).toLower();
+        if (!qualifierSource.contains(qualifier) || ambiguousQualifiers.contains(qualifier)) {
+            continue;
+        }
+        const int source = qualifierSource.value(qualifier);
+        if (occurrenceCounts[source] != 1) {
+            continue;
+        }
+
+        const QString op = predicate.captured(3).simplified().toUpper();
+        const QString literal = predicate.captured(4);
+        const bool nullTest = op.startsWith("IS");
+        if (nullTest != literal.isEmpty()) {
+            continue;
+        }
+        // Every other predicate rejects the NULLs an outer join pads with, so filtering
+        // early changes nothing. IS NULL is true for those padded rows: pushed to the
+        // nullable side of a LEFT JOIN it would empty that side and keep every row.
+        if (op == "IS NULL") {
+            continue;
+        }
+        // Text comparisons follow the source's collation, which may keep fewer rows
+        // than SQLite's would. Equality only ever keeps more, and the local query
+        // filters again; ordering and <> are only pushed for numbers.
+        if (op != "=" && !nullTest && literal.startsWith('\'')) {
+            continue;
+        }
+
+        FederatedSource &target = (*sources)[source];
+        QString pushed = SqlDialect::quoteIdentifier(target.type, predicate.captured(2)) + " " + op;
+        if (!nullTest) {
+            pushed += " " + literal;
+        }
+        target.pushedFilters << pushed;
+    }
+
+    for (FederatedSource &source : *sources) {
+        source.pullQuery = QString("SELECT * FROM %1").arg(SqlDialect::qualifiedName(source.type, source.relation));
+        if (!source.pushedFilters.isEmpty()) {
+            source.pullQuery += " WHERE " + source.pushedFilters.join(" AND ");
+        }
+        // One row over the cap tells the puller the relation is too large
+        source.pullQuery += QString(" LIMIT %1").arg(rowCap + 1);
+    }
+
+    // Rewrite back to front so earlier offsets stay valid
+    QString rewritten = query;
+    for (int i = occurrences.size() - 1; i >= 0; --i) {
+        const Occurrence &occurrence = occurrences.at(i);
+        QString replacement = SqlDialect::quoteIdentifier(
+            DatabaseType::SQLite, sources->at(occurrence.source).stagingTable);
+        if (!occurrence.hasAlias) {
+            // Keep relation-qualified column references (orders.id) working
+            replacement += " AS " + SqlDialect::quoteIdentifier(DatabaseType::SQLite, occurrence.alias);
+        }
+        rewritten.replace(occurrence.start, occurrence.length, replacement);
+    }
+
+    *stagingQuery = rewritten;
+    return true;
+}
+
+QFuture<QueryResult> FederatedQuery::execute(const QString &query, const CancelTokenPtr &token,
+                                             int rowCap) {
+    QVector<FederatedSource> sources;
+    QString stagingQuery;
+    QString error;
+    if (!plan(query, rowCap, &sources, &stagingQuery, &error)) {
+        QueryResult result;
+        result.success = false;
+        result.errorMessage = error;
+        result.rowCount = 0;
+        result.executionTimeMs = 0;
+        return QtConcurrent::run([result]() { return result; });
+    }
+
+    return QtConcurrent::run([sources, stagingQuery, rowCap, token]() {
+        return run(sources, stagingQuery, rowCap, token);
+    });
+}
+
+QueryResult FederatedQuery::run(const QVector<FederatedSource> &sources, const QString &stagingQuery,
+                                int rowCap, const CancelTokenPtr &token) {
+    QElapsedTimer timer;
+    timer.start();
+
+    const QString stagingName = QString("federated_%1").arg(QUuid::createUuid().toString(QUuid::WithoutBraces));
+    QueryResult result;
+    {
+        QSqlDatabase staging = QSqlDatabase::addDatabase("QSQLITE", stagingName);
+        staging.setDatabaseName(":memory:");
+        if (staging.open()) {
+            result = stageAndRun(staging, sources, stagingQuery, rowCap, token);
+            staging.close();
+        } else {
+            result.success = false;
+            result.rowCount = 0;
+            result.errorMessage = "Failed to open staging database: " + staging.lastError().text();
+        }
+    }
+    QSqlDatabase::removeDatabase(stagingName);
+
+    result.executionTimeMs = timer.elapsed();
+    return result;
+}
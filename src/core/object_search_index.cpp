@@ -0,0 +1,274 @@
+#include "core/object_search_index.h"
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+// Matches that are substrings always outrank scattered ones
+constexpr int kSubstringBonus = 10000;
+constexpr int kPrefixBonus = 5000;
+constexpr int kExactBonus = 20000;
+constexpr int kConsecutiveBonus = 5;
+constexpr int kWordStartBonus = 8;
+
+bool isWordStart(const QString &name, int i) {
+    if (i == 0) {
+        return true;
+    }
+    const QChar previous = name.at(i - 1);
+    const QChar current = name.at(i);
+    if (previous == '_' || previous == '-' || previous == '.' || previous == ' ') {
+        return true;
+    }
+    // camelCase and letters after digits
+    return (current.isUpper() && previous.isLower()) || (current.isLetter() && previous.isDigit());
+}
+
+} // namespace
+
+quint64 ObjectSearchIndex::trigramKey(const QChar *chars) {
+    return (quint64(chars[0].unicode()) << 32) | (quint64(chars[1].unicode()) << 16) | chars[2].unicode();
+}
+
+void ObjectSearchIndex::setSchema(const QString &connection, const QString &schema,
+                                  const QList<RelationInfo> &relations) {
+    removeSchema(connection, schema);
+    for (const RelationInfo &relation : relations) {
+        addEntry(connection, schema, relation);
+    }
+    invalidateNarrowing();
+}
+
+void ObjectSearchIndex::removeSchema(const QString &connection, const QString &schema) {
+    dropEntries(bySchema.take({connection, schema}));
+    compactIfSparse();
+}
+
+void ObjectSearchIndex::removeConnection(const QString &connection) {
+    // Compacting rebuilds bySchema, so it waits until every schema is out of it
+    QList<QPair<QString, QString>> schemas;
+    for (auto it = bySchema.cbegin(); it != bySchema.cend(); ++it) {
+        if (it.key().first == connection) {
+            schemas << it.key();
+        }
+    }
+    for (const auto &schema : std::as_const(schemas)) {
+        dropEntries(bySchema.take(schema));
+    }
+    compactIfSparse();
+}
+
+const QList<int> *ObjectSearchIndex::rarestCharacterPostings(const QString &queryLower) const {
+    const QList<int> *rarest = nullptr;
+    for (const QChar ch : queryLower) {
+        const auto postings = characters.constFind(ch);
+        if (postings == characters.constEnd()) {
+            static const QList<int> none;
+            return &none;
+        }
+        if (!rarest || postings->size() < rarest->size()) {
+            rarest = &postings.value();
+        }
+    }
+    return rarest;
+}
+
+void ObjectSearchIndex::addEntry(const QString &connection, const QString &schema, const RelationInfo &relation) {
+    const int id = entries.size();
+
+    Entry entry;
+    entry.connection = connection;
+    entry.schema = schema;
+    entry.name = relation.name;
+    entry.lowered = relation.name.toLower();
+    entry.kind = relation.kind;
+
+    // Ids only grow, so every posting list stays sorted
+    for (int i = 0; i + 3 <= entry.lowered.size(); ++i) {
+        QList<int> &postings = trigrams[trigramKey(entry.lowered.constData() + i)];
+        if (postings.isEmpty() || postings.last() != id) {
+            postings.append(id);
+        }
+    }
+    for (const QChar ch : std::as_const(entry.lowered)) {
+        QList<int> &postings = characters[ch];
+        if (postings.isEmpty() || postings.last() != id) {
+            postings.append(id);
+        }
+    }
+
+    entries.append(entry);
+    bySchema[{connection, schema}].append(id);
+    ++liveCount;
+}
+
+void ObjectSearchIndex::dropEntries(const QList<int> &ids) {
+    if (ids.isEmpty()) {
+        return;
+    }
+    for (int id : ids) {
+        entries[id].alive = false;
+    }
+    liveCount -= ids.size();
+    invalidateNarrowing();
+}
+
+void ObjectSearchIndex::compactIfSparse() {
+    if (liveCount < entries.size() / 2) {
+        compact();
+    }
+}
+
+void ObjectSearchIndex::compact() {
+    const QList<Entry> old = std::exchange(entries, QList<Entry>());
+    bySchema.clear();
+    trigrams.clear();
+    characters.clear();
+    liveCount = 0;
+
+    entries.reserve(old.size());
+    for (const Entry &entry : old) {
+        if (!entry.alive) {
+            continue;
+        }
+        RelationInfo relation;
+        relation.name = entry.name;
+        relation.kind = entry.kind;
+        addEntry(entry.connection, entry.schema, relation);
+    }
+}
+
+void ObjectSearchIndex::invalidateNarrowing() {
+    narrowing.clear();
+}
+
+int ObjectSearchIndex::matchScore(const QString &name, const QString &lowered, const QString &queryLower) {
+    if (queryLower.isEmpty() || queryLower.size() > lowered.size()) {
+        return -1;
+    }
+
+    // Lowercasing can change the length ("İ" becomes two code units); word starts are
+    // then taken from the lowercase name, which loses camelCase but stays in step
+    const QString &cased = name.size() == lowered.size() ? name : lowered;
+
+    int score = 0;
+    int matched = 0;
+    int previous = -2;
+    for (int i = 0; i < lowered.size() && matched < queryLower.size(); ++i) {
+        if (lowered.at(i) != queryLower.at(matched)) {
+            continue;
+        }
+        score += 1;
+        if (i == previous + 1) {
+            score += kConsecutiveBonus;
+        }
+        if (isWordStart(cased, i)) {
+            score += kWordStartBonus;
+        }
+        previous = i;
+        ++matched;
+    }
+    if (matched < queryLower.size()) {
+        return -1;
+    }
+
+    const int position = lowered.indexOf(queryLower);
+    if (position == 0) {
+        score += lowered.size() == queryLower.size() ? kExactBonus : kPrefixBonus;
+    }
+    if (position >= 0) {
+        score += kSubstringBonus;
+    }
+    // Shorter names are closer matches
+    return score - lowered.size();
+}
+
+QList<ObjectSearchResult> ObjectSearchIndex::search(const QString &query, int limit) {
+    const QString queryLower = query.trimmed().toLower();
+    if (queryLower.isEmpty() || limit <= 0) {
+        return {};
+    }
+
+    QList<QPair<int, int>> scored;  // (score, entry id)
+
+    // Substring matches from the rarest trigram's postings
+    bool complete = false;
+    if (queryLower.size() >= 3) {
+        const QList<int> *rarest = nullptr;
+        for (int i = 0; i + 3 <= queryLower.size(); ++i) {
+            const auto postings = trigrams.constFind(trigramKey(queryLower.constData() + i));
+            if (postings == trigrams.constEnd()) {
+                rarest = nullptr;
+                break;
+            }
+            if (!rarest || postings->size() < rarest->size()) {
+                rarest = &postings.value();
+            }
+        }
+        if (rarest) {
+            for (int id : *rarest) {
+                const Entry &entry = entries.at(id);
+                if (entry.alive && entry.lowered.contains(queryLower)) {
+                    scored.append({matchScore(entry.name, entry.lowered, queryLower), id});
+                }
+            }
+        }
+        // Scattered matches always rank below substrings, so they can't displace these
+        complete = scored.size() >= limit;
+    }
+
+    if (!complete) {
+        // Keep the matches of the longest earlier query this one extends; the rest
+        // were typed over or deleted
+        while (!narrowing.isEmpty() && !queryLower.startsWith(narrowing.last().first)) {
+            narrowing.removeLast();
+        }
+        QList<int> matches;
+        auto consider = [&](int id) {
+            const Entry &entry = entries.at(id);
+            if (!entry.alive) {
+                return;
+            }
+            const int score = matchScore(entry.name, entry.lowered, queryLower);
+            if (score >= 0) {
+                matches.append(id);
+                // Substrings of trigram-sized queries were collected above
+                if (queryLower.size() < 3 || !entry.lowered.contains(queryLower)) {
+                    scored.append({score, id});
+                }
+            }
+        };
+        // Otherwise only names holding the query's rarest character can match
+        const QList<int> &candidates = narrowing.isEmpty() ? *rarestCharacterPostings(queryLower)
+                                                           : narrowing.last().second;
+        for (int id : candidates) {
+            consider(id);
+        }
+        if (narrowing.isEmpty() || narrowing.last().first != queryLower) {
+            narrowing.append({queryLower, matches});
+        }
+    }
+
+    const int count = std::min<int>(limit, scored.size());
+    std::partial_sort(scored.begin(), scored.begin() + count, scored.end(),
+                      [this](const QPair<int, int> &a, const QPair<int, int> &b) {
+        if (a.first != b.first) {
+            return a.first > b.first;
+        }
+        return entries.at(a.second).name < entries.at(b.second).name;
+    });
+
+    QList<ObjectSearchResult> results;
+    results.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        const Entry &entry = entries.at(scored.at(i).second);
+        ObjectSearchResult result;
+        result.connection = entry.connection;
+        result.schema = entry.schema;
+        result.name = entry.name;
+        result.kind = entry.kind;
+        result.score = scored.at(i).first;
+        results.append(result);
+    }
+    return results;
+}
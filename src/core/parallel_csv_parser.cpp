@@ -0,0 +1,762 @@
+#include "core/parallel_csv_parser.h"
+#include <QDate>
+#include <QDateTime>
+#include <QFuture>
+#include <QQueue>
+#include <QThread>
+#include <QTimeZone>
+#include <QtConcurrent>
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <optional>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define CSV_SIMD_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define CSV_SIMD_NEON
+#endif
+
+namespace {
+constexpr qint64 kMinChunkBytes = 64 * 1024;
+
+struct FieldView {
+    const char *begin;
+    const char *end;
+    bool quoted;
+    bool escaped;  // contains doubled quotes
+};
+
+// Next delimiter or line break in [p, end). Quotes only matter at the start of a
+// field, so unquoted fields just run to the next terminator.
+const char *findTerminator(const char *p, const char *end, char delimiter) {
+#if defined(CSV_SIMD_SSE2)
+    const __m128i delim = _mm_set1_epi8(delimiter);
+    const __m128i lf = _mm_set1_epi8('\n');
+    const __m128i cr = _mm_set1_epi8('\r');
+    while (end - p >= 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        const __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(chunk, delim),
+                                          _mm_or_si128(_mm_cmpeq_epi8(chunk, lf), _mm_cmpeq_epi8(chunk, cr)));
+        const uint mask = uint(_mm_movemask_epi8(hits));
+        if (mask) {
+            return p + qCountTrailingZeroBits(mask);
+        }
+        p += 16;
+    }
+#elif defined(CSV_SIMD_NEON)
+    const uint8x16_t delim = vdupq_n_u8(uint8_t(delimiter));
+    const uint8x16_t lf = vdupq_n_u8('\n');
+    const uint8x16_t cr = vdupq_n_u8('\r');
+    while (end - p >= 16) {
+        const uint8x16_t chunk = vld1q_u8(reinterpret_cast<const uint8_t*>(p));
+        const uint8x16_t hits = vorrq_u8(vceqq_u8(chunk, delim),
+                                         vorrq_u8(vceqq_u8(chunk, lf), vceqq_u8(chunk, cr)));
+        // Narrow each byte to a nibble: a 64-bit mask with 4 bits per input byte
+        const quint64 mask = vget_lane_u64(
+            vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(hits), 4)), 0);
+        if (mask) {
+            return p + (qCountTrailingZeroBits(mask) >> 2);
+        }
+        p += 16;
+    }
+#endif
+    while (p < end && *p != delimiter && *p != '\n' && *p != '\r') {
+        ++p;
+    }
+    return p;
+}
+
+qint64 countQuotes(const char *p, const char *end) {
+    qint64 count = 0;
+#if defined(CSV_SIMD_SSE2)
+    const __m128i quote = _mm_set1_epi8('"');
+    while (end - p >= 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        count += qPopulationCount(uint(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, quote))));
+        p += 16;
+    }
+#elif defined(CSV_SIMD_NEON)
+    const uint8x16_t quote = vdupq_n_u8('"');
+    while (end - p >= 16) {
+        // Matches are 0xFF; accumulate up to 255 blocks per lane before widening
+        uint8x16_t lanes = vdupq_n_u8(0);
+        int blocks = 0;
+        while (end - p >= 16 && blocks < 255) {
+            const uint8x16_t chunk = vld1q_u8(reinterpret_cast<const uint8_t*>(p));
+            lanes = vsubq_u8(lanes, vceqq_u8(chunk, quote));
+            p += 16;
+            ++blocks;
+        }
+        count += vaddlvq_u8(lanes);
+    }
+#endif
+    count += std::count(p, end, '"');
+    return count;
+}
+
+// Reads one field starting at p and returns where it ends (at the delimiter, the
+// line break or end)
+const char *scanField(const char *p, const char *end, char delimiter, FieldView *field) {
+    if (p < end && *p == '"') {
+        const char *q = p + 1;
+        bool escaped = false;
+        for (;;) {
+            const char *quote = static_cast<const char*>(std::memchr(q, '"', size_t(end - q)));
+            if (!quote) {
+                q = end;  // unterminated: the rest of the input
+                break;
+            }
+            if (quote + 1 < end && quote[1] == '"') {
+                escaped = true;
+                q = quote + 2;
+                continue;
+            }
+            q = quote;
+            break;
+        }
+        *field = {p + 1, q, true, escaped};
+        // Anything between the closing quote and the terminator isn't RFC 4180; drop it
+        return q < end ? findTerminator(q + 1, end, delimiter) : end;
+    }
+
+    const char *terminator = findTerminator(p, end, delimiter);
+    *field = {p, terminator, false, false};
+    return terminator;
+}
+
+// Calls onField(field, column) for each field and onRecord(recordStart, fieldCount)
+// after each record in [p, end), up to maxRecords; returns where parsing stopped.
+// Blank lines are skipped.
+template <typename FieldFn, typename RecordFn>
+const char *forEachRecord(const char *p, const char *end, char delimiter, qint64 maxRecords,
+                          FieldFn onField, RecordFn onRecord) {
+    qint64 records = 0;
+    while (p < end && records < maxRecords) {
+        if (*p == '\n' || *p == '\r') {
+            ++p;
+            continue;
+        }
+
+        const char *recordStart = p;
+        int column = 0;
+        for (;;) {
+            FieldView field;
+            p = scanField(p, end, delimiter, &field);
+            onField(field, column++);
+            if (p < end && *p == delimiter) {
+                ++p;
+                continue;
+            }
+            break;
+        }
+        if (p < end && *p == '\r') {
+            ++p;
+        }
+        if (p < end && *p == '\n') {
+            ++p;
+        }
+        onRecord(recordStart, column);
+        ++records;
+    }
+    return p;
+}
+
+QByteArray unescaped(const FieldView &field) {
+    QByteArray bytes(field.begin, field.end - field.begin);
+    if (field.escaped) {
+        bytes.replace("\"\"", "\"");
+    }
+    return bytes;
+}
+
+QString fieldText(const FieldView &field) {
+    if (field.escaped) {
+        return QString::fromUtf8(unescaped(field));
+    }
+    return QString::fromUtf8(field.begin, field.end - field.begin);
+}
+
+bool parseInteger(const FieldView &field, qint64 *value) {
+    const auto parsed = std::from_chars(field.begin, field.end, *value);
+    return parsed.ec == std::errc() && parsed.ptr == field.end;
+}
+
+bool parseReal(const FieldView &field, double *value) {
+    bool ok = false;
+    *value = QByteArrayView(field.begin, field.end - field.begin).toDouble(&ok);
+    return ok;
+}
+
+bool parseBoolean(const FieldView &field, qint64 *value) {
+    const QByteArrayView text(field.begin, field.end - field.begin);
+    if (text.compare("true", Qt::CaseInsensitive) == 0) {
+        *value = 1;
+        return true;
+    }
+    if (text.compare("false", Qt::CaseInsensitive) == 0) {
+        *value = 0;
+        return true;
+    }
+    return false;
+}
+
+// yyyy-MM-dd
+bool parseDate(const char *p, qsizetype length, QDate *date) {
+    if (length != 10 || p[4] != '-' || p[7] != '-') {
+        return false;
+    }
+    int parts[3] = {0, 0, 0};
+    const int starts[3] = {0, 5, 8};
+    const int lengths[3] = {4, 2, 2};
+    for (int i = 0; i < 3; ++i) {
+        const auto parsed = std::from_chars(p + starts[i], p + starts[i] + lengths[i], parts[i]);
+        if (parsed.ec != std::errc() || parsed.ptr != p + starts[i] + lengths[i]) {
+            return false;
+        }
+    }
+    *date = QDate(parts[0], parts[1], parts[2]);
+    return date->isValid();
+}
+
+// ISO 8601 date and time with 'T' or a space between them; a bare date is midnight.
+// The result keeps the wall-clock time as written, as milliseconds in UTC.
+bool parseDateTime(const FieldView &field, qint64 *msecs) {
+    const qsizetype length = field.end - field.begin;
+    QDate date;
+    if (length == 10) {
+        if (!parseDate(field.begin, length, &date)) {
+            return false;
+        }
+        *msecs = QDateTime(date, QTime(0, 0), QTimeZone::UTC).toMSecsSinceEpoch();
+        return true;
+    }
+    if (length < 19 || !parseDate(field.begin, 10, &date)
+        || (field.begin[10] != 'T' && field.begin[10] != ' ')) {
+        return false;
+    }
+
+    QString text = QString::fromLatin1(field.begin, length);
+    text[10] = QLatin1Char('T');
+    QDateTime dateTime = QDateTime::fromString(text, Qt::ISODateWithMs);
+    if (!dateTime.isValid()) {
+        return false;
+    }
+    if (dateTime.timeSpec() == Qt::LocalTime) {
+        dateTime = QDateTime(dateTime.date(), dateTime.time(), QTimeZone::UTC);
+    }
+    *msecs = dateTime.toMSecsSinceEpoch();
+    return true;
+}
+
+// Leading zeros (zip codes, account numbers) are text
+bool hasLeadingZero(const FieldView &field) {
+    const char *digits = field.begin + ((*field.begin == '-' || *field.begin == '+') ? 1 : 0);
+    return field.end - digits > 1 && *digits == '0';
+}
+
+// Narrowest type that can hold the value; nullopt for empty fields, which say nothing
+std::optional<CsvColumnType> classify(const FieldView &field) {
+    const qsizetype length = field.end - field.begin;
+    if (length == 0) {
+        return std::nullopt;
+    }
+    if (field.escaped) {
+        return CsvColumnType::Text;
+    }
+
+    const char first = *field.begin;
+    if ((first >= '0' && first <= '9') || first == '-' || first == '+' || first == '.') {
+        qint64 integer;
+        if (parseInteger(field, &integer)) {
+            return hasLeadingZero(field) ? CsvColumnType::Text : CsvColumnType::Integer;
+        }
+        QDate date;
+        if (parseDate(field.begin, length, &date)) {
+            return CsvColumnType::Date;
+        }
+        qint64 msecs;
+        if (parseDateTime(field, &msecs)) {
+            return CsvColumnType::DateTime;
+        }
+        const bool numeric = std::all_of(field.begin, field.end, [](char c) {
+            return (c >= '0' && c <= '9') || c == '.' || c == '-' || c == '+' || c == 'e' || c == 'E';
+        });
+        double real;
+        if (numeric && parseReal(field, &real)) {
+            return CsvColumnType::Real;
+        }
+        return CsvColumnType::Text;
+    }
+
+    qint64 boolean;
+    if (parseBoolean(field, &boolean)) {
+        return CsvColumnType::Boolean;
+    }
+    return CsvColumnType::Text;
+}
+
+CsvColumnType combine(CsvColumnType a, CsvColumnType b) {
+    if (a == b) {
+        return a;
+    }
+    auto either = [a, b](CsvColumnType x, CsvColumnType y) {
+        return (a == x && b == y) || (a == y && b == x);
+    };
+    if (either(CsvColumnType::Integer, CsvColumnType::Real)) {
+        return CsvColumnType::Real;
+    }
+    if (either(CsvColumnType::Date, CsvColumnType::DateTime)) {
+        return CsvColumnType::DateTime;
+    }
+    return CsvColumnType::Text;
+}
+
+// Rewrites the column's values so far as text, for a value that doesn't fit the
+// inferred type. Only affects the batch being parsed, so it can only happen when the
+// types were inferred from a sample (Options::inferenceRows).
+void demoteToText(CsvColumn &column) {
+    const int rows = column.nulls.size();
+    QVector<QString> texts;
+    texts.reserve(rows);
+    for (int row = 0; row < rows; ++row) {
+        if (column.nulls.at(row)) {
+            texts.append(QString());
+            continue;
+        }
+        switch (column.type) {
+            case CsvColumnType::Integer:
+                texts.append(QString::number(column.ints.at(row)));
+                break;
+            case CsvColumnType::Real:
+                texts.append(QString::number(column.reals.at(row), 'g', QLocale::FloatingPointShortest));
+                break;
+            case CsvColumnType::Boolean:
+                texts.append(column.ints.at(row) ? "true" : "false");
+                break;
+            case CsvColumnType::Date:
+                texts.append(QDate::fromJulianDay(column.ints.at(row)).toString(Qt::ISODate));
+                break;
+            case CsvColumnType::DateTime:
+                texts.append(QDateTime::fromMSecsSinceEpoch(column.ints.at(row), QTimeZone::UTC)
+                                 .toString("yyyy-MM-dd HH:mm:ss.zzz"));
+                break;
+            case CsvColumnType::Text:
+                texts.append(column.texts.at(row));
+                break;
+        }
+    }
+    column.type = CsvColumnType::Text;
+    column.ints.clear();
+    column.reals.clear();
+    column.texts = std::move(texts);
+}
+
+void appendNull(CsvColumn &column) {
+    column.nulls.append(true);
+    switch (column.type) {
+        case CsvColumnType::Real:
+            column.reals.append(0.0);
+            break;
+        case CsvColumnType::Text:
+            column.texts.append(QString());
+            break;
+        default:
+            column.ints.append(0);
+            break;
+    }
+}
+
+void appendField(CsvColumn &column, const FieldView &field, bool emptyIsNull) {
+    if (field.begin == field.end) {
+        if (column.type == CsvColumnType::Text && (field.quoted || !emptyIsNull)) {
+            column.nulls.append(false);
+            column.texts.append(QString(""));
+        } else {
+            appendNull(column);
+        }
+        return;
+    }
+
+    bool ok = true;
+    qint64 integer = 0;
+    switch (column.type) {
+        case CsvColumnType::Integer:
+            ok = parseInteger(field, &integer) && !hasLeadingZero(field);
+            break;
+        case CsvColumnType::Real: {
+            double real;
+            if (parseReal(field, &real)) {
+                column.nulls.append(false);
+                column.reals.append(real);
+                return;
+            }
+            ok = false;
+            break;
+        }
+        case CsvColumnType::Boolean:
+            ok = parseBoolean(field, &integer);
+            break;
+        case CsvColumnType::Date: {
+            QDate date;
+            ok = parseDate(field.begin, field.end - field.begin, &date);
+            integer = date.toJulianDay();
+            break;
+        }
+        case CsvColumnType::DateTime:
+            ok = parseDateTime(field, &integer);
+            break;
+        case CsvColumnType::Text:
+            column.nulls.append(false);
+            column.texts.append(fieldText(field));
+            return;
+    }
+
+    if (!ok) {
+        demoteToText(column);
+        column.nulls.append(false);
+        column.texts.append(fieldText(field));
+        return;
+    }
+    column.nulls.append(false);
+    column.ints.append(integer);
+}
+} // namespace
+
+QVariant CsvColumn::value(int row) const {
+    if (nulls.at(row)) {
+        return QVariant(ParallelCsvParser::metaType(type));
+    }
+    switch (type) {
+        case CsvColumnType::Integer:
+            return QVariant(qlonglong(ints.at(row)));
+        case CsvColumnType::Real:
+            return QVariant(reals.at(row));
+        case CsvColumnType::Boolean:
+            return QVariant(ints.at(row) != 0);
+        case CsvColumnType::Date:
+            return QVariant(QDate::fromJulianDay(ints.at(row)));
+        case CsvColumnType::DateTime: {
+            const QDateTime utc = QDateTime::fromMSecsSinceEpoch(ints.at(row), QTimeZone::UTC);
+            return QVariant(QDateTime(utc.date(), utc.time()));
+        }
+        case CsvColumnType::Text:
+            break;
+    }
+    return QVariant(texts.at(row));
+}
+
+ParallelCsvParser::ParallelCsvParser()
+    : data(nullptr), size(0) {
+}
+
+ParallelCsvParser::~ParallelCsvParser() {
+    pool.waitForDone();
+    file.close();
+}
+
+QMetaType ParallelCsvParser::metaType(CsvColumnType type) {
+    switch (type) {
+        case CsvColumnType::Integer:
+            return QMetaType::fromType<qlonglong>();
+        case CsvColumnType::Real:
+            return QMetaType::fromType<double>();
+        case CsvColumnType::Boolean:
+            return QMetaType::fromType<bool>();
+        case CsvColumnType::Date:
+            return QMetaType::fromType<QDate>();
+        case CsvColumnType::DateTime:
+            return QMetaType::fromType<QDateTime>();
+        case CsvColumnType::Text:
+            break;
+    }
+    return QMetaType::fromType<QString>();
+}
+
+QString ParallelCsvParser::typeName(CsvColumnType type) {
+    switch (type) {
+        case CsvColumnType::Integer:
+            return "Integer";
+        case CsvColumnType::Real:
+            return "Real";
+        case CsvColumnType::Boolean:
+            return "Boolean";
+        case CsvColumnType::Date:
+            return "Date";
+        case CsvColumnType::DateTime:
+            return "DateTime";
+        case CsvColumnType::Text:
+            break;
+    }
+    return "Text";
+}
+
+bool ParallelCsvParser::open(const QString &filePath, const Options &options, QString *errorMessage) {
+    this->options = options;
+    pool.setMaxThreadCount(options.threads > 0 ? options.threads : QThread::idealThreadCount());
+
+    file.setFileName(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (errorMessage) {
+            *errorMessage = QString("Could not open '%1': %2").arg(filePath, file.errorString());
+        }
+        return false;
+    }
+    size = file.size();
+    if (size == 0) {
+        if (errorMessage) {
+            *errorMessage = "The file is empty";
+        }
+        return false;
+    }
+    data = reinterpret_cast<const char*>(file.map(0, size));
+    if (!data) {
+        if (errorMessage) {
+            *errorMessage = QString("Could not map '%1': %2").arg(filePath, file.errorString());
+        }
+        return false;
+    }
+
+    const char *begin = data;
+    const char *end = data + size;
+    if (size >= 3 && std::memcmp(begin, "\xEF\xBB\xBF", 3) == 0) {
+        begin += 3;
+    }
+
+    // The first record gives the column names, or just the column count
+    columnNames.clear();
+    const char *afterFirst = forEachRecord(
+        begin, end, options.delimiter, 1,
+        [this](const FieldView &field, int) { columnNames << fieldText(field); },
+        [](const char*, int) {});
+    if (columnNames.isEmpty()) {
+        if (errorMessage) {
+            *errorMessage = "The file is empty";
+        }
+        return false;
+    }
+    if (!options.hasHeader) {
+        const int count = columnNames.size();
+        columnNames.clear();
+        for (int i = 0; i < count; ++i) {
+            columnNames << QString("col%1").arg(i + 1);
+        }
+    }
+
+    const qint64 dataStart = (options.hasHeader ? afterFirst : begin) - data;
+    splitIntoChunks(dataStart);
+    inferColumnTypes(dataStart);
+    return true;
+}
+
+void ParallelCsvParser::inferColumnTypes(qint64 dataStart) {
+    const int count = columnNames.size();
+    using Inferred = QVector<std::optional<CsvColumnType>>;
+    auto inferRange = [this, count](qint64 begin, qint64 end, qint64 maxRecords) {
+        Inferred inferred(count);
+        forEachRecord(
+            data + begin, data + end, options.delimiter, maxRecords,
+            [&](const FieldView &field, int column) {
+                if (column >= count || inferred[column] == CsvColumnType::Text) {
+                    return;
+                }
+                if (const std::optional<CsvColumnType> type = classify(field)) {
+                    inferred[column] = inferred[column] ? combine(*inferred[column], *type) : *type;
+                }
+            },
+            [](const char*, int) {});
+        return inferred;
+    };
+
+    Inferred inferred(count);
+    if (options.inferenceRows > 0) {
+        inferred = inferRange(dataStart, size, options.inferenceRows);
+    } else {
+        // Every chunk is classified in parallel, so a late "N/A" or "007" shapes the
+        // column as much as the first rows do
+        QVector<int> chunks(getChunkCount());
+        std::iota(chunks.begin(), chunks.end(), 0);
+        const QVector<Inferred> perChunk = QtConcurrent::blockingMapped<QVector<Inferred>>(
+            &pool, chunks, [this, &inferRange](int chunk) {
+                return inferRange(chunkStarts.at(chunk), chunkStarts.at(chunk + 1),
+                                  std::numeric_limits<qint64>::max());
+            });
+        for (const Inferred &chunk : perChunk) {
+            for (int column = 0; column < count; ++column) {
+                if (chunk.at(column)) {
+                    inferred[column] = inferred[column] ? combine(*inferred[column], *chunk.at(column))
+                                                        : *chunk.at(column);
+                }
+            }
+        }
+    }
+
+    columnTypes.clear();
+    for (const std::optional<CsvColumnType> &type : inferred) {
+        columnTypes.append(type.value_or(CsvColumnType::Text));
+    }
+}
+
+void ParallelCsvParser::splitIntoChunks(qint64 dataStart) {
+    const qint64 chunkBytes = qMax(options.chunkBytes, kMinChunkBytes);
+    QVector<qint64> nominal;
+    for (qint64 position = dataStart; position < size; position += chunkBytes) {
+        nominal.append(position);
+    }
+
+    // Quote parity before each nominal cut tells whether the cut is inside a quoted field
+    const QVector<qint64> quotes = QtConcurrent::blockingMapped<QVector<qint64>>(
+        &pool, nominal, [this, chunkBytes](qint64 position) {
+            return countQuotes(data + position, data + qMin(position + chunkBytes, size));
+        });
+
+    chunkStarts = {dataStart};
+    const char *end = data + size;
+    bool inQuotes = false;
+    for (int i = 1; i < nominal.size(); ++i) {
+        inQuotes ^= (quotes.at(i - 1) & 1) != 0;
+
+        // Move the cut forward to just past the next line break outside quotes
+        const char *p = data + nominal.at(i);
+        bool quoted = inQuotes;
+        while (p < end) {
+            if (quoted) {
+                const char *quote = static_cast<const char*>(std::memchr(p, '"', size_t(end - p)));
+                p = quote ? quote + 1 : end;
+                quoted = false;
+                continue;
+            }
+            const char c = *p++;
+            if (c == '"') {
+                quoted = true;
+            } else if (c == '\n') {
+                break;
+            } else if (c == '\r') {
+                if (p < end && *p == '\n') {
+                    ++p;
+                }
+                break;
+            }
+        }
+
+        // A record longer than a chunk can swallow the next cut
+        const qint64 cut = p - data;
+        if (cut > chunkStarts.last() && cut < size) {
+            chunkStarts.append(cut);
+        }
+    }
+    chunkStarts.append(size);
+
+    // A stray quote inside an unquoted field (a"b) flips the parity without opening
+    // anything, which can put a cut inside a quoted field further on
+    if (!chunksAligned()) {
+        splitSequentially(dataStart, chunkBytes);
+    }
+}
+
+bool ParallelCsvParser::chunksAligned() {
+    // Parsed from its own start, a chunk ending inside an unterminated quoted field
+    // means the next one starts mid-record. The last chunk ends with the file.
+    QVector<int> chunks(qMax(0, getChunkCount() - 1));
+    std::iota(chunks.begin(), chunks.end(), 0);
+    std::atomic<bool> aligned{true};
+    QtConcurrent::blockingMap(&pool, chunks, [this, &aligned](int chunk) {
+        const char *end = data + chunkStarts.at(chunk + 1);
+        bool open = false;
+        forEachRecord(
+            data + chunkStarts.at(chunk), end, options.delimiter, std::numeric_limits<qint64>::max(),
+            [&open, end](const FieldView &field, int) { open = field.quoted && field.end == end; },
+            [](const char*, int) {});
+        if (open) {
+            aligned = false;
+        }
+    });
+    return aligned;
+}
+
+void ParallelCsvParser::splitSequentially(qint64 dataStart, qint64 chunkBytes) {
+    chunkStarts = {dataStart};
+    qint64 nextCut = dataStart + chunkBytes;
+    forEachRecord(
+        data + dataStart, data + size, options.delimiter, std::numeric_limits<qint64>::max(),
+        [](const FieldView&, int) {},
+        [this, &nextCut, chunkBytes](const char *recordStart, int) {
+            const qint64 start = recordStart - data;
+            if (start >= nextCut) {
+                chunkStarts.append(start);
+                nextCut = start + chunkBytes;
+            }
+        });
+    chunkStarts.append(size);
+}
+
+CsvBatch ParallelCsvParser::parseChunk(qint64 begin, qint64 end) const {
+    CsvBatch batch;
+    batch.byteOffset = begin;
+    batch.byteLength = end - begin;
+
+    const int count = columnTypes.size();
+    batch.columns.resize(count);
+    for (int i = 0; i < count; ++i) {
+        batch.columns[i].type = columnTypes.at(i);
+    }
+
+    const bool emptyIsNull = options.emptyIsNull;
+    forEachRecord(
+        data + begin, data + end, options.delimiter, std::numeric_limits<qint64>::max(),
+        [&batch, count, emptyIsNull](const FieldView &field, int column) {
+            if (column < count) {
+                appendField(batch.columns[column], field, emptyIsNull);
+            }
+        },
+        [&batch, count, this](const char *recordStart, int fields) {
+            for (int column = fields; column < count; ++column) {
+                appendNull(batch.columns[column]);
+            }
+            if (fields != count && batch.raggedRecordOffset < 0) {
+                batch.raggedRecordOffset = recordStart - data;
+                batch.raggedFieldCount = fields;
+            }
+            ++batch.rowCount;
+        });
+    return batch;
+}
+
+bool ParallelCsvParser::parse(const std::function<bool(CsvBatch &&)> &consumer) {
+    const int chunks = getChunkCount();
+    const int window = qMax(2, pool.maxThreadCount() * 2);
+
+    QQueue<QFuture<CsvBatch>> inFlight;
+    int next = 0;
+    auto launch = [&]() {
+        const qint64 begin = chunkStarts.at(next);
+        const qint64 end = chunkStarts.at(next + 1);
+        inFlight.enqueue(QtConcurrent::run(&pool, [this, begin, end]() {
+            return parseChunk(begin, end);
+        }));
+        ++next;
+    };
+
+    while (next < chunks && inFlight.size() < window) {
+        launch();
+    }
+    while (!inFlight.isEmpty()) {
+        QFuture<CsvBatch> future = inFlight.dequeue();
+        CsvBatch batch = future.takeResult();
+        if (next < chunks) {
+            launch();
+        }
+        if (!consumer(std::move(batch))) {
+            for (QFuture<CsvBatch> &pending : inFlight) {
+                pending.waitForFinished();
+            }
+            return false;
+        }
+    }
+    return true;
+}
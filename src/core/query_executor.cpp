@@ -1,5 +1,6 @@
 #include "core/query_executor.h"
 #include "database/connection_manager.h"
+#include "core/sql_dialect.h"
 #include <QElapsedTimer>
 #include <QSqlError>
 #include <QThread>
@@ -15,33 +16,7 @@ ConnectionInfo QueryExecutor::getConnectionInfo(const QString &connectionName) {
     // Get the actual database connection from manager
     DatabaseConnection *conn = ConnectionManager::instance().getConnection(connectionName);
     if (conn && conn->isConnected()) {
-        ConnectionConfig config = conn->getConfig();
-
-        qDebug() << "Getting connection info for:" << connectionName << "Type:" << (int)config.type;
-
-        // Map database type to driver name
-        switch (config.type) {
-            case DatabaseType::SQLite:
-                info.driverName = "QSQLITE";
-                info.databaseName = config.filePath;
-                break;
-            case DatabaseType::MySQL:
-                info.driverName = "QMYSQL";
-                info.databaseName = config.database;
-                info.hostName = config.host;
-                info.port = config.port;
-                info.userName = config.username;
-                info.password = config.password;
-                break;
-            case DatabaseType::PostgreSQL:
-                info.driverName = "QPSQL";
-                info.databaseName = config.database;
-                info.hostName = config.host;
-                info.port = config.port;
-                info.userName = config.username;
-                info.password = config.password;
-                break;
-        }
+        info = connectionInfoFromConfig(conn->getConfig());
         qDebug() << "Connection info - Driver:" << info.driverName << "DB:" << info.databaseName;
     } else {
         qDebug() << "Connection not found or not connected:" << connectionName;
@@ -49,6 +24,99 @@ ConnectionInfo QueryExecutor::getConnectionInfo(const QString &connectionName) {
     return info;
 }
 
+ConnectionInfo QueryExecutor::connectionInfoFromConfig(const ConnectionConfig &config) {
+    ConnectionInfo info;
+    info.name = config.name;
+
+    // Map database type to driver name
+    switch (config.type) {
+        case DatabaseType::SQLite:
+            info.driverName = "QSQLITE";
+            info.databaseName = config.filePath;
+            if (config.filePath.startsWith("file:")) {
+                // URI filenames (e.g. shared in-memory databases) need to be enabled explicitly
+                info.connectOptions = "QSQLITE_OPEN_URI";
+            }
+            break;
+        case DatabaseType::MySQL:
+            info.driverName = "QMYSQL";
+            info.databaseName = config.database;
+            info.hostName = config.host;
+            info.port = config.port;
+            info.userName = config.username;
+            info.password = config.password;
+            break;
+        case DatabaseType::PostgreSQL:
+            info.driverName = "QPSQL";
+            info.databaseName = config.database;
+            info.hostName = config.host;
+            info.port = config.port;
+            info.userName = config.username;
+            info.password = config.password;
+            break;
+    }
+    return info;
+}
+
+namespace {
+QString threadConnectionNameFor(const QString &connectionName) {
+    return QString("thread_%1_%2").arg((quintptr)QThread::currentThreadId()).arg(connectionName);
+}
+} // namespace
+
+QSqlDatabase QueryExecutor::threadDatabase(const ConnectionInfo &connInfo, QString *errorMessage) {
+    // Create a thread-specific connection
+    const QString threadConnectionName = threadConnectionNameFor(connInfo.name);
+
+    QSqlDatabase db;
+    if (QSqlDatabase::contains(threadConnectionName)) {
+        db = QSqlDatabase::database(threadConnectionName, false);
+    } else {
+        // Create new connection for this thread
+        db = QSqlDatabase::addDatabase(connInfo.driverName, threadConnectionName);
+        db.setDatabaseName(connInfo.databaseName);
+        db.setHostName(connInfo.hostName);
+        db.setUserName(connInfo.userName);
+        db.setPassword(connInfo.password);
+        db.setPort(connInfo.port);
+        db.setConnectOptions(connInfo.connectOptions);
+
+        // Pool threads come and go; drop the session together with its thread so a
+        // later thread reusing the same id doesn't inherit a foreign connection
+        QObject::connect(QThread::currentThread(), &QThread::finished, [threadConnectionName]() {
+            if (!QSqlDatabase::contains(threadConnectionName)) {
+                return;
+            }
+            {
+                QSqlDatabase threadDb = QSqlDatabase::database(threadConnectionName, false);
+                threadDb.close();
+            }
+            QSqlDatabase::removeDatabase(threadConnectionName);
+        });
+    }
+
+    if (!db.isOpen() && !db.open()) {
+        if (errorMessage) {
+            *errorMessage = "Failed to open database connection: " + db.lastError().text();
+        }
+        return QSqlDatabase();
+    }
+
+    return db;
+}
+
+void QueryExecutor::closeThreadDatabase(const QString &connectionName) {
+    const QString threadConnectionName = threadConnectionNameFor(connectionName);
+    if (!QSqlDatabase::contains(threadConnectionName)) {
+        return;
+    }
+    {
+        QSqlDatabase threadDb = QSqlDatabase::database(threadConnectionName, false);
+        threadDb.close();
+    }
+    QSqlDatabase::removeDatabase(threadConnectionName);
+}
+
 QFuture<QueryResult> QueryExecutor::executeQuery(const QString &connectionName, const QString &query) {
     emit queryStarted();
 
@@ -68,21 +136,14 @@ QFuture<QueryResult> QueryExecutor::executeQuery(const QString &connectionName,
 QFuture<QueryResult> QueryExecutor::executeTableQuery(const QString &connectionName, const QString &tableName,
                                                        const QString &databaseName, const QString &schemaName,
                                                        int limit, int offset) {
-    // Build fully qualified table name
-    QString qualifiedTableName;
-
-    // For PostgreSQL/MySQL with schema, table name may already be qualified (schema.table)
-    if (tableName.contains('.')) {
-        // Already qualified, just quote each part
-        QStringList parts = tableName.split('.');
-        for (QString &part : parts) {
-            part = QString("\"%1\"").arg(part);
-        }
-        qualifiedTableName = parts.join('.');
-    } else {
-        // Quote table name
-        qualifiedTableName = QString("\"%1\"").arg(tableName);
-    }
+    // Table name may already be qualified (schema.table); quote each part for the backend.
+    // Otherwise it belongs to the schema, or to the database on MySQL.
+    DatabaseConnection *conn = ConnectionManager::instance().getConnection(connectionName);
+    const DatabaseType type = conn ? conn->getType() : DatabaseType::SQLite;
+    const QString owner = type == DatabaseType::MySQL ? databaseName : schemaName;
+    const QString qualifiedTableName = tableName.contains('.') || owner.isEmpty() || type == DatabaseType::SQLite
+        ? SqlDialect::qualifiedName(type, tableName)
+        : SqlDialect::qualifiedName(type, tableName, owner);
 
     QString query = QString("SELECT * FROM %1 LIMIT %2 OFFSET %3")
                         .arg(qualifiedTableName)
@@ -91,7 +152,24 @@ QFuture<QueryResult> QueryExecutor::executeTableQuery(const QString &connectionN
     return executeQuery(connectionName, query);
 }
 
-QueryResult QueryExecutor::runQuery(const ConnectionInfo &connInfo, const QString &query) {
+QueryResult QueryExecutor::runQuery(const ConnectionInfo &connInfo, const QString &query,
+                                    const CancelTokenPtr &token) {
+    QString openError;
+    QSqlDatabase db = threadDatabase(connInfo, &openError);
+    if (!db.isValid() || !db.isOpen()) {
+        QueryResult result;
+        result.success = false;
+        result.rowCount = 0;
+        result.executionTimeMs = 0;
+        result.errorMessage = openError.isEmpty() ? QString("Database connection is not valid or not open")
+                                                  : openError;
+        return result;
+    }
+
+    return runQuery(db, query, token);
+}
+
+QueryResult QueryExecutor::runQuery(QSqlDatabase db, const QString &query, const CancelTokenPtr &token) {
     QueryResult result;
     result.success = false;
     result.rowCount = 0;
@@ -99,33 +177,6 @@ QueryResult QueryExecutor::runQuery(const ConnectionInfo &connInfo, const QStrin
     QElapsedTimer timer;
     timer.start();
 
-    // Create a thread-specific connection
-    QString threadConnectionName = QString("thread_%1").arg((quintptr)QThread::currentThreadId());
-
-    QSqlDatabase db;
-    if (QSqlDatabase::contains(threadConnectionName)) {
-        db = QSqlDatabase::database(threadConnectionName, false);
-    } else {
-        // Create new connection for this thread
-        db = QSqlDatabase::addDatabase(connInfo.driverName, threadConnectionName);
-        db.setDatabaseName(connInfo.databaseName);
-        db.setHostName(connInfo.hostName);
-        db.setUserName(connInfo.userName);
-        db.setPassword(connInfo.password);
-        db.setPort(connInfo.port);
-        db.setConnectOptions(connInfo.connectOptions);
-
-        if (!db.open()) {
-            result.errorMessage = "Failed to open database connection: " + db.lastError().text();
-            return result;
-        }
-    }
-
-    if (!db.isValid() || !db.isOpen()) {
-        result.errorMessage = "Database connection is not valid or not open";
-        return result;
-    }
-
     QSqlQuery sqlQuery(db);
     if (!sqlQuery.exec(query)) {
         result.errorMessage = sqlQuery.lastError().text();
@@ -141,6 +192,13 @@ QueryResult QueryExecutor::runQuery(const ConnectionInfo &connInfo, const QStrin
 
     // Fetch all results
     while (sqlQuery.next()) {
+        if (token && token->isCancelled()) {
+            result.records.clear();
+            result.rowCount = 0;
+            result.errorMessage = "Query cancelled";
+            result.executionTimeMs = timer.elapsed();
+            return result;
+        }
         result.records.append(sqlQuery.record());
         result.rowCount++;
     }
@@ -150,3 +208,89 @@ QueryResult QueryExecutor::runQuery(const ConnectionInfo &connInfo, const QStrin
 
     return result;
 }
+
+void QueryExecutor::enableServerCancel(QSqlDatabase db, const ConnectionInfo &connInfo,
+                                       const CancelTokenPtr &token) {
+    if (!token) {
+        return;
+    }
+
+    const QString cancelQuery = cancelStatement(db, connInfo);
+    if (cancelQuery.isEmpty()) {
+        return;
+    }
+
+    // cancel() is usually called on the GUI thread; send the interrupt from a pool thread
+    token->setCancelHandler([connInfo, cancelQuery]() {
+        QtConcurrent::run([connInfo, cancelQuery]() {
+            runQuery(connInfo, cancelQuery);
+        });
+    });
+}
+
+QString QueryExecutor::cancelStatement(QSqlDatabase db, const ConnectionInfo &connInfo) {
+    DatabaseType type = DatabaseType::SQLite;
+    if (connInfo.driverName == "QPSQL") {
+        type = DatabaseType::PostgreSQL;
+    } else if (connInfo.driverName == "QMYSQL") {
+        type = DatabaseType::MySQL;
+    }
+
+    const QString idQuery = SqlDialect::backendIdQuery(type);
+    if (idQuery.isEmpty()) {
+        return QString();
+    }
+
+    QSqlQuery sqlQuery(db);
+    if (!sqlQuery.exec(idQuery) || !sqlQuery.next()) {
+        qDebug() << "Could not look up backend id:" << sqlQuery.lastError().text();
+        return QString();
+    }
+    return SqlDialect::cancelBackendQuery(type, sqlQuery.value(0).toLongLong());
+}
+
+ServerCancelGroup::ServerCancelGroup(const CancelTokenPtr &token)
+    : token(token), state(std::make_shared<State>()) {
+    if (!token) {
+        return;
+    }
+    token->setCancelHandler([state = state]() {
+        QMutexLocker locker(&state->mutex);
+        for (const Session &session : std::as_const(state->sessions)) {
+            QtConcurrent::run([connInfo = session.connInfo, cancelQuery = session.cancelQuery]() {
+                QueryExecutor::runQuery(connInfo, cancelQuery);
+            });
+        }
+    });
+}
+
+ServerCancelGroup::~ServerCancelGroup() {
+    if (token) {
+        token->clearCancelHandler();
+    }
+}
+
+QString ServerCancelGroup::add(QSqlDatabase db, const ConnectionInfo &connInfo) {
+    const QString cancelQuery = QueryExecutor::cancelStatement(db, connInfo);
+    if (cancelQuery.isEmpty()) {
+        return QString();
+    }
+    // The same backend id can come back on different servers
+    Session session{connInfo.name + ":" + cancelQuery, connInfo, cancelQuery};
+    QMutexLocker locker(&state->mutex);
+    state->sessions.append(session);
+    return session.id;
+}
+
+void ServerCancelGroup::remove(const QString &id) {
+    if (id.isEmpty()) {
+        return;
+    }
+    QMutexLocker locker(&state->mutex);
+    for (int i = 0; i < state->sessions.size(); ++i) {
+        if (state->sessions.at(i).id == id) {
+            state->sessions.removeAt(i);
+            return;
+        }
+    }
+}
@@ -0,0 +1,216 @@
+#include "core/result_exporter.h"
+#include "core/bounded_queue.h"
+#include "core/chunked_scan.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <QSqlError>
+#include <QThread>
+
+ResultFormat ResultExporter::formatForPath(const QString &filePath) {
+    const QString path = CompressedFileWriter::stripCompressionSuffix(filePath).toLower();
+    if (path.endsWith(".tsv") || path.endsWith(".txt")) {
+        return ResultFormat::TSV;
+    }
+    if (path.endsWith(".ndjson") || path.endsWith(".jsonl")) {
+        return ResultFormat::NDJson;
+    }
+    if (path.endsWith(".sql")) {
+        return ResultFormat::SqlInsert;
+    }
+    return ResultFormat::CSV;
+}
+
+QFuture<QueryResult> ResultExporter::start(const ConnectionInfo &connInfo, const QString &query,
+                                           const ExportOptions &options, const TransferProgressPtr &progress,
+                                           const CancelTokenPtr &token) {
+    return QtConcurrent::run([connInfo, query, options, progress, token]() {
+        return run(connInfo, query, options, progress, token);
+    });
+}
+
+QFuture<QueryResult> ResultExporter::startTable(const ConnectionInfo &connInfo, DatabaseType type,
+                                                const QString &table, const ExportOptions &options,
+                                                const TransferProgressPtr &progress, const CancelTokenPtr &token) {
+    return QtConcurrent::run([connInfo, type, table, options, progress, token]() {
+        return runTable(connInfo, type, table, options, progress, token);
+    });
+}
+
+QueryResult ResultExporter::run(const ConnectionInfo &connInfo, const QString &query,
+                                const ExportOptions &options, const TransferProgressPtr &progress,
+                                const CancelTokenPtr &token) {
+    QElapsedTimer timer;
+    timer.start();
+
+    QueryResult result;
+    result.success = false;
+    result.rowCount = 0;
+    result.executionTimeMs = 0;
+
+    QSqlDatabase db = QueryExecutor::threadDatabase(connInfo, &result.errorMessage);
+    if (!db.isValid() || !db.isOpen()) {
+        return result;
+    }
+
+    // Forward-only keeps QSqlQuery from caching rows for backwards navigation, and
+    // QPSQL and QSQLITE then fetch as they go. QMYSQL still reads the whole result
+    // into client memory on exec (mysql_store_result); the export dialog says so.
+    QSqlQuery sqlQuery(db);
+    sqlQuery.setForwardOnly(true);
+    QueryExecutor::enableServerCancel(db, connInfo, token);
+    if (!sqlQuery.exec(query)) {
+        if (token) {
+            token->clearCancelHandler();
+        }
+        result.errorMessage = sqlQuery.lastError().text();
+        result.executionTimeMs = timer.elapsed();
+        return result;
+    }
+
+    QStringList columns;
+    const QSqlRecord layout = sqlQuery.record();
+    for (int i = 0; i < layout.count(); ++i) {
+        columns << layout.fieldName(i);
+    }
+
+    result = writeFile(options, columns, [&](const BatchSink &sink, QString *fetchError) {
+        QList<QSqlRecord> batch;
+        batch.reserve(kBatchRows);
+        bool cancelled = false;
+        while (sqlQuery.next()) {
+            if (token && token->isCancelled()) {
+                cancelled = true;
+                break;
+            }
+            batch.append(sqlQuery.record());
+            if (batch.size() == kBatchRows) {
+                if (!sink(std::move(batch))) {
+                    break;  // writer failed
+                }
+                batch = QList<QSqlRecord>();
+                batch.reserve(kBatchRows);
+            }
+        }
+        if (!cancelled && !batch.isEmpty()) {
+            sink(std::move(batch));
+        }
+        if (sqlQuery.lastError().isValid()) {
+            *fetchError = sqlQuery.lastError().text();
+        }
+        sqlQuery.finish();
+    }, progress, token);
+
+    if (token) {
+        token->clearCancelHandler();
+    }
+    result.executionTimeMs = timer.elapsed();
+    return result;
+}
+
+QueryResult ResultExporter::runTable(const ConnectionInfo &connInfo, DatabaseType type, const QString &table,
+                                     const ExportOptions &options, const TransferProgressPtr &progress,
+                                     const CancelTokenPtr &token) {
+    QElapsedTimer timer;
+    timer.start();
+
+    QueryResult result;
+    result.success = false;
+    result.rowCount = 0;
+    result.executionTimeMs = 0;
+
+    QSqlDatabase db = QueryExecutor::threadDatabase(connInfo, &result.errorMessage);
+    if (!db.isValid() || !db.isOpen()) {
+        return result;
+    }
+
+    // Row order doesn't matter in a file, so key ranges are written as they arrive
+    ChunkedScanOptions scanOptions;
+    scanOptions.table = table;
+    scanOptions.keyColumn = ChunkedScan::keyColumn(db, table);
+    scanOptions.concurrency = options.scanSessions;
+    scanOptions.ordered = false;
+    scanOptions.batchRows = kBatchRows;
+    ChunkedScan scan(connInfo, type, scanOptions);
+    if (!scan.plan(db, &result.errorMessage)) {
+        return result;
+    }
+
+    result = writeFile(options, scan.getColumnNames(), [&](const BatchSink &sink, QString *fetchError) {
+        scan.run(sink, token, fetchError);
+    }, progress, token);
+    result.executionTimeMs = timer.elapsed();
+    return result;
+}
+
+QueryResult ResultExporter::writeFile(const ExportOptions &options, const QStringList &columns,
+                                      const std::function<void(const BatchSink &, QString *)> &fetch,
+                                      const TransferProgressPtr &progress, const CancelTokenPtr &token) {
+    QueryResult result;
+    result.success = false;
+    result.rowCount = 0;
+    result.executionTimeMs = 0;
+    result.columnNames = columns;
+
+    CompressedFileWriter writer;
+    if (!writer.open(options.filePath, options.compression, &result.errorMessage)) {
+        return result;
+    }
+
+    const ResultSerializer serializer(options.format, columns, options.tableName,
+                                      options.dialect, options.rowsPerInsert);
+    BoundedQueue<QList<QSqlRecord>> queue(kQueueBatches);
+    QString writeError;
+
+    // The writer gets its own thread rather than a pool slot: the fetch loop blocks on
+    // the queue, and two pool tasks waiting on each other can starve a busy pool
+    std::unique_ptr<QThread> writerThread(QThread::create([&]() {
+        const QString header = serializer.header();
+        if (!header.isEmpty() && !writer.write(header.toUtf8(), &writeError)) {
+            queue.close();
+            return;
+        }
+
+        QList<QSqlRecord> batch;
+        QString text;
+        while (queue.pop(batch)) {
+            text.resize(0);
+            serializer.appendRecords(text, batch);
+            const QByteArray bytes = text.toUtf8();
+            if (!writer.write(bytes, &writeError)) {
+                queue.close();
+                return;
+            }
+            progress->rows += batch.size();
+            progress->bytes += bytes.size();
+        }
+    }));
+    writerThread->start();
+
+    QString fetchError;
+    fetch([&](QList<QSqlRecord> &&batch) {
+        result.rowCount += batch.size();
+        return queue.push(std::move(batch));
+    }, &fetchError);
+
+    queue.close();
+    writerThread->wait();
+
+    QString closeError;
+    const bool closed = writer.close(&closeError);
+
+    if (token && token->isCancelled()) {
+        result.errorMessage = "Export cancelled";
+    } else if (!writeError.isEmpty()) {
+        result.errorMessage = writeError;
+    } else if (!fetchError.isEmpty()) {
+        result.errorMessage = fetchError;
+    } else if (!closed) {
+        result.errorMessage = closeError;
+    } else {
+        result.success = true;
+        return result;
+    }
+
+    QFile::remove(options.filePath);
+    return result;
+}
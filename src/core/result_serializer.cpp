@@ -0,0 +1,262 @@
+#include "core/result_serializer.h"
+#include "core/sql_dialect.h"
+#include <QDate>
+#include <QDateTime>
+#include <QTime>
+#include <cmath>
+
+ResultSerializer::ResultSerializer(ResultFormat format, const QStringList &columns,
+                                   const QString &tableName, DatabaseType dialect,
+                                   int rowsPerStatement)
+    : format(format), columns(columns), dialect(dialect), rowsPerStatement(qMax(1, rowsPerStatement)) {
+    if (format == ResultFormat::SqlInsert) {
+        QStringList quotedColumns;
+        for (const QString &column : columns) {
+            quotedColumns << SqlDialect::quoteIdentifier(dialect, column);
+        }
+        QString target = tableName.isEmpty() ? QString("result") : tableName;
+        insertPrefix = QString("INSERT INTO %1 (%2) VALUES ")
+                           .arg(SqlDialect::qualifiedName(dialect, target), quotedColumns.join(", "));
+    } else if (format == ResultFormat::NDJson) {
+        for (const QString &column : columns) {
+            jsonKeys << jsonString(column) + ':';
+        }
+    }
+}
+
+QString ResultSerializer::formatName(ResultFormat format) {
+    switch (format) {
+        case ResultFormat::TSV:
+            return "TSV";
+        case ResultFormat::CSV:
+            return "CSV";
+        case ResultFormat::Markdown:
+            return "Markdown";
+        case ResultFormat::SqlInsert:
+            return "SQL INSERT";
+        case ResultFormat::NDJson:
+            return "JSON Lines";
+    }
+    return QString();
+}
+
+QString ResultSerializer::header() const {
+    switch (format) {
+        case ResultFormat::TSV:
+            return columns.join('\t') + "\n";
+        case ResultFormat::CSV: {
+            QStringList escaped;
+            for (const QString &column : columns) {
+                escaped << csvEscape(column);
+            }
+            return escaped.join(',') + "\r\n";
+        }
+        case ResultFormat::Markdown: {
+            QStringList escaped;
+            for (const QString &column : columns) {
+                escaped << markdownEscape(column);
+            }
+            QString text = "| " + escaped.join(" | ") + " |\n|";
+            for (int i = 0; i < columns.size(); ++i) {
+                text += " --- |";
+            }
+            return text + "\n";
+        }
+        case ResultFormat::SqlInsert:
+        case ResultFormat::NDJson:
+            return QString();
+    }
+    return QString();
+}
+
+void ResultSerializer::appendRecord(QString &out, const QSqlRecord &record) const {
+    const int count = record.count();
+
+    switch (format) {
+        case ResultFormat::TSV:
+            for (int i = 0; i < count; ++i) {
+                if (i > 0) out += '\t';
+                out += fieldText(record, i);
+            }
+            out += '\n';
+            break;
+        case ResultFormat::CSV:
+            for (int i = 0; i < count; ++i) {
+                if (i > 0) out += ',';
+                out += fieldText(record, i);
+            }
+            out += "\r\n";
+            break;
+        case ResultFormat::Markdown:
+            out += '|';
+            for (int i = 0; i < count; ++i) {
+                out += ' ';
+                out += fieldText(record, i);
+                out += " |";
+            }
+            out += '\n';
+            break;
+        case ResultFormat::SqlInsert:
+            out += insertPrefix;
+            appendValues(out, record);
+            out += ";\n";
+            break;
+        case ResultFormat::NDJson:
+            appendJsonObject(out, record);
+            out += '\n';
+            break;
+    }
+}
+
+void ResultSerializer::appendRecords(QString &out, const QList<QSqlRecord> &records) const {
+    if (format != ResultFormat::SqlInsert || rowsPerStatement == 1) {
+        for (const QSqlRecord &record : records) {
+            appendRecord(out, record);
+        }
+        return;
+    }
+
+    for (int i = 0; i < records.size(); ++i) {
+        if (i % rowsPerStatement == 0) {
+            out += insertPrefix;
+            out += '\n';
+        }
+        out += "  ";
+        appendValues(out, records.at(i));
+        const bool lastInStatement = (i + 1) % rowsPerStatement == 0 || i + 1 == records.size();
+        out += lastInStatement ? ";\n" : ",\n";
+    }
+}
+
+void ResultSerializer::appendValues(QString &out, const QSqlRecord &record) const {
+    out += '(';
+    for (int i = 0; i < record.count(); ++i) {
+        if (i > 0) out += ", ";
+        out += fieldText(record, i);
+    }
+    out += ')';
+}
+
+void ResultSerializer::appendJsonObject(QString &out, const QSqlRecord &record) const {
+    // Written by hand rather than through QJsonObject to keep column order and
+    // avoid a DOM allocation per row
+    out += '{';
+    for (int i = 0; i < record.count(); ++i) {
+        if (i > 0) out += ',';
+        out += i < jsonKeys.size() ? jsonKeys.at(i) : jsonString(record.fieldName(i)) + ':';
+        out += record.isNull(i) ? QString("null") : jsonValue(record.value(i));
+    }
+    out += '}';
+}
+
+QString ResultSerializer::jsonString(const QString &text) {
+    QString escaped;
+    escaped.reserve(text.size() + 2);
+    escaped += '"';
+    for (const QChar ch : text) {
+        switch (ch.unicode()) {
+            case '"':  escaped += "\\\""; break;
+            case '\\': escaped += "\\\\"; break;
+            case '\n': escaped += "\\n"; break;
+            case '\r': escaped += "\\r"; break;
+            case '\t': escaped += "\\t"; break;
+            default:
+                if (ch.unicode() < 0x20) {
+                    escaped += QString("\\u%1").arg(ch.unicode(), 4, 16, QChar('0'));
+                } else {
+                    escaped += ch;
+                }
+        }
+    }
+    escaped += '"';
+    return escaped;
+}
+
+QString ResultSerializer::jsonValue(const QVariant &value) {
+    switch (value.metaType().id()) {
+        case QMetaType::Bool:
+            return value.toBool() ? "true" : "false";
+        case QMetaType::Int:
+        case QMetaType::UInt:
+        case QMetaType::Long:
+        case QMetaType::ULong:
+        case QMetaType::LongLong:
+        case QMetaType::ULongLong:
+        case QMetaType::Short:
+        case QMetaType::UShort:
+            return value.toString();
+        case QMetaType::Double:
+        case QMetaType::Float: {
+            const double number = value.toDouble();
+            return std::isfinite(number) ? QString::number(number, 'g', 17) : QString("null");
+        }
+        case QMetaType::QByteArray:
+            return jsonString(QString::fromLatin1(value.toByteArray().toBase64()));
+        case QMetaType::QDate:
+            return jsonString(value.toDate().toString(Qt::ISODate));
+        case QMetaType::QTime:
+            return jsonString(value.toTime().toString(Qt::ISODateWithMs));
+        case QMetaType::QDateTime:
+            return jsonString(value.toDateTime().toString(Qt::ISODateWithMs));
+        default:
+            return jsonString(value.toString());
+    }
+}
+
+QString ResultSerializer::fieldText(const QSqlRecord &record, int column) const {
+    if (format == ResultFormat::SqlInsert) {
+        return record.isNull(column) ? QString("NULL")
+                                     : SqlDialect::literal(dialect, record.value(column));
+    }
+
+    if (record.isNull(column)) {
+        return QString();
+    }
+
+    QString text = record.value(column).toString();
+    switch (format) {
+        case ResultFormat::TSV:
+            // Spreadsheets split on tabs and newlines, so flatten them
+            text.replace('\t', ' ');
+            text.replace('\r', ' ');
+            text.replace('\n', ' ');
+            return text;
+        case ResultFormat::CSV:
+            return csvEscape(text);
+        case ResultFormat::Markdown:
+            return markdownEscape(text);
+        case ResultFormat::SqlInsert:
+        case ResultFormat::NDJson:
+            break;
+    }
+    return text;
+}
+
+QString ResultSerializer::markdownEscape(const QString &text) const {
+    // A backslash before the pipe would escape the escaping one
+    QString escaped = text;
+    escaped.replace('\\', "\\\\");
+    escaped.replace('|', "\\|");
+    escaped.replace("\r\n", "<br>");
+    escaped.replace('\n', "<br>");
+    escaped.replace('\r', "<br>");
+    return escaped;
+}
+
+QString ResultSerializer::csvEscape(const QString &text) const {
+    // RFC 4180: quote fields containing separators, quotes or line breaks
+    bool needsQuotes = false;
+    for (const QChar ch : text) {
+        if (ch == ',' || ch == '"' || ch == '\n' || ch == '\r') {
+            needsQuotes = true;
+            break;
+        }
+    }
+    if (!needsQuotes) {
+        return text;
+    }
+
+    QString escaped = text;
+    escaped.replace('"', "\"\"");
+    return QString("\"%1\"").arg(escaped);
+}
@@ -0,0 +1,681 @@
+#include "core/schema_differ.h"
+#include "core/sql_dialect.h"
+#include "database/connection_manager.h"
+#include <QElapsedTimer>
+#include <QHash>
+#include <QRegularExpression>
+#include <QtConcurrent>
+#include <algorithm>
+#include <memory>
+
+namespace {
+SchemaDiff failure(const QString &message) {
+    SchemaDiff diff;
+    diff.success = false;
+    diff.errorMessage = message;
+    return diff;
+}
+
+// A column, index or foreign key reduced to what is compared
+struct Member {
+    QString name;        // as shown
+    QString definition;
+    int index = 0;       // into the snapshot's list of its kind
+};
+
+// A relation and its members, keyed the way they are matched across the two sides
+struct Shape {
+    const RelationInfo *relation = nullptr;
+    QList<int> columns;      // into the snapshot's lists, in table order
+    QList<int> indexes;
+    QList<int> foreignKeys;
+    QHash<QString, Member> columnsByKey;
+    QHash<QString, Member> indexesByKey;
+    QHash<QString, Member> foreignKeysByKey;
+    size_t hash = 0;
+};
+
+// PostgreSQL serial defaults name their sequence, qualified when its schema isn't on
+// the search path: nextval('staging.orders_id_seq'::regclass). References into
+// fromSchema, and unqualified ones, are moved to toSchema (left unqualified when empty).
+QString moveSequenceReferences(const QString &expression, const QString &fromSchema, const QString &toSchema) {
+    static const QRegularExpression nextval(
+        R"(nextval\('((?:"(?:[^"]|"")*"|[^'".]+)\.)?((?:"(?:[^"]|"")*"|[^'".]+))'::regclass\))");
+    if (!expression.contains("nextval(")) {
+        return expression;
+    }
+
+    const QString qualifier = toSchema.isEmpty()
+        ? QString() : SqlDialect::quoteIdentifier(DatabaseType::PostgreSQL, toSchema).replace("'", "''") + ".";
+    QString moved;
+    qsizetype last = 0;
+    QRegularExpressionMatchIterator matches = nextval.globalMatch(expression);
+    while (matches.hasNext()) {
+        const QRegularExpressionMatch match = matches.next();
+        QString schema = match.captured(1);
+        schema.chop(1);
+        if (schema.startsWith('"')) {
+            schema = schema.mid(1, schema.size() - 2).replace("\"\"", "\"");
+        }
+        moved += expression.mid(last, match.capturedStart() - last);
+        if (!schema.isEmpty() && schema != fromSchema) {
+            moved += match.captured(0);
+        } else {
+            moved += QString("nextval('%1%2'::regclass)").arg(qualifier, match.captured(2));
+        }
+        last = match.capturedEnd();
+    }
+    return moved + expression.mid(last);
+}
+
+// A default as the same column in another schema would have it
+QString portableDefault(const ColumnInfo &column) {
+    return moveSequenceReferences(column.defaultValue, column.schema, QString());
+}
+
+QString columnDefinition(const ColumnInfo &column) {
+    QString definition = column.dataType.simplified();
+    if (!column.nullable) {
+        definition += " NOT NULL";
+    }
+    if (!column.defaultValue.isEmpty()) {
+        definition += " DEFAULT " + portableDefault(column);
+    }
+    if (!column.extra.isEmpty()) {
+        definition += " " + column.extra;
+    }
+    return definition;
+}
+
+QString indexDefinition(const IndexInfo &index) {
+    const QString columns = "(" + index.columns.join(", ") + ")";
+    if (index.primary) {
+        return "PRIMARY KEY " + columns;
+    }
+    return index.unique ? "UNIQUE " + columns : columns;
+}
+
+// References into the key's own schema are left unqualified, so that the same key in
+// schemas of different names compares equal
+QString foreignKeyDefinition(const ForeignKeyInfo &key) {
+    QString referenced = key.referencedTable;
+    if (!key.referencedSchema.isEmpty() && key.referencedSchema != key.schema) {
+        referenced = key.referencedSchema + "." + referenced;
+    }
+    QString definition = QString("(%1) REFERENCES %2").arg(key.columns.join(", "), referenced);
+    if (!key.referencedColumns.isEmpty()) {
+        definition += " (" + key.referencedColumns.join(", ") + ")";
+    }
+    return definition;
+}
+
+void addMember(QHash<QString, Member> *members, QChar type, const QString &key, const Member &member,
+               size_t *hash) {
+    // A sum doesn't depend on the order members are listed in
+    *hash += qHashMulti(0, type, key, member.definition);
+    members->insert(key, member);
+}
+
+QHash<QString, Shape> shapesOf(const CatalogSnapshot &snapshot) {
+    QHash<QString, Shape> shapes;
+    shapes.reserve(snapshot.relations.size());
+    for (const RelationInfo &relation : snapshot.relations) {
+        Shape &shape = shapes[relation.name];
+        shape.relation = &relation;
+        shape.hash = qHash(int(relation.kind));
+    }
+
+    for (int i = 0; i < snapshot.columns.size(); ++i) {
+        const ColumnInfo &column = snapshot.columns.at(i);
+        const auto shape = shapes.find(column.table);
+        if (shape == shapes.end()) {
+            continue;
+        }
+        shape->columns << i;
+        addMember(&shape->columnsByKey, u'C', column.name, Member{column.name, columnDefinition(column), i},
+                  &shape->hash);
+    }
+    for (int i = 0; i < snapshot.indexes.size(); ++i) {
+        const IndexInfo &index = snapshot.indexes.at(i);
+        const auto shape = shapes.find(index.table);
+        if (shape == shapes.end()) {
+            continue;
+        }
+        // Primary keys are matched whatever they are called; the names are generated
+        shape->indexes << i;
+        addMember(&shape->indexesByKey, u'I', index.primary ? QStringLiteral("PRIMARY KEY") : index.name,
+                  Member{index.name, indexDefinition(index), i}, &shape->hash);
+    }
+    for (int i = 0; i < snapshot.foreignKeys.size(); ++i) {
+        const ForeignKeyInfo &key = snapshot.foreignKeys.at(i);
+        const auto shape = shapes.find(key.table);
+        if (shape == shapes.end()) {
+            continue;
+        }
+        // SQLite's keys have no name, so they are known by what they say
+        const QString definition = foreignKeyDefinition(key);
+        shape->foreignKeys << i;
+        addMember(&shape->foreignKeysByKey, u'F', key.name.isEmpty() ? definition : key.name,
+                  Member{key.name, definition, i}, &shape->hash);
+    }
+    return shapes;
+}
+
+SchemaDifference::ObjectType relationType(RelationKind kind) {
+    switch (kind) {
+        case RelationKind::View:
+            return SchemaDifference::View;
+        case RelationKind::Sequence:
+            return SchemaDifference::Sequence;
+        case RelationKind::Table:
+            break;
+    }
+    return SchemaDifference::Table;
+}
+
+QString relationDefinition(const Shape &shape) {
+    const SchemaDifference::ObjectType type = relationType(shape.relation->kind);
+    if (type != SchemaDifference::Table) {
+        return SchemaDiffer::objectTypeName(type).toLower();
+    }
+    return QString("table, %1 columns").arg(shape.columns.size());
+}
+
+void sortNames(QStringList *names) {
+    std::sort(names->begin(), names->end(), [](const QString &a, const QString &b) {
+        const int order = a.compare(b, Qt::CaseInsensitive);
+        return order != 0 ? order < 0 : a < b;
+    });
+}
+
+const Member *memberAt(const QHash<QString, Member> &members, const QString &key) {
+    const auto it = members.constFind(key);
+    return it != members.cend() ? &it.value() : nullptr;
+}
+
+SchemaDifference::Kind differenceKind(const Member *wanted, const Member *current) {
+    if (!current) {
+        return SchemaDifference::Added;
+    }
+    return wanted ? SchemaDifference::Changed : SchemaDifference::Removed;
+}
+
+QStringList unitedKeys(const QHash<QString, Member> &source, const QHash<QString, Member> &target) {
+    QStringList keys = source.keys();
+    for (auto it = target.cbegin(); it != target.cend(); ++it) {
+        if (!source.contains(it.key())) {
+            keys << it.key();
+        }
+    }
+    sortNames(&keys);
+    return keys;
+}
+
+// Statements turning the target schema into the source one, collected by phase so
+// that keys are dropped before what they reference and created after it
+class MigrationWriter {
+public:
+    MigrationWriter(DatabaseType type, const CatalogSnapshot &source, const CatalogSnapshot &target)
+        : type(type), source(source), target(target) {}
+
+    void createRelation(const QString &name, const Shape &shape) {
+        switch (shape.relation->kind) {
+            case RelationKind::View:
+                note(&createRelations, QString("view %1: create it from the source's definition").arg(name));
+                return;
+            case RelationKind::Sequence:
+                // Before the tables, whose defaults may call nextval() on them
+                if (type == DatabaseType::PostgreSQL) {
+                    createSequences << QString("CREATE SEQUENCE %1;").arg(relationName(name));
+                } else {
+                    note(&createSequences, QString("sequence %1 has no equivalent on this backend").arg(name));
+                }
+                return;
+            case RelationKind::Table:
+                break;
+        }
+
+        QStringList lines;
+        for (int i : shape.columns) {
+            lines << "    " + columnSpec(source.columns.at(i));
+        }
+        for (int i : shape.indexes) {
+            const IndexInfo &index = source.indexes.at(i);
+            if (index.primary) {
+                lines << QString("    PRIMARY KEY (%1)").arg(indexColumns(shape, index.columns));
+            } else if (isImplicitIndex(index)) {
+                lines << QString("    UNIQUE (%1)").arg(indexColumns(shape, index.columns));
+            }
+        }
+        // SQLite can only declare foreign keys with the table
+        if (type == DatabaseType::SQLite) {
+            for (int i : shape.foreignKeys) {
+                lines << "    FOREIGN KEY " + foreignKeySpec(source.foreignKeys.at(i));
+            }
+        }
+        createRelations << QString("CREATE TABLE %1 (\n%2\n);").arg(relationName(name), lines.join(",\n"));
+
+        for (int i : shape.indexes) {
+            const IndexInfo &index = source.indexes.at(i);
+            if (!index.primary && !isImplicitIndex(index)) {
+                createIndex(shape, index);
+            }
+        }
+        if (type != DatabaseType::SQLite) {
+            for (int i : shape.foreignKeys) {
+                addForeignKey(source.foreignKeys.at(i));
+            }
+        }
+    }
+
+    void dropRelation(const QString &name, const Shape &shape) {
+        switch (shape.relation->kind) {
+            case RelationKind::View:
+                dropRelations << QString("DROP VIEW %1;").arg(relationName(name));
+                break;
+            case RelationKind::Sequence:
+                // After the columns whose defaults use them have been dropped or altered
+                dropSequences << QString("DROP SEQUENCE %1;").arg(relationName(name));
+                break;
+            case RelationKind::Table:
+                dropRelations << QString("DROP TABLE %1;").arg(relationName(name));
+                break;
+        }
+    }
+
+    void addColumn(const ColumnInfo &column) {
+        alterTables << QString("ALTER TABLE %1 ADD COLUMN %2;").arg(relationName(column.table), columnSpec(column));
+    }
+
+    void dropColumn(const ColumnInfo &column) {
+        alterTables << QString("ALTER TABLE %1 DROP COLUMN %2;")
+            .arg(relationName(column.table), quote(column.name));
+    }
+
+    void alterColumn(const ColumnInfo &wanted, const ColumnInfo &current) {
+        const QString table = relationName(wanted.table);
+        if (type == DatabaseType::MySQL) {
+            alterTables << QString("ALTER TABLE %1 MODIFY COLUMN %2;").arg(table, columnSpec(wanted));
+            return;
+        }
+        if (type == DatabaseType::SQLite) {
+            note(&alterTables, QString("%1.%2: SQLite can't alter a column; rebuild the table with %3")
+                .arg(wanted.table, wanted.name, columnSpec(wanted)));
+            return;
+        }
+
+        const QString column = quote(wanted.name);
+        const QString wantedDefault = targetDefault(wanted);
+        if (wanted.dataType.simplified() != current.dataType.simplified()) {
+            alterTables << QString("ALTER TABLE %1 ALTER COLUMN %2 TYPE %3;").arg(table, column, wanted.dataType);
+        }
+        if (wanted.nullable != current.nullable) {
+            alterTables << QString("ALTER TABLE %1 ALTER COLUMN %2 %3 NOT NULL;")
+                .arg(table, column, wanted.nullable ? "DROP" : "SET");
+        }
+        if (portableDefault(wanted) != portableDefault(current)) {
+            alterTables << (wantedDefault.isEmpty()
+                ? QString("ALTER TABLE %1 ALTER COLUMN %2 DROP DEFAULT;").arg(table, column)
+                : QString("ALTER TABLE %1 ALTER COLUMN %2 SET DEFAULT %3;").arg(table, column, wantedDefault));
+        }
+    }
+
+    void createIndex(const Shape &shape, const IndexInfo &index) {
+        const QString table = relationName(index.table);
+        const QString columns = indexColumns(shape, index.columns);
+        if (index.primary) {
+            if (type == DatabaseType::SQLite) {
+                note(&createIndexes, QString("%1: SQLite can't add a primary key; rebuild the table with "
+                                             "PRIMARY KEY (%2)").arg(index.table, columns));
+            } else if (type == DatabaseType::PostgreSQL && !index.name.isEmpty()) {
+                createIndexes << QString("ALTER TABLE %1 ADD CONSTRAINT %2 PRIMARY KEY (%3);")
+                    .arg(table, quote(index.name), columns);
+            } else {
+                createIndexes << QString("ALTER TABLE %1 ADD PRIMARY KEY (%2);").arg(table, columns);
+            }
+            return;
+        }
+        if (isImplicitIndex(index)) {
+            if (type == DatabaseType::SQLite) {
+                note(&createIndexes, QString("%1: SQLite can't add a UNIQUE constraint; rebuild the table with "
+                                             "UNIQUE (%2)").arg(index.table, columns));
+            } else {
+                createIndexes << QString("ALTER TABLE %1 ADD UNIQUE (%2);").arg(table, columns);
+            }
+            return;
+        }
+        if (type == DatabaseType::PostgreSQL && index.constraint) {
+            createIndexes << QString("ALTER TABLE %1 ADD CONSTRAINT %2 UNIQUE (%3);")
+                .arg(table, quote(index.name), columns);
+            return;
+        }
+        createIndexes << QString("CREATE %1INDEX %2 ON %3 (%4);")
+            .arg(index.unique ? "UNIQUE " : "", quote(index.name), table, columns);
+    }
+
+    void dropIndex(const IndexInfo &index) {
+        const QString table = relationName(index.table);
+        if (index.primary) {
+            if (type == DatabaseType::SQLite) {
+                note(&dropIndexes, QString("%1: SQLite can't drop a primary key; rebuild the table")
+                    .arg(index.table));
+            } else if (type == DatabaseType::PostgreSQL) {
+                dropIndexes << QString("ALTER TABLE %1 DROP CONSTRAINT %2;").arg(table, quote(index.name));
+            } else {
+                dropIndexes << QString("ALTER TABLE %1 DROP PRIMARY KEY;").arg(table);
+            }
+            return;
+        }
+        if (isImplicitIndex(index)) {
+            note(&dropIndexes, QString("%1: SQLite can't drop a UNIQUE constraint; rebuild the table")
+                .arg(index.table));
+        } else if (type == DatabaseType::PostgreSQL && index.constraint) {
+            // PostgreSQL refuses DROP INDEX on the index behind a constraint
+            dropIndexes << QString("ALTER TABLE %1 DROP CONSTRAINT %2;").arg(table, quote(index.name));
+        } else if (type == DatabaseType::MySQL) {
+            dropIndexes << QString("DROP INDEX %1 ON %2;").arg(quote(index.name), table);
+        } else {
+            dropIndexes << QString("DROP INDEX %1;").arg(relationName(index.name));
+        }
+    }
+
+    void addForeignKey(const ForeignKeyInfo &key) {
+        if (type == DatabaseType::SQLite) {
+            note(&addForeignKeys, QString("%1: SQLite can't add a foreign key; rebuild the table with "
+                                          "FOREIGN KEY %2").arg(key.table, foreignKeySpec(key)));
+            return;
+        }
+        const QString constraint = key.name.isEmpty() ? QString() : "CONSTRAINT " + quote(key.name) + " ";
+        addForeignKeys << QString("ALTER TABLE %1 ADD %2FOREIGN KEY %3;")
+            .arg(relationName(key.table), constraint, foreignKeySpec(key));
+    }
+
+    void dropForeignKey(const ForeignKeyInfo &key) {
+        if (type == DatabaseType::SQLite || key.name.isEmpty()) {
+            note(&dropForeignKeys, QString("%1: drop the foreign key %2 by rebuilding the table")
+                .arg(key.table, foreignKeyDefinition(key)));
+            return;
+        }
+        dropForeignKeys << QString("ALTER TABLE %1 DROP %2 %3;")
+            .arg(relationName(key.table), type == DatabaseType::MySQL ? "FOREIGN KEY" : "CONSTRAINT",
+                 quote(key.name));
+    }
+
+    QStringList script() const {
+        return dropForeignKeys + dropIndexes + dropRelations + createSequences + createRelations + alterTables
+            + dropSequences + createIndexes + addForeignKeys;
+    }
+
+private:
+    QString quote(const QString &identifier) const {
+        return SqlDialect::quoteIdentifier(type, identifier);
+    }
+
+    // Objects are created in and dropped from the target's schema
+    QString relationName(const QString &name) const {
+        if (target.schema.isEmpty()) {
+            return quote(name);
+        }
+        return quote(target.schema) + "." + quote(name);
+    }
+
+    // A generated column's expression must follow the type; other attributes go last
+    QString columnSpec(const ColumnInfo &column) const {
+        const bool generated = column.extra.startsWith("GENERATED");
+        QString spec = quote(column.name) + " " + column.dataType;
+        if (generated) {
+            spec += " " + column.extra;
+        }
+        if (!column.nullable) {
+            spec += " NOT NULL";
+        }
+        if (!column.defaultValue.isEmpty()) {
+            spec += " DEFAULT " + targetDefault(column);
+        }
+        if (!generated && !column.extra.isEmpty()) {
+            spec += " " + column.extra;
+        }
+        return spec;
+    }
+
+    // Sequences a source default uses are the ones created in the target schema
+    QString targetDefault(const ColumnInfo &column) const {
+        return moveSequenceReferences(column.defaultValue, column.schema, target.schema);
+    }
+
+    // Column names are quoted, expressions of expression indexes kept as they are
+    QString indexColumns(const Shape &shape, const QStringList &columns) const {
+        QStringList quoted;
+        for (const QString &column : columns) {
+            quoted << (shape.columnsByKey.contains(column) ? quote(column) : column);
+        }
+        return quoted.join(", ");
+    }
+
+    QString foreignKeySpec(const ForeignKeyInfo &key) const {
+        QStringList columns;
+        for (const QString &column : key.columns) {
+            columns << quote(column);
+        }
+        const QString referenced = key.referencedSchema.isEmpty() || key.referencedSchema == key.schema
+            ? relationName(key.referencedTable)
+            : quote(key.referencedSchema) + "." + quote(key.referencedTable);
+        QString spec = QString("(%1) REFERENCES %2").arg(columns.join(", "), referenced);
+        if (!key.referencedColumns.isEmpty()) {
+            QStringList referencedColumns;
+            for (const QString &column : key.referencedColumns) {
+                referencedColumns << quote(column);
+            }
+            spec += " (" + referencedColumns.join(", ") + ")";
+        }
+        return spec;
+    }
+
+    // SQLite's indexes behind UNIQUE constraints, which can't be created by name
+    static bool isImplicitIndex(const IndexInfo &index) {
+        return index.name.startsWith("sqlite_autoindex_");
+    }
+
+    static void note(QStringList *phase, const QString &text) {
+        *phase << "-- " + text;
+    }
+
+    DatabaseType type;
+    const CatalogSnapshot &source;
+    const CatalogSnapshot &target;
+
+    QStringList dropForeignKeys;
+    QStringList dropIndexes;
+    QStringList dropRelations;
+    QStringList createSequences;
+    QStringList createRelations;
+    QStringList alterTables;
+    QStringList dropSequences;
+    QStringList createIndexes;
+    QStringList addForeignKeys;
+};
+} // namespace
+
+QString SchemaDiffer::kindName(SchemaDifference::Kind kind) {
+    switch (kind) {
+        case SchemaDifference::Added:
+            return "Added";
+        case SchemaDifference::Removed:
+            return "Removed";
+        case SchemaDifference::Changed:
+            return "Changed";
+    }
+    return QString();
+}
+
+QString SchemaDiffer::objectTypeName(SchemaDifference::ObjectType type) {
+    switch (type) {
+        case SchemaDifference::Table:
+            return "Table";
+        case SchemaDifference::View:
+            return "View";
+        case SchemaDifference::Sequence:
+            return "Sequence";
+        case SchemaDifference::Column:
+            return "Column";
+        case SchemaDifference::Index:
+            return "Index";
+        case SchemaDifference::ForeignKey:
+            return "Foreign key";
+    }
+    return QString();
+}
+
+QFuture<SchemaDiff> SchemaDiffer::start(const SchemaDiffOptions &options) {
+    // Shared so that removing a connection meanwhile doesn't pull it from under the read
+    std::shared_ptr<DatabaseConnection> source =
+        ConnectionManager::instance().getSharedConnection(options.sourceConnection);
+    std::shared_ptr<DatabaseConnection> target =
+        ConnectionManager::instance().getSharedConnection(options.targetConnection);
+    if (!source || !target) {
+        return QtConcurrent::run([]() { return failure("Connection not found"); });
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    // Each connection reads its catalog on its own metadata thread, so the two reads
+    // overlap; the same connection twice shares one read
+    const QFuture<QList<CatalogSnapshot>> sourceCatalog = source->fetchCatalog();
+    const QFuture<QList<CatalogSnapshot>> targetCatalog = target->fetchCatalog();
+
+    return QtConcurrent::run([options, source, target, sourceCatalog, targetCatalog, timer]() {
+        auto findSchema = [](const QList<CatalogSnapshot> &snapshots, const QString &schema) {
+            return std::find_if(snapshots.cbegin(), snapshots.cend(),
+                                [&schema](const CatalogSnapshot &snapshot) { return snapshot.schema == schema; });
+        };
+
+        const QList<CatalogSnapshot> sourceSnapshots = sourceCatalog.result();
+        const QList<CatalogSnapshot> targetSnapshots = targetCatalog.result();
+        const auto sourceSnapshot = findSchema(sourceSnapshots, options.sourceSchema);
+        const auto targetSnapshot = findSchema(targetSnapshots, options.targetSchema);
+        if (sourceSnapshots.isEmpty() || targetSnapshots.isEmpty()) {
+            return failure(QString("The catalog of %1 couldn't be read")
+                .arg(sourceSnapshots.isEmpty() ? options.sourceConnection : options.targetConnection));
+        }
+        if (sourceSnapshot == sourceSnapshots.cend()) {
+            return failure(QString("%1 has no schema %2").arg(options.sourceConnection, options.sourceSchema));
+        }
+        if (targetSnapshot == targetSnapshots.cend()) {
+            return failure(QString("%1 has no schema %2").arg(options.targetConnection, options.targetSchema));
+        }
+
+        SchemaDiff diff = compare(*sourceSnapshot, *targetSnapshot, target->getType());
+        diff.elapsedMs = timer.elapsed();
+        return diff;
+    });
+}
+
+SchemaDiff SchemaDiffer::compare(const CatalogSnapshot &source, const CatalogSnapshot &target,
+                                 DatabaseType targetType) {
+    SchemaDiff diff;
+    diff.success = true;
+    diff.objectsCompared = source.relations.size() + source.columns.size() + source.indexes.size()
+        + source.foreignKeys.size() + target.relations.size() + target.columns.size()
+        + target.indexes.size() + target.foreignKeys.size();
+
+    const QHash<QString, Shape> sourceShapes = shapesOf(source);
+    const QHash<QString, Shape> targetShapes = shapesOf(target);
+    MigrationWriter writer(targetType, source, target);
+
+    QStringList names = sourceShapes.keys();
+    for (auto it = targetShapes.cbegin(); it != targetShapes.cend(); ++it) {
+        if (!sourceShapes.contains(it.key())) {
+            names << it.key();
+        }
+    }
+    sortNames(&names);
+
+    auto differ = [&diff](SchemaDifference::Kind kind, SchemaDifference::ObjectType type, const QString &table,
+                          const QString &name, const QString &sourceDefinition, const QString &targetDefinition) {
+        diff.differences << SchemaDifference{kind, type, table, name, sourceDefinition, targetDefinition};
+    };
+
+    for (const QString &name : std::as_const(names)) {
+        const auto sourceShape = sourceShapes.constFind(name);
+        const auto targetShape = targetShapes.constFind(name);
+        if (targetShape == targetShapes.cend()) {
+            differ(SchemaDifference::Added, relationType(sourceShape->relation->kind), name, QString(),
+                   relationDefinition(*sourceShape), QString());
+            writer.createRelation(name, *sourceShape);
+            continue;
+        }
+        if (sourceShape == sourceShapes.cend()) {
+            differ(SchemaDifference::Removed, relationType(targetShape->relation->kind), name, QString(),
+                   QString(), relationDefinition(*targetShape));
+            writer.dropRelation(name, *targetShape);
+            continue;
+        }
+
+        ++diff.tablesCompared;
+        if (sourceShape->hash == targetShape->hash) {
+            continue;
+        }
+        ++diff.tablesChanged;
+        if (sourceShape->relation->kind != targetShape->relation->kind) {
+            differ(SchemaDifference::Changed, relationType(sourceShape->relation->kind), name, QString(),
+                   relationDefinition(*sourceShape), relationDefinition(*targetShape));
+            writer.dropRelation(name, *targetShape);
+            writer.createRelation(name, *sourceShape);
+            continue;
+        }
+
+        for (const QString &key : unitedKeys(sourceShape->columnsByKey, targetShape->columnsByKey)) {
+            const Member *wanted = memberAt(sourceShape->columnsByKey, key);
+            const Member *current = memberAt(targetShape->columnsByKey, key);
+            if (wanted && current && wanted->definition == current->definition) {
+                continue;
+            }
+            differ(differenceKind(wanted, current), SchemaDifference::Column, name, key,
+                   wanted ? wanted->definition : QString(), current ? current->definition : QString());
+            if (!current) {
+                writer.addColumn(source.columns.at(wanted->index));
+            } else if (!wanted) {
+                writer.dropColumn(target.columns.at(current->index));
+            } else {
+                writer.alterColumn(source.columns.at(wanted->index), target.columns.at(current->index));
+            }
+        }
+
+        // Changed indexes and keys are dropped and created again
+        for (const QString &key : unitedKeys(sourceShape->indexesByKey, targetShape->indexesByKey)) {
+            const Member *wanted = memberAt(sourceShape->indexesByKey, key);
+            const Member *current = memberAt(targetShape->indexesByKey, key);
+            if (wanted && current && wanted->definition == current->definition) {
+                continue;
+            }
+            differ(differenceKind(wanted, current), SchemaDifference::Index, name, (wanted ? wanted : current)->name,
+                   wanted ? wanted->definition : QString(), current ? current->definition : QString());
+            if (current) {
+                writer.dropIndex(target.indexes.at(current->index));
+            }
+            if (wanted) {
+                writer.createIndex(*sourceShape, source.indexes.at(wanted->index));
+            }
+        }
+
+        for (const QString &key : unitedKeys(sourceShape->foreignKeysByKey, targetShape->foreignKeysByKey)) {
+            const Member *wanted = memberAt(sourceShape->foreignKeysByKey, key);
+            const Member *current = memberAt(targetShape->foreignKeysByKey, key);
+            if (wanted && current && wanted->definition == current->definition) {
+                continue;
+            }
+            differ(differenceKind(wanted, current), SchemaDifference::ForeignKey, name,
+                   (wanted ? wanted : current)->name,
+                   wanted ? wanted->definition : QString(), current ? current->definition : QString());
+            if (current) {
+                writer.dropForeignKey(target.foreignKeys.at(current->index));
+            }
+            if (wanted) {
+                writer.addForeignKey(source.foreignKeys.at(wanted->index));
+            }
+        }
+    }
+
+    diff.migration = writer.script();
+    return diff;
+}
@@ -0,0 +1,892 @@
+#include "core/schema_dumper.h"
+#include "core/bounded_queue.h"
+#include "core/result_serializer.h"
+#include "core/sql_dialect.h"
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMutex>
+#include <QRegularExpression>
+#include <QSemaphore>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QSqlRecord>
+#include <QThread>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace {
+QueryResult failure(const QString &message, qint64 elapsedMs = 0) {
+    QueryResult result;
+    result.success = false;
+    result.errorMessage = message;
+    result.rowCount = 0;
+    result.executionTimeMs = elapsedMs;
+    return result;
+}
+
+struct DumpTable {
+    QString schema;
+    QString name;
+};
+
+// DDL of one table. Indexes are created after the data is loaded, foreign keys once
+// every table exists.
+struct TableDdl {
+    QString create;
+    QStringList indexes;
+    QStringList postData;
+    bool hasData = true;    // false for partitioned tables, whose rows are their partitions'
+};
+
+// Receives finished statements; false stops the table
+using Emit = std::function<bool(const QString &)>;
+
+QString qualified(DatabaseType type, const DumpTable &table) {
+    return SqlDialect::qualifiedName(type, table.name, table.schema);
+}
+
+QString regclass(DatabaseType type, const DumpTable &table) {
+    return SqlDialect::literal(type, qualified(type, table)) + "::regclass";
+}
+
+bool exec(QSqlQuery &query, const QString &sql, QString *errorMessage) {
+    if (query.exec(sql)) {
+        return true;
+    }
+    if (errorMessage) {
+        *errorMessage = query.lastError().text();
+    }
+    return false;
+}
+
+QString fileHeader(DatabaseType type, const QString &database) {
+    QString header = QString("-- Dump of %1 taken %2\n\n")
+                         .arg(database, QDateTime::currentDateTime().toString(Qt::ISODate));
+    switch (type) {
+        case DatabaseType::MySQL:
+            header += "SET NAMES utf8mb4;\nSET FOREIGN_KEY_CHECKS = 0;\nSET UNIQUE_CHECKS = 0;\n";
+            break;
+        case DatabaseType::PostgreSQL:
+            header += "SET client_encoding = 'UTF8';\nSET standard_conforming_strings = on;\n";
+            break;
+        case DatabaseType::SQLite:
+            header += "PRAGMA foreign_keys = OFF;\n";
+            break;
+    }
+    return header;
+}
+
+bool listTables(QSqlDatabase db, DatabaseType type, const QString &schema, QList<DumpTable> *tables,
+                QString *errorMessage) {
+    QString sql;
+    switch (type) {
+        case DatabaseType::SQLite:
+            sql = "SELECT name FROM sqlite_master WHERE type = 'table' AND name NOT LIKE 'sqlite_%' ORDER BY name";
+            break;
+        case DatabaseType::MySQL:
+            sql = QString("SELECT TABLE_NAME FROM information_schema.TABLES WHERE TABLE_SCHEMA = %1 "
+                          "AND TABLE_TYPE = 'BASE TABLE' ORDER BY TABLE_NAME")
+                      .arg(SqlDialect::literal(type, schema));
+            break;
+        case DatabaseType::PostgreSQL:
+            // Partitions are dumped as tables of their own and attached in the post-data
+            sql = QString("SELECT c.relname FROM pg_class c JOIN pg_namespace n ON n.oid = c.relnamespace "
+                          "WHERE n.nspname = %1 AND c.relkind IN ('r', 'p') ORDER BY c.relname")
+                      .arg(SqlDialect::literal(type, schema));
+            break;
+    }
+
+    QSqlQuery query(db);
+    if (!exec(query, sql, errorMessage)) {
+        return false;
+    }
+    while (query.next()) {
+        tables->append({schema, query.value(0).toString()});
+    }
+    return true;
+}
+
+// Extensions installed in the schema, then its enum, composite and range types and
+// its domains in creation order, so later ones can build on earlier ones
+bool postgresTypes(QSqlQuery &query, const QString &schema, QString *out, QString *errorMessage) {
+    const DatabaseType type = DatabaseType::PostgreSQL;
+    if (!exec(query, QString("SELECT e.extname FROM pg_extension e JOIN pg_namespace n ON n.oid = e.extnamespace "
+                             "WHERE n.nspname = %1 ORDER BY e.oid")
+                         .arg(SqlDialect::literal(type, schema)), errorMessage)) {
+        return false;
+    }
+    while (query.next()) {
+        *out += QString("CREATE EXTENSION IF NOT EXISTS %1 WITH SCHEMA %2;\n")
+                    .arg(SqlDialect::quoteIdentifier(type, query.value(0).toString()),
+                         SqlDialect::quoteIdentifier(type, schema));
+    }
+
+    // Types an extension created come with it; row types of tables come with the tables
+    if (!exec(query, QString("SELECT t.typname, t.typtype, CASE t.typtype "
+                             "WHEN 'e' THEN (SELECT string_agg(quote_literal(e.enumlabel), ', ' "
+                             "ORDER BY e.enumsortorder) FROM pg_enum e WHERE e.enumtypid = t.oid) "
+                             "WHEN 'c' THEN (SELECT string_agg(quote_ident(a.attname) || ' ' "
+                             "|| format_type(a.atttypid, a.atttypmod), ', ' ORDER BY a.attnum) FROM pg_attribute a "
+                             "WHERE a.attrelid = t.typrelid AND a.attnum > 0 AND NOT a.attisdropped) "
+                             "WHEN 'r' THEN (SELECT 'SUBTYPE = ' || format_type(r.rngsubtype, NULL) "
+                             "FROM pg_range r WHERE r.rngtypid = t.oid) "
+                             "ELSE format_type(t.typbasetype, t.typtypmod) "
+                             "|| COALESCE(' DEFAULT ' || t.typdefault, '') "
+                             "|| CASE WHEN t.typnotnull THEN ' NOT NULL' ELSE '' END "
+                             "|| COALESCE((SELECT string_agg(' CONSTRAINT ' || quote_ident(c.conname) || ' ' "
+                             "|| pg_get_constraintdef(c.oid, true), '' ORDER BY c.conname) "
+                             "FROM pg_constraint c WHERE c.contypid = t.oid), '') END "
+                             "FROM pg_type t JOIN pg_namespace n ON n.oid = t.typnamespace "
+                             "WHERE n.nspname = %1 AND t.typtype IN ('e', 'c', 'r', 'd') "
+                             "AND (t.typtype <> 'c' OR (SELECT c.relkind FROM pg_class c WHERE c.oid = t.typrelid) = 'c') "
+                             "AND NOT EXISTS (SELECT 1 FROM pg_depend d WHERE d.classid = 'pg_type'::regclass "
+                             "AND d.objid = t.oid AND d.deptype = 'e') "
+                             "ORDER BY t.oid")
+                         .arg(SqlDialect::literal(type, schema)), errorMessage)) {
+        return false;
+    }
+    while (query.next()) {
+        const QString name = SqlDialect::qualifiedName(type, query.value(0).toString(), schema);
+        const QString kind = query.value(1).toString();
+        const QString definition = query.value(2).toString();
+        if (kind == "e") {
+            *out += QString("CREATE TYPE %1 AS ENUM (%2);\n").arg(name, definition);
+        } else if (kind == "c") {
+            *out += QString("CREATE TYPE %1 AS (%2);\n").arg(name, definition);
+        } else if (kind == "r") {
+            *out += QString("CREATE TYPE %1 AS RANGE (%2);\n").arg(name, definition);
+        } else {
+            *out += QString("CREATE DOMAIN %1 AS %2;\n").arg(name, definition);
+        }
+    }
+    return true;
+}
+
+// CREATE SCHEMA / DATABASE, PostgreSQL extensions, types and domains, and standalone
+// sequences, before any table
+bool preData(QSqlDatabase db, DatabaseType type, const QString &schema, QString *out, QString *errorMessage) {
+    if (type == DatabaseType::MySQL) {
+        *out += QString("\nCREATE DATABASE IF NOT EXISTS %1;\n").arg(SqlDialect::quoteIdentifier(type, schema));
+        return true;
+    }
+    if (type != DatabaseType::PostgreSQL) {
+        return true;
+    }
+
+    *out += QString("\nCREATE SCHEMA IF NOT EXISTS %1;\n").arg(SqlDialect::quoteIdentifier(type, schema));
+
+    QSqlQuery query(db);
+    if (!postgresTypes(query, schema, out, errorMessage)) {
+        return false;
+    }
+
+    // Identity sequences come back with their columns
+    if (!exec(query, QString("SELECT c.relname, s.seqtypid::regtype, s.seqincrement, s.seqmin, s.seqmax, "
+                             "s.seqstart, s.seqcache, s.seqcycle "
+                             "FROM pg_class c JOIN pg_namespace n ON n.oid = c.relnamespace "
+                             "JOIN pg_sequence s ON s.seqrelid = c.oid "
+                             "WHERE n.nspname = %1 AND c.relkind = 'S' AND NOT EXISTS "
+                             "(SELECT 1 FROM pg_depend d WHERE d.objid = c.oid AND d.deptype = 'i') "
+                             "ORDER BY c.relname")
+                         .arg(SqlDialect::literal(type, schema)), errorMessage)) {
+        return false;
+    }
+    while (query.next()) {
+        *out += QString("CREATE SEQUENCE IF NOT EXISTS %1 AS %2 INCREMENT BY %3 MINVALUE %4 MAXVALUE %5 "
+                        "START WITH %6 CACHE %7%8;\n")
+                    .arg(SqlDialect::qualifiedName(type, query.value(0).toString(), schema),
+                         query.value(1).toString(), query.value(2).toString(), query.value(3).toString(),
+                         query.value(4).toString(), query.value(5).toString(), query.value(6).toString(),
+                         query.value(7).toBool() ? " CYCLE" : "");
+    }
+    return true;
+}
+
+// Sequence positions, views and (SQLite) triggers, once the data is in
+bool postData(QSqlDatabase db, DatabaseType type, const QString &schema, QString *out, QString *errorMessage) {
+    QSqlQuery query(db);
+    switch (type) {
+        case DatabaseType::SQLite:
+            if (!exec(query, "SELECT sql FROM sqlite_master WHERE type IN ('view', 'trigger') "
+                             "AND sql IS NOT NULL ORDER BY rowid", errorMessage)) {
+                return false;
+            }
+            while (query.next()) {
+                *out += query.value(0).toString() + ";\n";
+            }
+            return true;
+
+        case DatabaseType::MySQL: {
+            if (!exec(query, QString("SELECT TABLE_NAME FROM information_schema.VIEWS WHERE TABLE_SCHEMA = %1 "
+                                     "ORDER BY TABLE_NAME")
+                                 .arg(SqlDialect::literal(type, schema)), errorMessage)) {
+                return false;
+            }
+            QStringList views;
+            while (query.next()) {
+                views << query.value(0).toString();
+            }
+            for (const QString &view : views) {
+                if (!exec(query, "SHOW CREATE VIEW " + SqlDialect::qualifiedName(type, view, schema), errorMessage)) {
+                    return false;
+                }
+                if (query.next()) {
+                    *out += query.value(1).toString() + ";\n";
+                }
+            }
+            return true;
+        }
+
+        case DatabaseType::PostgreSQL: {
+            if (!exec(query, QString("SELECT c.relname FROM pg_class c JOIN pg_namespace n ON n.oid = c.relnamespace "
+                                     "WHERE n.nspname = %1 AND c.relkind = 'S' ORDER BY c.relname")
+                                 .arg(SqlDialect::literal(type, schema)), errorMessage)) {
+                return false;
+            }
+            QStringList sequences;
+            while (query.next()) {
+                sequences << SqlDialect::qualifiedName(type, query.value(0).toString(), schema);
+            }
+            for (const QString &sequence : sequences) {
+                if (!exec(query, "SELECT last_value, is_called FROM " + sequence, errorMessage)) {
+                    return false;
+                }
+                if (query.next()) {
+                    *out += QString("SELECT pg_catalog.setval(%1, %2, %3);\n")
+                                .arg(SqlDialect::literal(type, sequence), query.value(0).toString(),
+                                     query.value(1).toBool() ? "true" : "false");
+                }
+            }
+
+            // Creation order puts views after the views they select from
+            if (!exec(query, QString("SELECT c.relname, pg_get_viewdef(c.oid, true) FROM pg_class c "
+                                     "JOIN pg_namespace n ON n.oid = c.relnamespace "
+                                     "WHERE n.nspname = %1 AND c.relkind = 'v' ORDER BY c.oid")
+                                 .arg(SqlDialect::literal(type, schema)), errorMessage)) {
+                return false;
+            }
+            while (query.next()) {
+                QString definition = query.value(1).toString().trimmed();
+                if (definition.endsWith(';')) {
+                    definition.chop(1);
+                }
+                *out += QString("CREATE OR REPLACE VIEW %1 AS\n%2;\n")
+                            .arg(SqlDialect::qualifiedName(type, query.value(0).toString(), schema), definition);
+            }
+            return true;
+        }
+    }
+    return true;
+}
+
+bool postgresTableDdl(QSqlQuery &query, const DumpTable &table, TableDdl *ddl, QString *errorMessage) {
+    const DatabaseType type = DatabaseType::PostgreSQL;
+    const QString name = qualified(type, table);
+
+    if (!exec(query, QString("SELECT a.attname, format_type(a.atttypid, a.atttypmod), a.attnotnull, "
+                             "pg_get_expr(d.adbin, d.adrelid), a.attidentity, a.attgenerated "
+                             "FROM pg_attribute a LEFT JOIN pg_attrdef d "
+                             "ON d.adrelid = a.attrelid AND d.adnum = a.attnum "
+                             "WHERE a.attrelid = %1 AND a.attnum > 0 AND NOT a.attisdropped ORDER BY a.attnum")
+                         .arg(regclass(type, table)), errorMessage)) {
+        return false;
+    }
+    QStringList definitions;
+    while (query.next()) {
+        const QString column = SqlDialect::quoteIdentifier(type, query.value(0).toString());
+        QString definition = column + " " + query.value(1).toString();
+        const QString identity = query.value(4).toString();
+        if (query.value(5).toString() == "s") {
+            definition += QString(" GENERATED ALWAYS AS (%1) STORED").arg(query.value(3).toString());
+        } else if (!identity.isEmpty()) {
+            // Loaded rows carry their own ids, which ALWAYS would reject on INSERT
+            definition += " GENERATED BY DEFAULT AS IDENTITY";
+            if (identity == "a") {
+                ddl->postData << QString("ALTER TABLE %1 ALTER COLUMN %2 SET GENERATED ALWAYS;").arg(name, column);
+            }
+        } else if (!query.isNull(3)) {
+            definition += " DEFAULT " + query.value(3).toString();
+        }
+        if (query.value(2).toBool()) {
+            definition += " NOT NULL";
+        }
+        definitions << definition;
+    }
+
+    // A partition's foreign keys inherited from its parent come back when it is attached
+    if (!exec(query, QString("SELECT conname, pg_get_constraintdef(oid, true), contype FROM pg_constraint "
+                             "WHERE conrelid = %1 AND contype IN ('p', 'u', 'c', 'x', 'f') "
+                             "AND NOT (contype = 'f' AND conparentid <> 0) "
+                             "ORDER BY contype, conname")
+                         .arg(regclass(type, table)), errorMessage)) {
+        return false;
+    }
+    while (query.next()) {
+        const QString constraint = QString("CONSTRAINT %1 %2")
+                                       .arg(SqlDialect::quoteIdentifier(type, query.value(0).toString()),
+                                            query.value(1).toString());
+        if (query.value(2).toString() == "f") {
+            ddl->postData << QString("ALTER TABLE %1 ADD %2;").arg(name, constraint);
+        } else {
+            definitions << constraint;
+        }
+    }
+
+    // Partitioned tables keep their key; partitions are attached once every table exists
+    if (!exec(query, QString("SELECT c.relkind, pg_get_partkeydef(c.oid), pn.nspname, p.relname, "
+                             "pg_get_expr(c.relpartbound, c.oid) FROM pg_class c "
+                             "LEFT JOIN pg_inherits i ON c.relispartition AND i.inhrelid = c.oid "
+                             "LEFT JOIN pg_class p ON p.oid = i.inhparent "
+                             "LEFT JOIN pg_namespace pn ON pn.oid = p.relnamespace WHERE c.oid = %1")
+                         .arg(regclass(type, table)), errorMessage)) {
+        return false;
+    }
+    QString partitioning;
+    if (query.next()) {
+        if (query.value(0).toString() == "p") {
+            partitioning = " PARTITION BY " + query.value(1).toString();
+            ddl->hasData = false;
+        }
+        if (!query.isNull(3)) {
+            ddl->postData << QString("ALTER TABLE %1 ATTACH PARTITION %2 %3;")
+                                 .arg(SqlDialect::qualifiedName(type, query.value(3).toString(),
+                                                                query.value(2).toString()),
+                                      name, query.value(4).toString());
+        }
+    }
+    ddl->create = QString("CREATE TABLE %1 (\n    %2\n)%3;\n").arg(name, definitions.join(",\n    "), partitioning);
+
+    // Indexes behind primary key, unique and exclusion constraints come with them
+    if (!exec(query, QString("SELECT pg_get_indexdef(i.indexrelid) FROM pg_index i WHERE i.indrelid = %1 "
+                             "AND NOT EXISTS (SELECT 1 FROM pg_constraint c WHERE c.conindid = i.indexrelid "
+                             "AND c.contype IN ('p', 'u', 'x')) ORDER BY i.indexrelid")
+                         .arg(regclass(type, table)), errorMessage)) {
+        return false;
+    }
+    while (query.next()) {
+        ddl->indexes << query.value(0).toString() + ";";
+    }
+    return true;
+}
+
+bool tableDdl(QSqlDatabase db, DatabaseType type, const DumpTable &table, TableDdl *ddl, QString *errorMessage) {
+    QSqlQuery query(db);
+    switch (type) {
+        case DatabaseType::SQLite:
+            if (!exec(query, QString("SELECT type, sql FROM sqlite_master WHERE tbl_name = %1 "
+                                     "AND type IN ('table', 'index') AND sql IS NOT NULL ORDER BY rowid")
+                                 .arg(SqlDialect::literal(type, table.name)), errorMessage)) {
+                return false;
+            }
+            while (query.next()) {
+                if (query.value(0).toString() == "table") {
+                    ddl->create = query.value(1).toString() + ";\n";
+                } else {
+                    ddl->indexes << query.value(1).toString() + ";";
+                }
+            }
+            return true;
+
+        case DatabaseType::MySQL: {
+            if (!exec(query, "SHOW CREATE TABLE " + qualified(type, table), errorMessage)) {
+                return false;
+            }
+            if (!query.next()) {
+                return true;
+            }
+            // SHOW CREATE TABLE names the table bare; the dump may hold several databases
+            QString create = query.value(1).toString();
+            const QString bare = "CREATE TABLE " + SqlDialect::quoteIdentifier(type, table.name);
+            if (create.startsWith(bare)) {
+                create.replace(0, bare.size(), "CREATE TABLE " + qualified(type, table));
+            }
+            ddl->create = create + ";\n";
+            return true;
+        }
+
+        case DatabaseType::PostgreSQL:
+            return postgresTableDdl(query, table, ddl, errorMessage);
+    }
+    return true;
+}
+
+struct DataColumns {
+    QStringList names;
+    QStringList selectList;  // names as read: exact text where the driver would round
+    QString pageKey;         // MySQL: single-column primary key to page through
+};
+
+// Columns an INSERT can set; generated ones are computed again on load.
+// PostgreSQL columns are read as their own text output, which restores exactly
+// (QPSQL hands numeric over as a double and cuts timestamps to milliseconds); MySQL
+// temporal columns are read as text for the same reason, and DECIMAL stays exact
+// under QSql::HighPrecision.
+bool dataColumns(QSqlDatabase db, DatabaseType type, const DumpTable &table, DataColumns *columns,
+                 QString *errorMessage) {
+    QString sql;
+    switch (type) {
+        case DatabaseType::SQLite:
+            sql = QString("SELECT name, '', 0 FROM pragma_table_xinfo(%1) WHERE hidden = 0 ORDER BY cid")
+                      .arg(SqlDialect::literal(type, table.name));
+            break;
+        case DatabaseType::MySQL:
+            sql = QString("SELECT COLUMN_NAME, DATA_TYPE, COLUMN_KEY = 'PRI' FROM information_schema.COLUMNS "
+                          "WHERE TABLE_SCHEMA = %1 AND TABLE_NAME = %2 "
+                          "AND EXTRA NOT IN ('VIRTUAL GENERATED', 'STORED GENERATED') "
+                          "ORDER BY ORDINAL_POSITION")
+                      .arg(SqlDialect::literal(type, table.schema), SqlDialect::literal(type, table.name));
+            break;
+        case DatabaseType::PostgreSQL:
+            sql = QString("SELECT attname, '', false FROM pg_attribute WHERE attrelid = %1 AND attnum > 0 "
+                          "AND NOT attisdropped AND attgenerated = '' ORDER BY attnum")
+                      .arg(regclass(type, table));
+            break;
+    }
+
+    QSqlQuery query(db);
+    if (!exec(query, sql, errorMessage)) {
+        return false;
+    }
+    QStringList keys;
+    while (query.next()) {
+        const QString name = query.value(0).toString();
+        const QString quoted = SqlDialect::quoteIdentifier(type, name);
+        const QString dataType = query.value(1).toString().toLower();
+        columns->names << name;
+        if (type == DatabaseType::PostgreSQL) {
+            columns->selectList << QString("%1::text AS %1").arg(quoted);
+        } else if (dataType == "datetime" || dataType == "timestamp" || dataType == "time") {
+            columns->selectList << QString("CAST(%1 AS CHAR) AS %1").arg(quoted);
+        } else {
+            columns->selectList << quoted;
+        }
+        if (query.value(2).toBool()) {
+            keys << name;
+        }
+    }
+    if (keys.size() == 1) {
+        columns->pageKey = keys.first();
+    }
+    return true;
+}
+
+// One value in PostgreSQL's COPY text format. Values arrive as the server's own
+// text output (see dataColumns), so only NULL and the separators need care.
+QString copyText(const QVariant &value) {
+    if (!value.isValid() || value.isNull()) {
+        return "\\N";
+    }
+
+    const QString text = value.toString();
+    QString escaped;
+    escaped.reserve(text.size());
+    for (const QChar c : text) {
+        switch (c.unicode()) {
+            case '\\': escaped += "\\\\"; break;
+            case '\t': escaped += "\\t"; break;
+            case '\n': escaped += "\\n"; break;
+            case '\r': escaped += "\\r"; break;
+            default: escaped += c; break;
+        }
+    }
+    return escaped;
+}
+
+void appendCopyBlock(QString &out, const QString &target, const QList<QSqlRecord> &records) {
+    out += QString("COPY %1 FROM stdin;\n").arg(target);
+    for (const QSqlRecord &record : records) {
+        for (int i = 0; i < record.count(); ++i) {
+            if (i > 0) {
+                out += '\t';
+            }
+            out += copyText(record.value(i));
+        }
+        out += '\n';
+    }
+    out += "\\.\n";
+}
+
+bool dumpTable(QSqlDatabase db, DatabaseType type, const DumpTable &table, const DumpOptions &options,
+               const Emit &emit, QStringList *postDataOut, const TransferProgressPtr &progress,
+               const CancelTokenPtr &token, QString *errorMessage) {
+    TableDdl ddl;
+    if (!tableDdl(db, type, table, &ddl, errorMessage)) {
+        return false;
+    }
+    if (!emit(QString("\n-- Table: %1\n\n%2").arg(qualified(type, table), ddl.create))) {
+        return false;
+    }
+
+    if (options.includeData && ddl.hasData) {
+        DataColumns columns;
+        if (!dataColumns(db, type, table, &columns, errorMessage)) {
+            return false;
+        }
+        QStringList quoted;
+        for (const QString &column : columns.names) {
+            quoted << SqlDialect::quoteIdentifier(type, column);
+        }
+
+        const bool useCopy = options.useCopy && type == DatabaseType::PostgreSQL;
+        const QString copyTarget = QString("%1 (%2)").arg(qualified(type, table), quoted.join(", "));
+        const ResultSerializer serializer(ResultFormat::SqlInsert, columns.names,
+                                          table.schema.isEmpty() ? table.name : table.schema + "." + table.name,
+                                          type, qMax(1, options.rowsPerInsert));
+
+        // Every batch is complete statements, so batches of different tables can
+        // interleave in a single file
+        QList<QSqlRecord> batch;
+        batch.reserve(SchemaDumper::kBatchRows);
+        auto flush = [&]() {
+            QString text;
+            if (useCopy) {
+                appendCopyBlock(text, copyTarget, batch);
+            } else {
+                serializer.appendRecords(text, batch);
+            }
+            progress->rows += batch.size();
+            progress->bytes += text.size();
+            batch.clear();
+            return emit(text);
+        };
+
+        QVariant lastKey;
+        auto read = [&](const QString &sql, int *rows) {
+            QSqlQuery query(db);
+            query.setForwardOnly(true);
+            query.setNumericalPrecisionPolicy(QSql::HighPrecision);
+            if (!exec(query, sql, errorMessage)) {
+                return false;
+            }
+            const int key = columns.pageKey.isEmpty() ? -1 : query.record().indexOf(columns.pageKey);
+            while (query.next()) {
+                if (token->isCancelled()) {
+                    return false;
+                }
+                batch.append(query.record());
+                ++*rows;
+                if (key >= 0) {
+                    lastKey = query.value(key);
+                }
+                if (batch.size() == SchemaDumper::kBatchRows && !flush()) {
+                    return false;
+                }
+            }
+            if (query.lastError().isValid()) {
+                if (errorMessage) {
+                    *errorMessage = query.lastError().text();
+                }
+                return false;
+            }
+            return true;
+        };
+
+        const QString select = QString("SELECT %1 FROM %2").arg(columns.selectList.join(", "), qualified(type, table));
+        int rows = 0;
+        if (columns.pageKey.isEmpty()) {
+            if (!read(select, &rows)) {
+                return false;
+            }
+        } else {
+            // QMYSQL buffers a whole result on the client, so a keyed MySQL table is read
+            // in pages after the last key seen. The pages stay on this session and in its
+            // snapshot, which a ChunkedScan with sessions of its own would not.
+            const QString key = qualified(type, table) + "." + SqlDialect::quoteIdentifier(type, columns.pageKey);
+            do {
+                QString sql = select;
+                if (rows > 0) {
+                    sql += QString(" WHERE %1 > %2").arg(key, SqlDialect::literal(type, lastKey));
+                }
+                sql += QString(" ORDER BY %1 LIMIT %2").arg(key).arg(SchemaDumper::kPageRows);
+                rows = 0;
+                if (!read(sql, &rows)) {
+                    return false;
+                }
+            } while (rows == SchemaDumper::kPageRows);
+        }
+        if (!batch.isEmpty() && !flush()) {
+            return false;
+        }
+    }
+
+    if (!ddl.indexes.isEmpty() && !emit("\n" + ddl.indexes.join("\n") + "\n")) {
+        return false;
+    }
+    *postDataOut << ddl.postData;
+    return true;
+}
+
+QString fileName(const DumpTable &table) {
+    QString name = table.schema.isEmpty() ? table.name : table.schema + "." + table.name;
+    return name.replace(QRegularExpression("[/\\\\:*?\"<>|]"), "_");
+}
+
+bool writeWholeFile(const QString &filePath, Compression compression, const QString &text, QString *errorMessage) {
+    CompressedFileWriter writer;
+    return writer.open(filePath, compression, errorMessage)
+        && writer.write(text.toUtf8(), errorMessage)
+        && writer.close(errorMessage);
+}
+} // namespace
+
+QString SchemaDumper::compressionSuffix(Compression compression) {
+    switch (compression) {
+        case Compression::Gzip:
+            return ".gz";
+        case Compression::Zstd:
+            return ".zst";
+        case Compression::None:
+            break;
+    }
+    return QString();
+}
+
+QFuture<QueryResult> SchemaDumper::start(const ConnectionInfo &connInfo, DatabaseType type,
+                                         const DumpOptions &options, const TransferProgressPtr &progress,
+                                         const CancelTokenPtr &token) {
+    return QtConcurrent::run([connInfo, type, options, progress, token]() {
+        return run(connInfo, type, options, progress, token);
+    });
+}
+
+QueryResult SchemaDumper::run(const ConnectionInfo &connInfo, DatabaseType type, const DumpOptions &options,
+                              const TransferProgressPtr &progress, const CancelTokenPtr &token) {
+    QElapsedTimer timer;
+    timer.start();
+
+    const QStringList schemas = type == DatabaseType::SQLite ? QStringList{QString()} : options.schemas;
+    if (schemas.isEmpty()) {
+        return failure("Nothing to dump");
+    }
+    if (!CompressedFileWriter::isAvailable(options.compression)) {
+        return failure("This build cannot write compressed files of that kind");
+    }
+    if (options.filePerTable && !QDir().mkpath(options.outputPath)) {
+        return failure(QString("Cannot create directory %1").arg(options.outputPath));
+    }
+
+    QString error;
+    QSqlDatabase db = QueryExecutor::threadDatabase(connInfo, &error);
+    if (!db.isValid() || !db.isOpen()) {
+        return failure(error);
+    }
+    QSqlQuery control(db);
+
+    // The coordinator's transaction owns the exported snapshot and stays open until
+    // every worker has read its tables
+    QString snapshotId;
+    bool globalLock = false;
+    if (type == DatabaseType::PostgreSQL) {
+        if (!exec(control, "BEGIN ISOLATION LEVEL REPEATABLE READ READ ONLY", &error)
+            || !exec(control, "SELECT pg_export_snapshot()", &error) || !control.next()) {
+            return failure("Cannot take a snapshot: " + error);
+        }
+        snapshotId = control.value(0).toString();
+    } else if (type == DatabaseType::MySQL) {
+        // Needs RELOAD; without it each worker reads its own snapshot
+        globalLock = control.exec("FLUSH TABLES WITH READ LOCK");
+    }
+    auto endSnapshot = [&]() {
+        if (type == DatabaseType::PostgreSQL) {
+            control.exec("ROLLBACK");
+        } else if (globalLock) {
+            control.exec("UNLOCK TABLES");
+            globalLock = false;
+        }
+    };
+
+    QList<DumpTable> tables;
+    QString header = fileHeader(type, connInfo.databaseName.isEmpty() ? connInfo.name : connInfo.databaseName);
+    if (type == DatabaseType::MySQL && !globalLock) {
+        header += "-- Tables were read in separate snapshots (no FLUSH TABLES WITH READ LOCK privilege)\n";
+    }
+    QString pre = header;
+    for (const QString &schema : schemas) {
+        if (!listTables(db, type, schema, &tables, &error) || !preData(db, type, schema, &pre, &error)) {
+            endSnapshot();
+            return failure(error, timer.elapsed());
+        }
+    }
+
+    QMutex mutex;
+    QString dumpError;
+    QStringList postStatements;
+    QStringList writtenFiles;
+    std::atomic<bool> stop{false};
+    auto fail = [&](const QString &message) {
+        QMutexLocker locker(&mutex);
+        if (dumpError.isEmpty()) {
+            dumpError = message;
+        }
+        stop = true;
+    };
+
+    // A single file is written by its own thread from a queue of finished statements
+    const QString suffix = compressionSuffix(options.compression);
+    const QString singlePath = options.filePerTable || options.outputPath.endsWith(suffix)
+        ? options.outputPath : options.outputPath + suffix;
+    BoundedQueue<QByteArray> chunks(kQueueChunks);
+    std::unique_ptr<QThread> writerThread;
+    if (options.filePerTable) {
+        const QString path = QDir(options.outputPath).filePath("_pre_data.sql" + suffix);
+        writtenFiles << path;
+        if (!writeWholeFile(path, options.compression, pre, &error)) {
+            endSnapshot();
+            QFile::remove(path);
+            return failure(error, timer.elapsed());
+        }
+    } else {
+        writtenFiles << singlePath;
+        writerThread.reset(QThread::create([&]() {
+            CompressedFileWriter writer;
+            QString writeError;
+            if (!writer.open(singlePath, options.compression, &writeError)) {
+                fail(writeError);
+                chunks.close();
+                return;
+            }
+            QByteArray chunk;
+            while (chunks.pop(chunk)) {
+                if (!writer.write(chunk, &writeError)) {
+                    fail(writeError);
+                    break;
+                }
+            }
+            chunks.close();
+            if (!writer.close(&writeError)) {
+                fail(writeError);
+            }
+        }));
+        writerThread->start();
+        chunks.push(pre.toUtf8());
+    }
+
+    // SQLite has one writer-visible snapshot per connection file; a single worker reads it
+    const int workers = type == DatabaseType::SQLite ? 1 : qBound(1, options.parallelTables, qMax(1, int(tables.size())));
+    QSemaphore ready;
+    std::atomic<int> nextTable{0};
+    std::vector<std::unique_ptr<QThread>> threads;
+    for (int w = 0; w < workers; ++w) {
+        threads.push_back(std::unique_ptr<QThread>(QThread::create([&]() {
+            QString workerError;
+            QSqlDatabase workerDb = QueryExecutor::threadDatabase(connInfo, &workerError);
+            bool started = workerDb.isValid() && workerDb.isOpen();
+            if (started) {
+                QSqlQuery begin(workerDb);
+                switch (type) {
+                    case DatabaseType::PostgreSQL:
+                        started = exec(begin, "BEGIN ISOLATION LEVEL REPEATABLE READ READ ONLY", &workerError)
+                            && exec(begin, QString("SET TRANSACTION SNAPSHOT %1")
+                                               .arg(SqlDialect::literal(type, snapshotId)), &workerError);
+                        break;
+                    case DatabaseType::MySQL:
+                        started = exec(begin, "SET SESSION TRANSACTION ISOLATION LEVEL REPEATABLE READ", &workerError)
+                            && exec(begin, "START TRANSACTION WITH CONSISTENT SNAPSHOT, READ ONLY", &workerError);
+                        break;
+                    case DatabaseType::SQLite:
+                        started = exec(begin, "BEGIN", &workerError);
+                        break;
+                }
+            }
+            ready.release();
+            if (!started) {
+                fail(workerError);
+                return;
+            }
+
+            for (int i = nextTable++; i < tables.size() && !stop && !token->isCancelled(); i = nextTable++) {
+                const DumpTable &table = tables.at(i);
+                QStringList post;
+                bool ok = false;
+                if (options.filePerTable) {
+                    const QString path = QDir(options.outputPath).filePath(fileName(table) + ".sql" + suffix);
+                    {
+                        QMutexLocker locker(&mutex);
+                        writtenFiles << path;
+                    }
+                    CompressedFileWriter writer;
+                    ok = writer.open(path, options.compression, &workerError)
+                        && writer.write(header.toUtf8(), &workerError)
+                        && dumpTable(workerDb, type, table, options, [&](const QString &text) {
+                               return writer.write(text.toUtf8(), &workerError);
+                           }, &post, progress, token, &workerError)
+                        && writer.close(&workerError);
+                } else {
+                    ok = dumpTable(workerDb, type, table, options, [&](const QString &text) {
+                        return chunks.push(text.toUtf8());
+                    }, &post, progress, token, &workerError);
+                }
+                if (!ok) {
+                    if (!token->isCancelled()) {
+                        fail(QString("%1: %2").arg(qualified(type, table), workerError));
+                    }
+                    break;
+                }
+                QMutexLocker locker(&mutex);
+                postStatements << post;
+            }
+            QSqlQuery(workerDb).exec(type == DatabaseType::SQLite ? "COMMIT" : "ROLLBACK");
+        })));
+        threads.back()->start();
+    }
+
+    // Writes can resume once every worker holds its snapshot
+    ready.acquire(workers);
+    if (type == DatabaseType::MySQL && globalLock) {
+        control.exec("UNLOCK TABLES");
+        globalLock = false;
+    }
+    for (const std::unique_ptr<QThread> &thread : threads) {
+        thread->wait();
+    }
+
+    if (dumpError.isEmpty() && !token->isCancelled()) {
+        QString post = "\n";
+        if (!postStatements.isEmpty()) {
+            post += postStatements.join("\n") + "\n";
+        }
+        for (const QString &schema : schemas) {
+            if (!postData(db, type, schema, &post, &error)) {
+                fail(error);
+                break;
+            }
+        }
+        if (dumpError.isEmpty()) {
+            if (options.filePerTable) {
+                const QString path = QDir(options.outputPath).filePath("_post_data.sql" + suffix);
+                writtenFiles << path;
+                if (!writeWholeFile(path, options.compression, header + post, &error)) {
+                    fail(error);
+                }
+            } else {
+                chunks.push(post.toUtf8());
+            }
+        }
+    }
+    endSnapshot();
+
+    chunks.close();
+    if (writerThread) {
+        writerThread->wait();
+    }
+
+    if (dumpError.isEmpty() && token->isCancelled()) {
+        dumpError = "Dump cancelled";
+    }
+    if (!dumpError.isEmpty()) {
+        for (const QString &path : writtenFiles) {
+            QFile::remove(path);
+        }
+        return failure(dumpError, timer.elapsed());
+    }
+
+    QueryResult result;
+    result.success = true;
+    result.rowCount = progress->rows;
+    result.executionTimeMs = timer.elapsed();
+    return result;
+}
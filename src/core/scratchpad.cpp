@@ -0,0 +1,202 @@
+#include "core/scratchpad.h"
+#include "core/sql_dialect.h"
+#include "database/connection_manager.h"
+#include <QSet>
+#include <QSqlError>
+#include <QSqlField>
+#include <QSqlQuery>
+
+QString Scratchpad::create(QString *errorMessage) {
+    // Only called from the GUI thread
+    static int counter = 0;
+
+    ConnectionConfig config;
+    do {
+        ++counter;
+        config.name = QString("Scratchpad %1").arg(counter);
+    } while (ConnectionManager::instance().getConnection(config.name));
+
+    config.type = DatabaseType::SQLite;
+    config.port = 0;
+    config.filePath = QString("file:scratchpad_%1?mode=memory&cache=shared").arg(counter);
+    config.scratchpad = true;
+
+    ConnectionManager::instance().addConnection(config);
+    DatabaseConnection *conn = ConnectionManager::instance().getConnection(config.name);
+    if (!conn || !conn->connect()) {
+        if (errorMessage) {
+            *errorMessage = conn ? conn->getLastError() : QString("Failed to create scratchpad");
+        }
+        ConnectionManager::instance().removeConnection(config.name);
+        return QString();
+    }
+
+    return config.name;
+}
+
+QString Scratchpad::sqliteType(QMetaType type) {
+    switch (type.id()) {
+        case QMetaType::Bool:
+        case QMetaType::Int:
+        case QMetaType::UInt:
+        case QMetaType::Long:
+        case QMetaType::ULong:
+        case QMetaType::LongLong:
+        case QMetaType::ULongLong:
+        case QMetaType::Short:
+        case QMetaType::UShort:
+            return "INTEGER";
+        case QMetaType::Double:
+        case QMetaType::Float:
+            return "REAL";
+        case QMetaType::QByteArray:
+            return "BLOB";
+        default:
+            return "TEXT";
+    }
+}
+
+bool Scratchpad::createTable(QSqlDatabase db, const QString &tableName, const QSqlRecord &layout,
+                             QStringList *columns, QString *errorMessage) {
+    // Joins commonly return duplicate column names (a.id, b.id), which a table can't hold
+    QStringList names;
+    QSet<QString> usedNames;
+    QStringList definitions;
+    for (int i = 0; i < layout.count(); ++i) {
+        const QString base = layout.fieldName(i).isEmpty() ? QString("column") : layout.fieldName(i);
+        QString candidate = base;
+        int suffix = 2;
+        while (usedNames.contains(candidate.toLower())) {
+            candidate = QString("%1_%2").arg(base).arg(suffix++);
+        }
+        usedNames.insert(candidate.toLower());
+        names << candidate;
+
+        definitions << QString("%1 %2").arg(SqlDialect::quoteIdentifier(DatabaseType::SQLite, candidate),
+                                            sqliteType(layout.field(i).metaType()));
+    }
+
+    if (definitions.isEmpty()) {
+        if (errorMessage) {
+            *errorMessage = "The result has no columns to load";
+        }
+        return false;
+    }
+
+    QSqlQuery query(db);
+    if (!query.exec(QString("CREATE TABLE %1 (%2)")
+                        .arg(SqlDialect::quoteIdentifier(DatabaseType::SQLite, tableName),
+                             definitions.join(", ")))) {
+        if (errorMessage) {
+            *errorMessage = query.lastError().text();
+        }
+        return false;
+    }
+
+    if (columns) {
+        *columns = names;
+    }
+    return true;
+}
+
+bool Scratchpad::prepareInsert(QSqlQuery &query, const QString &tableName, int columnCount,
+                               QString *errorMessage) {
+    QStringList placeholders;
+    for (int i = 0; i < columnCount; ++i) {
+        placeholders << "?";
+    }
+
+    if (!query.prepare(QString("INSERT INTO %1 VALUES (%2)")
+                           .arg(SqlDialect::quoteIdentifier(DatabaseType::SQLite, tableName),
+                                placeholders.join(", ")))) {
+        if (errorMessage) {
+            *errorMessage = query.lastError().text();
+        }
+        return false;
+    }
+    return true;
+}
+
+bool Scratchpad::insertRecords(QSqlQuery &query, const QList<QSqlRecord> &records, int columnCount,
+                               QString *errorMessage) {
+    const int rowCount = records.size();
+    for (int begin = 0; begin < rowCount; begin += kInsertBatchRows) {
+        const int end = qMin(begin + kInsertBatchRows, rowCount);
+
+        QVector<QVariantList> values(columnCount);
+        for (QVariantList &columnValues : values) {
+            columnValues.reserve(end - begin);
+        }
+        for (int row = begin; row < end; ++row) {
+            const QSqlRecord &record = records.at(row);
+            for (int column = 0; column < columnCount; ++column) {
+                values[column].append(record.value(column));
+            }
+        }
+
+        for (const QVariantList &columnValues : values) {
+            query.addBindValue(columnValues);
+        }
+        if (!query.execBatch()) {
+            if (errorMessage) {
+                *errorMessage = query.lastError().text();
+            }
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Scratchpad::loadResult(const ConnectionInfo &connInfo, const QString &tableName,
+                            const QueryResult &result, QString *errorMessage) {
+    auto fail = [errorMessage](const QString &message) {
+        if (errorMessage) {
+            *errorMessage = message;
+        }
+        return false;
+    };
+
+    if (result.columnNames.isEmpty()) {
+        return fail("The result has no columns to load");
+    }
+
+    QString error;
+    QSqlDatabase db = QueryExecutor::threadDatabase(connInfo, &error);
+    if (!db.isOpen()) {
+        return fail(error);
+    }
+
+    // Column affinity comes from the driver's field types of the first row
+    QSqlRecord layout;
+    if (!result.records.isEmpty()) {
+        layout = result.records.first();
+    } else {
+        for (const QString &name : result.columnNames) {
+            layout.append(QSqlField(name));
+        }
+    }
+
+    QStringList columns;
+    if (!createTable(db, tableName, layout, &columns, &error)) {
+        return fail(error);
+    }
+
+    if (!db.transaction()) {
+        return fail(db.lastError().text());
+    }
+
+    QSqlQuery query(db);
+    if (!prepareInsert(query, tableName, columns.size(), &error) ||
+        !insertRecords(query, result.records, columns.size(), &error)) {
+        db.rollback();
+        return fail(error);
+    }
+
+    if (!db.commit()) {
+        error = db.lastError().text();
+        db.rollback();
+        return fail(error);
+    }
+
+    return true;
+}
@@ -0,0 +1,283 @@
+#include "core/script_runner.h"
+#include "core/bulk_writer.h"
+#include "core/sql_script_splitter.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <limits>
+
+namespace {
+QueryResult failure(const QString &message, qint64 elapsedMs = 0) {
+    QueryResult result;
+    result.success = false;
+    result.errorMessage = message;
+    result.rowCount = 0;
+    result.executionTimeMs = elapsedMs;
+    return result;
+}
+
+enum class StatementKind {
+    Normal,
+    TransactionControl,  // the script's own BEGIN / COMMIT
+    NoTransaction,       // refused inside a transaction block
+    ImplicitCommit       // MySQL commits the open transaction before running it
+};
+
+// Upper-cased word starting at or after from; end receives where it stops
+QByteArray wordAt(const QByteArray &sql, qsizetype from, qsizetype *end) {
+    qsizetype start = from;
+    while (start < sql.size() && QChar::isSpace(uchar(sql.at(start)))) {
+        ++start;
+    }
+    qsizetype stop = start;
+    while (stop < sql.size() && stop - start < 16 && (QChar::isLetter(uchar(sql.at(stop))) || sql.at(stop) == '_')) {
+        ++stop;
+    }
+    *end = stop;
+    return sql.mid(start, stop - start).toUpper();
+}
+
+StatementKind classify(DatabaseType type, const QByteArray &sql) {
+    qsizetype end = 0;
+    const QByteArray first = wordAt(sql, 0, &end);
+    if (first == "BEGIN" || first == "START" || first == "COMMIT" || first == "END" || first == "ROLLBACK") {
+        return StatementKind::TransactionControl;
+    }
+    if (first == "VACUUM") {
+        return StatementKind::NoTransaction;
+    }
+    if (type == DatabaseType::MySQL) {
+        if (first == "CREATE" || first == "DROP") {
+            // Temporary tables are the exception
+            return wordAt(sql, end, &end) == "TEMPORARY" ? StatementKind::Normal : StatementKind::ImplicitCommit;
+        }
+        if (first == "ALTER" || first == "RENAME" || first == "TRUNCATE" || first == "LOCK" || first == "UNLOCK"
+            || first == "GRANT" || first == "REVOKE") {
+            return StatementKind::ImplicitCommit;
+        }
+    }
+    if (type == DatabaseType::PostgreSQL && (first == "CREATE" || first == "DROP" || first == "ALTER"
+                                             || first == "REINDEX")) {
+        const QByteArray second = wordAt(sql, end, &end);
+        if (second == "DATABASE" || second == "TABLESPACE" || (first == "ALTER" && second == "SYSTEM")) {
+            return StatementKind::NoTransaction;
+        }
+        if (first != "ALTER" && sql.left(1024).toUpper().contains("CONCURRENTLY")) {
+            return StatementKind::NoTransaction;
+        }
+    }
+    return StatementKind::Normal;
+}
+
+// For transaction control: whether the script's transaction is open after sql ran.
+// ROLLBACK TO a savepoint keeps it open.
+bool leavesTransactionOpen(const QByteArray &sql, bool wasOpen) {
+    qsizetype end = 0;
+    const QByteArray first = wordAt(sql, 0, &end);
+    if (first == "BEGIN" || first == "START") {
+        return true;
+    }
+    if (first == "ROLLBACK" && wordAt(sql, end, &end) == "TO") {
+        return wasOpen;
+    }
+    return false;
+}
+
+QString snippet(const QByteArray &sql) {
+    const QString text = QString::fromUtf8(sql.left(400)).simplified();
+    return text.size() > 200 ? text.left(200) + "..." : text;
+}
+} // namespace
+
+QFuture<QueryResult> ScriptRunner::start(const ConnectionInfo &connInfo, DatabaseType type,
+                                         const ScriptRunOptions &options, const TransferProgressPtr &progress,
+                                         const ScriptRunReportPtr &report, const CancelTokenPtr &token) {
+    return QtConcurrent::run([connInfo, type, options, progress, report, token]() {
+        return run(connInfo, type, options, progress, report, token);
+    });
+}
+
+QueryResult ScriptRunner::run(const ConnectionInfo &connInfo, DatabaseType type, const ScriptRunOptions &options,
+                              const TransferProgressPtr &progress, const ScriptRunReportPtr &report,
+                              const CancelTokenPtr &token) {
+    QElapsedTimer timer;
+    timer.start();
+
+    QFile file(options.filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return failure(QString("Could not open '%1': %2").arg(options.filePath, file.errorString()));
+    }
+    const qint64 size = file.size();
+    const char *data = nullptr;
+    if (size > 0) {
+        data = reinterpret_cast<const char *>(file.map(0, size));
+        if (!data) {
+            return failure(QString("Could not map '%1': %2").arg(options.filePath, file.errorString()));
+        }
+    }
+    progress->totalBytes = size;
+    progress->bytes = qMin(options.startOffset, size);
+    report->resumeOffset = options.startOffset;
+
+    QString error;
+    QSqlDatabase db = QueryExecutor::threadDatabase(connInfo, &error);
+    if (!db.isValid() || !db.isOpen()) {
+        return failure(error);
+    }
+    QueryExecutor::enableServerCancel(db, connInfo, token);
+
+    SqlScriptSplitter splitter(type, data, size);
+    QSqlQuery query(db);
+    const int batchSize = qMax(1, options.statementsPerTransaction);
+    bool batching = batchSize > 1;
+    bool inTransaction = false;
+    bool scriptTransaction = false;  // opened by the script's own BEGIN
+    QList<ScriptStatement> batch;
+    qint64 committedStatements = 0;
+    QString stopError;
+
+    auto execute = [&](const ScriptStatement &statement, QString *statementError) {
+        if (statement.copyIn) {
+            return BulkWriter::copyFromStdin(db, statement.sql, statement.copyData, statementError);
+        }
+        const bool ok = query.exec(QString::fromUtf8(statement.sql));
+        if (!ok) {
+            *statementError = query.lastError().text();
+        }
+        query.finish();
+        return ok;
+    };
+    auto recordError = [&](const ScriptStatement &statement, const QString &message) {
+        ++report->failedStatements;
+        if (report->errors.size() < kMaxErrors) {
+            report->errors << QString("Byte %1: %2\n%3").arg(statement.offset).arg(message, snippet(statement.sql));
+        }
+    };
+    auto commitBatch = [&](QString *commitError) {
+        if (inTransaction) {
+            inTransaction = false;
+            if (!db.commit()) {
+                *commitError = db.lastError().text();
+                return false;
+            }
+        }
+        // Statements in the script's own transaction count once it commits
+        if (!batch.isEmpty() && !scriptTransaction) {
+            report->resumeOffset = batch.last().endOffset;
+            committedStatements += batch.size();
+            batch.clear();
+        }
+        return true;
+    };
+    auto rollbackBatch = [&]() {
+        if (inTransaction) {
+            db.rollback();
+            inTransaction = false;
+        }
+        if (scriptTransaction) {
+            query.exec("ROLLBACK");
+            query.finish();
+            scriptTransaction = false;
+        }
+        batch.clear();
+    };
+
+    ScriptStatement statement;
+    while (!token->isCancelled() && splitter.next(&statement)) {
+        if (statement.offset < options.startOffset) {
+            progress->bytes = splitter.position();
+            continue;
+        }
+
+        const StatementKind kind = classify(type, statement.sql);
+        if (kind != StatementKind::Normal || !batching) {
+            if (!commitBatch(&stopError)) {
+                break;
+            }
+            // From here on the script decides what a transaction is
+            if (kind == StatementKind::TransactionControl) {
+                batching = false;
+            }
+        } else if (!inTransaction) {
+            if (!db.transaction()) {
+                stopError = db.lastError().text();
+                break;
+            }
+            inTransaction = true;
+        }
+
+        QString statementError;
+        const bool ok = execute(statement, &statementError);
+        batch.append(statement);
+        ++progress->rows;
+        progress->bytes = splitter.position();
+        if (kind == StatementKind::TransactionControl) {
+            // A failed COMMIT still ends the transaction; a failed BEGIN opens none
+            scriptTransaction = (ok || scriptTransaction) && leavesTransactionOpen(statement.sql, scriptTransaction);
+        } else if (kind == StatementKind::ImplicitCommit) {
+            // Committed on the server even when the statement itself failed, the
+            // script's transaction included
+            scriptTransaction = false;
+        }
+
+        if (!ok) {
+            if (token->isCancelled()) {
+                break;
+            }
+            if (options.stopOnError) {
+                recordError(statement, statementError);
+                stopError = QString("Byte %1: %2").arg(statement.offset).arg(statementError);
+                break;
+            }
+            if (inTransaction && type == DatabaseType::PostgreSQL) {
+                // The error aborted the whole transaction; redo the batch one statement
+                // at a time so only the failing ones are lost
+                db.rollback();
+                inTransaction = false;
+                const QList<ScriptStatement> replay = std::move(batch);
+                batch.clear();
+                for (const ScriptStatement &replayed : replay) {
+                    if (token->isCancelled()) {
+                        break;
+                    }
+                    QString replayError;
+                    if (!execute(replayed, &replayError)) {
+                        recordError(replayed, replayError);
+                    }
+                    report->resumeOffset = replayed.endOffset;
+                    ++committedStatements;
+                }
+            } else {
+                recordError(statement, statementError);
+            }
+        }
+
+        if (!inTransaction || batch.size() >= batchSize) {
+            if (!commitBatch(&stopError)) {
+                break;
+            }
+        }
+    }
+
+    if (stopError.isEmpty() && token->isCancelled()) {
+        stopError = "Script cancelled";
+    }
+    if (stopError.isEmpty() && scriptTransaction) {
+        stopError = "The script ended inside a transaction; it was rolled back";
+    }
+    if (stopError.isEmpty()) {
+        commitBatch(&stopError);
+    }
+    if (!stopError.isEmpty()) {
+        rollbackBatch();
+    }
+    token->clearCancelHandler();
+
+    QueryResult result;
+    result.success = stopError.isEmpty();
+    result.errorMessage = stopError;
+    result.rowCount = int(qMin<qint64>(committedStatements, std::numeric_limits<int>::max()));
+    result.executionTimeMs = timer.elapsed();
+    return result;
+}
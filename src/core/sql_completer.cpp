@@ -0,0 +1,660 @@
+#include "core/sql_completer.h"
+#include "core/sql_dialect.h"
+#include <QSet>
+#include <algorithm>
+
+namespace {
+
+bool lessCaseInsensitive(const QString &a, const QString &b) {
+    return QString::compare(a, b, Qt::CaseInsensitive) < 0;
+}
+
+// Visits the items of a list sorted with lessCaseInsensitive whose name starts with
+// prefix; they are contiguous, so this is a binary search and a walk. visit returns
+// false to stop.
+template <typename T, typename Name, typename Visit>
+void forEachWithPrefix(const QList<T> &sorted, Name name, const QString &prefix, Visit visit) {
+    auto it = std::lower_bound(sorted.cbegin(), sorted.cend(), prefix, [&name](const T &item, const QString &value) {
+        return lessCaseInsensitive(name(item), value);
+    });
+    for (; it != sorted.cend() && name(*it).startsWith(prefix, Qt::CaseInsensitive); ++it) {
+        if (!visit(*it)) {
+            return;
+        }
+    }
+}
+
+template <typename T>
+const T *findByName(const QList<T> &sorted, const QString &name) {
+    auto it = std::lower_bound(sorted.cbegin(), sorted.cend(), name, [](const T &item, const QString &value) {
+        return lessCaseInsensitive(item.name, value);
+    });
+    const T *found = nullptr;
+    for (; it != sorted.cend() && QString::compare(it->name, name, Qt::CaseInsensitive) == 0; ++it) {
+        if (it->name == name) {
+            return &*it;
+        }
+        if (!found) {
+            found = &*it;
+        }
+    }
+    return found;
+}
+
+QStringList sortedWords(QStringList words) {
+    std::sort(words.begin(), words.end(), lessCaseInsensitive);
+    return words;
+}
+
+const QStringList &keywords() {
+    static const QStringList words = sortedWords({
+        "ADD", "ALL", "ALTER", "AND", "AS", "ASC", "BETWEEN", "BY", "CASE", "CAST", "COLUMN",
+        "CONSTRAINT", "CREATE", "CROSS", "DEFAULT", "DELETE", "DESC", "DISTINCT", "DROP", "ELSE",
+        "END", "EXCEPT", "EXISTS", "EXPLAIN", "FALSE", "FOREIGN", "FROM", "FULL", "GROUP", "HAVING",
+        "IN", "INDEX", "INNER", "INSERT", "INTERSECT", "INTO", "IS", "JOIN", "KEY", "LEFT", "LIKE",
+        "LIMIT", "NOT", "NULL", "OFFSET", "ON", "OR", "ORDER", "OUTER", "PRIMARY", "REFERENCES",
+        "RETURNING", "RIGHT", "SELECT", "SET", "TABLE", "THEN", "TRUE", "TRUNCATE", "UNION", "UNIQUE",
+        "UPDATE", "USING", "VALUES", "VIEW", "WHEN", "WHERE", "WITH"
+    });
+    return words;
+}
+
+// Words that end a FROM item rather than alias it
+const QSet<QString> &reservedWords() {
+    static const QSet<QString> words = [] {
+        QSet<QString> set(keywords().cbegin(), keywords().cend());
+        set += {"NATURAL", "LATERAL", "WINDOW", "FETCH", "FOR", "ILIKE"};
+        return set;
+    }();
+    return words;
+}
+
+const QStringList &functions(DatabaseType type) {
+    static const QStringList common = {
+        "ABS", "AVG", "COALESCE", "COUNT", "CURRENT_DATE", "CURRENT_TIMESTAMP", "DENSE_RANK", "LAG",
+        "LEAD", "LENGTH", "LOWER", "MAX", "MIN", "NULLIF", "RANK", "REPLACE", "ROUND", "ROW_NUMBER",
+        "SUBSTR", "SUM", "TRIM", "UPPER"
+    };
+    static const QStringList sqlite = sortedWords(common + QStringList{
+        "DATE", "DATETIME", "GROUP_CONCAT", "IFNULL", "INSTR", "JSON_EXTRACT", "PRINTF", "RANDOM",
+        "STRFTIME", "TIME", "TYPEOF"
+    });
+    static const QStringList mysql = sortedWords(common + QStringList{
+        "CONCAT", "CONCAT_WS", "DATE_ADD", "DATE_FORMAT", "DATEDIFF", "GROUP_CONCAT", "IF", "IFNULL",
+        "JSON_EXTRACT", "JSON_OBJECT", "NOW", "STR_TO_DATE", "SUBSTRING", "UNIX_TIMESTAMP"
+    });
+    static const QStringList postgres = sortedWords(common + QStringList{
+        "AGE", "ARRAY_AGG", "CONCAT", "DATE_PART", "DATE_TRUNC", "EXTRACT", "GENERATE_SERIES",
+        "JSON_AGG", "JSONB_BUILD_OBJECT", "NOW", "STRING_AGG", "SUBSTRING", "TO_CHAR", "TO_DATE",
+        "UNNEST"
+    });
+    switch (type) {
+        case DatabaseType::MySQL:
+            return mysql;
+        case DatabaseType::PostgreSQL:
+            return postgres;
+        default:
+            return sqlite;
+    }
+}
+
+bool isIdentifierStart(QChar c) {
+    return c.isLetter() || c == '_';
+}
+
+bool isIdentifierChar(QChar c) {
+    return c.isLetterOrNumber() || c == '_' || c == '$';
+}
+
+} // namespace
+
+// Catalog
+
+std::shared_ptr<const SqlCompletionCatalog> SqlCompletionCatalog::build(DatabaseType type,
+                                                                        const QList<CatalogSnapshot> &snapshots) {
+    auto catalog = std::make_shared<SqlCompletionCatalog>();
+    catalog->type = type;
+
+    for (const CatalogSnapshot &snapshot : snapshots) {
+        Schema schema;
+        schema.name = snapshot.schema;
+
+        QHash<QString, int> byName;
+        for (const RelationInfo &relation : snapshot.relations) {
+            if (relation.kind == RelationKind::Sequence) {
+                continue;
+            }
+            byName.insert(relation.name, schema.relations.size());
+            schema.relations.append(Relation{relation.name, relation.kind, {}});
+        }
+        // Columns come grouped by table, so the lookup mostly hits the previous one
+        QString table;
+        int position = -1;
+        for (const ColumnInfo &column : snapshot.columns) {
+            if (column.table != table) {
+                table = column.table;
+                position = byName.value(table, -1);
+            }
+            if (position >= 0) {
+                schema.relations[position].columns.append(Column{column.name, column.dataType});
+            }
+        }
+
+        std::sort(schema.relations.begin(), schema.relations.end(), [](const Relation &a, const Relation &b) {
+            return lessCaseInsensitive(a.name, b.name);
+        });
+        catalog->schemas.append(schema);
+    }
+    std::sort(catalog->schemas.begin(), catalog->schemas.end(), [](const Schema &a, const Schema &b) {
+        return lessCaseInsensitive(a.name, b.name);
+    });
+    return catalog;
+}
+
+const SqlCompletionCatalog::Schema *SqlCompletionCatalog::findSchema(const QString &name) const {
+    return findByName(schemas, name);
+}
+
+const SqlCompletionCatalog::Relation *SqlCompletionCatalog::findRelation(const Schema &schema, const QString &name) {
+    return findByName(schema.relations, name);
+}
+
+// Completer
+
+void SqlCompleter::setCatalog(const SqlCompletionCatalogPtr &catalog, DatabaseType type,
+                              const QString &defaultSchema) {
+    this->catalog = catalog;
+    this->defaultSchema = defaultSchema;
+    if (this->type != type) {
+        // Quoting rules differ, so the boundaries found may not hold
+        this->type = type;
+        invalidateFrom(0);
+    }
+}
+
+void SqlCompleter::invalidateFrom(int position) {
+    // A boundary sits just past a ';', so one at position was found in unchanged text
+    while (!boundaries.isEmpty() && boundaries.last() > position) {
+        boundaries.removeLast();
+    }
+    scannedTo = std::min(scannedTo, position);
+}
+
+int SqlCompleter::wordStart(const QString &text, int cursor) {
+    int start = cursor;
+    while (start > 0 && isIdentifierChar(text.at(start - 1))) {
+        --start;
+    }
+    return start;
+}
+
+bool SqlCompleter::nextToken(const QString &text, int *pos, DatabaseType type, Token *token) {
+    const int size = text.size();
+    int i = *pos;
+    while (i < size && text.at(i).isSpace()) {
+        ++i;
+    }
+    if (i >= size) {
+        *pos = i;
+        return false;
+    }
+    auto at = [&text, size](int k) { return k < size ? text.at(k) : QChar(); };
+
+    token->start = i;
+    token->text.clear();
+    token->unterminated = false;
+    const QChar c = text.at(i);
+
+    if ((c == '-' && at(i + 1) == '-') || (c == '#' && type == DatabaseType::MySQL)) {
+        // The newline belongs to the comment, so the end of its line is still inside
+        token->kind = Token::Comment;
+        const int eol = text.indexOf('\n', i);
+        token->unterminated = eol < 0;
+        i = eol < 0 ? size : eol + 1;
+    } else if (c == '/' && at(i + 1) == '*') {
+        token->kind = Token::Comment;
+        const int close = text.indexOf(QLatin1String("*/"), i + 2);
+        token->unterminated = close < 0;
+        i = close < 0 ? size : close + 2;
+    } else if (c == '\'') {
+        token->kind = Token::String;
+        token->unterminated = true;
+        for (++i; i < size; ++i) {
+            if (text.at(i) == '\\' && type == DatabaseType::MySQL) {
+                ++i;
+            } else if (text.at(i) == '\'') {
+                if (at(i + 1) != '\'') {
+                    token->unterminated = false;
+                    ++i;
+                    break;
+                }
+                ++i;
+            }
+        }
+        i = std::min(i, size);
+    } else if (c == '"' || (c == '`' && type != DatabaseType::PostgreSQL)
+               || (c == '[' && type == DatabaseType::SQLite)) {
+        const QChar close = c == '[' ? QChar(']') : c;
+        token->kind = Token::Quoted;
+        token->unterminated = true;
+        for (++i; i < size; ++i) {
+            if (text.at(i) == close) {
+                if (close != ']' && at(i + 1) == close) {
+                    token->text += close;
+                    ++i;
+                    continue;
+                }
+                token->unterminated = false;
+                ++i;
+                break;
+            }
+            token->text += text.at(i);
+        }
+    } else if (c == '$' && type == DatabaseType::PostgreSQL && !at(i + 1).isDigit()) {
+        // $tag$ ... $tag$ body; a lone $ is left as a symbol
+        int j = i + 1;
+        while (j < size && (text.at(j).isLetterOrNumber() || text.at(j) == '_')) {
+            ++j;
+        }
+        if (at(j) == '$') {
+            const QString tag = text.mid(i, j - i + 1);
+            const int close = text.indexOf(tag, j + 1);
+            token->kind = Token::String;
+            token->unterminated = close < 0;
+            i = close < 0 ? size : close + tag.size();
+        } else {
+            token->kind = Token::Symbol;
+            token->text = c;
+            ++i;
+        }
+    } else if (isIdentifierStart(c)) {
+        token->kind = Token::Word;
+        while (i < size && isIdentifierChar(text.at(i))) {
+            ++i;
+        }
+        token->text = text.mid(token->start, i - token->start);
+    } else if (c.isDigit()) {
+        token->kind = Token::Number;
+        while (i < size && (text.at(i).isLetterOrNumber() || text.at(i) == '.')) {
+            ++i;
+        }
+    } else {
+        token->kind = Token::Symbol;
+        static const char *const pairs[] = {"<>", "!=", "<=", ">=", "||", "::"};
+        token->text = c;
+        for (const char *pair : pairs) {
+            if (c == QLatin1Char(pair[0]) && at(i + 1) == QLatin1Char(pair[1])) {
+                token->text += at(i + 1);
+                break;
+            }
+        }
+        i += token->text.size();
+    }
+
+    token->end = i;
+    *pos = i;
+    return true;
+}
+
+int SqlCompleter::statementStart(const QString &text, int cursor) {
+    if (scannedTo > text.size()) {
+        invalidateFrom(text.size());
+    }
+    if (cursor > scannedTo) {
+        // Resume from the last boundary known, where no string or comment is open
+        int pos = boundaries.isEmpty() ? 0 : boundaries.last();
+        Token token;
+        while (pos < cursor && nextToken(text, &pos, type, &token)) {
+            if (token.kind == Token::Symbol && token.text == ";") {
+                boundaries.append(token.end);
+            }
+        }
+        scannedTo = pos;
+    }
+    const auto after = std::upper_bound(boundaries.cbegin(), boundaries.cend(), cursor);
+    return after == boundaries.cbegin() ? 0 : *(after - 1);
+}
+
+QList<SqlCompleter::Token> SqlCompleter::tokenize(const QString &text, int start, int cursor) const {
+    QList<Token> tokens;
+    int pos = start;
+    Token token;
+    while (nextToken(text, &pos, type, &token)) {
+        if (token.start >= cursor
+            && ((token.kind == Token::Symbol && token.text == ";") || token.start > cursor + kMaxLookahead)) {
+            break;
+        }
+        tokens.append(token);
+    }
+    return tokens;
+}
+
+QList<SqlCompleter::TableRef> SqlCompleter::scanScopes(QList<Token> *tokens, QList<int> *groupParents,
+                                                        int cursorIndex, int *cursorGroup) const {
+    // Each parenthesis opens a group; the statement itself is group 0
+    groupParents->clear();
+    groupParents->append(-1);
+    QList<int> open = {0};
+    QStringList clauses = {QString()};
+    QList<TableRef> refs;
+    *cursorGroup = 0;
+
+    auto isName = [tokens](int i) {
+        if (i >= tokens->size()) {
+            return false;
+        }
+        const Token &token = tokens->at(i);
+        return token.kind == Token::Quoted
+            || (token.kind == Token::Word && !reservedWords().contains(token.text.toUpper()));
+    };
+    auto isDot = [tokens](int i) {
+        return i < tokens->size() && tokens->at(i).kind == Token::Symbol && tokens->at(i).text == ".";
+    };
+    // [schema.]name [[AS] alias] starting at token i
+    auto readRef = [&](int i, int group) {
+        if (!isName(i)) {
+            return;
+        }
+        TableRef ref;
+        ref.group = group;
+        ref.name = tokens->at(i).text;
+        ++i;
+        if (isDot(i) && isName(i + 1)) {
+            ref.schema = ref.name;
+            ref.name = tokens->at(i + 1).text;
+            i += 2;
+        }
+        if (i < tokens->size() && tokens->at(i).kind == Token::Word
+            && tokens->at(i).text.compare(QLatin1String("AS"), Qt::CaseInsensitive) == 0) {
+            ++i;
+        }
+        if (isName(i) && !isDot(i + 1)) {
+            ref.alias = tokens->at(i).text;
+        }
+        refs.append(ref);
+    };
+
+    static const QSet<QString> clauseWords = {
+        "SELECT", "FROM", "WHERE", "GROUP", "ORDER", "HAVING", "SET", "VALUES", "ON", "JOIN",
+        "USING", "LIMIT", "RETURNING", "INTO", "UPDATE", "UNION", "WITH"
+    };
+
+    for (int i = 0; i < tokens->size(); ++i) {
+        if (i == cursorIndex) {
+            *cursorGroup = open.last();
+        }
+        Token &token = (*tokens)[i];
+        token.group = open.last();
+        if (token.kind == Token::Symbol && token.text == "(") {
+            groupParents->append(open.last());
+            open.append(groupParents->size() - 1);
+            clauses.append(QString());
+            continue;
+        }
+        if (token.kind == Token::Symbol && token.text == ")") {
+            if (open.size() > 1) {
+                open.removeLast();
+            }
+            token.group = open.last();
+            continue;
+        }
+
+        const int group = token.group;
+        if (token.kind == Token::Word) {
+            const QString upper = token.text.toUpper();
+            if (clauseWords.contains(upper)) {
+                clauses[group] = upper;
+            }
+            if (upper == "FROM" || upper == "JOIN" || upper == "UPDATE" || upper == "INTO") {
+                readRef(i + 1, group);
+            }
+        } else if (token.kind == Token::Symbol && token.text == "," && clauses.at(group) == "FROM") {
+            readRef(i + 1, group);
+        }
+    }
+    if (cursorIndex >= tokens->size()) {
+        *cursorGroup = open.last();
+    }
+    return refs;
+}
+
+const SqlCompletionCatalog::Relation *SqlCompleter::resolve(const TableRef &ref) const {
+    const QString schemaName = ref.schema.isEmpty() ? defaultSchema : ref.schema;
+    if (const SqlCompletionCatalog::Schema *schema = catalog->findSchema(schemaName)) {
+        if (const SqlCompletionCatalog::Relation *relation = SqlCompletionCatalog::findRelation(*schema, ref.name)) {
+            return relation;
+        }
+    }
+    // An unqualified name outside the default schema, through the search path or USE
+    if (ref.schema.isEmpty()) {
+        for (const SqlCompletionCatalog::Schema &schema : catalog->schemas) {
+            if (const SqlCompletionCatalog::Relation *relation = SqlCompletionCatalog::findRelation(schema, ref.name)) {
+                return relation;
+            }
+        }
+    }
+    return nullptr;
+}
+
+QString SqlCompleter::quoted(const QString &name) const {
+    bool plain = !name.isEmpty() && isIdentifierStart(name.at(0)) && !reservedWords().contains(name.toUpper());
+    for (int i = 1; plain && i < name.size(); ++i) {
+        plain = name.at(i).isLetterOrNumber() || name.at(i) == '_';
+    }
+    // PostgreSQL folds unquoted names to lower case
+    if (plain && type == DatabaseType::PostgreSQL) {
+        plain = name == name.toLower();
+    }
+    return plain ? name : SqlDialect::quoteIdentifier(type, name);
+}
+
+QList<SqlCompletion> SqlCompleter::complete(const QString &text, int cursor, int limit) {
+    QList<SqlCompletion> completions;
+    cursor = std::clamp(cursor, 0, int(text.size()));
+    const QList<Token> all = tokenize(text, statementStart(text, cursor), cursor);
+
+    // The word being typed, if any; nothing is offered inside strings, comments and
+    // quoted names
+    QString prefix;
+    QList<Token> tokens;
+    int before = -1;  // tokens[0, before) precede the word
+    for (const Token &token : all) {
+        const bool touches = token.start < cursor && (cursor < token.end || (cursor == token.end && token.unterminated));
+        if (touches && token.kind != Token::Word) {
+            return completions;
+        }
+        if (token.kind == Token::Comment) {
+            continue;
+        }
+        if (before < 0 && token.start >= cursor) {
+            before = tokens.size();
+        }
+        if (token.kind == Token::Word && token.start < cursor && cursor <= token.end) {
+            prefix = text.mid(token.start, cursor - token.start);
+            before = tokens.size();
+        }
+        tokens.append(token);
+    }
+    if (before < 0) {
+        before = tokens.size();
+    }
+
+    QList<int> groupParents;
+    int cursorGroup = 0;
+    const QList<TableRef> refs = scanScopes(&tokens, &groupParents, before, &cursorGroup);
+
+    // "a." or "a.b." right before the word
+    QStringList qualifier;
+    int k = before;
+    while (k >= 2 && tokens.at(k - 1).kind == Token::Symbol && tokens.at(k - 1).text == "."
+           && (tokens.at(k - 2).kind == Token::Word || tokens.at(k - 2).kind == Token::Quoted)) {
+        qualifier.prepend(tokens.at(k - 2).text);
+        k -= 2;
+    }
+    const Token *previous = k > 0 ? &tokens.at(k - 1) : nullptr;
+
+    enum class Context { Keywords, Relations, Expression };
+    Context context = Context::Keywords;
+    static const QSet<QString> relationWords = {"FROM", "JOIN", "INTO", "UPDATE", "TABLE"};
+    static const QSet<QString> expressionWords = {
+        "SELECT", "WHERE", "ON", "AND", "OR", "NOT", "BY", "SET", "HAVING", "WHEN", "THEN", "ELSE",
+        "CASE", "DISTINCT", "RETURNING", "LIKE", "ILIKE", "BETWEEN", "IS"
+    };
+    if (previous && previous->kind == Token::Word) {
+        const QString upper = previous->text.toUpper();
+        if (relationWords.contains(upper)) {
+            context = Context::Relations;
+        } else if (expressionWords.contains(upper)) {
+            context = Context::Expression;
+        }
+    } else if (previous && previous->kind == Token::Symbol && previous->text == ",") {
+        // A list: of FROM items or of expressions, depending on the clause it is in
+        context = Context::Expression;
+        int depth = 0;
+        for (int i = k - 2; i >= 0; --i) {
+            const Token &token = tokens.at(i);
+            if (token.kind == Token::Symbol && token.text == ")") {
+                ++depth;
+            } else if (token.kind == Token::Symbol && token.text == "(") {
+                if (depth-- == 0) {
+                    break;
+                }
+            } else if (depth == 0 && token.kind == Token::Word) {
+                const QString upper = token.text.toUpper();
+                if (upper == "FROM") {
+                    context = Context::Relations;
+                    break;
+                }
+                if (expressionWords.contains(upper) || upper == "VALUES" || upper == "JOIN") {
+                    break;
+                }
+            }
+        }
+    } else if (previous && previous->kind == Token::Symbol && previous->text != ")" && previous->text != ";") {
+        // After "(" and operators
+        context = Context::Expression;
+    }
+
+    const bool lowerCase = !prefix.isEmpty() && prefix == prefix.toLower();
+    auto add = [&completions, limit](const QString &text, SqlCompletion::Kind kind, const QString &detail) {
+        if (completions.size() < limit) {
+            completions.append(SqlCompletion{text, kind, detail});
+        }
+        return completions.size() < limit;
+    };
+    auto addWords = [&](const QStringList &words, SqlCompletion::Kind kind, const QString &detail) {
+        forEachWithPrefix(words, [](const QString &word) -> const QString & { return word; }, prefix,
+                          [&](const QString &word) { return add(lowerCase ? word.toLower() : word, kind, detail); });
+    };
+    auto addRelations = [&](const SqlCompletionCatalog::Schema &schema) {
+        forEachWithPrefix(schema.relations,
+                          [](const SqlCompletionCatalog::Relation &relation) -> const QString & { return relation.name; },
+                          prefix, [&](const SqlCompletionCatalog::Relation &relation) {
+            const bool view = relation.kind == RelationKind::View;
+            return add(quoted(relation.name), view ? SqlCompletion::View : SqlCompletion::Table,
+                       view ? "view" : "table");
+        });
+    };
+    auto addSchemas = [&]() {
+        if (type == DatabaseType::SQLite) {
+            return;
+        }
+        forEachWithPrefix(catalog->schemas,
+                          [](const SqlCompletionCatalog::Schema &schema) -> const QString & { return schema.name; },
+                          prefix, [&](const SqlCompletionCatalog::Schema &schema) {
+            return add(quoted(schema.name), SqlCompletion::Schema,
+                       type == DatabaseType::MySQL ? "database" : "schema");
+        });
+    };
+    auto addColumns = [&](const SqlCompletionCatalog::Relation &relation, const QString &owner) {
+        for (const SqlCompletionCatalog::Column &column : relation.columns) {
+            if (column.name.startsWith(prefix, Qt::CaseInsensitive)
+                && !add(quoted(column.name), SqlCompletion::Column, QString("%1 · %2").arg(column.dataType, owner))) {
+                return;
+            }
+        }
+    };
+
+    if (!catalog) {
+        addWords(keywords(), SqlCompletion::Keyword, "keyword");
+        return completions;
+    }
+
+    // FROM items visible here: those of the cursor's group and the groups around it
+    QList<TableRef> visible;
+    for (const TableRef &ref : refs) {
+        for (int group = cursorGroup; group >= 0; group = groupParents.at(group)) {
+            if (ref.group == group) {
+                visible.append(ref);
+                break;
+            }
+        }
+    }
+
+    if (!qualifier.isEmpty()) {
+        if (qualifier.size() == 1 && context != Context::Relations) {
+            for (const TableRef &ref : std::as_const(visible)) {
+                const QString &label = ref.alias.isEmpty() ? ref.name : ref.alias;
+                if (QString::compare(label, qualifier.first(), Qt::CaseInsensitive) == 0) {
+                    if (const SqlCompletionCatalog::Relation *relation = resolve(ref)) {
+                        addColumns(*relation, relation->name);
+                    }
+                    return completions;
+                }
+            }
+        }
+        if (qualifier.size() == 2) {
+            TableRef ref;
+            ref.schema = qualifier.at(0);
+            ref.name = qualifier.at(1);
+            if (const SqlCompletionCatalog::Relation *relation = resolve(ref)) {
+                addColumns(*relation, relation->name);
+            }
+            return completions;
+        }
+        if (const SqlCompletionCatalog::Schema *schema = catalog->findSchema(qualifier.first())) {
+            addRelations(*schema);
+        } else if (context != Context::Relations) {
+            // A table that isn't in a FROM clause (yet)
+            TableRef ref;
+            ref.name = qualifier.first();
+            if (const SqlCompletionCatalog::Relation *relation = resolve(ref)) {
+                addColumns(*relation, relation->name);
+            }
+        }
+        return completions;
+    }
+
+    const SqlCompletionCatalog::Schema *schema = catalog->findSchema(defaultSchema);
+    switch (context) {
+        case Context::Relations:
+            if (schema) {
+                addRelations(*schema);
+            }
+            addSchemas();
+            break;
+        case Context::Expression:
+            for (const TableRef &ref : std::as_const(visible)) {
+                if (const SqlCompletionCatalog::Relation *relation = resolve(ref)) {
+                    addColumns(*relation, ref.alias.isEmpty() ? relation->name : ref.alias);
+                }
+            }
+            for (const TableRef &ref : std::as_const(visible)) {
+                const QString &label = ref.alias.isEmpty() ? ref.name : ref.alias;
+                if (label.startsWith(prefix, Qt::CaseInsensitive)) {
+                    add(label, SqlCompletion::Table, ref.alias.isEmpty() ? "table" : "alias of " + ref.name);
+                }
+            }
+            // Before the FROM clause is written, its candidates
+            if (visible.isEmpty() && schema && !prefix.isEmpty()) {
+                addRelations(*schema);
+            }
+            addWords(functions(type), SqlCompletion::Function, "function");
+            addWords(keywords(), SqlCompletion::Keyword, "keyword");
+            break;
+        case Context::Keywords:
+            addWords(keywords(), SqlCompletion::Keyword, "keyword");
+            break;
+    }
+    return completions;
+}
@@ -0,0 +1,192 @@
+#include "core/sql_dialect.h"
+#include <QByteArray>
+#include <QDate>
+#include <QDateTime>
+#include <QTime>
+
+namespace SqlDialect {
+    QString quoteIdentifier(DatabaseType type, const QString &identifier) {
+        if (type == DatabaseType::MySQL) {
+            QString escaped = identifier;
+            escaped.replace('`', "``");
+            return QString("`%1`").arg(escaped);
+        }
+
+        QString escaped = identifier;
+        escaped.replace('"', "\"\"");
+        return QString("\"%1\"").arg(escaped);
+    }
+
+    QString qualifiedName(DatabaseType type, const QString &name, const QString &schema) {
+        QStringList parts;
+        if (name.contains('.')) {
+            parts = name.split('.');
+        } else {
+            if (!schema.isEmpty()) {
+                parts << schema;
+            }
+            parts << name;
+        }
+
+        for (QString &part : parts) {
+            part = quoteIdentifier(type, part);
+        }
+        return parts.join('.');
+    }
+
+    QString literal(DatabaseType type, const QVariant &value) {
+        if (!value.isValid() || value.isNull()) {
+            return "NULL";
+        }
+
+        switch (value.metaType().id()) {
+            case QMetaType::Bool:
+                // SQLite before 3.23 and older MySQL have no boolean literals
+                if (type != DatabaseType::PostgreSQL) {
+                    return value.toBool() ? "1" : "0";
+                }
+                return value.toBool() ? "TRUE" : "FALSE";
+            case QMetaType::Int:
+            case QMetaType::UInt:
+            case QMetaType::Long:
+            case QMetaType::ULong:
+            case QMetaType::LongLong:
+            case QMetaType::ULongLong:
+            case QMetaType::Short:
+            case QMetaType::UShort:
+                return value.toString();
+            case QMetaType::Double:
+            case QMetaType::Float:
+                return QString::number(value.toDouble(), 'g', 17);
+            case QMetaType::QByteArray: {
+                const QByteArray hex = value.toByteArray().toHex();
+                if (type == DatabaseType::PostgreSQL) {
+                    return QString("'\\x%1'").arg(QString::fromLatin1(hex));
+                }
+                return QString("X'%1'").arg(QString::fromLatin1(hex));
+            }
+            case QMetaType::QDate:
+                return QString("'%1'").arg(value.toDate().toString(Qt::ISODate));
+            case QMetaType::QTime:
+                return QString("'%1'").arg(value.toTime().toString(Qt::ISODateWithMs));
+            case QMetaType::QDateTime:
+                return QString("'%1'").arg(
+                    value.toDateTime().toString("yyyy-MM-dd HH:mm:ss.zzz"));
+            default:
+                break;
+        }
+
+        QString text = value.toString();
+        text.replace('\'', "''");
+        if (type == DatabaseType::MySQL) {
+            // MySQL treats backslash as an escape character inside string literals
+            text.replace('\\', "\\\\");
+        }
+        return QString("'%1'").arg(text);
+    }
+
+    QString columnType(DatabaseType type, QMetaType valueType) {
+        const bool sqlite = type == DatabaseType::SQLite;
+        const bool mysql = type == DatabaseType::MySQL;
+
+        switch (valueType.id()) {
+            case QMetaType::Bool:
+                return sqlite ? "INTEGER" : "BOOLEAN";
+            case QMetaType::Int:
+            case QMetaType::UInt:
+            case QMetaType::Short:
+            case QMetaType::UShort:
+            case QMetaType::Char:
+            case QMetaType::SChar:
+            case QMetaType::UChar:
+                return "INTEGER";
+            case QMetaType::Long:
+            case QMetaType::ULong:
+            case QMetaType::LongLong:
+            case QMetaType::ULongLong:
+                return sqlite ? "INTEGER" : "BIGINT";
+            case QMetaType::Float:
+                return sqlite ? "REAL" : mysql ? "FLOAT" : "REAL";
+            case QMetaType::Double:
+                return sqlite ? "REAL" : mysql ? "DOUBLE" : "DOUBLE PRECISION";
+            case QMetaType::QDate:
+                return sqlite ? "TEXT" : "DATE";
+            case QMetaType::QTime:
+                return sqlite ? "TEXT" : mysql ? "TIME(6)" : "TIME";
+            case QMetaType::QDateTime:
+                return sqlite ? "TEXT" : mysql ? "DATETIME(6)" : "TIMESTAMP";
+            case QMetaType::QByteArray:
+                return sqlite ? "BLOB" : mysql ? "LONGBLOB" : "BYTEA";
+            default:
+                break;
+        }
+        return mysql ? "LONGTEXT" : "TEXT";
+    }
+
+    QString backendIdQuery(DatabaseType type) {
+        switch (type) {
+            case DatabaseType::PostgreSQL:
+                return "SELECT pg_backend_pid()";
+            case DatabaseType::MySQL:
+                return "SELECT CONNECTION_ID()";
+            case DatabaseType::SQLite:
+                break;
+        }
+        return QString();
+    }
+
+    QString cancelBackendQuery(DatabaseType type, qint64 backendId) {
+        switch (type) {
+            case DatabaseType::PostgreSQL:
+                return QString("SELECT pg_cancel_backend(%1)").arg(backendId);
+            case DatabaseType::MySQL:
+                return QString("KILL QUERY %1").arg(backendId);
+            case DatabaseType::SQLite:
+                break;
+        }
+        return QString();
+    }
+
+    QString estimatedRowCountQuery(DatabaseType type, const QString &table, const QString &schema) {
+        switch (type) {
+            case DatabaseType::PostgreSQL:
+                return QString("SELECT c.reltuples FROM pg_class c "
+                               "JOIN pg_namespace n ON n.oid = c.relnamespace "
+                               "WHERE c.relname = %1 AND n.nspname = %2")
+                    .arg(literal(type, table),
+                         schema.isEmpty() ? QString("current_schema()") : literal(type, schema));
+            case DatabaseType::MySQL:
+                return QString("SELECT TABLE_ROWS FROM information_schema.TABLES "
+                               "WHERE TABLE_NAME = %1 AND TABLE_SCHEMA = %2")
+                    .arg(literal(type, table),
+                         schema.isEmpty() ? QString("DATABASE()") : literal(type, schema));
+            case DatabaseType::SQLite:
+                // Prefer the whole-table row; any index row starts with the same count
+                return QString("SELECT stat FROM sqlite_stat1 WHERE tbl = %1 "
+                               "ORDER BY idx IS NULL DESC LIMIT 1")
+                    .arg(literal(type, table));
+        }
+        return QString();
+    }
+
+    QString histogramBoundsQuery(DatabaseType type, const QString &table, const QString &schema,
+                                 const QString &column) {
+        switch (type) {
+            case DatabaseType::PostgreSQL:
+                return QString("SELECT unnest(histogram_bounds::text::text[]) FROM pg_stats "
+                               "WHERE tablename = %1 AND schemaname = %2 AND attname = %3")
+                    .arg(literal(type, table),
+                         schema.isEmpty() ? QString("current_schema()") : literal(type, schema),
+                         literal(type, column));
+            case DatabaseType::MySQL:
+                return QString("SELECT HISTOGRAM FROM information_schema.COLUMN_STATISTICS "
+                               "WHERE TABLE_NAME = %1 AND SCHEMA_NAME = %2 AND COLUMN_NAME = %3")
+                    .arg(literal(type, table),
+                         schema.isEmpty() ? QString("DATABASE()") : literal(type, schema),
+                         literal(type, column));
+            case DatabaseType::SQLite:
+                break;
+        }
+        return QString();
+    }
+} // namespace SqlDialect
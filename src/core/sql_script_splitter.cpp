@@ -0,0 +1,381 @@
+#include "core/sql_script_splitter.h"
+#include <QRegularExpression>
+#include <cstring>
+
+namespace {
+bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+}
+
+bool isIdentifierChar(char c) {
+    const uchar u = uchar(c);
+    return (u >= 'a' && u <= 'z') || (u >= 'A' && u <= 'Z') || (u >= '0' && u <= '9') || u == '_' || u >= 0x80;
+}
+
+// Whether the word at p (case-insensitive) is followed by a non-identifier byte
+bool wordAt(const char *p, qint64 available, const char *word) {
+    const qint64 length = qint64(std::strlen(word));
+    if (available < length || qstrnicmp(p, word, length) != 0) {
+        return false;
+    }
+    return available == length || !isIdentifierChar(p[length]);
+}
+
+qint64 skipSpaces(const char *data, qint64 pos, qint64 end) {
+    while (pos < end && isSpace(data[pos])) {
+        ++pos;
+    }
+    return pos;
+}
+} // namespace
+
+SqlScriptSplitter::SqlScriptSplitter(DatabaseType type, const char *data, qint64 size)
+    : type(type), input(QByteArray::fromRawData(data, size)), data(data), size(size), pos(0), delimiter(";") {
+    updateSpecial();
+}
+
+void SqlScriptSplitter::updateSpecial() {
+    std::memset(special, 0, sizeof(special));
+    for (const char c : {'\'', '"', '-', '/'}) {
+        special[uchar(c)] = true;
+    }
+    switch (type) {
+        case DatabaseType::MySQL:
+            special[uchar('`')] = true;
+            special[uchar('#')] = true;
+            break;
+        case DatabaseType::PostgreSQL:
+            special[uchar('$')] = true;
+            break;
+        case DatabaseType::SQLite:
+            special[uchar('`')] = true;
+            special[uchar('[')] = true;
+            break;
+    }
+    special[uchar(delimiter.at(0))] = true;
+}
+
+bool SqlScriptSplitter::next(ScriptStatement *statement) {
+    for (;;) {
+        skipSpaceAndComments();
+        if (pos >= size) {
+            return false;
+        }
+        if (type == DatabaseType::MySQL && readDelimiterCommand()) {
+            continue;
+        }
+        // psql meta-commands (\connect, \set ...) run in the client, not the server
+        if (type == DatabaseType::PostgreSQL && data[pos] == '\\') {
+            const qint64 eol = input.indexOf('\n', pos);
+            pos = eol < 0 ? size : eol + 1;
+            continue;
+        }
+        break;
+    }
+
+    const qint64 start = pos;
+    qint64 end = size;
+    bool terminated = false;
+    while (pos < size) {
+        while (pos < size && !special[uchar(data[pos])]) {
+            ++pos;
+        }
+        if (pos >= size) {
+            break;
+        }
+        if (atDelimiter()) {
+            if (type == DatabaseType::SQLite && endsInsideTrigger(start)) {
+                pos += delimiter.size();
+                continue;
+            }
+            end = pos;
+            pos += delimiter.size();
+            terminated = true;
+            break;
+        }
+
+        switch (data[pos]) {
+            case '\'': {
+                // PostgreSQL only honours backslashes in E'' strings
+                bool escapes = type == DatabaseType::MySQL;
+                if (type == DatabaseType::PostgreSQL && pos > start && (data[pos - 1] == 'E' || data[pos - 1] == 'e')) {
+                    escapes = pos - 1 == start || !isIdentifierChar(data[pos - 2]);
+                }
+                skipQuoted('\'', escapes);
+                break;
+            }
+            case '"':
+                skipQuoted('"', type == DatabaseType::MySQL);
+                break;
+            case '`':
+                skipQuoted('`', false);
+                break;
+            case '[': {
+                const qint64 close = input.indexOf(']', pos + 1);
+                pos = close < 0 ? size : close + 1;
+                break;
+            }
+            case '$':
+                if (!skipDollarQuoted()) {
+                    ++pos;
+                }
+                break;
+            case '-':
+            case '#':
+                if (!skipLineComment()) {
+                    ++pos;
+                }
+                break;
+            case '/':
+                if (!skipBlockComment()) {
+                    ++pos;
+                }
+                break;
+            default:
+                ++pos;
+                break;
+        }
+    }
+
+    while (end > start && isSpace(data[end - 1])) {
+        --end;
+    }
+    statement->sql = QByteArray::fromRawData(data + start, end - start);
+    statement->copyData = QByteArray();
+    statement->copyIn = false;
+    statement->offset = start;
+    if (terminated && type == DatabaseType::PostgreSQL) {
+        readCopyData(statement);
+    }
+    statement->endOffset = pos;
+    return true;
+}
+
+void SqlScriptSplitter::skipSpaceAndComments() {
+    while (pos < size) {
+        if (isSpace(data[pos])) {
+            ++pos;
+        } else if (type == DatabaseType::MySQL && pos + 2 < size && data[pos] == '/' && data[pos + 1] == '*'
+                   && data[pos + 2] == '!') {
+            // /*!40101 ... */ is executed by MySQL, so it starts a statement
+            return;
+        } else if (!skipLineComment() && !skipBlockComment()) {
+            return;
+        }
+    }
+}
+
+bool SqlScriptSplitter::skipLineComment() {
+    bool comment = false;
+    if (data[pos] == '-' && pos + 1 < size && data[pos + 1] == '-') {
+        // MySQL wants a space after --
+        comment = type != DatabaseType::MySQL || pos + 2 >= size || isSpace(data[pos + 2]);
+    } else if (data[pos] == '#') {
+        comment = type == DatabaseType::MySQL;
+    }
+    if (!comment) {
+        return false;
+    }
+    const qint64 eol = input.indexOf('\n', pos);
+    pos = eol < 0 ? size : eol + 1;
+    return true;
+}
+
+bool SqlScriptSplitter::skipBlockComment() {
+    if (data[pos] != '/' || pos + 1 >= size || data[pos + 1] != '*') {
+        return false;
+    }
+    // Only PostgreSQL nests block comments
+    int depth = 0;
+    while (pos < size) {
+        if (data[pos] == '/' && pos + 1 < size && data[pos + 1] == '*'
+            && (depth == 0 || type == DatabaseType::PostgreSQL)) {
+            ++depth;
+            pos += 2;
+        } else if (data[pos] == '*' && pos + 1 < size && data[pos + 1] == '/') {
+            pos += 2;
+            if (--depth == 0) {
+                return true;
+            }
+        } else {
+            ++pos;
+        }
+    }
+    return true;
+}
+
+void SqlScriptSplitter::skipQuoted(char quote, bool backslashEscapes) {
+    ++pos;
+    while (pos < size) {
+        if (!backslashEscapes) {
+            const void *found = std::memchr(data + pos, quote, size_t(size - pos));
+            if (!found) {
+                pos = size;
+                return;
+            }
+            pos = static_cast<const char *>(found) - data;
+        }
+
+        const char c = data[pos];
+        if (c == '\\' && backslashEscapes) {
+            pos += 2;
+        } else if (c == quote) {
+            // A doubled quote stands for itself
+            if (pos + 1 < size && data[pos + 1] == quote) {
+                pos += 2;
+            } else {
+                ++pos;
+                return;
+            }
+        } else {
+            ++pos;
+        }
+    }
+    pos = qMin(pos, size);
+}
+
+bool SqlScriptSplitter::skipDollarQuoted() {
+    // $tag$ ... $tag$, where the tag is empty or an identifier not starting with a
+    // digit; $1 and name$x are something else
+    if (pos > 0 && isIdentifierChar(data[pos - 1])) {
+        return false;
+    }
+    qint64 tagEnd = pos + 1;
+    if (tagEnd < size && data[tagEnd] >= '0' && data[tagEnd] <= '9') {
+        return false;
+    }
+    while (tagEnd < size && isIdentifierChar(data[tagEnd])) {
+        ++tagEnd;
+    }
+    if (tagEnd >= size || data[tagEnd] != '$') {
+        return false;
+    }
+
+    const QByteArray tag = QByteArray(data + pos, tagEnd - pos + 1);
+    const qint64 close = input.indexOf(tag, tagEnd + 1);
+    pos = close < 0 ? size : close + tag.size();
+    return true;
+}
+
+bool SqlScriptSplitter::readDelimiterCommand() {
+    if (!wordAt(data + pos, size - pos, "DELIMITER")) {
+        return false;
+    }
+    qint64 eol = input.indexOf('\n', pos);
+    if (eol < 0) {
+        eol = size;
+    }
+    const QByteArray argument = QByteArray(data + pos + 9, eol - pos - 9).trimmed();
+    const QByteArray token = argument.left(argument.indexOf(' ') < 0 ? argument.size() : argument.indexOf(' '));
+    if (token.isEmpty()) {
+        return false;
+    }
+    delimiter = token;
+    updateSpecial();
+    pos = qMin(eol + 1, size);
+    return true;
+}
+
+bool SqlScriptSplitter::atDelimiter() const {
+    return size - pos >= delimiter.size() && std::memcmp(data + pos, delimiter.constData(), delimiter.size()) == 0;
+}
+
+bool SqlScriptSplitter::endsInsideTrigger(qint64 start) const {
+    // CREATE [TEMP|TEMPORARY] TRIGGER ... BEGIN ...; ...; END
+    qint64 p = start;
+    if (!wordAt(data + p, pos - p, "CREATE")) {
+        return false;
+    }
+    p = skipSpaces(data, p + 6, pos);
+    if (wordAt(data + p, pos - p, "TEMPORARY")) {
+        p = skipSpaces(data, p + 9, pos);
+    } else if (wordAt(data + p, pos - p, "TEMP")) {
+        p = skipSpaces(data, p + 4, pos);
+    }
+    if (!wordAt(data + p, pos - p, "TRIGGER")) {
+        return false;
+    }
+
+    // The body ends with the END matching its BEGIN; the CASE ... END expressions in
+    // it nest. Words in quotes and comments don't count.
+    int depth = 0;
+    bool body = false;
+    for (qint64 q = p + 7; q < pos;) {
+        const char c = data[q];
+        if (c == '\'' || c == '"' || c == '`' || c == '[') {
+            // A doubled quote just closes and reopens
+            const char close = c == '[' ? ']' : c;
+            ++q;
+            while (q < pos && data[q] != close) {
+                ++q;
+            }
+            ++q;
+        } else if (c == '-' && q + 1 < pos && data[q + 1] == '-') {
+            while (q < pos && data[q] != '\n') {
+                ++q;
+            }
+        } else if (c == '/' && q + 1 < pos && data[q + 1] == '*') {
+            q += 2;
+            while (q + 1 < pos && !(data[q] == '*' && data[q + 1] == '/')) {
+                ++q;
+            }
+            q += 2;
+        } else if (isIdentifierChar(c)) {
+            qint64 wordEnd = q;
+            while (wordEnd < pos && isIdentifierChar(data[wordEnd])) {
+                ++wordEnd;
+            }
+            if (wordAt(data + q, wordEnd - q, "BEGIN")) {
+                ++depth;
+                body = true;
+            } else if (body && wordAt(data + q, wordEnd - q, "CASE")) {
+                ++depth;
+            } else if (depth > 0 && wordAt(data + q, wordEnd - q, "END")) {
+                --depth;
+            }
+            q = wordEnd;
+        } else {
+            ++q;
+        }
+    }
+    return !body || depth > 0;
+}
+
+void SqlScriptSplitter::readCopyData(ScriptStatement *statement) {
+    static const QRegularExpression fromStdin("^\\s*COPY\\b.*\\bFROM\\s+STDIN\\b",
+                                              QRegularExpression::CaseInsensitiveOption
+                                                  | QRegularExpression::DotMatchesEverythingOption);
+    if (!wordAt(statement->sql.constData(), statement->sql.size(), "COPY")
+        || !fromStdin.match(QString::fromUtf8(statement->sql)).hasMatch()) {
+        return;
+    }
+    statement->copyIn = true;
+
+    // Rows start on the line after the statement and run up to a line holding \.
+    const qint64 eol = input.indexOf('\n', pos);
+    const qint64 rowsStart = eol < 0 ? size : eol + 1;
+    qint64 terminator = -1;
+    if (size - rowsStart >= 2 && data[rowsStart] == '\\' && data[rowsStart + 1] == '.') {
+        terminator = rowsStart;
+    }
+    for (qint64 from = rowsStart; terminator < 0;) {
+        const qint64 found = input.indexOf("\n\\.", from);
+        if (found < 0) {
+            break;
+        }
+        const qint64 after = found + 3;
+        if (after >= size || data[after] == '\n' || data[after] == '\r') {
+            terminator = found + 1;
+        }
+        from = found + 1;
+    }
+
+    if (terminator < 0) {
+        statement->copyData = QByteArray::fromRawData(data + rowsStart, size - rowsStart);
+        pos = size;
+        return;
+    }
+    statement->copyData = QByteArray::fromRawData(data + rowsStart, terminator - rowsStart);
+    const qint64 terminatorEnd = input.indexOf('\n', terminator);
+    pos = terminatorEnd < 0 ? size : terminatorEnd + 1;
+}
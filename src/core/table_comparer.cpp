@@ -0,0 +1,557 @@
+#include "core/table_comparer.h"
+#include "core/chunked_scan.h"
+#include "core/sql_dialect.h"
+#include "core/table_statistics.h"
+#include "database/connection_manager.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QSqlError>
+#include <QSqlField>
+#include <QSqlQuery>
+#include <QSqlRecord>
+#include <QThread>
+#include <QWaitCondition>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace {
+QueryResult failure(const QString &message, qint64 elapsedMs = 0) {
+    QueryResult result;
+    result.success = false;
+    result.errorMessage = message;
+    result.rowCount = 0;
+    result.executionTimeMs = elapsedMs;
+    return result;
+}
+
+bool isIntegerType(QMetaType type) {
+    switch (type.id()) {
+        case QMetaType::Int:
+        case QMetaType::UInt:
+        case QMetaType::Short:
+        case QMetaType::UShort:
+        case QMetaType::Long:
+        case QMetaType::ULong:
+        case QMetaType::LongLong:
+        case QMetaType::ULongLong:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Key range [low, high); an invalid bound is open
+struct Range {
+    QVariant low;
+    QVariant high;
+};
+
+struct RangeChecksum {
+    qint64 rows = 0;
+    QString sum;
+};
+
+// A row of a leaf range: its key and the hash of all compared columns
+struct RowHash {
+    QVariant key;
+    QByteArray hash;
+};
+
+// One of the two tables and how to query it
+struct Side {
+    DatabaseType type;
+    QString table;           // quoted, qualified
+    QString key;             // quoted
+    QStringList columns;     // quoted, in source order
+    bool serverHashes;
+};
+
+QString rangePredicate(const Side &side, const Range &range) {
+    QStringList predicates;
+    if (range.low.isValid()) {
+        predicates << QString("%1 >= %2").arg(side.key, SqlDialect::literal(side.type, range.low));
+    }
+    if (range.high.isValid()) {
+        predicates << QString("%1 < %2").arg(side.key, SqlDialect::literal(side.type, range.high));
+    }
+    return predicates.isEmpty() ? QString("1 = 1") : predicates.join(" AND ");
+}
+
+// Hex MD5 of the row computed by the server. Both sides run the same expression over
+// the same column list, so equal rows hash alike.
+QString rowHashExpression(const Side &side) {
+    if (side.type == DatabaseType::PostgreSQL) {
+        return QString("md5(ROW(%1)::text)").arg(side.columns.join(", "));
+    }
+    // CONCAT_WS skips NULLs, so a NULL flag per column keeps NULL apart from ''
+    QStringList nullFlags;
+    for (const QString &column : side.columns) {
+        nullFlags << QString("ISNULL(%1)").arg(column);
+    }
+    return QString("MD5(CONCAT_WS('#', %1, CONCAT(%2)))").arg(side.columns.join(", "), nullFlags.join(", "));
+}
+
+// Values as text that doesn't depend on which driver read them
+QString canonicalText(const QVariant &value) {
+    if (!value.isValid() || value.isNull()) {
+        return QStringLiteral("\\N");
+    }
+    switch (value.metaType().id()) {
+        case QMetaType::Bool:
+            return value.toBool() ? "1" : "0";
+        case QMetaType::Double:
+        case QMetaType::Float:
+            return QString::number(value.toDouble(), 'g', 17);
+        case QMetaType::QDateTime:
+            return value.toDateTime().toString(Qt::ISODateWithMs);
+        case QMetaType::QByteArray:
+            return QString::fromLatin1(value.toByteArray().toHex());
+        default:
+            return value.toString();
+    }
+}
+
+QByteArray localRowHash(const QSqlQuery &query, int firstColumn, int columnCount) {
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    for (int i = firstColumn; i < firstColumn + columnCount; ++i) {
+        hash.addData(canonicalText(query.value(i)).toUtf8());
+        hash.addData(QByteArrayView("\x1f", 1));
+    }
+    return hash.result();
+}
+
+quint64 hashPrefix(const QByteArray &hash) {
+    quint64 value = 0;
+    for (int i = 0; i < 8 && i < hash.size(); ++i) {
+        value = (value << 8) | uchar(hash.at(i));
+    }
+    return value;
+}
+
+qint64 payloadBytes(const QVariant &value) {
+    switch (value.metaType().id()) {
+        case QMetaType::QString:
+            return value.toString().size();
+        case QMetaType::QByteArray:
+            return value.toByteArray().size();
+        default:
+            return value.isValid() ? 8 : 0;
+    }
+}
+
+// COUNT(*) and the sum of the first 64 bits of every row hash
+bool rangeChecksum(QSqlDatabase db, const Side &side, const Range &range, RangeChecksum *checksum,
+                   qint64 *bytes, QString *errorMessage) {
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+
+    if (side.serverHashes) {
+        const QString hash = rowHashExpression(side);
+        const QString sum = side.type == DatabaseType::PostgreSQL
+            ? QString("SUM(('x' || SUBSTR(%1, 1, 16))::bit(64)::bigint)").arg(hash)
+            : QString("SUM(CAST(CONV(SUBSTRING(%1, 1, 16), 16, 10) AS UNSIGNED))").arg(hash);
+        if (!query.exec(QString("SELECT COUNT(*), COALESCE(%1, 0) FROM %2 WHERE %3")
+                            .arg(sum, side.table, rangePredicate(side, range)))
+            || !query.next()) {
+            *errorMessage = query.lastError().text();
+            return false;
+        }
+        checksum->rows = query.value(0).toLongLong();
+        checksum->sum = query.value(1).toString();
+        *bytes += 32;
+        return true;
+    }
+
+    if (!query.exec(QString("SELECT %1 FROM %2 WHERE %3")
+                        .arg(side.columns.join(", "), side.table, rangePredicate(side, range)))) {
+        *errorMessage = query.lastError().text();
+        return false;
+    }
+    quint64 sum = 0;
+    qint64 rows = 0;
+    while (query.next()) {
+        sum += hashPrefix(localRowHash(query, 0, side.columns.size()));
+        ++rows;
+        for (int i = 0; i < side.columns.size(); ++i) {
+            *bytes += payloadBytes(query.value(i));
+        }
+    }
+    if (query.lastError().isValid()) {
+        *errorMessage = query.lastError().text();
+        return false;
+    }
+    checksum->rows = rows;
+    checksum->sum = QString::number(sum);
+    return true;
+}
+
+// Per-row hashes of a leaf range, by canonical key
+bool rowHashes(QSqlDatabase db, const Side &side, const Range &range, QHash<QString, RowHash> *rows,
+               qint64 *bytes, QString *errorMessage) {
+    const QString selected = side.serverHashes ? rowHashExpression(side) : side.columns.join(", ");
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    if (!query.exec(QString("SELECT %1, %2 FROM %3 WHERE %4")
+                        .arg(side.key, selected, side.table, rangePredicate(side, range)))) {
+        *errorMessage = query.lastError().text();
+        return false;
+    }
+    while (query.next()) {
+        RowHash row;
+        row.key = query.value(0);
+        if (side.serverHashes) {
+            row.hash = query.value(1).toByteArray();
+            *bytes += payloadBytes(row.key) + row.hash.size();
+        } else {
+            row.hash = localRowHash(query, 1, side.columns.size());
+            for (int i = 0; i <= side.columns.size(); ++i) {
+                *bytes += payloadBytes(query.value(i));
+            }
+        }
+        rows->insert(canonicalText(row.key), row);
+    }
+    if (query.lastError().isValid()) {
+        *errorMessage = query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+// A key strictly inside the range that halves it: the midpoint of a bounded integer
+// range, else the median key of the side's rows in it. Invalid when the range can't
+// be split.
+QVariant splitKey(QSqlDatabase db, const Side &side, const Range &range, bool integerKey, qint64 rows,
+                  QString *errorMessage) {
+    if (integerKey && range.low.isValid() && range.high.isValid()) {
+        const qint64 low = range.low.toLongLong();
+        const qint64 high = range.high.toLongLong();
+        if (high - low > 1) {
+            return QVariant(low + (high - low) / 2);
+        }
+        return QVariant();
+    }
+    if (rows < 2) {
+        return QVariant();
+    }
+
+    // The row at offset rows / 2 >= 1 has a larger key than the first one, so both
+    // halves keep rows
+    QSqlQuery query(db);
+    if (!query.exec(QString("SELECT %1 FROM %2 WHERE %3 ORDER BY %1 LIMIT 1 OFFSET %4")
+                        .arg(side.key, side.table, rangePredicate(side, range))
+                        .arg(rows / 2))) {
+        *errorMessage = query.lastError().text();
+        return QVariant();
+    }
+    return query.next() ? query.value(0) : QVariant();
+}
+
+// Starting ranges: even steps between the smallest and largest integer key of both
+// tables, the source planner's histogram for other keys, else the whole table
+QList<Range> initialRanges(QSqlDatabase sourceDb, const Side &source, QSqlDatabase targetDb, const Side &target,
+                           const QString &sourceTable, const QString &keyColumn, QMetaType keyType,
+                           int rangeCount) {
+    QVariantList bounds;
+    if (isIntegerType(keyType)) {
+        bool found = false;
+        qint64 low = 0;
+        qint64 high = 0;
+        auto extend = [&](QSqlDatabase db, const Side &side) {
+            QSqlQuery query(db);
+            if (query.exec(QString("SELECT MIN(%1), MAX(%1) FROM %2").arg(side.key, side.table))
+                && query.next() && !query.isNull(0)) {
+                low = found ? qMin(low, query.value(0).toLongLong()) : query.value(0).toLongLong();
+                high = found ? qMax(high, query.value(1).toLongLong()) : query.value(1).toLongLong();
+                found = true;
+            }
+        };
+        extend(sourceDb, source);
+        extend(targetDb, target);
+        const double step = (double(high) - double(low)) / rangeCount;
+        for (int i = 1; found && i < rangeCount && step >= 1.0; ++i) {
+            bounds << QVariant(low + qint64(step * i));
+        }
+    } else {
+        QString table;
+        QString schema;
+        TableStatistics::splitTableName(sourceTable, &table, &schema);
+        const QStringList histogram = TableStatistics::histogramBounds(sourceDb, source.type, table, schema,
+                                                                       keyColumn);
+        if (histogram.size() > 2) {
+            QString previous;
+            for (int i = 1; i < rangeCount; ++i) {
+                const QString bound = histogram.at(int(qint64(i) * (histogram.size() - 1) / rangeCount));
+                if (bound != previous) {
+                    bounds << QVariant(bound);
+                    previous = bound;
+                }
+            }
+        }
+    }
+
+    QList<Range> ranges;
+    QVariant low;
+    for (const QVariant &bound : bounds) {
+        ranges << Range{low, bound};
+        low = bound;
+    }
+    ranges << Range{low, QVariant()};
+    return ranges;
+}
+} // namespace
+
+QString TableComparer::kindName(RowDifference::Kind kind) {
+    switch (kind) {
+        case RowDifference::MissingInTarget:
+            return "missing in target";
+        case RowDifference::MissingInSource:
+            return "missing in source";
+        case RowDifference::Changed:
+            return "changed";
+    }
+    return QString();
+}
+
+QFuture<QueryResult> TableComparer::start(const TableCompareOptions &options, const TransferProgressPtr &progress,
+                                          const TableCompareReportPtr &report, const CancelTokenPtr &token) {
+    DatabaseConnection *source = ConnectionManager::instance().getConnection(options.sourceConnection);
+    DatabaseConnection *target = ConnectionManager::instance().getConnection(options.targetConnection);
+    if (!source || !source->isConnected() || !target || !target->isConnected()) {
+        return QtConcurrent::run([]() {
+            return failure("Both connections must be open");
+        });
+    }
+
+    const ConnectionInfo sourceInfo = QueryExecutor::getConnectionInfo(options.sourceConnection);
+    const ConnectionInfo targetInfo = QueryExecutor::getConnectionInfo(options.targetConnection);
+    const DatabaseType sourceType = source->getType();
+    const DatabaseType targetType = target->getType();
+    return QtConcurrent::run([sourceInfo, sourceType, targetInfo, targetType, options, progress, report, token]() {
+        return run(sourceInfo, sourceType, targetInfo, targetType, options, progress, report, token);
+    });
+}
+
+QueryResult TableComparer::run(const ConnectionInfo &sourceInfo, DatabaseType sourceType,
+                               const ConnectionInfo &targetInfo, DatabaseType targetType,
+                               const TableCompareOptions &options, const TransferProgressPtr &progress,
+                               const TableCompareReportPtr &report, const CancelTokenPtr &token) {
+    QElapsedTimer timer;
+    timer.start();
+
+    QString error;
+    QSqlDatabase sourceDb = QueryExecutor::threadDatabase(sourceInfo, &error);
+    if (!sourceDb.isValid() || !sourceDb.isOpen()) {
+        return failure(error);
+    }
+    QSqlDatabase targetDb = QueryExecutor::threadDatabase(targetInfo, &error);
+    if (!targetDb.isValid() || !targetDb.isOpen()) {
+        return failure(error);
+    }
+
+    const QSqlRecord sourceLayout = sourceDb.record(options.sourceTable);
+    if (sourceLayout.isEmpty()) {
+        return failure(QString("Table '%1' was not found").arg(options.sourceTable));
+    }
+    const QSqlRecord targetLayout = targetDb.record(options.targetTable);
+    if (targetLayout.isEmpty()) {
+        return failure(QString("Table '%1' was not found on %2").arg(options.targetTable, options.targetConnection));
+    }
+    const QString key = ChunkedScan::keyColumn(sourceDb, options.sourceTable);
+    if (key.isEmpty()) {
+        return failure(QString("'%1' has no single-column primary key to compare by").arg(options.sourceTable));
+    }
+
+    // Columns only the target has are not compared
+    const bool serverHashes = sourceType == targetType && sourceType != DatabaseType::SQLite;
+    Side source{sourceType, SqlDialect::qualifiedName(sourceType, options.sourceTable),
+                SqlDialect::quoteIdentifier(sourceType, key), QStringList(), serverHashes};
+    Side target{targetType, SqlDialect::qualifiedName(targetType, options.targetTable),
+                SqlDialect::quoteIdentifier(targetType, key), QStringList(), serverHashes};
+    for (int i = 0; i < sourceLayout.count(); ++i) {
+        const QString column = sourceLayout.fieldName(i);
+        if (!targetLayout.contains(column)) {
+            return failure(QString("Column '%1' is missing from %2").arg(column, options.targetTable));
+        }
+        source.columns << SqlDialect::quoteIdentifier(sourceType, column);
+        target.columns << SqlDialect::quoteIdentifier(targetType, column);
+    }
+    report->serverChecksums = serverHashes;
+
+    const QMetaType keyType = sourceLayout.field(key).metaType();
+    const bool integerKey = isIntegerType(keyType);
+    const int workers = qBound(1, options.workers, 32);
+    const int loadPercent = qBound(1, options.loadPercent, 100);
+
+    QMutex queueMutex;
+    QWaitCondition queueChanged;
+    QList<Range> pending = initialRanges(sourceDb, source, targetDb, target, options.sourceTable, key, keyType,
+                                         workers * kChunksPerWorker);
+    int busy = 0;
+
+    std::atomic<bool> stop{false};
+    QMutex resultMutex;
+    QString runError;
+    auto fail = [&](const QString &message) {
+        {
+            QMutexLocker locker(&resultMutex);
+            if (runError.isEmpty()) {
+                runError = message;
+            }
+        }
+        QMutexLocker locker(&queueMutex);
+        stop = true;
+        queueChanged.wakeAll();
+    };
+    auto addDifference = [&](const QVariant &rowKey, RowDifference::Kind kind) {
+        ++report->differenceCount;
+        QMutexLocker locker(&resultMutex);
+        if (report->differences.size() < kMaxDifferences) {
+            report->differences.append(RowDifference{rowKey, kind});
+        }
+    };
+    // Keeps a worker's share of time on the servers at loadPercent
+    auto throttle = [&](qint64 queryMs) {
+        qint64 pauseMs = queryMs * (100 - loadPercent) / loadPercent;
+        while (pauseMs > 0 && !token->isCancelled()) {
+            QThread::msleep(quint64(qMin<qint64>(pauseMs, 100)));
+            pauseMs -= 100;
+        }
+    };
+
+    // Compares one range; mismatching ones larger than a leaf come back split
+    auto compareRange = [&](QSqlDatabase sdb, QSqlDatabase tdb, const Range &range, QList<Range> *split,
+                            QString *rangeError) {
+        QElapsedTimer queryTimer;
+        queryTimer.start();
+        qint64 bytes = 0;
+        RangeChecksum sourceSum;
+        RangeChecksum targetSum;
+        const bool ok = rangeChecksum(sdb, source, range, &sourceSum, &bytes, rangeError)
+            && rangeChecksum(tdb, target, range, &targetSum, &bytes, rangeError);
+        progress->bytes += bytes;
+        ++report->chunksCompared;
+        if (!ok) {
+            return false;
+        }
+
+        if (sourceSum.rows == targetSum.rows && sourceSum.sum == targetSum.sum) {
+            progress->rows += sourceSum.rows;
+            throttle(queryTimer.elapsed());
+            return true;
+        }
+        ++report->mismatchedChunks;
+
+        if (qMax(sourceSum.rows, targetSum.rows) > kLeafRows) {
+            const bool sourceLarger = sourceSum.rows >= targetSum.rows;
+            const QVariant middle = splitKey(sourceLarger ? sdb : tdb, sourceLarger ? source : target, range,
+                                             integerKey, qMax(sourceSum.rows, targetSum.rows), rangeError);
+            if (!rangeError->isEmpty()) {
+                return false;
+            }
+            if (middle.isValid()) {
+                *split << Range{range.low, middle} << Range{middle, range.high};
+                throttle(queryTimer.elapsed());
+                return true;
+            }
+        }
+
+        bytes = 0;
+        QHash<QString, RowHash> sourceRows;
+        QHash<QString, RowHash> targetRows;
+        const bool fetched = rowHashes(sdb, source, range, &sourceRows, &bytes, rangeError)
+            && rowHashes(tdb, target, range, &targetRows, &bytes, rangeError);
+        progress->bytes += bytes;
+        if (!fetched) {
+            return false;
+        }
+        for (auto it = targetRows.cbegin(); it != targetRows.cend(); ++it) {
+            const auto match = sourceRows.constFind(it.key());
+            if (match == sourceRows.cend()) {
+                addDifference(it->key, RowDifference::MissingInSource);
+            } else {
+                if (match->hash != it->hash) {
+                    addDifference(match->key, RowDifference::Changed);
+                }
+                sourceRows.erase(match);
+            }
+        }
+        for (const RowHash &row : std::as_const(sourceRows)) {
+            addDifference(row.key, RowDifference::MissingInTarget);
+        }
+        progress->rows += sourceSum.rows;
+        throttle(queryTimer.elapsed());
+        return true;
+    };
+
+    // Cancelling interrupts the checksum queries still running on either side
+    ServerCancelGroup sessions(token);
+
+    // Ranges are taken from the back, so split halves are finished before new ranges
+    // start and the pending list stays short
+    std::vector<std::unique_ptr<QThread>> threads;
+    for (int w = 0; w < workers; ++w) {
+        threads.push_back(std::unique_ptr<QThread>(QThread::create([&]() {
+            QString openError;
+            QSqlDatabase sdb = QueryExecutor::threadDatabase(sourceInfo, &openError);
+            QSqlDatabase tdb = sdb.isOpen() ? QueryExecutor::threadDatabase(targetInfo, &openError) : QSqlDatabase();
+            if (!sdb.isOpen() || !tdb.isValid() || !tdb.isOpen()) {
+                fail(openError);
+                return;
+            }
+            const QString sourceSession = sessions.add(sdb, sourceInfo);
+            const QString targetSession = sessions.add(tdb, targetInfo);
+
+            forever {
+                Range range;
+                {
+                    QMutexLocker locker(&queueMutex);
+                    while (pending.isEmpty() && busy > 0 && !stop) {
+                        queueChanged.wait(&queueMutex);
+                    }
+                    if (stop || pending.isEmpty()) {
+                        queueChanged.wakeAll();
+                        break;
+                    }
+                    range = pending.takeLast();
+                    ++busy;
+                }
+
+                QList<Range> split;
+                QString rangeError;
+                if (!compareRange(sdb, tdb, range, &split, &rangeError) && !token->isCancelled()) {
+                    fail(rangeError);
+                }
+                QMutexLocker locker(&queueMutex);
+                --busy;
+                pending << split;
+                if (token->isCancelled()) {
+                    stop = true;
+                }
+                queueChanged.wakeAll();
+            }
+            sessions.remove(sourceSession);
+            sessions.remove(targetSession);
+        })));
+    }
+    for (const std::unique_ptr<QThread> &thread : threads) {
+        thread->start();
+    }
+    for (const std::unique_ptr<QThread> &thread : threads) {
+        thread->wait();
+    }
+
+    if (runError.isEmpty() && token->isCancelled()) {
+        runError = "Compare cancelled";
+    }
+
+    QueryResult result;
+    result.success = runError.isEmpty();
+    result.errorMessage = runError;
+    result.rowCount = int(qMin<qint64>(progress->rows, std::numeric_limits<int>::max()));
+    result.executionTimeMs = timer.elapsed();
+    return result;
+}
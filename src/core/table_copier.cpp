@@ -0,0 +1,377 @@
+#include "core/table_copier.h"
+#include "core/bounded_queue.h"
+#include "core/bulk_writer.h"
+#include "core/chunked_scan.h"
+#include "core/connection_storage.h"
+#include "core/sql_dialect.h"
+#include "core/table_statistics.h"
+#include "database/connection_manager.h"
+#include <QDate>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QRegularExpression>
+#include <QSqlError>
+#include <QSqlField>
+#include <QSqlQuery>
+#include <QSqlRecord>
+#include <QThread>
+
+namespace {
+QueryResult failure(const QString &message, qint64 elapsedMs = 0) {
+    QueryResult result;
+    result.success = false;
+    result.errorMessage = message;
+    result.rowCount = 0;
+    result.executionTimeMs = elapsedMs;
+    return result;
+}
+
+// Rows for the writer plus the key of the last one, for the checkpoint
+struct RowBatch {
+    QList<BulkRow> rows;
+    QVariant lastKey;
+    qint64 bytes = 0;
+};
+
+// Source values the target can't take as they are: MySQL zero dates come back as
+// invalid dates, and SQLite has no boolean type
+QVariant convertValue(const QVariant &value, DatabaseType targetType) {
+    if (!value.isValid() || value.isNull()) {
+        return QVariant();
+    }
+    switch (value.metaType().id()) {
+        case QMetaType::QDate:
+            return value.toDate().isValid() ? value : QVariant();
+        case QMetaType::QDateTime:
+            return value.toDateTime().isValid() ? value : QVariant();
+        case QMetaType::Bool:
+            if (targetType == DatabaseType::SQLite) {
+                return QVariant(value.toBool() ? 1 : 0);
+            }
+            break;
+        default:
+            break;
+    }
+    return value;
+}
+
+// Precision and scale (-1 when unconstrained) of the table's DECIMAL/NUMERIC
+// columns, which QSqlField only reports as doubles
+QHash<QString, QPair<int, int>> decimalColumns(QSqlDatabase db, DatabaseType type, const QString &qualifiedTable) {
+    QString table;
+    QString schema;
+    TableStatistics::splitTableName(qualifiedTable, &table, &schema);
+
+    QString sql;
+    switch (type) {
+        case DatabaseType::SQLite:
+            sql = QString("SELECT name, type FROM pragma_table_info(%1)").arg(SqlDialect::literal(type, table));
+            break;
+        case DatabaseType::MySQL:
+            sql = QString("SELECT COLUMN_NAME, NUMERIC_PRECISION, NUMERIC_SCALE FROM information_schema.COLUMNS "
+                          "WHERE TABLE_SCHEMA = %1 AND TABLE_NAME = %2 AND DATA_TYPE = 'decimal'")
+                      .arg(schema.isEmpty() ? "DATABASE()" : SqlDialect::literal(type, schema),
+                           SqlDialect::literal(type, table));
+            break;
+        case DatabaseType::PostgreSQL:
+            sql = QString("SELECT attname, CASE WHEN atttypmod >= 4 THEN (atttypmod - 4) >> 16 ELSE -1 END, "
+                          "CASE WHEN atttypmod >= 4 THEN (atttypmod - 4) & 65535 ELSE -1 END "
+                          "FROM pg_attribute WHERE attrelid = %1::regclass AND atttypid = 'numeric'::regtype "
+                          "AND attnum > 0 AND NOT attisdropped")
+                      .arg(SqlDialect::literal(type, SqlDialect::qualifiedName(type, qualifiedTable)));
+            break;
+    }
+
+    QHash<QString, QPair<int, int>> decimals;
+    QSqlQuery query(db);
+    if (!query.exec(sql)) {
+        return decimals;
+    }
+    static const QRegularExpression declared(
+        "^\\s*(?:DECIMAL|NUMERIC)\\s*(?:\\(\\s*(\\d+)\\s*(?:,\\s*(\\d+)\\s*)?\\))?\\s*$",
+        QRegularExpression::CaseInsensitiveOption);
+    while (query.next()) {
+        if (type != DatabaseType::SQLite) {
+            decimals.insert(query.value(0).toString(), {query.value(1).toInt(), query.value(2).toInt()});
+            continue;
+        }
+        const QRegularExpressionMatch match = declared.match(query.value(1).toString());
+        if (match.hasMatch()) {
+            const bool sized = match.hasCaptured(1);
+            decimals.insert(query.value(0).toString(),
+                            {sized ? match.captured(1).toInt() : -1,
+                             sized ? match.captured(2).toInt() : -1});
+        }
+    }
+    return decimals;
+}
+
+// Target column type for a copied column. DECIMAL/NUMERIC stay exact, and MySQL
+// can't index TEXT or BLOB keys, so those become VARCHAR/VARBINARY within InnoDB's
+// 3072-byte key limit.
+QString targetColumnType(DatabaseType targetType, const QSqlField &field, const QPair<int, int> *decimal,
+                         bool isKey) {
+    if (decimal) {
+        const int precision = decimal->first;
+        const int scale = qMax(0, decimal->second);
+        switch (targetType) {
+            case DatabaseType::SQLite:
+                return "NUMERIC";
+            case DatabaseType::MySQL:
+                return precision > 0 ? QString("DECIMAL(%1,%2)").arg(qMin(precision, 65)).arg(qMin(scale, 30))
+                                     : "DECIMAL(65,30)";
+            case DatabaseType::PostgreSQL:
+                return precision > 0 ? QString("NUMERIC(%1,%2)").arg(precision).arg(scale) : "NUMERIC";
+        }
+    }
+
+    const QString type = SqlDialect::columnType(targetType, field.metaType());
+    if (isKey && targetType == DatabaseType::MySQL) {
+        if (type == "LONGTEXT") {
+            return QString("VARCHAR(%1)").arg(field.length() > 255 ? qMin(field.length(), 768) : 255);
+        }
+        if (type == "LONGBLOB") {
+            return QString("VARBINARY(%1)").arg(field.length() > 255 ? qMin(field.length(), 3072) : 255);
+        }
+    }
+    return type;
+}
+
+qint64 payloadBytes(const QVariant &value) {
+    switch (value.metaType().id()) {
+        case QMetaType::QString:
+            return value.toString().size();
+        case QMetaType::QByteArray:
+            return value.toByteArray().size();
+        default:
+            return value.isValid() ? 8 : 0;
+    }
+}
+} // namespace
+
+QFuture<QueryResult> TableCopier::start(const TableCopyOptions &options, const TransferProgressPtr &progress,
+                                        const CancelTokenPtr &token) {
+    DatabaseConnection *source = ConnectionManager::instance().getConnection(options.sourceConnection);
+    DatabaseConnection *target = ConnectionManager::instance().getConnection(options.targetConnection);
+    if (!source || !source->isConnected() || !target || !target->isConnected()) {
+        return QtConcurrent::run([]() {
+            return failure("Both connections must be open");
+        });
+    }
+
+    const ConnectionInfo sourceInfo = QueryExecutor::getConnectionInfo(options.sourceConnection);
+    const ConnectionInfo targetInfo = QueryExecutor::getConnectionInfo(options.targetConnection);
+    const DatabaseType sourceType = source->getType();
+    const DatabaseType targetType = target->getType();
+    return QtConcurrent::run([sourceInfo, sourceType, targetInfo, targetType, options, progress, token]() {
+        return run(sourceInfo, sourceType, targetInfo, targetType, options, progress, token);
+    });
+}
+
+QueryResult TableCopier::run(const ConnectionInfo &sourceInfo, DatabaseType sourceType,
+                             const ConnectionInfo &targetInfo, DatabaseType targetType,
+                             const TableCopyOptions &options, const TransferProgressPtr &progress,
+                             const CancelTokenPtr &token) {
+    QElapsedTimer timer;
+    timer.start();
+
+    QString error;
+    QSqlDatabase sourceDb = QueryExecutor::threadDatabase(sourceInfo, &error);
+    if (!sourceDb.isValid() || !sourceDb.isOpen()) {
+        return failure(error);
+    }
+
+    const QSqlRecord layout = sourceDb.record(options.sourceTable);
+    if (layout.isEmpty()) {
+        return failure(QString("Table '%1' was not found").arg(options.sourceTable));
+    }
+    QStringList columns;
+    for (int i = 0; i < layout.count(); ++i) {
+        columns << layout.fieldName(i);
+    }
+    const QString key = ChunkedScan::keyColumn(sourceDb, options.sourceTable);
+    const int keyIndex = columns.indexOf(key);
+
+    ConnectionStorage &storage = ConnectionStorage::instance();
+    CopyCheckpoint checkpoint;
+    if (options.resume && !key.isEmpty()) {
+        checkpoint = storage.loadCopyCheckpoint(options.sourceConnection, options.sourceTable,
+                                                options.targetConnection, options.targetTable);
+        if (checkpoint.keyColumn != key) {
+            checkpoint.lastKey = QVariant();
+            checkpoint.rowsCopied = 0;
+        }
+    } else {
+        storage.removeCopyCheckpoint(options.sourceConnection, options.sourceTable,
+                                     options.targetConnection, options.targetTable);
+        checkpoint.sourceConnection = options.sourceConnection;
+        checkpoint.sourceTable = options.sourceTable;
+        checkpoint.targetConnection = options.targetConnection;
+        checkpoint.targetTable = options.targetTable;
+    }
+    checkpoint.keyColumn = key;
+
+    QSqlDatabase targetDb = QueryExecutor::threadDatabase(BulkWriter::bulkConnectionInfo(targetInfo, targetType),
+                                                          &error);
+    if (!targetDb.isValid() || !targetDb.isOpen()) {
+        return failure(error);
+    }
+
+    if (targetDb.record(options.targetTable).isEmpty()) {
+        const QHash<QString, QPair<int, int>> decimals = decimalColumns(sourceDb, sourceType, options.sourceTable);
+        QStringList definitions;
+        for (int i = 0; i < layout.count(); ++i) {
+            const auto decimal = decimals.constFind(columns.at(i));
+            definitions << QString("%1 %2").arg(
+                SqlDialect::quoteIdentifier(targetType, columns.at(i)),
+                targetColumnType(targetType, layout.field(i), decimal == decimals.cend() ? nullptr : &*decimal,
+                                 columns.at(i) == key));
+        }
+        if (!key.isEmpty()) {
+            definitions << QString("PRIMARY KEY (%1)").arg(SqlDialect::quoteIdentifier(targetType, key));
+        }
+        QSqlQuery create(targetDb);
+        if (!create.exec(QString("CREATE TABLE %1 (%2)")
+                             .arg(SqlDialect::qualifiedName(targetType, options.targetTable),
+                                  definitions.join(", ")))) {
+            return failure("Failed to create table: " + create.lastError().text(), timer.elapsed());
+        }
+        // Nothing to resume into
+        checkpoint.lastKey = QVariant();
+        checkpoint.rowsCopied = 0;
+    } else if (options.resume && !key.isEmpty()) {
+        // The checkpoint is saved after each commit, so it can lag one batch behind a
+        // copy that stopped in between; the target's highest key never does
+        QSqlQuery last(targetDb);
+        if (!last.exec(QString("SELECT MAX(%1) FROM %2")
+                           .arg(SqlDialect::quoteIdentifier(targetType, key),
+                                SqlDialect::qualifiedName(targetType, options.targetTable)))
+            || !last.next()) {
+            return failure("Failed to read the copied keys: " + last.lastError().text(), timer.elapsed());
+        }
+        checkpoint.lastKey = last.isNull(0) ? QVariant() : last.value(0);
+        if (!checkpoint.isValid()) {
+            checkpoint.rowsCopied = 0;
+        }
+    }
+
+    std::unique_ptr<BulkWriter> writer = BulkWriter::create(targetDb, targetType, options.targetTable, columns);
+    if (!writer->begin(&error)) {
+        return failure(error, timer.elapsed());
+    }
+
+    // Key order makes every committed batch a prefix of the table, which is what lets
+    // a checkpoint stand for everything copied so far. The source is read as parallel
+    // key ranges that are delivered one after another.
+    ChunkedScanOptions scanOptions;
+    scanOptions.table = options.sourceTable;
+    scanOptions.keyColumn = key;
+    scanOptions.columns = columns;
+    scanOptions.concurrency = options.scanSessions;
+    scanOptions.ordered = true;
+    scanOptions.batchRows = qMax(1, options.batchRows);
+    scanOptions.precision = QSql::HighPrecision;
+    if (checkpoint.isValid()) {
+        scanOptions.filter = QString("%1 > %2").arg(SqlDialect::quoteIdentifier(sourceType, key),
+                                                    SqlDialect::literal(sourceType, checkpoint.lastKey));
+    }
+    ChunkedScan scan(sourceInfo, sourceType, scanOptions);
+    if (!scan.plan(sourceDb, &error)) {
+        writer->abort();
+        return failure(error, timer.elapsed());
+    }
+
+    BoundedQueue<QList<QSqlRecord>> records(kQueueBatches);
+    BoundedQueue<RowBatch> rows(kQueueBatches);
+    QString readError;
+
+    // Reader and converter get their own threads rather than pool slots since each
+    // blocks on a queue the next stage drains
+    std::unique_ptr<QThread> readerThread(QThread::create([&]() {
+        scan.run([&records](QList<QSqlRecord> &&batch) {
+            return records.push(std::move(batch));
+        }, token, &readError);
+        records.close();
+    }));
+
+    std::unique_ptr<QThread> converterThread(QThread::create([&]() {
+        QList<QSqlRecord> batch;
+        while (records.pop(batch)) {
+            RowBatch converted;
+            converted.rows.reserve(batch.size());
+            for (const QSqlRecord &record : batch) {
+                BulkRow row;
+                row.reserve(columns.size());
+                for (int i = 0; i < columns.size(); ++i) {
+                    const QVariant value = record.value(i);
+                    converted.bytes += payloadBytes(value);
+                    row.append(convertValue(value, targetType));
+                }
+                converted.rows.append(std::move(row));
+            }
+            if (keyIndex >= 0 && !batch.isEmpty()) {
+                converted.lastKey = batch.last().value(keyIndex);
+            }
+            if (!rows.push(std::move(converted))) {
+                break;
+            }
+        }
+        records.close();
+        rows.close();
+    }));
+
+    readerThread->start();
+    converterThread->start();
+
+    QueryResult result;
+    result.success = false;
+    result.rowCount = 0;
+    result.columnNames = columns;
+
+    RowBatch batch;
+    while (rows.pop(batch)) {
+        if (token->isCancelled()) {
+            error = "Copy cancelled";
+            break;
+        }
+        if (!writer->writeRows(batch.rows, &error) || !writer->commit(&error)) {
+            break;
+        }
+        result.rowCount += batch.rows.size();
+        progress->rows += batch.rows.size();
+        progress->bytes += batch.bytes;
+
+        if (keyIndex >= 0) {
+            checkpoint.lastKey = batch.lastKey;
+            checkpoint.rowsCopied += batch.rows.size();
+            storage.saveCopyCheckpoint(checkpoint);
+        }
+    }
+    rows.close();
+    records.close();
+    readerThread->wait();
+    converterThread->wait();
+
+    if (error.isEmpty() && token->isCancelled()) {
+        error = "Copy cancelled";
+    }
+    if (error.isEmpty() && !readError.isEmpty()) {
+        error = readError;
+    }
+    if (error.isEmpty()) {
+        writer->finish(&error);
+    } else {
+        writer->abort();
+    }
+
+    if (error.isEmpty()) {
+        storage.removeCopyCheckpoint(options.sourceConnection, options.sourceTable,
+                                     options.targetConnection, options.targetTable);
+    }
+
+    result.executionTimeMs = timer.elapsed();
+    result.errorMessage = error;
+    result.success = error.isEmpty();
+    return result;
+}
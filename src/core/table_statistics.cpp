@@ -0,0 +1,232 @@
+#include "core/table_statistics.h"
+#include "core/sql_dialect.h"
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRandomGenerator>
+#include <QSqlError>
+#include <QDebug>
+#include <cmath>
+
+void TableStatistics::splitTableName(const QString &qualifiedTable, QString *table, QString *schema) {
+    const int dot = qualifiedTable.indexOf('.');
+    if (dot < 0) {
+        *table = qualifiedTable;
+        schema->clear();
+        return;
+    }
+    *schema = qualifiedTable.left(dot);
+    *table = qualifiedTable.mid(dot + 1);
+}
+
+QStringList TableStatistics::histogramBounds(QSqlDatabase db, DatabaseType type, const QString &table,
+                                             const QString &schema, const QString &column) {
+    QStringList bounds;
+    const QString sql = SqlDialect::histogramBoundsQuery(type, table, schema, column);
+    if (sql.isEmpty()) {
+        return bounds;
+    }
+
+    QSqlQuery query(db);
+    if (!query.exec(sql)) {
+        return bounds;
+    }
+
+    if (type == DatabaseType::PostgreSQL) {
+        while (query.next()) {
+            bounds << query.value(0).toString();
+        }
+        return bounds;
+    }
+
+    // MySQL: {"buckets": [[lower, upper, frequency, distinct], ...]} for equi-height
+    // histograms, [[value, frequency], ...] for singleton ones. String values come as
+    // "base64:type254:..." and aren't usable as bounds.
+    if (!query.next()) {
+        return bounds;
+    }
+    const QJsonObject histogram = QJsonDocument::fromJson(query.value(0).toString().toUtf8()).object();
+    const bool singleton = histogram.value("histogram-type").toString() == "singleton";
+    for (const QJsonValue &bucket : histogram.value("buckets").toArray()) {
+        const QJsonValue bound = bucket.toArray().at(singleton ? 0 : 1);
+        QString text = bound.toString();
+        if (bound.isDouble()) {
+            const double value = bound.toDouble();
+            text = value == std::floor(value) && std::abs(value) < 9.0e15
+                ? QString::number(qint64(value)) : QString::number(value, 'g', 17);
+        }
+        if (text.startsWith("base64:")) {
+            return QStringList();
+        }
+        bounds << text;
+    }
+    return bounds;
+}
+
+qint64 TableStatistics::estimateRowCount(const ConnectionInfo &connInfo, DatabaseType type,
+                                         const QString &table, const QString &schema) {
+    QSqlDatabase db = QueryExecutor::threadDatabase(connInfo);
+    if (!db.isValid() || !db.isOpen()) {
+        return -1;
+    }
+
+    QSqlQuery query(db);
+    if (query.exec(SqlDialect::estimatedRowCountQuery(type, table, schema)) && query.next() && !query.isNull(0)) {
+        if (type == DatabaseType::SQLite) {
+            // sqlite_stat1.stat is "<rows> <rows per distinct key prefix>..."
+            return query.value(0).toString().section(' ', 0, 0).toLongLong();
+        }
+        // reltuples is -1 for tables that were never vacuumed or analyzed
+        const double rows = query.value(0).toDouble();
+        return rows < 0 ? -1 : qint64(rows);
+    }
+
+    if (type == DatabaseType::SQLite) {
+        // Without ANALYZE statistics the largest rowid is a cheap upper bound
+        QSqlQuery maxRowid(db);
+        if (maxRowid.exec(QString("SELECT max(rowid) FROM %1").arg(SqlDialect::quoteIdentifier(type, table)))
+            && maxRowid.next() && !maxRowid.isNull(0)) {
+            return maxRowid.value(0).toLongLong();
+        }
+    }
+    return -1;
+}
+
+QueryResult TableStatistics::exactRowCount(const ConnectionInfo &connInfo, DatabaseType type,
+                                           const QString &table, const QString &schema,
+                                           const CancelTokenPtr &token) {
+    QString openError;
+    QSqlDatabase db = QueryExecutor::threadDatabase(connInfo, &openError);
+    if (!db.isValid() || !db.isOpen()) {
+        QueryResult result;
+        result.success = false;
+        result.errorMessage = openError;
+        result.rowCount = 0;
+        result.executionTimeMs = 0;
+        return result;
+    }
+
+    QueryExecutor::enableServerCancel(db, connInfo, token);
+    QueryResult result = QueryExecutor::runQuery(
+        db, QString("SELECT COUNT(*) FROM %1").arg(SqlDialect::qualifiedName(type, table, schema)), token);
+    if (token) {
+        token->clearCancelHandler();
+        if (token->isCancelled()) {
+            result.success = false;
+            result.errorMessage = "Count cancelled";
+        }
+    }
+    return result;
+}
+
+QueryResult TableStatistics::samplePeek(const ConnectionInfo &connInfo, DatabaseType type,
+                                        const QString &table, const QString &schema,
+                                        qint64 estimatedRows, int sampleSize) {
+    QString openError;
+    QSqlDatabase db = QueryExecutor::threadDatabase(connInfo, &openError);
+    if (!db.isValid() || !db.isOpen()) {
+        QueryResult result;
+        result.success = false;
+        result.errorMessage = openError;
+        result.rowCount = 0;
+        result.executionTimeMs = 0;
+        return result;
+    }
+
+    const QString from = SqlDialect::qualifiedName(type, table, schema);
+    QString query;
+
+    if (estimatedRows >= 0 && estimatedRows <= qint64(sampleSize) * kExactSampleThreshold) {
+        // Small enough that shuffling the whole table is cheaper than being clever
+        query = QString("SELECT * FROM %1 ORDER BY %2 LIMIT %3")
+                    .arg(from, type == DatabaseType::MySQL ? QString("RAND()") : QString("random()"))
+                    .arg(sampleSize);
+    } else {
+        switch (type) {
+            case DatabaseType::PostgreSQL: {
+                // Block-level sampling reads only the chosen pages; oversample 2x so
+                // the LIMIT is usually reached
+                const double percent = estimatedRows > 0
+                    ? qBound(0.0001, 200.0 * sampleSize / double(estimatedRows), 100.0)
+                    : 1.0;
+                query = QString("SELECT * FROM %1 TABLESAMPLE SYSTEM (%2) LIMIT %3")
+                            .arg(from, QString::number(percent, 'f', 4))
+                            .arg(sampleSize);
+                break;
+            }
+            case DatabaseType::MySQL:
+                query = mysqlSampleQuery(db, table, schema, estimatedRows, sampleSize);
+                break;
+            case DatabaseType::SQLite:
+                // Random rowid point lookups, oversampled 2x to make up for deleted rowids
+                query = QString("WITH RECURSIVE picks(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM picks WHERE i < %2) "
+                                "SELECT * FROM %1 WHERE rowid IN "
+                                "(SELECT abs(random()) % (SELECT max(rowid) FROM %1) + 1 FROM picks) "
+                                "LIMIT %3")
+                            .arg(from)
+                            .arg(sampleSize * 2)
+                            .arg(sampleSize);
+                break;
+        }
+    }
+
+    QueryResult result = QueryExecutor::runQuery(db, query);
+    if (!result.success) {
+        // e.g. WITHOUT ROWID tables or views; a plain first page is still a useful peek
+        qDebug() << "Sampling failed, falling back to first rows:" << result.errorMessage;
+        result = QueryExecutor::runQuery(db, QString("SELECT * FROM %1 LIMIT %2").arg(from).arg(sampleSize));
+    }
+    return result;
+}
+
+QString TableStatistics::mysqlSampleQuery(QSqlDatabase db, const QString &table, const QString &schema,
+                                          qint64 estimatedRows, int sampleSize) {
+    const DatabaseType type = DatabaseType::MySQL;
+    const QString from = SqlDialect::qualifiedName(type, table, schema);
+
+    QSqlQuery keyQuery(db);
+    const bool haveKey = keyQuery.exec(
+        QString("SELECT k.COLUMN_NAME, c.DATA_TYPE FROM information_schema.KEY_COLUMN_USAGE k "
+                "JOIN information_schema.COLUMNS c ON c.TABLE_SCHEMA = k.TABLE_SCHEMA "
+                "AND c.TABLE_NAME = k.TABLE_NAME AND c.COLUMN_NAME = k.COLUMN_NAME "
+                "WHERE k.CONSTRAINT_NAME = 'PRIMARY' AND k.TABLE_NAME = %1 AND k.TABLE_SCHEMA = %2")
+            .arg(SqlDialect::literal(type, table),
+                 schema.isEmpty() ? QString("DATABASE()") : SqlDialect::literal(type, schema)));
+
+    QStringList keyColumns;
+    QString keyType;
+    while (haveKey && keyQuery.next()) {
+        keyColumns << keyQuery.value(0).toString();
+        keyType = keyQuery.value(1).toString().toLower();
+    }
+
+    static const QStringList integerTypes = {"tinyint", "smallint", "mediumint", "int", "bigint"};
+    if (keyColumns.size() == 1 && integerTypes.contains(keyType)) {
+        const QString key = SqlDialect::quoteIdentifier(type, keyColumns.first());
+        QSqlQuery bounds(db);
+        if (bounds.exec(QString("SELECT MIN(%1), MAX(%1) FROM %2").arg(key, from)) && bounds.next()
+            && !bounds.isNull(0)) {
+            const qint64 low = bounds.value(0).toLongLong();
+            const qint64 high = bounds.value(1).toLongLong();
+            const quint64 span = quint64(high - low) + 1;
+            const int rowsPerSeek = qMax(1, sampleSize / kSeekCount);
+
+            // Short index range scans starting at random keys
+            QStringList seeks;
+            for (int i = 0; i < kSeekCount; ++i) {
+                const qint64 start = low + qint64(QRandomGenerator::global()->generate64() % span);
+                seeks << QString("(SELECT * FROM %1 WHERE %2 >= %3 ORDER BY %2 LIMIT %4)")
+                             .arg(from, key)
+                             .arg(start)
+                             .arg(rowsPerSeek);
+            }
+            return seeks.join(" UNION ALL ");
+        }
+    }
+
+    // No usable key: Bernoulli filter, which stops scanning once the LIMIT is reached
+    const double fraction = estimatedRows > 0 ? qMin(1.0, 2.0 * sampleSize / double(estimatedRows)) : 0.01;
+    return QString("SELECT * FROM %1 WHERE RAND() < %2 LIMIT %3")
+        .arg(from, QString::number(fraction, 'g', 6))
+        .arg(sampleSize);
+}
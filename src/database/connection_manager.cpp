@@ -35,6 +35,15 @@ DatabaseConnection* ConnectionManager::getConnection(const QString &name) {
     return nullptr;
 }
 
+std::shared_ptr<DatabaseConnection> ConnectionManager::getSharedConnection(const QString &name) {
+    for (const auto &conn : connections) {
+        if (conn->getName() == name) {
+            return conn;
+        }
+    }
+    return nullptr;
+}
+
 QVector<DatabaseConnection*> ConnectionManager::getAllConnections() const {
     QVector<DatabaseConnection*> result;
     for (const auto &conn : connections) {
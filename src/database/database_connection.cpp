@@ -1,11 +1,25 @@
 #include "database/database_connection.h"
+#include "core/query_executor.h"
+#include "core/sql_dialect.h"
+#include <QMutexLocker>
+#include <QScopeGuard>
+#include <QSet>
+#include <QSqlQuery>
 #include <QUuid>
+#include <QtConcurrent>
+#include <utility>
 
 DatabaseConnection::DatabaseConnection(const ConnectionConfig &config, QObject *parent)
     : QObject(parent), config(config) {
+    metadataPool.setMaxThreadCount(1);
+    metadataPool.setExpiryTimeout(-1);
+    metadataConnectionName = generateConnectionName() + "_metadata";
 }
 
 DatabaseConnection::~DatabaseConnection() {
+    stopMetadataThread();
+    QSqlDatabase::removeDatabase(metadataConnectionName);
+
     if (db.isOpen()) {
         db.close();
     }
@@ -15,3 +29,431 @@ DatabaseConnection::~DatabaseConnection() {
 QString DatabaseConnection::generateConnectionName() const {
     return config.name + "_" + QUuid::createUuid().toString();
 }
+
+namespace {
+QString requestKey(const QStringList &parts) {
+    return parts.join(QChar(31));
+}
+} // namespace
+
+template <typename T>
+QFuture<T> DatabaseConnection::runCatalogQuery(const QString &key, std::function<T(QSqlDatabase)> query) {
+    // Held until the future is registered, so the task can't forget it first
+    QMutexLocker locker(&inFlightMutex);
+    const auto pending = inFlight.constFind(key);
+    if (pending != inFlight.constEnd()) {
+        return std::any_cast<QFuture<T>>(pending.value());
+    }
+
+    const int generation = catalogGeneration;
+    QFuture<T> future = QtConcurrent::run(&metadataPool, [this, key, query, generation]() {
+        // Once this is done, requests start over instead of joining it
+        const auto forget = qScopeGuard([this, &key, generation]() {
+            runningGeneration = -1;
+            forgetCatalogQuery(key, generation);
+        });
+        if (stopping || generation != catalogGeneration) {
+            return T();
+        }
+        QSqlDatabase session = QSqlDatabase::contains(metadataConnectionName)
+            ? QSqlDatabase::database(metadataConnectionName, false)
+            : createSession(metadataConnectionName);
+        if (!session.isOpen()) {
+            if (!session.open()) {
+                return T();
+            }
+            readMetadataBackendId(session);
+        }
+        runningGeneration = generation;
+        return query(session);
+    });
+    inFlight.insert(key, future);
+    return future;
+}
+
+void DatabaseConnection::forgetCatalogQuery(const QString &key, int generation) {
+    QMutexLocker locker(&inFlightMutex);
+    // After a cancel the key may belong to a newer request
+    if (generation == catalogGeneration) {
+        inFlight.remove(key);
+    }
+}
+
+void DatabaseConnection::cancelCatalogQueries() {
+    int generation;
+    {
+        QMutexLocker locker(&inFlightMutex);
+        generation = ++catalogGeneration;
+        inFlight.clear();
+    }
+    interruptCatalogQuery(generation);
+}
+
+void DatabaseConnection::readMetadataBackendId(QSqlDatabase session) {
+    metadataBackendId = -1;
+    const QString idQuery = SqlDialect::backendIdQuery(config.type);
+    QSqlQuery query(session);
+    if (!idQuery.isEmpty() && query.exec(idQuery) && query.next()) {
+        metadataBackendId = query.value(0).toLongLong();
+    }
+}
+
+void DatabaseConnection::interruptCatalogQuery(int generation) {
+    // Only a request from before the cancel; a newer one may have started meanwhile
+    const int running = runningGeneration;
+    const qint64 backendId = metadataBackendId;
+    if (running < 0 || running >= generation || backendId < 0) {
+        return;
+    }
+    const QString cancelQuery = SqlDialect::cancelBackendQuery(config.type, backendId);
+    if (cancelQuery.isEmpty()) {
+        return;
+    }
+
+    // The interrupt has to come from another session, and the GUI thread shouldn't
+    // wait for it; send it from a pool thread as QueryExecutor::enableServerCancel() does
+    QtConcurrent::run([connInfo = QueryExecutor::connectionInfoFromConfig(config), cancelQuery]() {
+        QueryExecutor::runQuery(connInfo, cancelQuery);
+    });
+}
+
+QFuture<QStringList> DatabaseConnection::fetchDatabases() {
+    return runCatalogQuery<QStringList>("databases", [this](QSqlDatabase session) {
+        return queryDatabases(session);
+    });
+}
+
+QFuture<QStringList> DatabaseConnection::fetchSchemas(const QString &database) {
+    return runCatalogQuery<QStringList>(requestKey({"schemas", database}), [this, database](QSqlDatabase session) {
+        return querySchemas(session, database);
+    });
+}
+
+QFuture<CatalogRevalidation> DatabaseConnection::revalidateCatalog(const QHash<QString, QString> &knownVersions) {
+    // Callers knowing the same versions get the same answer
+    QStringList known;
+    for (auto it = knownVersions.cbegin(); it != knownVersions.cend(); ++it) {
+        known << it.key() + "=" + it.value();
+    }
+    known.sort();
+    known.prepend("revalidate");
+
+    return runCatalogQuery<CatalogRevalidation>(requestKey(known), [this, knownVersions](QSqlDatabase session) {
+        CatalogRevalidation result;
+        QHash<QString, QString> versions;
+        if (!querySchemaVersions(session, &versions)) {
+            return result;
+        }
+
+        // Versions are read before the contents, so a change racing the fetch shows up
+        // as a new version next time
+        QStringList changed;
+        for (auto it = versions.cbegin(); it != versions.cend(); ++it) {
+            result.schemas << it.key();
+            const auto known = knownVersions.constFind(it.key());
+            if (known == knownVersions.cend() || known.value() != it.value()) {
+                changed << it.key();
+            }
+        }
+        result.schemas.sort();
+        changed.sort();
+
+        // Schemas another request already read at this version aren't read again
+        QStringList outdated;
+        for (const QString &schema : std::as_const(changed)) {
+            const auto cached = metadataCache.constFind(schema);
+            if (cached != metadataCache.constEnd() && cached->snapshot.version == versions.value(schema)) {
+                result.changed << cached->snapshot;
+            } else {
+                outdated << schema;
+            }
+        }
+        const int firstRead = result.changed.size();
+        if (!outdated.isEmpty() && !readSnapshots(session, outdated, versions, &result.changed)) {
+            return result;
+        }
+
+        // Whatever was read also serves fetchColumns() and friends
+        serverVersions = versions;
+        serverVersionsAge.start();
+        for (int i = firstRead; i < result.changed.size(); ++i) {
+            storeSchemaMetadata(result.changed.at(i));
+        }
+        for (auto it = metadataCache.begin(); it != metadataCache.end();) {
+            it = versions.contains(it.key()) ? std::next(it) : metadataCache.erase(it);
+        }
+
+        result.valid = true;
+        return result;
+    });
+}
+
+bool DatabaseConnection::readSnapshots(QSqlDatabase session, const QStringList &schemas,
+                                       const QHash<QString, QString> &versions, QList<CatalogSnapshot> *snapshots) {
+    QList<RelationInfo> relations;
+    QList<ColumnInfo> columns;
+    QList<IndexInfo> indexes;
+    QList<ForeignKeyInfo> foreignKeys;
+    if (!queryRelations(session, schemas, &relations) || !queryColumns(session, schemas, &columns)
+        || !queryIndexes(session, schemas, &indexes) || !queryForeignKeys(session, schemas, &foreignKeys)) {
+        return false;
+    }
+
+    const int first = snapshots->size();
+    for (const QString &schema : schemas) {
+        CatalogSnapshot snapshot;
+        snapshot.schema = schema;
+        snapshot.version = versions.value(schema);
+        snapshots->append(snapshot);
+    }
+    QHash<QString, CatalogSnapshot *> bySchema;
+    for (int i = first; i < snapshots->size(); ++i) {
+        bySchema.insert((*snapshots)[i].schema, &(*snapshots)[i]);
+    }
+
+    for (const RelationInfo &relation : std::as_const(relations)) {
+        if (CatalogSnapshot *snapshot = bySchema.value(relation.schema)) {
+            snapshot->relations << relation;
+        }
+    }
+    for (const ColumnInfo &column : std::as_const(columns)) {
+        if (CatalogSnapshot *snapshot = bySchema.value(column.schema)) {
+            snapshot->columns << column;
+        }
+    }
+    for (const IndexInfo &index : std::as_const(indexes)) {
+        if (CatalogSnapshot *snapshot = bySchema.value(index.schema)) {
+            snapshot->indexes << index;
+        }
+    }
+    for (const ForeignKeyInfo &foreignKey : std::as_const(foreignKeys)) {
+        if (CatalogSnapshot *snapshot = bySchema.value(foreignKey.schema)) {
+            snapshot->foreignKeys << foreignKey;
+        }
+    }
+
+    for (int i = first; i < snapshots->size(); ++i) {
+        (*snapshots)[i].shareStrings();
+    }
+    return true;
+}
+
+QFuture<QList<ColumnInfo>> DatabaseConnection::fetchColumns(const QString &schema, const QString &table) {
+    return runCatalogQuery<QList<ColumnInfo>>(requestKey({"columns", schema, table}),
+                                              [this, schema, table](QSqlDatabase session) {
+        const SchemaMetadata *metadata = schemaMetadata(session, schema.isEmpty() ? defaultSchema() : schema);
+        if (!metadata) {
+            return QList<ColumnInfo>();
+        }
+        const QPair<int, int> range = metadata->ranges.columns.value(table, {0, 0});
+        return metadata->snapshot.columns.mid(range.first, range.second - range.first);
+    });
+}
+
+QFuture<QList<IndexInfo>> DatabaseConnection::fetchIndexes(const QString &schema, const QString &table) {
+    return runCatalogQuery<QList<IndexInfo>>(requestKey({"indexes", schema, table}),
+                                             [this, schema, table](QSqlDatabase session) {
+        const SchemaMetadata *metadata = schemaMetadata(session, schema.isEmpty() ? defaultSchema() : schema);
+        if (!metadata) {
+            return QList<IndexInfo>();
+        }
+        const QPair<int, int> range = metadata->ranges.indexes.value(table, {0, 0});
+        return metadata->snapshot.indexes.mid(range.first, range.second - range.first);
+    });
+}
+
+QFuture<QList<ForeignKeyInfo>> DatabaseConnection::fetchForeignKeys(const QString &schema, const QString &table) {
+    return runCatalogQuery<QList<ForeignKeyInfo>>(requestKey({"foreignKeys", schema, table}),
+                                                  [this, schema, table](QSqlDatabase session) {
+        const SchemaMetadata *metadata = schemaMetadata(session, schema.isEmpty() ? defaultSchema() : schema);
+        if (!metadata) {
+            return QList<ForeignKeyInfo>();
+        }
+        const QPair<int, int> range = metadata->ranges.foreignKeys.value(table, {0, 0});
+        return metadata->snapshot.foreignKeys.mid(range.first, range.second - range.first);
+    });
+}
+
+void DatabaseConnection::primeCatalog(const QList<CatalogSnapshot> &snapshots) {
+    // Needs no session, so it doesn't go through runCatalogQuery
+    QtConcurrent::run(&metadataPool, [this, snapshots]() {
+        for (const CatalogSnapshot &snapshot : snapshots) {
+            if (!metadataCache.contains(snapshot.schema)) {
+                storeSchemaMetadata(snapshot);
+            }
+        }
+    });
+}
+
+CatalogTableRanges CatalogTableRanges::of(const CatalogSnapshot &snapshot) {
+    auto rangesOf = [](const auto &entries) {
+        QHash<QString, QPair<int, int>> ranges;
+        for (int i = 0; i < entries.size(); ++i) {
+            auto range = ranges.find(entries.at(i).table);
+            if (range == ranges.end()) {
+                ranges.insert(entries.at(i).table, {i, i + 1});
+            } else {
+                range->second = i + 1;
+            }
+        }
+        return ranges;
+    };
+
+    CatalogTableRanges ranges;
+    ranges.columns = rangesOf(snapshot.columns);
+    ranges.indexes = rangesOf(snapshot.indexes);
+    ranges.foreignKeys = rangesOf(snapshot.foreignKeys);
+    return ranges;
+}
+
+void DatabaseConnection::storeSchemaMetadata(const CatalogSnapshot &snapshot) {
+    SchemaMetadata metadata;
+    metadata.snapshot = snapshot;
+    metadata.ranges = CatalogTableRanges::of(snapshot);
+    metadataCache.insert(snapshot.schema, metadata);
+}
+
+QFuture<QList<CatalogSnapshot>> DatabaseConnection::fetchCatalog() {
+    return runCatalogQuery<QList<CatalogSnapshot>>("catalog", [this](QSqlDatabase session) {
+        recheckServerVersions(session);
+
+        // Schemas missing or out of date are read together
+        QStringList outdated;
+        for (auto it = serverVersions.cbegin(); it != serverVersions.cend(); ++it) {
+            const auto cached = metadataCache.constFind(it.key());
+            if (cached == metadataCache.constEnd() || cached->snapshot.version != it.value()) {
+                outdated << it.key();
+            }
+        }
+        QList<CatalogSnapshot> snapshots;
+        if (!outdated.isEmpty() && readSnapshots(session, outdated, serverVersions, &snapshots)) {
+            for (const CatalogSnapshot &snapshot : std::as_const(snapshots)) {
+                storeSchemaMetadata(snapshot);
+            }
+        }
+
+        snapshots.clear();
+        for (auto it = metadataCache.cbegin(); it != metadataCache.cend(); ++it) {
+            if (serverVersions.isEmpty() || serverVersions.contains(it.key())) {
+                snapshots << it->snapshot;
+            }
+        }
+        return snapshots;
+    });
+}
+
+void DatabaseConnection::recheckServerVersions(QSqlDatabase session) {
+    if (serverVersionsAge.isValid() && serverVersionsAge.elapsed() <= kMetadataRecheckMs) {
+        return;
+    }
+    QHash<QString, QString> versions;
+    if (querySchemaVersions(session, &versions)) {
+        serverVersions = versions;
+        serverVersionsAge.start();
+    }
+}
+
+const DatabaseConnection::SchemaMetadata *DatabaseConnection::schemaMetadata(QSqlDatabase session,
+                                                                             const QString &schema) {
+    recheckServerVersions(session);
+
+    // Without versions the server couldn't be asked; serve what there is
+    const auto cached = metadataCache.constFind(schema);
+    if (cached != metadataCache.constEnd()
+        && (serverVersions.isEmpty() || cached->snapshot.version == serverVersions.value(schema))) {
+        return &cached.value();
+    }
+    if (!serverVersions.isEmpty() && !serverVersions.contains(schema)) {
+        return nullptr;
+    }
+
+    QList<CatalogSnapshot> snapshots;
+    if (!readSnapshots(session, {schema}, serverVersions, &snapshots)) {
+        return cached != metadataCache.constEnd() ? &cached.value() : nullptr;
+    }
+    storeSchemaMetadata(snapshots.first());
+    return &metadataCache.constFind(schema).value();
+}
+
+QString DatabaseConnection::defaultSchema() const {
+    switch (config.type) {
+        case DatabaseType::MySQL:
+            return config.database;
+        case DatabaseType::PostgreSQL:
+            return "public";
+        default:
+            return QString();
+    }
+}
+
+void CatalogSnapshot::shareStrings() {
+    QSet<QString> pool;
+    auto share = [&pool](QString &value) {
+        const auto it = pool.constFind(value);
+        if (it != pool.constEnd()) {
+            value = *it;
+        } else {
+            pool.insert(value);
+        }
+    };
+
+    for (RelationInfo &relation : relations) {
+        relation.schema = schema;
+        share(relation.name);
+    }
+    for (ColumnInfo &column : columns) {
+        column.schema = schema;
+        share(column.table);
+        share(column.dataType);
+    }
+    for (IndexInfo &index : indexes) {
+        index.schema = schema;
+        share(index.table);
+        for (QString &column : index.columns) {
+            share(column);
+        }
+    }
+    for (ForeignKeyInfo &foreignKey : foreignKeys) {
+        foreignKey.schema = schema;
+        share(foreignKey.table);
+        share(foreignKey.referencedSchema);
+        share(foreignKey.referencedTable);
+        for (QString &column : foreignKey.columns) {
+            share(column);
+        }
+        for (QString &column : foreignKey.referencedColumns) {
+            share(column);
+        }
+    }
+}
+
+QString DatabaseConnection::sqlStringList(const QStringList &values) const {
+    QStringList quoted;
+    for (QString value : values) {
+        value.replace('\'', "''");
+        if (config.type == DatabaseType::MySQL) {
+            value.replace('\\', "\\\\");
+        }
+        quoted << QString("'%1'").arg(value);
+    }
+    return QString("(%1)").arg(quoted.join(", "));
+}
+
+void DatabaseConnection::closeMetadataSession() {
+    cancelCatalogQueries();
+    // Sessions may only be closed on the thread that uses them
+    QtConcurrent::run(&metadataPool, [this, name = metadataConnectionName]() {
+        if (QSqlDatabase::contains(name)) {
+            QSqlDatabase::database(name, false).close();
+        }
+        metadataBackendId = -1;
+    });
+}
+
+void DatabaseConnection::stopMetadataThread() {
+    if (stopping.exchange(true)) {
+        return;
+    }
+    closeMetadataSession();
+    metadataPool.waitForDone();
+}
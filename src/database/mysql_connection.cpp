@@ -1,20 +1,73 @@
 #include "database/mysql_connection.h"
+#include <QRegularExpression>
+#include <QSet>
 #include <QSqlQuery>
 
+namespace {
+// COLUMN_DEFAULT holds the bare value of a literal default ("active", not 'active') and
+// the expression of an expression default, flagged DEFAULT_GENERATED in EXTRA on
+// MySQL 8. MariaDB 10.2.7+ already reports an SQL expression, and NULL as "NULL".
+QString defaultExpression(const QVariant &value, const QString &dataType, const QString &extra, bool mariaDb) {
+    if (value.isNull()) {
+        return QString();
+    }
+    const QString text = value.toString();
+    if (mariaDb) {
+        return text == "NULL" ? QString() : text;
+    }
+
+    static const QRegularExpression currentTime(R"(^(CURRENT_TIMESTAMP|LOCALTIMESTAMP|LOCALTIME|NOW)(\(\d*\))?$)",
+                                                QRegularExpression::CaseInsensitiveOption);
+    if (currentTime.match(text).hasMatch()) {
+        return text;
+    }
+    if (extra.contains("DEFAULT_GENERATED", Qt::CaseInsensitive)) {
+        return "(" + text + ")";
+    }
+    static const QSet<QString> numericTypes = {
+        "tinyint", "smallint", "mediumint", "int", "integer", "bigint", "decimal", "numeric",
+        "float", "double", "real", "bit", "year"
+    };
+    if (numericTypes.contains(dataType.toLower())) {
+        return text;
+    }
+    return "'" + QString(text).replace("\\", "\\\\").replace("'", "''") + "'";
+}
+
+// EXTRA as DDL, without the DEFAULT_GENERATED flag, which isn't syntax
+QString extraAttributes(const QString &extra, const QString &generationExpression) {
+    const QString attributes = QString(extra).remove("DEFAULT_GENERATED", Qt::CaseInsensitive).simplified();
+    if (attributes.contains("GENERATED", Qt::CaseInsensitive)) {
+        return QString("GENERATED ALWAYS AS (%1) %2")
+            .arg(generationExpression, attributes.startsWith("STORED", Qt::CaseInsensitive) ? "STORED" : "VIRTUAL");
+    }
+    return attributes.toUpper();
+}
+} // namespace
+
 MySQLConnection::MySQLConnection(const ConnectionConfig &config, QObject *parent)
     : DatabaseConnection(config, parent) {
 }
 
-bool MySQLConnection::connect() {
-    db = QSqlDatabase::addDatabase("QMYSQL", generateConnectionName());
-    db.setHostName(config.host);
-    db.setPort(config.port);
-    db.setUserName(config.username);
-    db.setPassword(config.password);
+MySQLConnection::~MySQLConnection() {
+    stopMetadataThread();
+}
+
+QSqlDatabase MySQLConnection::createSession(const QString &connectionName) const {
+    QSqlDatabase session = QSqlDatabase::addDatabase("QMYSQL", connectionName);
+    session.setHostName(config.host);
+    session.setPort(config.port);
+    session.setUserName(config.username);
+    session.setPassword(config.password);
 
     if (!config.database.isEmpty()) {
-        db.setDatabaseName(config.database);
+        session.setDatabaseName(config.database);
     }
+    return session;
+}
+
+bool MySQLConnection::connect() {
+    db = createSession(generateConnectionName());
 
     if (!db.open()) {
         lastError = db.lastError().text();
@@ -27,6 +80,7 @@ bool MySQLConnection::connect() {
 }
 
 void MySQLConnection::disconnect() {
+    closeMetadataSession();
     if (db.isOpen()) {
         db.close();
         emit disconnected();
@@ -37,9 +91,9 @@ bool MySQLConnection::isConnected() const {
     return db.isOpen();
 }
 
-QStringList MySQLConnection::getDatabases() {
+QStringList MySQLConnection::queryDatabases(QSqlDatabase session) {
     QStringList databases;
-    QSqlQuery query(db);
+    QSqlQuery query(session);
     query.exec("SHOW DATABASES");
 
     while (query.next()) {
@@ -54,59 +108,193 @@ QStringList MySQLConnection::getDatabases() {
     return databases;
 }
 
-QStringList MySQLConnection::getSchemas(const QString &database) {
+QStringList MySQLConnection::querySchemas(QSqlDatabase session, const QString &database) {
     // In MySQL, schemas and databases are the same
     Q_UNUSED(database);
-    return getDatabases();
+    return queryDatabases(session);
 }
 
-QStringList MySQLConnection::getTables(const QString &schema, const QString &database) {
-    QString dbName = database.isEmpty() ? schema : database;
+bool MySQLConnection::querySchemaVersions(QSqlDatabase session, QHash<QString, QString> *versions) {
+    QSqlQuery query(session);
+    query.setForwardOnly(true);
+
+    // Table count and newest CREATE_TIME catch added, dropped and rebuilt tables;
+    // checksums over COLUMNS, STATISTICS and KEY_COLUMN_USAGE catch in-place column,
+    // index and constraint changes. They cover every field the catalog reads, down to
+    // a changed default or an index turned unique (CONCAT_WS skips NULLs, so a flag
+    // keeps a NULL default apart from none).
+    if (!query.exec(
+            "SELECT s.SCHEMA_NAME, "
+            "CONCAT_WS('/', t.tables, t.created, c.columns, c.checksum, i.checksum, k.checksum) "
+            "FROM information_schema.SCHEMATA s "
+            "LEFT JOIN (SELECT TABLE_SCHEMA, COUNT(*) AS tables, MAX(CREATE_TIME) AS created "
+            "           FROM information_schema.TABLES GROUP BY TABLE_SCHEMA) t "
+            "  ON t.TABLE_SCHEMA = s.SCHEMA_NAME "
+            "LEFT JOIN (SELECT TABLE_SCHEMA, COUNT(*) AS columns, "
+            "                  SUM(CRC32(CONCAT_WS('.', TABLE_NAME, COLUMN_NAME, COLUMN_TYPE, IS_NULLABLE, "
+            "                                      ISNULL(COLUMN_DEFAULT), COLUMN_DEFAULT, EXTRA, "
+            "                                      GENERATION_EXPRESSION))) "
+            "                  AS checksum "
+            "           FROM information_schema.COLUMNS GROUP BY TABLE_SCHEMA) c "
+            "  ON c.TABLE_SCHEMA = s.SCHEMA_NAME "
+            "LEFT JOIN (SELECT TABLE_SCHEMA, SUM(CRC32(CONCAT_WS('.', TABLE_NAME, INDEX_NAME, COLUMN_NAME, "
+            "                                                    NON_UNIQUE, SEQ_IN_INDEX))) "
+            "                  AS checksum "
+            "           FROM information_schema.STATISTICS GROUP BY TABLE_SCHEMA) i "
+            "  ON i.TABLE_SCHEMA = s.SCHEMA_NAME "
+            "LEFT JOIN (SELECT TABLE_SCHEMA, SUM(CRC32(CONCAT_WS('.', TABLE_NAME, CONSTRAINT_NAME, COLUMN_NAME, "
+            "                                                    REFERENCED_TABLE_SCHEMA, REFERENCED_TABLE_NAME, "
+            "                                                    REFERENCED_COLUMN_NAME))) AS checksum "
+            "           FROM information_schema.KEY_COLUMN_USAGE GROUP BY TABLE_SCHEMA) k "
+            "  ON k.TABLE_SCHEMA = s.SCHEMA_NAME "
+            "WHERE s.SCHEMA_NAME NOT IN ('information_schema', 'performance_schema', 'mysql', 'sys')")) {
+        return false;
+    }
+
+    while (query.next()) {
+        versions->insert(query.value(0).toString(), query.value(1).toString());
+    }
+    return true;
+}
 
-    QStringList tables;
-    QSqlQuery query(db);
+bool MySQLConnection::queryRelations(QSqlDatabase session, const QStringList &schemas,
+                                     QList<RelationInfo> *relations) {
+    QSqlQuery query(session);
+    query.setForwardOnly(true);
 
-    if (dbName.isEmpty()) {
-        query.exec("SHOW TABLES");
+    // TABLE_ROWS is exact for MyISAM and an estimate for InnoDB
+    QString sql =
+        "SELECT TABLE_SCHEMA, TABLE_NAME, TABLE_TYPE, TABLE_ROWS, DATA_LENGTH + INDEX_LENGTH "
+        "FROM information_schema.TABLES ";
+    if (schemas.isEmpty()) {
+        sql += "WHERE TABLE_SCHEMA NOT IN ('information_schema', 'performance_schema', 'mysql', 'sys') ";
     } else {
-        query.exec(QString("SHOW TABLES FROM `%1`").arg(dbName));
+        sql += QString("WHERE TABLE_SCHEMA IN %1 ").arg(sqlStringList(schemas));
     }
+    sql += "ORDER BY TABLE_SCHEMA, TABLE_NAME";
 
-    while (query.next()) {
-        tables << query.value(0).toString();
+    if (!query.exec(sql)) {
+        return false;
     }
 
-    return tables;
+    while (query.next()) {
+        RelationInfo relation;
+        relation.schema = query.value(0).toString();
+        relation.name = query.value(1).toString();
+        if (query.value(2).toString() == "VIEW") {
+            relation.kind = RelationKind::View;
+        } else {
+            relation.kind = RelationKind::Table;
+            relation.estimatedRows = query.isNull(3) ? -1 : query.value(3).toLongLong();
+            relation.sizeBytes = query.isNull(4) ? -1 : query.value(4).toLongLong();
+        }
+        relations->append(relation);
+    }
+    return true;
 }
 
-QStringList MySQLConnection::getViews(const QString &schema, const QString &database) {
-    QString dbName = database.isEmpty() ? schema : database;
+bool MySQLConnection::queryColumns(QSqlDatabase session, const QStringList &schemas, QList<ColumnInfo> *columns) {
+    QSqlQuery query(session);
+    query.setForwardOnly(true);
 
-    QStringList views;
-    QSqlQuery query(db);
+    QString sql =
+        "SELECT TABLE_SCHEMA, TABLE_NAME, COLUMN_NAME, COLUMN_TYPE, IS_NULLABLE = 'YES', COLUMN_DEFAULT, "
+        "DATA_TYPE, EXTRA, GENERATION_EXPRESSION, VERSION() LIKE '%MariaDB%' "
+        "FROM information_schema.COLUMNS ";
+    if (schemas.isEmpty()) {
+        sql += "WHERE TABLE_SCHEMA NOT IN ('information_schema', 'performance_schema', 'mysql', 'sys') ";
+    } else {
+        sql += QString("WHERE TABLE_SCHEMA IN %1 ").arg(sqlStringList(schemas));
+    }
+    sql += "ORDER BY TABLE_SCHEMA, TABLE_NAME, ORDINAL_POSITION";
 
-    QString sql = QString(
-        "SELECT TABLE_NAME FROM information_schema.TABLES "
-        "WHERE TABLE_TYPE = 'VIEW'"
-    );
+    if (!query.exec(sql)) {
+        return false;
+    }
 
-    if (!dbName.isEmpty()) {
-        sql += QString(" AND TABLE_SCHEMA = '%1'").arg(dbName);
+    while (query.next()) {
+        ColumnInfo column;
+        column.schema = query.value(0).toString();
+        column.table = query.value(1).toString();
+        column.name = query.value(2).toString();
+        column.dataType = query.value(3).toString();
+        column.nullable = query.value(4).toBool();
+        const QString extra = query.value(7).toString();
+        column.defaultValue = defaultExpression(query.value(5), query.value(6).toString(), extra,
+                                                query.value(9).toBool());
+        column.extra = extraAttributes(extra, query.value(8).toString());
+        columns->append(column);
     }
+    return true;
+}
 
-    query.exec(sql);
+bool MySQLConnection::queryIndexes(QSqlDatabase session, const QStringList &schemas, QList<IndexInfo> *indexes) {
+    QSqlQuery query(session);
+    query.setForwardOnly(true);
 
-    while (query.next()) {
-        views << query.value(0).toString();
+    QString sql =
+        "SELECT TABLE_SCHEMA, TABLE_NAME, INDEX_NAME, NON_UNIQUE = 0, INDEX_NAME = 'PRIMARY', "
+        "GROUP_CONCAT(COLUMN_NAME ORDER BY SEQ_IN_INDEX SEPARATOR '\x1f') "
+        "FROM information_schema.STATISTICS ";
+    if (schemas.isEmpty()) {
+        sql += "WHERE TABLE_SCHEMA NOT IN ('information_schema', 'performance_schema', 'mysql', 'sys') ";
+    } else {
+        sql += QString("WHERE TABLE_SCHEMA IN %1 ").arg(sqlStringList(schemas));
+    }
+    sql += "GROUP BY TABLE_SCHEMA, TABLE_NAME, INDEX_NAME, NON_UNIQUE "
+           "ORDER BY TABLE_SCHEMA, TABLE_NAME, INDEX_NAME";
+
+    if (!query.exec(sql)) {
+        return false;
     }
 
-    return views;
+    while (query.next()) {
+        IndexInfo index;
+        index.schema = query.value(0).toString();
+        index.table = query.value(1).toString();
+        index.name = query.value(2).toString();
+        index.unique = query.value(3).toBool();
+        index.primary = query.value(4).toBool();
+        index.columns = query.value(5).toString().split(QChar(31), Qt::SkipEmptyParts);
+        indexes->append(index);
+    }
+    return true;
 }
 
-QStringList MySQLConnection::getSequences(const QString &schema, const QString &database) {
-    Q_UNUSED(schema);
-    Q_UNUSED(database);
+bool MySQLConnection::queryForeignKeys(QSqlDatabase session, const QStringList &schemas,
+                                       QList<ForeignKeyInfo> *foreignKeys) {
+    QSqlQuery query(session);
+    query.setForwardOnly(true);
+
+    QString sql =
+        "SELECT TABLE_SCHEMA, TABLE_NAME, CONSTRAINT_NAME, "
+        "GROUP_CONCAT(COLUMN_NAME ORDER BY ORDINAL_POSITION SEPARATOR '\x1f'), "
+        "REFERENCED_TABLE_SCHEMA, REFERENCED_TABLE_NAME, "
+        "GROUP_CONCAT(REFERENCED_COLUMN_NAME ORDER BY ORDINAL_POSITION SEPARATOR '\x1f') "
+        "FROM information_schema.KEY_COLUMN_USAGE "
+        "WHERE REFERENCED_TABLE_NAME IS NOT NULL ";
+    if (schemas.isEmpty()) {
+        sql += "AND TABLE_SCHEMA NOT IN ('information_schema', 'performance_schema', 'mysql', 'sys') ";
+    } else {
+        sql += QString("AND TABLE_SCHEMA IN %1 ").arg(sqlStringList(schemas));
+    }
+    sql += "GROUP BY TABLE_SCHEMA, TABLE_NAME, CONSTRAINT_NAME, REFERENCED_TABLE_SCHEMA, REFERENCED_TABLE_NAME "
+           "ORDER BY TABLE_SCHEMA, TABLE_NAME, CONSTRAINT_NAME";
+
+    if (!query.exec(sql)) {
+        return false;
+    }
 
-    // MySQL doesn't have sequences (uses AUTO_INCREMENT)
-    return QStringList();
+    while (query.next()) {
+        ForeignKeyInfo foreignKey;
+        foreignKey.schema = query.value(0).toString();
+        foreignKey.table = query.value(1).toString();
+        foreignKey.name = query.value(2).toString();
+        foreignKey.columns = query.value(3).toString().split(QChar(31), Qt::SkipEmptyParts);
+        foreignKey.referencedSchema = query.value(4).toString();
+        foreignKey.referencedTable = query.value(5).toString();
+        foreignKey.referencedColumns = query.value(6).toString().split(QChar(31), Qt::SkipEmptyParts);
+        foreignKeys->append(foreignKey);
+    }
+    return true;
 }
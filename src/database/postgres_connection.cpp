@@ -5,13 +5,22 @@ PostgresConnection::PostgresConnection(const ConnectionConfig &config, QObject *
     : DatabaseConnection(config, parent) {
 }
 
+PostgresConnection::~PostgresConnection() {
+    stopMetadataThread();
+}
+
+QSqlDatabase PostgresConnection::createSession(const QString &connectionName) const {
+    QSqlDatabase session = QSqlDatabase::addDatabase("QPSQL", connectionName);
+    session.setHostName(config.host);
+    session.setPort(config.port);
+    session.setDatabaseName(config.database.isEmpty() ? "postgres" : config.database);
+    session.setUserName(config.username);
+    session.setPassword(config.password);
+    return session;
+}
+
 bool PostgresConnection::connect() {
-    db = QSqlDatabase::addDatabase("QPSQL", generateConnectionName());
-    db.setHostName(config.host);
-    db.setPort(config.port);
-    db.setDatabaseName(config.database.isEmpty() ? "postgres" : config.database);
-    db.setUserName(config.username);
-    db.setPassword(config.password);
+    db = createSession(generateConnectionName());
 
     if (!db.open()) {
         lastError = db.lastError().text();
@@ -24,6 +33,7 @@ bool PostgresConnection::connect() {
 }
 
 void PostgresConnection::disconnect() {
+    closeMetadataSession();
     if (db.isOpen()) {
         db.close();
         emit disconnected();
@@ -34,9 +44,9 @@ bool PostgresConnection::isConnected() const {
     return db.isOpen();
 }
 
-QStringList PostgresConnection::getDatabases() {
+QStringList PostgresConnection::queryDatabases(QSqlDatabase session) {
     QStringList databases;
-    QSqlQuery query(db);
+    QSqlQuery query(session);
     query.exec("SELECT datname FROM pg_database WHERE datistemplate = false ORDER BY datname");
 
     while (query.next()) {
@@ -46,11 +56,11 @@ QStringList PostgresConnection::getDatabases() {
     return databases;
 }
 
-QStringList PostgresConnection::getSchemas(const QString &database) {
+QStringList PostgresConnection::querySchemas(QSqlDatabase session, const QString &database) {
     Q_UNUSED(database);
 
     QStringList schemas;
-    QSqlQuery query(db);
+    QSqlQuery query(session);
     query.exec(
         "SELECT schema_name FROM information_schema.schemata "
         "WHERE schema_name NOT LIKE 'pg_%' AND schema_name != 'information_schema' "
@@ -64,72 +74,203 @@ QStringList PostgresConnection::getSchemas(const QString &database) {
     return schemas;
 }
 
-QStringList PostgresConnection::getTables(const QString &schema, const QString &database) {
-    Q_UNUSED(database);
+bool PostgresConnection::querySchemaVersions(QSqlDatabase session, QHash<QString, QString> *versions) {
+    QSqlQuery query(session);
+    query.setForwardOnly(true);
 
-    QStringList tables;
-    QSqlQuery query(db);
+    // Every DDL statement writes catalog rows with a new xmin, and drops change the
+    // counts, so per-namespace counts and newest xmins of pg_class and pg_constraint
+    // move with any change (VACUUM and ANALYZE update pg_class in place, keeping xmin).
+    // Column renames and defaults only touch pg_attribute, which is read per relation
+    // through its index and skipped for partitions, whose columns follow the parent:
+    // aggregating all of it costs too much with many partitions.
+    if (!query.exec(
+            "SELECT n.nspname, COALESCE(r.version, '0') || '/' || COALESCE(k.version, '0') "
+            "FROM pg_namespace n LEFT JOIN ("
+            "  SELECT c.relnamespace, count(*) || '/' || max(c.xmin::text::bigint) || '/' "
+            "         || COALESCE(sum(a.columns), 0) || '/' || COALESCE(max(a.xmin), 0) AS version "
+            "  FROM pg_class c LEFT JOIN LATERAL ("
+            "    SELECT count(*) AS columns, max(xmin::text::bigint) AS xmin FROM pg_attribute "
+            "    WHERE attrelid = c.oid AND attnum > 0 "
+            "      AND c.relkind IN ('r', 'p', 'f', 'v', 'm') AND NOT c.relispartition"
+            "  ) a ON true "
+            "  GROUP BY c.relnamespace"
+            ") r ON r.relnamespace = n.oid "
+            "LEFT JOIN ("
+            "  SELECT connamespace, count(*) || '/' || max(xmin::text::bigint) AS version "
+            "  FROM pg_constraint GROUP BY connamespace"
+            ") k ON k.connamespace = n.oid "
+            "WHERE n.nspname NOT LIKE 'pg_%' AND n.nspname != 'information_schema'")) {
+        return false;
+    }
 
-    QString sql = "SELECT tablename FROM pg_tables";
-    if (!schema.isEmpty()) {
-        sql += QString(" WHERE schemaname = '%1'").arg(schema);
+    while (query.next()) {
+        versions->insert(query.value(0).toString(), query.value(1).toString());
+    }
+    return true;
+}
+
+bool PostgresConnection::queryRelations(QSqlDatabase session, const QStringList &schemas,
+                                        QList<RelationInfo> *relations) {
+    QSqlQuery query(session);
+    query.setForwardOnly(true);
+
+    // Sizes come from relpages so the catalog alone answers, without touching files
+    QString sql =
+        "SELECT n.nspname, c.relname, c.relkind, c.reltuples::bigint, "
+        "c.relpages::bigint * current_setting('block_size')::bigint "
+        "FROM pg_class c JOIN pg_namespace n ON n.oid = c.relnamespace "
+        "WHERE c.relkind IN ('r', 'p', 'f', 'v', 'm', 'S') ";
+    if (schemas.isEmpty()) {
+        sql += "AND n.nspname NOT LIKE 'pg_%' AND n.nspname != 'information_schema' ";
     } else {
-        sql += " WHERE schemaname NOT IN ('pg_catalog', 'information_schema')";
+        sql += QString("AND n.nspname IN %1 ").arg(sqlStringList(schemas));
     }
-    sql += " ORDER BY tablename";
+    sql += "ORDER BY n.nspname, c.relname";
 
-    query.exec(sql);
+    if (!query.exec(sql)) {
+        return false;
+    }
 
     while (query.next()) {
-        tables << query.value(0).toString();
+        RelationInfo relation;
+        relation.schema = query.value(0).toString();
+        relation.name = query.value(1).toString();
+        const QString kind = query.value(2).toString();
+        if (kind == "v" || kind == "m") {
+            relation.kind = RelationKind::View;
+        } else if (kind == "S") {
+            relation.kind = RelationKind::Sequence;
+        } else {
+            relation.kind = RelationKind::Table;
+            // reltuples is -1 until the table is first analyzed (PostgreSQL 14+)
+            const qint64 rows = query.value(3).toLongLong();
+            relation.estimatedRows = rows >= 0 ? rows : -1;
+            // Foreign tables keep no pages of their own
+            relation.sizeBytes = kind == "f" ? -1 : query.value(4).toLongLong();
+        }
+        relations->append(relation);
     }
-
-    return tables;
+    return true;
 }
 
-QStringList PostgresConnection::getViews(const QString &schema, const QString &database) {
-    Q_UNUSED(database);
+bool PostgresConnection::queryColumns(QSqlDatabase session, const QStringList &schemas, QList<ColumnInfo> *columns) {
+    QSqlQuery query(session);
+    query.setForwardOnly(true);
 
-    QStringList views;
-    QSqlQuery query(db);
-
-    QString sql = "SELECT viewname FROM pg_views";
-    if (!schema.isEmpty()) {
-        sql += QString(" WHERE schemaname = '%1'").arg(schema);
+    // pg_attribute rather than information_schema.columns, which is slow on large catalogs
+    QString sql =
+        "SELECT n.nspname, c.relname, a.attname, format_type(a.atttypid, a.atttypmod), "
+        "NOT a.attnotnull, pg_get_expr(d.adbin, d.adrelid) "
+        "FROM pg_attribute a "
+        "JOIN pg_class c ON c.oid = a.attrelid "
+        "JOIN pg_namespace n ON n.oid = c.relnamespace "
+        "LEFT JOIN pg_attrdef d ON d.adrelid = a.attrelid AND d.adnum = a.attnum "
+        "WHERE a.attnum > 0 AND NOT a.attisdropped AND c.relkind IN ('r', 'p', 'v', 'm', 'f') ";
+    if (schemas.isEmpty()) {
+        sql += "AND n.nspname NOT LIKE 'pg_%' AND n.nspname != 'information_schema' ";
     } else {
-        sql += " WHERE schemaname NOT IN ('pg_catalog', 'information_schema')";
+        sql += QString("AND n.nspname IN %1 ").arg(sqlStringList(schemas));
     }
-    sql += " ORDER BY viewname";
+    sql += "ORDER BY n.nspname, c.relname, a.attnum";
 
-    query.exec(sql);
+    if (!query.exec(sql)) {
+        return false;
+    }
 
     while (query.next()) {
-        views << query.value(0).toString();
+        ColumnInfo column;
+        column.schema = query.value(0).toString();
+        column.table = query.value(1).toString();
+        column.name = query.value(2).toString();
+        column.dataType = query.value(3).toString();
+        column.nullable = query.value(4).toBool();
+        column.defaultValue = query.value(5).toString();
+        columns->append(column);
     }
-
-    return views;
+    return true;
 }
 
-QStringList PostgresConnection::getSequences(const QString &schema, const QString &database) {
-    Q_UNUSED(database);
-
-    QStringList sequences;
-    QSqlQuery query(db);
+bool PostgresConnection::queryIndexes(QSqlDatabase session, const QStringList &schemas, QList<IndexInfo> *indexes) {
+    QSqlQuery query(session);
+    query.setForwardOnly(true);
 
+    // pg_get_indexdef gives the column name, or the expression, of each index key
     QString sql =
-        "SELECT sequence_name FROM information_schema.sequences";
-    if (!schema.isEmpty()) {
-        sql += QString(" WHERE sequence_schema = '%1'").arg(schema);
+        "SELECT n.nspname, t.relname, i.relname, ix.indisunique, ix.indisprimary, "
+        "array_to_string(ARRAY(SELECT pg_get_indexdef(ix.indexrelid, k, true) "
+        "FROM generate_series(1, ix.indnatts) k), chr(31)), "
+        "EXISTS (SELECT 1 FROM pg_constraint con WHERE con.conindid = ix.indexrelid "
+        "        AND con.conrelid = ix.indrelid AND con.contype IN ('p', 'u', 'x')) "
+        "FROM pg_index ix "
+        "JOIN pg_class i ON i.oid = ix.indexrelid "
+        "JOIN pg_class t ON t.oid = ix.indrelid "
+        "JOIN pg_namespace n ON n.oid = t.relnamespace ";
+    if (schemas.isEmpty()) {
+        sql += "WHERE n.nspname NOT LIKE 'pg_%' AND n.nspname != 'information_schema' ";
     } else {
-        sql += " WHERE sequence_schema NOT IN ('pg_catalog', 'information_schema')";
+        sql += QString("WHERE n.nspname IN %1 ").arg(sqlStringList(schemas));
     }
-    sql += " ORDER BY sequence_name";
+    sql += "ORDER BY n.nspname, t.relname, i.relname";
 
-    query.exec(sql);
+    if (!query.exec(sql)) {
+        return false;
+    }
 
     while (query.next()) {
-        sequences << query.value(0).toString();
+        IndexInfo index;
+        index.schema = query.value(0).toString();
+        index.table = query.value(1).toString();
+        index.name = query.value(2).toString();
+        index.unique = query.value(3).toBool();
+        index.primary = query.value(4).toBool();
+        index.columns = query.value(5).toString().split(QChar(31), Qt::SkipEmptyParts);
+        index.constraint = query.value(6).toBool();
+        indexes->append(index);
     }
+    return true;
+}
+
+bool PostgresConnection::queryForeignKeys(QSqlDatabase session, const QStringList &schemas,
+                                          QList<ForeignKeyInfo> *foreignKeys) {
+    QSqlQuery query(session);
+    query.setForwardOnly(true);
 
-    return sequences;
+    // conkey and confkey pair up position by position
+    QString sql =
+        "SELECT n.nspname, t.relname, con.conname, "
+        "array_to_string(ARRAY(SELECT a.attname FROM unnest(con.conkey) WITH ORDINALITY k(attnum, pos) "
+        "  JOIN pg_attribute a ON a.attrelid = con.conrelid AND a.attnum = k.attnum ORDER BY k.pos), chr(31)), "
+        "rn.nspname, r.relname, "
+        "array_to_string(ARRAY(SELECT a.attname FROM unnest(con.confkey) WITH ORDINALITY k(attnum, pos) "
+        "  JOIN pg_attribute a ON a.attrelid = con.confrelid AND a.attnum = k.attnum ORDER BY k.pos), chr(31)) "
+        "FROM pg_constraint con "
+        "JOIN pg_class t ON t.oid = con.conrelid "
+        "JOIN pg_namespace n ON n.oid = t.relnamespace "
+        "JOIN pg_class r ON r.oid = con.confrelid "
+        "JOIN pg_namespace rn ON rn.oid = r.relnamespace "
+        "WHERE con.contype = 'f' ";
+    if (schemas.isEmpty()) {
+        sql += "AND n.nspname NOT LIKE 'pg_%' AND n.nspname != 'information_schema' ";
+    } else {
+        sql += QString("AND n.nspname IN %1 ").arg(sqlStringList(schemas));
+    }
+    sql += "ORDER BY n.nspname, t.relname, con.conname";
+
+    if (!query.exec(sql)) {
+        return false;
+    }
+
+    while (query.next()) {
+        ForeignKeyInfo foreignKey;
+        foreignKey.schema = query.value(0).toString();
+        foreignKey.table = query.value(1).toString();
+        foreignKey.name = query.value(2).toString();
+        foreignKey.columns = query.value(3).toString().split(QChar(31), Qt::SkipEmptyParts);
+        foreignKey.referencedSchema = query.value(4).toString();
+        foreignKey.referencedTable = query.value(5).toString();
+        foreignKey.referencedColumns = query.value(6).toString().split(QChar(31), Qt::SkipEmptyParts);
+        foreignKeys->append(foreignKey);
+    }
+    return true;
 }
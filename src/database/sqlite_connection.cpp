@@ -5,9 +5,21 @@ SQLiteConnection::SQLiteConnection(const ConnectionConfig &config, QObject *pare
     : DatabaseConnection(config, parent) {
 }
 
+SQLiteConnection::~SQLiteConnection() {
+    stopMetadataThread();
+}
+
+QSqlDatabase SQLiteConnection::createSession(const QString &connectionName) const {
+    QSqlDatabase session = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+    session.setDatabaseName(config.filePath);
+    if (config.filePath.startsWith("file:")) {
+        session.setConnectOptions("QSQLITE_OPEN_URI");
+    }
+    return session;
+}
+
 bool SQLiteConnection::connect() {
-    db = QSqlDatabase::addDatabase("QSQLITE", generateConnectionName());
-    db.setDatabaseName(config.filePath);
+    db = createSession(generateConnectionName());
 
     if (!db.open()) {
         lastError = db.lastError().text();
@@ -20,6 +32,7 @@ bool SQLiteConnection::connect() {
 }
 
 void SQLiteConnection::disconnect() {
+    closeMetadataSession();
     if (db.isOpen()) {
         db.close();
         emit disconnected();
@@ -30,51 +43,141 @@ bool SQLiteConnection::isConnected() const {
     return db.isOpen();
 }
 
-QStringList SQLiteConnection::getDatabases() {
+QStringList SQLiteConnection::queryDatabases(QSqlDatabase session) {
+    Q_UNUSED(session);
     // SQLite has only one database per file
     return QStringList() << config.filePath;
 }
 
-QStringList SQLiteConnection::getSchemas(const QString &database) {
+QStringList SQLiteConnection::querySchemas(QSqlDatabase session, const QString &database) {
     // SQLite doesn't have schemas
+    Q_UNUSED(session);
     Q_UNUSED(database);
     return QStringList();
 }
 
-QStringList SQLiteConnection::getTables(const QString &schema, const QString &database) {
-    Q_UNUSED(schema);
-    Q_UNUSED(database);
+bool SQLiteConnection::querySchemaVersions(QSqlDatabase session, QHash<QString, QString> *versions) {
+    // schema_version is bumped by every schema change to the file
+    QSqlQuery query(session);
+    if (!query.exec("PRAGMA schema_version") || !query.next()) {
+        return false;
+    }
+    versions->insert(QString(), query.value(0).toString());
+    return true;
+}
 
-    QStringList tables;
-    QSqlQuery query(db);
-    query.exec("SELECT name FROM sqlite_master WHERE type='table' AND name NOT LIKE 'sqlite_%' ORDER BY name");
+bool SQLiteConnection::queryRelations(QSqlDatabase session, const QStringList &schemas,
+                                      QList<RelationInfo> *relations) {
+    Q_UNUSED(schemas);
 
-    while (query.next()) {
-        tables << query.value(0).toString();
+    QSqlQuery query(session);
+    query.setForwardOnly(true);
+
+    // SQLite keeps no row or size statistics worth showing
+    if (!query.exec(
+            "SELECT name, type FROM sqlite_master "
+            "WHERE (type = 'table' AND name NOT LIKE 'sqlite_%') OR type = 'view' "
+            "ORDER BY name")) {
+        return false;
     }
 
-    return tables;
+    while (query.next()) {
+        RelationInfo relation;
+        relation.name = query.value(0).toString();
+        relation.kind = query.value(1).toString() == "view" ? RelationKind::View : RelationKind::Table;
+        relations->append(relation);
+    }
+    return true;
 }
 
-QStringList SQLiteConnection::getViews(const QString &schema, const QString &database) {
-    Q_UNUSED(schema);
-    Q_UNUSED(database);
+bool SQLiteConnection::queryColumns(QSqlDatabase session, const QStringList &schemas, QList<ColumnInfo> *columns) {
+    Q_UNUSED(schemas);
+
+    QSqlQuery query(session);
+    query.setForwardOnly(true);
 
-    QStringList views;
-    QSqlQuery query(db);
-    query.exec("SELECT name FROM sqlite_master WHERE type='view' ORDER BY name");
+    // Table-valued pragmas (SQLite 3.16+) read every table's columns in one statement
+    if (!query.exec(
+            "SELECT m.name, p.name, p.type, p.\"notnull\" = 0, p.dflt_value "
+            "FROM sqlite_master m JOIN pragma_table_info(m.name) p "
+            "WHERE m.type IN ('table', 'view') AND m.name NOT LIKE 'sqlite_%' "
+            "ORDER BY m.name, p.cid")) {
+        return false;
+    }
 
     while (query.next()) {
-        views << query.value(0).toString();
+        ColumnInfo column;
+        column.table = query.value(0).toString();
+        column.name = query.value(1).toString();
+        column.dataType = query.value(2).toString();
+        column.nullable = query.value(3).toBool();
+        column.defaultValue = query.value(4).toString();
+        columns->append(column);
+    }
+    return true;
+}
+
+bool SQLiteConnection::queryIndexes(QSqlDatabase session, const QStringList &schemas, QList<IndexInfo> *indexes) {
+    Q_UNUSED(schemas);
+
+    QSqlQuery query(session);
+    query.setForwardOnly(true);
+
+    if (!query.exec(
+            "SELECT m.name, l.name, l.\"unique\", l.origin = 'pk', "
+            "(SELECT group_concat(COALESCE(i.name, '<expression>'), char(31)) "
+            " FROM (SELECT name FROM pragma_index_info(l.name) ORDER BY seqno) i) "
+            "FROM sqlite_master m JOIN pragma_index_list(m.name) l "
+            "WHERE m.type = 'table' AND m.name NOT LIKE 'sqlite_%' "
+            "ORDER BY m.name, l.name")) {
+        return false;
     }
 
-    return views;
+    while (query.next()) {
+        IndexInfo index;
+        index.table = query.value(0).toString();
+        index.name = query.value(1).toString();
+        index.unique = query.value(2).toBool();
+        index.primary = query.value(3).toBool();
+        index.columns = query.value(4).toString().split(QChar(31), Qt::SkipEmptyParts);
+        indexes->append(index);
+    }
+    return true;
 }
 
-QStringList SQLiteConnection::getSequences(const QString &schema, const QString &database) {
-    Q_UNUSED(schema);
-    Q_UNUSED(database);
+bool SQLiteConnection::queryForeignKeys(QSqlDatabase session, const QStringList &schemas,
+                                        QList<ForeignKeyInfo> *foreignKeys) {
+    Q_UNUSED(schemas);
 
-    // SQLite doesn't have sequences in the traditional sense
-    return QStringList();
+    QSqlQuery query(session);
+    query.setForwardOnly(true);
+
+    // Each row of pragma_foreign_key_list is one column pair and id groups them. "to"
+    // is NULL when the key refers to the parent's primary key without naming it.
+    if (!query.exec(
+            "SELECT m.name, f.id, f.\"table\", f.\"from\", f.\"to\" "
+            "FROM sqlite_master m JOIN pragma_foreign_key_list(m.name) f "
+            "WHERE m.type = 'table' AND m.name NOT LIKE 'sqlite_%' "
+            "ORDER BY m.name, f.id, f.seq")) {
+        return false;
+    }
+
+    QString table;
+    int id = -1;
+    while (query.next()) {
+        if (foreignKeys->isEmpty() || query.value(0).toString() != table || query.value(1).toInt() != id) {
+            table = query.value(0).toString();
+            id = query.value(1).toInt();
+            ForeignKeyInfo foreignKey;
+            foreignKey.table = table;
+            foreignKey.referencedTable = query.value(2).toString();
+            foreignKeys->append(foreignKey);
+        }
+        ForeignKeyInfo &foreignKey = foreignKeys->last();
+        foreignKey.columns << query.value(3).toString();
+        if (!query.value(4).isNull()) {
+            foreignKey.referencedColumns << query.value(4).toString();
+        }
+    }
+    return true;
 }
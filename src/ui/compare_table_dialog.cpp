@@ -0,0 +1,91 @@
+#include "ui/compare_table_dialog.h"
+#include "database/connection_manager.h"
+#include <QFormLayout>
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QLabel>
+
+CompareTableDialog::CompareTableDialog(const QString &sourceConnection, const QString &sourceTable, QWidget *parent)
+    : QDialog(parent), sourceConnection(sourceConnection), sourceTable(sourceTable) {
+    setupUI();
+    setWindowTitle("Compare Table Data");
+    resize(440, 0);
+}
+
+void CompareTableDialog::setupUI() {
+    auto *mainLayout = new QVBoxLayout(this);
+
+    mainLayout->addWidget(new QLabel(QString("Compare %1 on %2 with:").arg(sourceTable, sourceConnection), this));
+
+    auto *formLayout = new QFormLayout();
+
+    targetConnectionCombo = new QComboBox(this);
+    for (DatabaseConnection *conn : ConnectionManager::instance().getAllConnections()) {
+        if (conn->isConnected() && !conn->isScratchpad()) {
+            targetConnectionCombo->addItem(conn->getName());
+        }
+    }
+    // The usual question is whether a replica or migrated copy matches
+    const int other = targetConnectionCombo->findText(sourceConnection) == 0 ? 1 : 0;
+    if (other < targetConnectionCombo->count()) {
+        targetConnectionCombo->setCurrentIndex(other);
+    }
+    formLayout->addRow("Target connection:", targetConnectionCombo);
+
+    targetTableEdit = new QLineEdit(sourceTable, this);
+    formLayout->addRow("Target table:", targetTableEdit);
+
+    workersSpin = new QSpinBox(this);
+    workersSpin->setRange(1, 32);
+    workersSpin->setValue(TableCompareOptions().workers);
+    workersSpin->setToolTip("Key ranges checksummed at once, each with one session per side");
+    formLayout->addRow("Parallel ranges:", workersSpin);
+
+    loadSpin = new QSpinBox(this);
+    loadSpin->setRange(5, 100);
+    loadSpin->setSingleStep(5);
+    loadSpin->setSuffix(" %");
+    loadSpin->setValue(TableCompareOptions().loadPercent);
+    loadSpin->setToolTip("Share of time each session spends running queries; "
+                         "it pauses for the rest to spare production servers");
+    formLayout->addRow("Server load:", loadSpin);
+
+    mainLayout->addLayout(formLayout);
+
+    connect(targetConnectionCombo, &QComboBox::currentTextChanged, this, &CompareTableDialog::updateButtons);
+    connect(targetTableEdit, &QLineEdit::textChanged, this, &CompareTableDialog::updateButtons);
+
+    // Buttons
+    auto *buttonLayout = new QHBoxLayout();
+    buttonLayout->addStretch();
+
+    cancelButton = new QPushButton("Cancel", this);
+    connect(cancelButton, &QPushButton::clicked, this, &QDialog::reject);
+    buttonLayout->addWidget(cancelButton);
+
+    okButton = new QPushButton("Compare", this);
+    okButton->setDefault(true);
+    connect(okButton, &QPushButton::clicked, this, &QDialog::accept);
+    buttonLayout->addWidget(okButton);
+
+    mainLayout->addLayout(buttonLayout);
+
+    updateButtons();
+}
+
+void CompareTableDialog::updateButtons() {
+    const QString targetTable = targetTableEdit->text().trimmed();
+    const bool sameTable = targetConnectionCombo->currentText() == sourceConnection && targetTable == sourceTable;
+    okButton->setEnabled(targetConnectionCombo->count() > 0 && !targetTable.isEmpty() && !sameTable);
+}
+
+TableCompareOptions CompareTableDialog::getCompareOptions() const {
+    TableCompareOptions options;
+    options.sourceConnection = sourceConnection;
+    options.sourceTable = sourceTable;
+    options.targetConnection = targetConnectionCombo->currentText();
+    options.targetTable = targetTableEdit->text().trimmed();
+    options.workers = workersSpin->value();
+    options.loadPercent = loadSpin->value();
+    return options;
+}
@@ -0,0 +1,96 @@
+#include "ui/connection_group_dialog.h"
+#include "database/connection_manager.h"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QLabel>
+
+ConnectionGroupDialog::ConnectionGroupDialog(const QString &initialConnection, QWidget *parent)
+    : QDialog(parent) {
+    setupUI(initialConnection);
+    setWindowTitle("Run on Connection Group");
+    resize(420, 480);
+}
+
+void ConnectionGroupDialog::setupUI(const QString &initialConnection) {
+    auto *mainLayout = new QVBoxLayout(this);
+
+    mainLayout->addWidget(new QLabel("Connections:", this));
+
+    // Preselect every connection of the same type as the one the dialog was opened on,
+    // which is usually the shard/replica set the user wants
+    DatabaseConnection *initial = ConnectionManager::instance().getConnection(initialConnection);
+
+    connectionList = new QListWidget(this);
+    for (DatabaseConnection *conn : ConnectionManager::instance().getAllConnections()) {
+        if (conn->isScratchpad()) {
+            continue;
+        }
+        auto *item = new QListWidgetItem(conn->getName(), connectionList);
+        item->setFlags(item->flags() | Qt::ItemIsUserCheckable);
+        const bool preselect = initial && conn->getType() == initial->getType();
+        item->setCheckState(preselect ? Qt::Checked : Qt::Unchecked);
+    }
+    connect(connectionList, &QListWidget::itemChanged, this, &ConnectionGroupDialog::updateOkButton);
+    mainLayout->addWidget(connectionList, 1);
+
+    auto *selectLayout = new QHBoxLayout();
+    auto *selectAllButton = new QPushButton("Select All", this);
+    connect(selectAllButton, &QPushButton::clicked, this, [this]() { setAllChecked(true); });
+    auto *selectNoneButton = new QPushButton("Select None", this);
+    connect(selectNoneButton, &QPushButton::clicked, this, [this]() { setAllChecked(false); });
+    selectLayout->addWidget(selectAllButton);
+    selectLayout->addWidget(selectNoneButton);
+    selectLayout->addStretch();
+    mainLayout->addLayout(selectLayout);
+
+    auto *concurrencyLayout = new QHBoxLayout();
+    concurrencyLayout->addWidget(new QLabel("Max concurrent connections:", this));
+    concurrencySpin = new QSpinBox(this);
+    concurrencySpin->setRange(1, 64);
+    concurrencySpin->setValue(kDefaultConcurrency);
+    concurrencyLayout->addWidget(concurrencySpin);
+    concurrencyLayout->addStretch();
+    mainLayout->addLayout(concurrencyLayout);
+
+    // Buttons
+    auto *buttonLayout = new QHBoxLayout();
+    buttonLayout->addStretch();
+
+    cancelButton = new QPushButton("Cancel", this);
+    connect(cancelButton, &QPushButton::clicked, this, &QDialog::reject);
+    buttonLayout->addWidget(cancelButton);
+
+    okButton = new QPushButton("Open Editor", this);
+    okButton->setDefault(true);
+    connect(okButton, &QPushButton::clicked, this, &QDialog::accept);
+    buttonLayout->addWidget(okButton);
+
+    mainLayout->addLayout(buttonLayout);
+
+    updateOkButton();
+}
+
+QStringList ConnectionGroupDialog::getSelectedConnections() const {
+    QStringList names;
+    for (int i = 0; i < connectionList->count(); ++i) {
+        QListWidgetItem *item = connectionList->item(i);
+        if (item->checkState() == Qt::Checked) {
+            names.append(item->text());
+        }
+    }
+    return names;
+}
+
+int ConnectionGroupDialog::getMaxConcurrency() const {
+    return concurrencySpin->value();
+}
+
+void ConnectionGroupDialog::setAllChecked(bool checked) {
+    for (int i = 0; i < connectionList->count(); ++i) {
+        connectionList->item(i)->setCheckState(checked ? Qt::Checked : Qt::Unchecked);
+    }
+}
+
+void ConnectionGroupDialog::updateOkButton() {
+    okButton->setEnabled(!getSelectedConnections().isEmpty());
+}
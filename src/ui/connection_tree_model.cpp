@@ -1,421 +1,1107 @@
 #include "ui/connection_tree_model.h"
 #include "database/connection_manager.h"
+#include "core/catalog_cache.h"
 #include <QIcon>
+#include <QLocale>
 #include <QtConcurrent>
 #include <QFutureWatcher>
-#include <QPainter>
-#include <QPixmap>
-#include <QVariant>
-
-namespace {
-constexpr int kSpinnerOriginalIconRole = Qt::UserRole + 1024;
-}
+#include <algorithm>
 
 ConnectionTreeModel::ConnectionTreeModel(QObject *parent)
-    : QStandardItemModel(parent) {
-    setHorizontalHeaderLabels({"Connections"});
-
+    : QAbstractItemModel(parent), root(new Node(TreeItemType::Connection, QString())) {
     // Create reusable spinner icon
     spinnerIcon = new SpinnerIcon(this);
-    connect(spinnerIcon, &SpinnerIcon::iconUpdated, this, [this](const QIcon &icon) {
-        // Update all spinning items with the new icon frame
-        for (auto it = spinningItems.begin(); it != spinningItems.end(); ++it) {
-            TreeItem *item = it.key();
-            item->setIcon(icon);
+    connect(spinnerIcon, &SpinnerIcon::iconUpdated, this, [this](const QIcon &) {
+        // Repaint all spinning rows with the new icon frame
+        for (Node *node : std::as_const(spinningNodes)) {
+            const QModelIndex nodeIndex = indexOf(node);
+            if (node->busy) {
+                emit dataChanged(nodeIndex, nodeIndex, {Qt::DecorationRole});
+            }
+            if (node->placeholderBusy && !node->placeholder.isEmpty()) {
+                const QModelIndex placeholderIndex = index(0, 0, nodeIndex);
+                emit dataChanged(placeholderIndex, placeholderIndex, {Qt::DecorationRole});
+            }
         }
     });
 }
 
+ConnectionTreeModel::~ConnectionTreeModel() {
+    delete root;
+}
+
+// QAbstractItemModel
+//
+// An index's internal pointer is the node of its parent; the row then picks a child
+// node, a folder leaf or the status row. Rows under an expanded table hang off the
+// table's node, which folder->tables holds rather than folder->children.
+
+QModelIndex ConnectionTreeModel::index(int row, int column, const QModelIndex &parent) const {
+    if (column != 0 || row < 0) {
+        return QModelIndex();
+    }
+    Node *parentNode = parent.isValid() ? nodeAt(parent) : root;
+    if (!parentNode || row >= rowCountOf(parentNode)) {
+        return QModelIndex();
+    }
+    return createIndex(row, 0, parentNode);
+}
+
+QModelIndex ConnectionTreeModel::parent(const QModelIndex &child) const {
+    if (!child.isValid()) {
+        return QModelIndex();
+    }
+    auto *parentNode = static_cast<Node*>(child.internalPointer());
+    return indexOf(parentNode);
+}
+
+int ConnectionTreeModel::rowCount(const QModelIndex &parent) const {
+    if (parent.column() > 0) {
+        return 0;
+    }
+    Node *node = parent.isValid() ? nodeAt(parent) : root;
+    return node ? rowCountOf(node) : 0;
+}
+
+int ConnectionTreeModel::columnCount(const QModelIndex &) const {
+    return 1;
+}
+
+bool ConnectionTreeModel::hasChildren(const QModelIndex &parent) const {
+    if (!parent.isValid()) {
+        return !root->children.isEmpty();
+    }
+    Node *node = nodeAt(parent);
+    if (isExpandableLeaf(parent)) {
+        return !node || !node->loaded || !node->children.isEmpty();
+    }
+    if (!node) {
+        return false;
+    }
+    if (node->type == TreeItemType::Connection) {
+        return true;
+    }
+    // Folders that haven't been opened yet might hold something
+    if (node->isFolder() && !node->loaded) {
+        return true;
+    }
+    return rowCountOf(node) > 0 || node->leaves.size() > node->fetched;
+}
+
+QVariant ConnectionTreeModel::data(const QModelIndex &index, int role) const {
+    if (!index.isValid()) {
+        return QVariant();
+    }
+    auto *parentNode = static_cast<Node*>(index.internalPointer());
+
+    if (!parentNode->placeholder.isEmpty()) {
+        switch (role) {
+            case Qt::DisplayRole:
+                return parentNode->placeholder;
+            case Qt::DecorationRole:
+                return parentNode->placeholderBusy ? QVariant(spinnerIcon->getIcon()) : QVariant();
+            default:
+                return QVariant();
+        }
+    }
+
+    if (parentNode->isFolder()) {
+        const RelationInfo &relation = parentNode->relations.at(parentNode->leaves.at(index.row()));
+        switch (role) {
+            case Qt::DisplayRole:
+                return relation.name;
+            case Qt::DecorationRole:
+                return getIconForType(relation.kind == RelationKind::View ? TreeItemType::View
+                    : relation.kind == RelationKind::Sequence ? TreeItemType::Sequence : TreeItemType::Table);
+            case Qt::ToolTipRole: {
+                QStringList estimates;
+                if (relation.estimatedRows >= 0) {
+                    estimates << QString("~%1 rows").arg(QLocale().toString(relation.estimatedRows));
+                }
+                if (relation.sizeBytes >= 0) {
+                    estimates << QLocale().formattedDataSize(relation.sizeBytes);
+                }
+                return estimates.isEmpty() ? QVariant() : QVariant(estimates.join(", "));
+            }
+            default:
+                return QVariant();
+        }
+    }
+
+    const Node *node = parentNode->children.at(index.row());
+    switch (role) {
+        case Qt::DisplayRole:
+            return node->text;
+        case Qt::DecorationRole:
+            if (node->busy) {
+                return spinnerIcon->getIcon();
+            }
+            return node->type == TreeItemType::Connection ? getIconForDatabaseType(node->databaseType)
+                                                          : getIconForType(node->type);
+        case Qt::ToolTipRole:
+            return node->toolTip.isEmpty() ? QVariant() : QVariant(node->toolTip);
+        default:
+            return QVariant();
+    }
+}
+
+QVariant ConnectionTreeModel::headerData(int section, Qt::Orientation orientation, int role) const {
+    if (section == 0 && orientation == Qt::Horizontal && role == Qt::DisplayRole) {
+        return QString("Connections");
+    }
+    return QVariant();
+}
+
+Qt::ItemFlags ConnectionTreeModel::flags(const QModelIndex &index) const {
+    if (!index.isValid()) {
+        return Qt::NoItemFlags;
+    }
+    auto *parentNode = static_cast<Node*>(index.internalPointer());
+    if (!parentNode->placeholder.isEmpty()) {
+        return Qt::ItemIsEnabled;
+    }
+    return Qt::ItemIsEnabled | Qt::ItemIsSelectable;
+}
+
+bool ConnectionTreeModel::canFetchMore(const QModelIndex &parent) const {
+    Node *node = parent.isValid() ? nodeAt(parent) : nullptr;
+    if (isExpandableLeaf(parent)) {
+        return !node || !node->loaded;
+    }
+    if (!node || !node->isFolder()) {
+        return false;
+    }
+    if (!node->loaded) {
+        return !node->placeholderBusy;
+    }
+    return node->fetched < node->leaves.size();
+}
+
+void ConnectionTreeModel::fetchMore(const QModelIndex &parent) {
+    Node *node = parent.isValid() ? nodeAt(parent) : nullptr;
+    if (isExpandableLeaf(parent)) {
+        // Details come from the snapshot the folder was filled from
+        auto *folder = static_cast<Node*>(parent.internalPointer());
+        const SchemaCatalog *catalog = catalogOf(folder);
+        if (!catalog) {
+            return;
+        }
+        if (!node) {
+            const RelationInfo &relation = folder->relations.at(folder->leaves.at(parent.row()));
+            node = new Node(relation.kind == RelationKind::View ? TreeItemType::View : TreeItemType::Table,
+                            relation.name);
+            node->parent = folder;
+            node->leafRow = parent.row();
+            folder->tables.insert(node->text, node);
+        }
+        fillDetails(node, *catalog);
+        return;
+    }
+    if (!node || !node->isFolder()) {
+        return;
+    }
+    if (!node->loaded) {
+        loadFolder(node);
+    } else {
+        fetchLeaves(node, kFetchBatchSize);
+    }
+}
+
+TreeItem ConnectionTreeModel::itemAt(const QModelIndex &index) const {
+    if (!index.isValid()) {
+        return TreeItem();
+    }
+    auto *parentNode = static_cast<Node*>(index.internalPointer());
+
+    TreeItem item;
+    const Node *context = parentNode;
+    if (!parentNode->placeholder.isEmpty()) {
+        item = TreeItem(parentNode->placeholder, TreeItemType::Placeholder);
+    } else if (parentNode->isFolder()) {
+        const RelationInfo &relation = parentNode->relations.at(parentNode->leaves.at(index.row()));
+        item = TreeItem(relation.name, relation.kind == RelationKind::View ? TreeItemType::View
+            : relation.kind == RelationKind::Sequence ? TreeItemType::Sequence : TreeItemType::Table);
+        item.setLoaded(true);
+    } else {
+        const Node *node = parentNode->children.at(index.row());
+        item = TreeItem(node->text, node->type);
+        item.setLoaded(node->loaded);
+        context = node;
+    }
+
+    // Connection, database and schema come from the ancestors
+    for (const Node *node = context; node && node != root; node = node->parent) {
+        if (node->type == TreeItemType::Database) {
+            item.setDatabaseName(node->text);
+        } else if (node->type == TreeItemType::Schema) {
+            item.setSchemaName(node->text);
+        } else if (node->parent == root) {
+            item.setConnectionName(node->text);
+        }
+    }
+    return item;
+}
+
+// Connections
+
 void ConnectionTreeModel::addConnection(DatabaseConnection *connection) {
     if (!connection) return;
 
     // Store connection reference for lazy loading
     connections[connection->getName()] = connection;
 
-    auto *connectionItem = new TreeItem(connection->getName(), TreeItemType::Connection);
-    connectionItem->setConnectionName(connection->getName());
-    connectionItem->setIcon(getIconForDatabaseType(connection->getType()));
-
-    appendRow(connectionItem);
+    Node *connectionNode = appendNode(root, TreeItemType::Connection, connection->getName());
+    connectionNode->databaseType = connection->getType();
+    connectionNode->loaded = true;
 
-    // Load structure (now with lazy loading for folders)
-    loadConnectionStructure(connectionItem, connection);
+    loadConnectionStructure(connectionNode, connection);
 }
 
 void ConnectionTreeModel::addConnectionPlaceholder(const QString &connectionName, DatabaseType dbType) {
-    auto *connectionItem = new TreeItem(connectionName, TreeItemType::Connection);
-    connectionItem->setConnectionName(connectionName);
-    connectionItem->setIcon(getIconForDatabaseType(dbType));
-    connectionItem->setLoaded(false);
-
-    // Add a placeholder child to make it expandable
-    auto *placeholder = new TreeItem("Not connected", TreeItemType::Connection);
-    connectionItem->appendRow(placeholder);
-
-    appendRow(connectionItem);
+    Node *connectionNode = appendNode(root, TreeItemType::Connection, connectionName);
+    connectionNode->databaseType = dbType;
+    connectionNode->placeholder = "Not connected";
 }
 
-void ConnectionTreeModel::connectToDatabase(TreeItem *connectionItem) {
-    if (!connectionItem || connectionItem->getType() != TreeItemType::Connection) {
+void ConnectionTreeModel::connectToDatabase(const QModelIndex &connectionIndex) {
+    Node *connectionNode = nodeAt(connectionIndex);
+    if (!connectionNode || connectionNode->type != TreeItemType::Connection || connectionNode->busy) {
         return;
     }
 
-    QString connectionName = connectionItem->getConnectionName();
+    QString connectionName = connectionNode->text;
     emit connectionStarted(connectionName);
 
-    startSpinner(connectionItem);
+    setBusy(connectionNode, true);
 
-    // Update placeholder to show connecting with animated spinner
-    if (connectionItem->rowCount() > 0) {
-        auto *placeholder = dynamic_cast<TreeItem*>(connectionItem->child(0));
-        if (placeholder) {
-            placeholder->setText("Connecting...");
-            startSpinner(placeholder);
+    // Draw the cached catalog while connecting; it is revalidated once connected.
+    // Otherwise show connecting with animated spinner until the cache has been read.
+    if (!showCachedCatalog(connectionNode)) {
+        setPlaceholder(connectionNode, "Connecting...", true);
+        if (!catalogs.contains(connectionName)) {
+            drawWhenCached.insert(connectionName);
+            loadCachedCatalog(connectionName);
         }
     }
 
-    // Connect in background
-    auto future = QtConcurrent::run([connectionName]() -> QPair<bool, QString> {
-        DatabaseConnection *conn = ConnectionManager::instance().getConnection(connectionName);
-        if (conn && conn->connect()) {
+    // Connect in background; the task shares ownership, so deleting the connection
+    // meanwhile doesn't pull it from under connect()
+    std::shared_ptr<DatabaseConnection> connection = ConnectionManager::instance().getSharedConnection(connectionName);
+    auto future = QtConcurrent::run([connection]() -> QPair<bool, QString> {
+        if (connection && connection->connect()) {
             return QPair<bool, QString>(true, QString());
         }
-        return QPair<bool, QString>(false, conn ? conn->getLastError() : "Connection not found");
+        return QPair<bool, QString>(false, connection ? connection->getLastError() : "Connection not found");
     });
 
     auto *watcher = new QFutureWatcher<QPair<bool, QString>>(this);
-    connect(watcher, &QFutureWatcher<QPair<bool, QString>>::finished, this, [this, watcher, connectionItem, connectionName]() {
+    connectAttempts.insert(connectionName, watcher);
+    connect(watcher, &QFutureWatcher<QPair<bool, QString>>::finished, this, [this, watcher, connectionName]() {
+        watcher->deleteLater();
+        if (connectAttempts.value(connectionName) != watcher) {
+            return;
+        }
+        connectAttempts.remove(connectionName);
         auto result = watcher->result();
 
-        if (result.first) {
-            // Stop spinner and remove placeholder
-            if (connectionItem->rowCount() > 0) {
-                auto *placeholder = dynamic_cast<TreeItem*>(connectionItem->child(0));
-                if (placeholder) {
-                    stopSpinner(placeholder);
-                }
-            }
-            connectionItem->removeRows(0, connectionItem->rowCount());
+        // The connection may have been deleted meanwhile
+        Node *connectionNode = findConnectionNode(connectionName);
+        if (connectionNode) {
+            setBusy(connectionNode, false);
+        }
 
-            // Load structure
+        if (result.first) {
+            // Load structure; databases and schemas arrive from the metadata thread
             DatabaseConnection *conn = ConnectionManager::instance().getConnection(connectionName);
-            if (conn) {
+            if (conn && connectionNode) {
                 connections[connectionName] = conn;
-                loadConnectionStructure(connectionItem, conn);
-                connectionItem->setLoaded(true);
+                connectionNode->loaded = true;
+                // Drawn from the cache while connecting
+                if (!catalogs.value(connectionName).isEmpty()) {
+                    revalidateCatalog(connectionName);
+                } else {
+                    clearRows(connectionNode);
+                    loadConnectionStructure(connectionNode, conn);
+                }
             }
 
-            stopSpinner(connectionItem);
             emit connectionFinished(connectionName, true, QString());
         } else {
-            // Stop spinner and show error in placeholder
-            if (connectionItem->rowCount() > 0) {
-                auto *placeholder = dynamic_cast<TreeItem*>(connectionItem->child(0));
-                if (placeholder) {
-                    stopSpinner(placeholder);
-                    placeholder->setText("Connection failed");
-                }
+            // The cached structure can't be browsed without a session
+            if (connectionNode) {
+                cacheLoads.remove(connectionName);
+                drawWhenCached.remove(connectionName);
+                catalogs.remove(connectionName);
+                searchIndex.removeConnection(connectionName);
+                setPlaceholder(connectionNode, "Connection failed", false);
             }
-            stopSpinner(connectionItem);
             emit connectionFinished(connectionName, false, result.second);
         }
-
-        watcher->deleteLater();
     });
     watcher->setFuture(future);
 }
 
 void ConnectionTreeModel::removeConnection(const QString &connectionName) {
-    TreeItem *item = findConnectionItem(connectionName);
-    if (item) {
-        removeRow(item->row());
+    // Loads still queued are dropped and the ones running are ignored when they finish
+    connectAttempts.remove(connectionName);
+    revalidations.remove(connectionName);
+    cacheLoads.remove(connectionName);
+    drawWhenCached.remove(connectionName);
+    if (DatabaseConnection *connection = connections.value(connectionName)) {
+        connection->cancelCatalogQueries();
+    }
+
+    if (Node *connectionNode = findConnectionNode(connectionName)) {
+        removeNode(connectionNode);
     }
     // Remove from connections map
     connections.remove(connectionName);
+    catalogs.remove(connectionName);
+    searchIndex.removeConnection(connectionName);
 }
 
 void ConnectionTreeModel::refreshConnection(const QString &connectionName) {
-    TreeItem *item = findConnectionItem(connectionName);
-    if (item) {
-        item->removeRows(0, item->rowCount());
-        // Re-load structure
-        // Would need to get connection from manager
+    Node *connectionNode = findConnectionNode(connectionName);
+    if (!connectionNode || !connections.contains(connectionName) || revalidations.contains(connectionName)) {
+        return;
     }
+    setBusy(connectionNode, true);
+    revalidateCatalog(connectionName);
 }
 
-TreeItem* ConnectionTreeModel::findConnectionItem(const QString &connectionName) {
-    for (int i = 0; i < rowCount(); ++i) {
-        auto *item = dynamic_cast<TreeItem*>(this->item(i));
-        if (item && item->getConnectionName() == connectionName) {
-            return item;
-        }
+void ConnectionTreeModel::setExpanded(const QModelIndex &index, bool expanded) {
+    if (Node *node = nodeAt(index)) {
+        node->expanded = expanded;
     }
-    return nullptr;
 }
 
-void ConnectionTreeModel::loadConnectionStructure(TreeItem *connectionItem, DatabaseConnection *connection) {
-    switch (connection->getType()) {
-        case DatabaseType::SQLite:
-            loadSQLiteStructure(connectionItem, connection);
-            break;
-        case DatabaseType::MySQL:
-            loadMySQLStructure(connectionItem, connection);
-            break;
-        case DatabaseType::PostgreSQL:
-            loadPostgreSQLStructure(connectionItem, connection);
+QModelIndex ConnectionTreeModel::findConnectionIndex(const QString &connectionName) const {
+    return indexOf(findConnectionNode(connectionName));
+}
+
+void ConnectionTreeModel::indexCachedCatalogs() {
+    for (Node *connectionNode : std::as_const(root->children)) {
+        loadCachedCatalog(connectionNode->text);
+    }
+}
+
+QModelIndex ConnectionTreeModel::revealObject(const QString &connectionName, const QString &schema,
+                                              RelationKind kind, const QString &name) {
+    Node *connectionNode = findConnectionNode(connectionName);
+    if (!connectionNode) {
+        return QModelIndex();
+    }
+    // Connecting draws the cached catalog right away
+    if (!connectionNode->loaded) {
+        connectToDatabase(indexOf(connectionNode));
+    }
+
+    Node *owner = connectionNode;
+    if (connectionNode->databaseType != DatabaseType::SQLite) {
+        owner = nullptr;
+        for (Node *child : std::as_const(connectionNode->children)) {
+            if (child->text == schema) {
+                owner = child;
+                break;
+            }
+        }
+        if (!owner) {
+            return indexOf(connectionNode);
+        }
+    }
+
+    const TreeItemType folderType = kind == RelationKind::View ? TreeItemType::ViewsFolder
+        : kind == RelationKind::Sequence ? TreeItemType::SequencesFolder : TreeItemType::TablesFolder;
+    Node *folder = nullptr;
+    for (Node *child : std::as_const(owner->children)) {
+        if (child->type == folderType) {
+            folder = child;
             break;
+        }
+    }
+    if (!folder) {
+        return indexOf(owner);
+    }
+
+    if (!folder->loaded || folder->stale) {
+        loadFolderContentsAsync(indexOf(folder));
+    }
+    for (int row = 0; row < folder->leaves.size(); ++row) {
+        if (folder->relations.at(folder->leaves.at(row)).name == name) {
+            if (row >= folder->fetched) {
+                fetchLeaves(folder, row + 1 - folder->fetched);
+            }
+            return createIndex(row, 0, folder);
+        }
     }
+    return indexOf(folder);
 }
 
-void ConnectionTreeModel::loadSQLiteStructure(TreeItem *connectionItem, DatabaseConnection *connection) {
-    // Tables folder - create empty with placeholder
-    auto *tablesFolder = new TreeItem("Tables", TreeItemType::TablesFolder);
-    tablesFolder->setIcon(getIconForType(TreeItemType::TablesFolder));
-    tablesFolder->setConnectionName(connection->getName());
-    tablesFolder->setLoaded(false);
-    connectionItem->appendRow(tablesFolder);
+// Structure
 
-    // Add placeholder to make it expandable
-    auto *placeholder = new TreeItem("Loading...", TreeItemType::TablesFolder);
-    tablesFolder->appendRow(placeholder);
+void ConnectionTreeModel::loadConnectionStructure(Node *connectionNode, DatabaseConnection *connection) {
+    // The revalidation needs the versions of the cached snapshots, so wait for them
+    if (!catalogs.contains(connection->getName())) {
+        setBusy(connectionNode, true);
+        drawWhenCached.insert(connection->getName());
+        loadCachedCatalog(connection->getName());
+        return;
+    }
 
-    // Views folder - create empty with placeholder
-    auto *viewsFolder = new TreeItem("Views", TreeItemType::ViewsFolder);
-    viewsFolder->setIcon(getIconForType(TreeItemType::ViewsFolder));
-    viewsFolder->setConnectionName(connection->getName());
-    viewsFolder->setLoaded(false);
-    connectionItem->appendRow(viewsFolder);
+    if (!showCachedCatalog(connectionNode)) {
+        if (connection->getType() == DatabaseType::SQLite) {
+            addFolders(connectionNode, DatabaseType::SQLite);
+        } else {
+            // Databases and schemas arrive with the first revalidation
+            setBusy(connectionNode, true);
+        }
+    }
 
-    // Add placeholder to make it expandable
-    auto *viewPlaceholder = new TreeItem("Loading...", TreeItemType::ViewsFolder);
-    viewsFolder->appendRow(viewPlaceholder);
+    revalidateCatalog(connection->getName());
 }
 
-void ConnectionTreeModel::loadMySQLStructure(TreeItem *connectionItem, DatabaseConnection *connection) {
-    // Databases folder
-    QStringList databases = connection->getDatabases();
+void ConnectionTreeModel::addFolders(Node *parent, DatabaseType type) {
+    appendNode(parent, TreeItemType::TablesFolder, "Tables");
+    appendNode(parent, TreeItemType::ViewsFolder, "Views");
+    // Sequences are PostgreSQL only
+    if (type == DatabaseType::PostgreSQL) {
+        appendNode(parent, TreeItemType::SequencesFolder, "Sequences");
+    }
+}
 
-    for (const QString &database : databases) {
-        auto *dbItem = new TreeItem(database, TreeItemType::Database);
-        dbItem->setConnectionName(connection->getName());
-        dbItem->setDatabaseName(database);
-        dbItem->setIcon(getIconForType(TreeItemType::Database));
-        connectionItem->appendRow(dbItem);
+void ConnectionTreeModel::addSchemaNode(Node *connectionNode, int row, const QString &schema) {
+    // MySQL lists databases, PostgreSQL schemas
+    const TreeItemType type = connectionNode->databaseType == DatabaseType::MySQL ? TreeItemType::Database
+                                                                                 : TreeItemType::Schema;
+    auto *schemaNode = new Node(type, schema);
+    schemaNode->loaded = true;
+    addFolders(schemaNode, connectionNode->databaseType);
+    insertNode(connectionNode, row, schemaNode);
+}
 
-        // Tables folder - create empty with placeholder
-        auto *tablesFolder = new TreeItem("Tables", TreeItemType::TablesFolder);
-        tablesFolder->setIcon(getIconForType(TreeItemType::TablesFolder));
-        tablesFolder->setConnectionName(connection->getName());
-        tablesFolder->setDatabaseName(database);
-        tablesFolder->setLoaded(false);
-        dbItem->appendRow(tablesFolder);
+// Catalog
 
-        // Add placeholder to make it expandable
-        auto *placeholder = new TreeItem("Loading...", TreeItemType::TablesFolder);
-        tablesFolder->appendRow(placeholder);
+void ConnectionTreeModel::loadCachedCatalog(const QString &connectionName) {
+    if (catalogs.contains(connectionName) || cacheLoads.contains(connectionName)) {
+        return;
+    }
+
+    // Deserializing a large catalog takes a while, so it never happens on the GUI thread
+    auto *watcher = new QFutureWatcher<QHash<QString, SchemaCatalog>>(this);
+    cacheLoads.insert(connectionName, watcher);
+    connect(watcher, &QFutureWatcher<QHash<QString, SchemaCatalog>>::finished, this,
+            [this, watcher, connectionName]() {
+        watcher->deleteLater();
+        if (cacheLoads.value(connectionName) != watcher) {
+            return;
+        }
+        cacheLoads.remove(connectionName);
+        const bool draw = drawWhenCached.remove(connectionName);
+
+        // Kept even when empty, so the cache isn't read again. A refresh that finished
+        // first holds newer snapshots.
+        if (!catalogs.contains(connectionName)) {
+            const QHash<QString, SchemaCatalog> cached = watcher->result();
+            catalogs.insert(connectionName, cached);
+            for (const SchemaCatalog &catalog : cached) {
+                searchIndex.setSchema(connectionName, catalog.snapshot.schema, catalog.snapshot.relations);
+            }
+            if (!cached.isEmpty()) {
+                emit objectIndexChanged();
+            }
+        }
+
+        Node *connectionNode = findConnectionNode(connectionName);
+        if (!draw || !connectionNode) {
+            return;
+        }
+        if (connectAttempts.contains(connectionName)) {
+            showCachedCatalog(connectionNode);
+        } else if (DatabaseConnection *connection = connections.value(connectionName)) {
+            loadConnectionStructure(connectionNode, connection);
+        }
+    });
+    watcher->setFuture(QtConcurrent::run([connectionName]() {
+        QHash<QString, SchemaCatalog> cached;
+        for (const CatalogSnapshot &snapshot : CatalogCache::instance().load(connectionName)) {
+            cached.insert(snapshot.schema, {snapshot, CatalogTableRanges::of(snapshot)});
+        }
+        return cached;
+    }));
+}
+
+bool ConnectionTreeModel::showCachedCatalog(Node *connectionNode) {
+    const QString connectionName = connectionNode->text;
+    const QHash<QString, SchemaCatalog> cached = catalogs.value(connectionName);
+    if (cached.isEmpty()) {
+        return false;
+    }
 
-        // Views folder - create empty with placeholder
-        auto *viewsFolder = new TreeItem("Views", TreeItemType::ViewsFolder);
-        viewsFolder->setIcon(getIconForType(TreeItemType::ViewsFolder));
-        viewsFolder->setConnectionName(connection->getName());
-        viewsFolder->setDatabaseName(database);
-        viewsFolder->setLoaded(false);
-        dbItem->appendRow(viewsFolder);
+    // Lets getColumns() and friends answer from the cache while connecting
+    if (DatabaseConnection *connection = ConnectionManager::instance().getConnection(connectionName)) {
+        QList<CatalogSnapshot> snapshots;
+        for (const SchemaCatalog &catalog : cached) {
+            snapshots << catalog.snapshot;
+        }
+        connection->primeCatalog(snapshots);
+    }
 
-        // Add placeholder to make it expandable
-        auto *viewPlaceholder = new TreeItem("Loading...", TreeItemType::ViewsFolder);
-        viewsFolder->appendRow(viewPlaceholder);
+    // Drop the "Not connected" status row
+    clearRows(connectionNode);
+
+    if (connectionNode->databaseType == DatabaseType::SQLite) {
+        addFolders(connectionNode, DatabaseType::SQLite);
+    } else {
+        QStringList schemas = cached.keys();
+        schemas.sort();
+        syncSchemaNodes(connectionNode, schemas);
     }
+    return true;
 }
 
-void ConnectionTreeModel::loadPostgreSQLStructure(TreeItem *connectionItem, DatabaseConnection *connection) {
-    // Schemas
-    QStringList schemas = connection->getSchemas();
+void ConnectionTreeModel::revalidateCatalog(const QString &connectionName) {
+    DatabaseConnection *connection = connections.value(connectionName);
+    if (!connection || revalidations.contains(connectionName)) {
+        return;
+    }
+
+    QHash<QString, QString> knownVersions;
+    const QHash<QString, SchemaCatalog> known = catalogs.value(connectionName);
+    for (auto it = known.constBegin(); it != known.constEnd(); ++it) {
+        knownVersions.insert(it.key(), it.value().snapshot.version);
+    }
+
+    auto *watcher = new QFutureWatcher<CatalogRevalidation>(this);
+    revalidations.insert(connectionName, watcher);
+    connect(watcher, &QFutureWatcher<CatalogRevalidation>::finished, this, [this, watcher, connectionName]() {
+        watcher->deleteLater();
+        if (revalidations.value(connectionName) != watcher) {
+            return;
+        }
+        revalidations.remove(connectionName);
+
+        const CatalogRevalidation result = watcher->result();
+        Node *connectionNode = findConnectionNode(connectionName);
+        if (connectionNode) {
+            setBusy(connectionNode, false);
+        }
+
+        if (!result.valid) {
+            // Keep what is shown; folders still waiting are retried when expanded again
+            if (connectionNode) {
+                forEachFolder(connectionNode, [this](Node *folder) {
+                    if (!folder->loaded && folder->placeholderBusy) {
+                        setPlaceholder(folder, "Failed to load", false);
+                        emit folderLoadingFinished(indexOf(folder));
+                    }
+                });
+            }
+            return;
+        }
+
+        QHash<QString, SchemaCatalog> &catalog = catalogs[connectionName];
+        QStringList dropped;
+        for (auto it = catalog.constBegin(); it != catalog.constEnd(); ++it) {
+            if (!result.schemas.contains(it.key())) {
+                dropped << it.key();
+            }
+        }
+        for (const QString &schema : dropped) {
+            catalog.remove(schema);
+            searchIndex.removeSchema(connectionName, schema);
+        }
+        QSet<QString> changed;
+        for (const CatalogSnapshot &snapshot : result.changed) {
+            catalog.insert(snapshot.schema, {snapshot, CatalogTableRanges::of(snapshot)});
+            changed.insert(snapshot.schema);
+            searchIndex.setSchema(connectionName, snapshot.schema, snapshot.relations);
+        }
+
+        if (connectionNode) {
+            if (connectionNode->databaseType != DatabaseType::SQLite) {
+                syncSchemaNodes(connectionNode, result.schemas);
+            }
+            // Folders never opened stay unfilled; filled ones whose schema changed are
+            // updated now if open, when next expanded otherwise
+            forEachFolder(connectionNode, [this, &catalog, &changed](Node *folder) {
+                const QString owner = ownerOf(folder);
+                if (folder->loaded && changed.contains(owner)) {
+                    if (folder->expanded) {
+                        fillFolder(folder, catalog[owner]);
+                    } else {
+                        folder->stale = true;
+                    }
+                } else if (!folder->loaded && folder->placeholderBusy) {
+                    loadFolder(folder);
+                }
+            });
+        }
+
+        if (!result.changed.isEmpty() || !dropped.isEmpty()) {
+            emit objectIndexChanged();
+            QtConcurrent::run([connectionName, changedSnapshots = result.changed, dropped]() {
+                CatalogCache::instance().store(connectionName, changedSnapshots, dropped);
+            });
+        }
+    });
+    watcher->setFuture(connection->revalidateCatalog(knownVersions));
+}
 
+void ConnectionTreeModel::syncSchemaNodes(Node *connectionNode, const QStringList &schemas) {
+    // Both lists are sorted, so one merge pass removes the dropped schemas and inserts
+    // the new ones in place
+    int row = 0;
     for (const QString &schema : schemas) {
-        auto *schemaItem = new TreeItem(schema, TreeItemType::Schema);
-        schemaItem->setConnectionName(connection->getName());
-        schemaItem->setSchemaName(schema);
-        schemaItem->setIcon(getIconForType(TreeItemType::Schema));
-        connectionItem->appendRow(schemaItem);
-
-        // Tables folder - create empty with placeholder
-        auto *tablesFolder = new TreeItem("Tables", TreeItemType::TablesFolder);
-        tablesFolder->setIcon(getIconForType(TreeItemType::TablesFolder));
-        tablesFolder->setConnectionName(connection->getName());
-        tablesFolder->setSchemaName(schema);
-        tablesFolder->setLoaded(false);
-        schemaItem->appendRow(tablesFolder);
-
-        // Add placeholder to make it expandable
-        auto *placeholder = new TreeItem("Loading...", TreeItemType::TablesFolder);
-        tablesFolder->appendRow(placeholder);
-
-        // Views folder - create empty with placeholder
-        auto *viewsFolder = new TreeItem("Views", TreeItemType::ViewsFolder);
-        viewsFolder->setIcon(getIconForType(TreeItemType::ViewsFolder));
-        viewsFolder->setConnectionName(connection->getName());
-        viewsFolder->setSchemaName(schema);
-        viewsFolder->setLoaded(false);
-        schemaItem->appendRow(viewsFolder);
-
-        // Add placeholder to make it expandable
-        auto *viewPlaceholder = new TreeItem("Loading...", TreeItemType::ViewsFolder);
-        viewsFolder->appendRow(viewPlaceholder);
-
-        // Sequences folder - create empty with placeholder
-        auto *sequencesFolder = new TreeItem("Sequences", TreeItemType::SequencesFolder);
-        sequencesFolder->setIcon(getIconForType(TreeItemType::SequencesFolder));
-        sequencesFolder->setConnectionName(connection->getName());
-        sequencesFolder->setSchemaName(schema);
-        sequencesFolder->setLoaded(false);
-        schemaItem->appendRow(sequencesFolder);
-
-        // Add placeholder to make it expandable
-        auto *seqPlaceholder = new TreeItem("Loading...", TreeItemType::SequencesFolder);
-        sequencesFolder->appendRow(seqPlaceholder);
-    }
-}
-
-void ConnectionTreeModel::loadFolderContents(TreeItem *folderItem) {
-    if (!folderItem || folderItem->isLoaded()) {
-        return;
+        while (row < connectionNode->children.size() && connectionNode->children.at(row)->text < schema) {
+            removeNode(connectionNode->children.at(row));
+        }
+        if (row < connectionNode->children.size() && connectionNode->children.at(row)->text == schema) {
+            ++row;
+            continue;
+        }
+        addSchemaNode(connectionNode, row++, schema);
+    }
+    while (row < connectionNode->children.size()) {
+        removeNode(connectionNode->children.at(row));
     }
+}
 
-    // Remove placeholder
-    folderItem->removeRows(0, folderItem->rowCount());
+void ConnectionTreeModel::forEachFolder(Node *parent, const std::function<void(Node*)> &visit) {
+    for (Node *child : std::as_const(parent->children)) {
+        if (child->isFolder()) {
+            visit(child);
+        } else {
+            forEachFolder(child, visit);
+        }
+    }
+}
 
-    // Get connection
-    QString connectionName = folderItem->getConnectionName();
-    DatabaseConnection *connection = connections.value(connectionName);
-    if (!connection) {
+void ConnectionTreeModel::loadFolderContentsAsync(const QModelIndex &folderIndex) {
+    Node *folder = nodeAt(folderIndex);
+    if (!folder || !folder->isFolder()) {
+        return;
+    }
+    if (!folder->loaded) {
+        loadFolder(folder);
         return;
     }
+    if (folder->stale) {
+        if (const SchemaCatalog *catalog = catalogOf(folder)) {
+            fillFolder(folder, *catalog);
+        }
+    }
+}
+
+void ConnectionTreeModel::loadFolder(Node *folder) {
+    const QString connectionName = connectionNameOf(folder);
 
-    TreeItemType type = folderItem->getType();
-    QString databaseName = folderItem->getDatabaseName();
-    QString schemaName = folderItem->getSchemaName();
-
-    if (type == TreeItemType::TablesFolder) {
-        // Load tables
-        QStringList tables = connection->getTables(schemaName, databaseName);
-        for (const QString &table : tables) {
-            auto *tableItem = new TreeItem(table, TreeItemType::Table);
-            tableItem->setConnectionName(connectionName);
-            tableItem->setDatabaseName(databaseName);
-            tableItem->setSchemaName(schemaName);
-            tableItem->setIcon(getIconForType(TreeItemType::Table));
-            folderItem->appendRow(tableItem);
-        }
-    } else if (type == TreeItemType::ViewsFolder) {
-        // Load views
-        QStringList views = connection->getViews(schemaName, databaseName);
-        for (const QString &view : views) {
-            auto *viewItem = new TreeItem(view, TreeItemType::View);
-            viewItem->setConnectionName(connectionName);
-            viewItem->setDatabaseName(databaseName);
-            viewItem->setSchemaName(schemaName);
-            viewItem->setIcon(getIconForType(TreeItemType::View));
-            folderItem->appendRow(viewItem);
-        }
-    } else if (type == TreeItemType::SequencesFolder) {
-        // Load sequences (PostgreSQL only)
-        QStringList sequences = connection->getSequences(schemaName);
-        for (const QString &sequence : sequences) {
-            auto *seqItem = new TreeItem(sequence, TreeItemType::Sequence);
-            seqItem->setConnectionName(connectionName);
-            seqItem->setSchemaName(schemaName);
-            seqItem->setIcon(getIconForType(TreeItemType::Sequence));
-            folderItem->appendRow(seqItem);
-        }
-    }
-
-    folderItem->setLoaded(true);
-}
-
-void ConnectionTreeModel::loadFolderContentsAsync(TreeItem *folderItem) {
-    if (!folderItem || folderItem->isLoaded()) {
+    // All folders of a schema are filled from its catalog snapshot
+    if (const SchemaCatalog *catalog = catalogOf(folder)) {
+        fillFolder(folder, *catalog);
+        return;
+    }
+    if (!connections.contains(connectionName) || folder->placeholderBusy) {
         return;
     }
 
-    emit folderLoadingStarted(folderItem);
+    emit folderLoadingStarted(indexOf(folder));
+    setPlaceholder(folder, "Loading...", true);
+    revalidateCatalog(connectionName);
+}
 
-    // Change placeholder text and start animated spinner
-    if (folderItem->rowCount() > 0) {
-        auto *placeholder = dynamic_cast<TreeItem*>(folderItem->child(0));
-        if (placeholder) {
-            placeholder->setText("Loading...");
-            startSpinner(placeholder);
-        }
+const ConnectionTreeModel::SchemaCatalog *ConnectionTreeModel::catalogOf(Node *folder) const {
+    const auto catalog = catalogs.constFind(connectionNameOf(folder));
+    if (catalog == catalogs.constEnd()) {
+        return nullptr;
     }
+    const auto schema = catalog->constFind(ownerOf(folder));
+    return schema == catalog->constEnd() ? nullptr : &schema.value();
+}
 
-    // Get connection info
-    QString connectionName = folderItem->getConnectionName();
-    QString databaseName = folderItem->getDatabaseName();
-    QString schemaName = folderItem->getSchemaName();
-    TreeItemType type = folderItem->getType();
+void ConnectionTreeModel::fillFolder(Node *folder, const SchemaCatalog &catalog) {
+    const CatalogSnapshot &snapshot = catalog.snapshot;
+    const RelationKind kind = folder->type == TreeItemType::ViewsFolder ? RelationKind::View
+        : folder->type == TreeItemType::SequencesFolder ? RelationKind::Sequence : RelationKind::Table;
 
-    // Load in background
-    auto future = QtConcurrent::run([this, connectionName, databaseName, schemaName, type]() -> QStringList {
-        DatabaseConnection *connection = connections.value(connectionName);
-        if (!connection) {
-            return QStringList();
+    // The relation list is shared with the snapshot; only positions are stored here
+    QList<int> leaves;
+    for (int i = 0; i < snapshot.relations.size(); ++i) {
+        if (snapshot.relations.at(i).kind == kind) {
+            leaves << i;
         }
+    }
 
-        if (type == TreeItemType::TablesFolder) {
-            return connection->getTables(schemaName, databaseName);
-        } else if (type == TreeItemType::ViewsFolder) {
-            return connection->getViews(schemaName, databaseName);
-        } else if (type == TreeItemType::SequencesFolder) {
-            return connection->getSequences(schemaName);
+    if (folder->loaded) {
+        updateFolder(folder, snapshot.relations, leaves);
+        // Expanded tables that are still there may have gained or lost columns
+        for (Node *table : std::as_const(folder->tables)) {
+            fillDetails(table, catalog);
         }
-        return QStringList();
-    });
+        return;
+    }
 
-    auto *watcher = new QFutureWatcher<QStringList>(this);
-    connect(watcher, &QFutureWatcher<QStringList>::finished, this, [this, watcher, folderItem, connectionName, databaseName, schemaName, type]() {
-        QStringList items = watcher->result();
+    // Drop the status row
+    clearRows(folder);
+    folder->relations = snapshot.relations;
+    folder->leaves = leaves;
+    folder->loaded = true;
+    folder->stale = false;
 
-        // Stop spinner and remove placeholder
-        if (folderItem->rowCount() > 0) {
-            auto *placeholder = dynamic_cast<TreeItem*>(folderItem->child(0));
-            if (placeholder) {
-                stopSpinner(placeholder);
-            }
+    fetchLeaves(folder, kFetchBatchSize);
+    emit folderLoadingFinished(indexOf(folder));
+}
+
+void ConnectionTreeModel::updateFolder(Node *folder, const QList<RelationInfo> &relations, const QList<int> &leaves) {
+    const QModelIndex folderIndex = indexOf(folder);
+    folder->stale = false;
+
+    QHash<QString, int> positions;  // name -> index into the new relations
+    for (int leaf : leaves) {
+        positions.insert(relations.at(leaf).name, leaf);
+    }
+    auto shownName = [folder](int row) -> const QString & {
+        return folder->relations.at(folder->leaves.at(row)).name;
+    };
+
+    // Rows past the fetched ones were never shown, so they go without signals
+    folder->leaves.resize(folder->fetched);
+
+    // Remove the rows that are gone, one run at a time from the bottom so the rows
+    // above keep their numbers
+    for (int last = folder->fetched - 1; last >= 0;) {
+        if (positions.contains(shownName(last))) {
+            --last;
+            continue;
+        }
+        int first = last;
+        while (first > 0 && !positions.contains(shownName(first - 1))) {
+            --first;
         }
-        folderItem->removeRows(0, folderItem->rowCount());
-
-        // Add items
-        for (const QString &itemName : items) {
-            TreeItem *newItem = nullptr;
-
-            if (type == TreeItemType::TablesFolder) {
-                newItem = new TreeItem(itemName, TreeItemType::Table);
-                newItem->setIcon(getIconForType(TreeItemType::Table));
-            } else if (type == TreeItemType::ViewsFolder) {
-                newItem = new TreeItem(itemName, TreeItemType::View);
-                newItem->setIcon(getIconForType(TreeItemType::View));
-            } else if (type == TreeItemType::SequencesFolder) {
-                newItem = new TreeItem(itemName, TreeItemType::Sequence);
-                newItem->setIcon(getIconForType(TreeItemType::Sequence));
+        const int count = last - first + 1;
+        QList<Node*> dropped;
+        beginRemoveRows(folderIndex, first, last);
+        folder->leaves.remove(first, count);
+        folder->fetched -= count;
+        for (auto it = folder->tables.begin(); it != folder->tables.end();) {
+            Node *table = it.value();
+            if (table->leafRow >= first && table->leafRow <= last) {
+                dropped << table;
+                it = folder->tables.erase(it);
+                continue;
             }
+            if (table->leafRow > last) {
+                table->leafRow -= count;
+            }
+            ++it;
+        }
+        endRemoveRows();
+        qDeleteAll(dropped);
+        last = first - 1;
+    }
+
+    // Point the remaining rows at the new list; their names are the same
+    for (int &leaf : folder->leaves) {
+        leaf = positions.value(folder->relations.at(leaf).name);
+    }
+    folder->relations = relations;
+
+    // Both lists follow the catalog order, so the kept rows' positions ascend unless
+    // the server sorted differently this time; then the folder is simply reloaded
+    if (!std::is_sorted(folder->leaves.cbegin(), folder->leaves.cend())) {
+        const int shown = folder->fetched;
+        const QList<Node*> tables = folder->tables.values();
+        folder->tables.clear();
+        if (shown > 0) {
+            beginRemoveRows(folderIndex, 0, shown - 1);
+            folder->leaves.clear();
+            folder->fetched = 0;
+            endRemoveRows();
+        }
+        qDeleteAll(tables);
+        folder->leaves = leaves;
+        fetchLeaves(folder, std::max<int>(shown, kFetchBatchSize));
+        return;
+    }
 
-            if (newItem) {
-                newItem->setConnectionName(connectionName);
-                newItem->setDatabaseName(databaseName);
-                newItem->setSchemaName(schemaName);
-                folderItem->appendRow(newItem);
+    // Insert the new relations that fall between shown rows, a run at a time
+    int row = 0;
+    int next = 0;
+    while (row < folder->fetched && next < leaves.size()) {
+        if (leaves.at(next) == folder->leaves.at(row)) {
+            ++row;
+            ++next;
+            continue;
+        }
+        int runEnd = next;
+        while (leaves.at(runEnd) != folder->leaves.at(row)) {
+            ++runEnd;
+        }
+        const int count = runEnd - next;
+        beginInsertRows(folderIndex, row, row + count - 1);
+        folder->leaves.insert(row, count, 0);
+        std::copy(leaves.cbegin() + next, leaves.cbegin() + runEnd, folder->leaves.begin() + row);
+        folder->fetched += count;
+        for (Node *table : std::as_const(folder->tables)) {
+            if (table->leafRow >= row) {
+                table->leafRow += count;
             }
         }
+        endInsertRows();
+        row += count;
+        next = runEnd;
+    }
 
-        folderItem->setLoaded(true);
-        emit folderLoadingFinished(folderItem);
-        watcher->deleteLater();
-    });
-    watcher->setFuture(future);
+    // Whatever follows the last shown row is handed out by fetchMore as before
+    folder->leaves += leaves.mid(next);
+    if (folder->fetched < kFetchBatchSize) {
+        fetchLeaves(folder, kFetchBatchSize - folder->fetched);
+    }
+
+    // Estimates of the kept rows may have moved
+    if (folder->fetched > 0) {
+        emit dataChanged(index(0, 0, folderIndex), index(folder->fetched - 1, 0, folderIndex), {Qt::ToolTipRole});
+    }
 }
 
-QIcon ConnectionTreeModel::getIconForDatabaseType(DatabaseType type) {
+void ConnectionTreeModel::fillDetails(Node *table, const SchemaCatalog &catalog) {
+    const CatalogSnapshot &snapshot = catalog.snapshot;
+    QList<Node*> details;
+    const QPair<int, int> columns = catalog.ranges.columns.value(table->text, {0, 0});
+    for (int i = columns.first; i < columns.second; ++i) {
+        const ColumnInfo &column = snapshot.columns.at(i);
+        auto *node = new Node(TreeItemType::Column, QString("%1  %2").arg(column.name, column.dataType));
+        node->toolTip = column.nullable ? "NULL" : "NOT NULL";
+        if (!column.defaultValue.isEmpty()) {
+            node->toolTip += QString(", DEFAULT %1").arg(column.defaultValue);
+        }
+        if (!column.extra.isEmpty()) {
+            node->toolTip += ", " + column.extra;
+        }
+        details << node;
+    }
+    const QPair<int, int> indexes = catalog.ranges.indexes.value(table->text, {0, 0});
+    for (int i = indexes.first; i < indexes.second; ++i) {
+        const IndexInfo &index = snapshot.indexes.at(i);
+        auto *node = new Node(TreeItemType::Index, QString("%1 (%2)").arg(index.name, index.columns.join(", ")));
+        node->toolTip = index.primary ? "Primary key" : index.unique ? "Unique index" : "Index";
+        details << node;
+    }
+    const QPair<int, int> foreignKeys = catalog.ranges.foreignKeys.value(table->text, {0, 0});
+    for (int i = foreignKeys.first; i < foreignKeys.second; ++i) {
+        const ForeignKeyInfo &foreignKey = snapshot.foreignKeys.at(i);
+        QString target = foreignKey.referencedTable;
+        if (!foreignKey.referencedSchema.isEmpty() && foreignKey.referencedSchema != foreignKey.schema) {
+            target = foreignKey.referencedSchema + "." + target;
+        }
+        if (!foreignKey.referencedColumns.isEmpty()) {
+            target += QString("(%1)").arg(foreignKey.referencedColumns.join(", "));
+        }
+        QString text = QString("(%1) → %2").arg(foreignKey.columns.join(", "), target);
+        if (!foreignKey.name.isEmpty()) {
+            text = foreignKey.name + " " + text;
+        }
+        auto *node = new Node(TreeItemType::ForeignKey, text);
+        node->toolTip = "Foreign key";
+        details << node;
+    }
+
+    // Replaced wholesale; a table holds few enough of these that diffing isn't worth it
+    const QModelIndex tableIndex = indexOf(table);
+    if (!table->children.isEmpty()) {
+        beginRemoveRows(tableIndex, 0, table->children.size() - 1);
+        qDeleteAll(table->children);
+        table->children.clear();
+        endRemoveRows();
+    }
+    table->loaded = true;
+    if (!details.isEmpty()) {
+        beginInsertRows(tableIndex, 0, details.size() - 1);
+        for (Node *node : std::as_const(details)) {
+            node->parent = table;
+        }
+        table->children = details;
+        endInsertRows();
+    }
+}
+
+void ConnectionTreeModel::fetchLeaves(Node *folder, int count) {
+    const int first = folder->fetched;
+    const int last = std::min<int>(folder->leaves.size(), first + count) - 1;
+    if (last < first) {
+        return;
+    }
+    beginInsertRows(indexOf(folder), first, last);
+    folder->fetched = last + 1;
+    endInsertRows();
+}
+
+// Nodes
+
+ConnectionTreeModel::Node *ConnectionTreeModel::nodeAt(const QModelIndex &index) const {
+    if (!index.isValid()) {
+        return nullptr;
+    }
+    auto *parentNode = static_cast<Node*>(index.internalPointer());
+    if (!parentNode->placeholder.isEmpty()) {
+        return nullptr;
+    }
+    if (parentNode->isFolder()) {
+        return parentNode->tables.value(parentNode->relations.at(parentNode->leaves.at(index.row())).name);
+    }
+    return parentNode->children.value(index.row());
+}
+
+bool ConnectionTreeModel::isExpandableLeaf(const QModelIndex &index) const {
+    if (!index.isValid()) {
+        return false;
+    }
+    auto *parentNode = static_cast<Node*>(index.internalPointer());
+    return parentNode->placeholder.isEmpty() && parentNode->isFolder()
+        && parentNode->relations.at(parentNode->leaves.at(index.row())).kind != RelationKind::Sequence;
+}
+
+QModelIndex ConnectionTreeModel::indexOf(Node *node) const {
+    if (!node || node == root) {
+        return QModelIndex();
+    }
+    return createIndex(node->row(), 0, node->parent);
+}
+
+ConnectionTreeModel::Node *ConnectionTreeModel::findConnectionNode(const QString &connectionName) const {
+    for (Node *node : std::as_const(root->children)) {
+        if (node->text == connectionName) {
+            return node;
+        }
+    }
+    return nullptr;
+}
+
+QString ConnectionTreeModel::connectionNameOf(const Node *node) const {
+    while (node && node->parent != root) {
+        node = node->parent;
+    }
+    return node ? node->text : QString();
+}
+
+QString ConnectionTreeModel::ownerOf(const Node *folder) const {
+    // Catalog snapshot key: MySQL folders hang off a database, PostgreSQL ones off a
+    // schema, SQLite ones off the connection
+    return folder->parent->type == TreeItemType::Connection ? QString() : folder->parent->text;
+}
+
+int ConnectionTreeModel::rowCountOf(const Node *node) const {
+    if (!node->placeholder.isEmpty()) {
+        return 1;
+    }
+    return node->isFolder() ? node->fetched : node->children.size();
+}
+
+ConnectionTreeModel::Node *ConnectionTreeModel::appendNode(Node *parent, TreeItemType type, const QString &text) {
+    auto *node = new Node(type, text);
+    insertNode(parent, parent->children.size(), node);
+    return node;
+}
+
+void ConnectionTreeModel::insertNode(Node *parent, int row, Node *child) {
+    if (!parent->placeholder.isEmpty()) {
+        clearRows(parent);
+    }
+    child->parent = parent;
+    beginInsertRows(indexOf(parent), row, row);
+    parent->children.insert(row, child);
+    endInsertRows();
+}
+
+void ConnectionTreeModel::removeNode(Node *node) {
+    Node *parent = node->parent;
+    const int row = node->row();
+    forgetSpinners(node);
+    beginRemoveRows(indexOf(parent), row, row);
+    parent->children.removeAt(row);
+    endRemoveRows();
+    delete node;
+}
+
+void ConnectionTreeModel::clearRows(Node *node) {
+    const int count = rowCountOf(node);
+    for (Node *child : std::as_const(node->children)) {
+        forgetSpinners(child);
+    }
+    if (count > 0) {
+        beginRemoveRows(indexOf(node), 0, count - 1);
+    }
+    qDeleteAll(node->children);
+    node->children.clear();
+    qDeleteAll(node->tables);
+    node->tables.clear();
+    node->relations.clear();
+    node->leaves.clear();
+    node->fetched = 0;
+    node->placeholder.clear();
+    node->placeholderBusy = false;
+    if (node->isFolder()) {
+        node->loaded = false;
+    }
+    if (!node->busy) {
+        spinningNodes.remove(node);
+    }
+    if (spinningNodes.isEmpty()) {
+        spinnerIcon->stop();
+    }
+    if (count > 0) {
+        endRemoveRows();
+    }
+}
+
+void ConnectionTreeModel::setPlaceholder(Node *node, const QString &text, bool busy) {
+    clearRows(node);
+    beginInsertRows(indexOf(node), 0, 0);
+    node->placeholder = text;
+    node->placeholderBusy = busy;
+    endInsertRows();
+
+    if (busy) {
+        spinningNodes.insert(node);
+        if (!spinnerIcon->isRunning()) {
+            spinnerIcon->start();
+        }
+    }
+}
+
+void ConnectionTreeModel::setBusy(Node *node, bool busy) {
+    if (node->busy == busy) {
+        return;
+    }
+    node->busy = busy;
+    if (busy) {
+        spinningNodes.insert(node);
+        if (!spinnerIcon->isRunning()) {
+            spinnerIcon->start();
+        }
+    } else {
+        if (!node->placeholderBusy) {
+            spinningNodes.remove(node);
+        }
+        if (spinningNodes.isEmpty()) {
+            spinnerIcon->stop();
+        }
+    }
+
+    const QModelIndex nodeIndex = indexOf(node);
+    emit dataChanged(nodeIndex, nodeIndex, {Qt::DecorationRole});
+}
+
+void ConnectionTreeModel::forgetSpinners(Node *node) {
+    spinningNodes.remove(node);
+    for (Node *child : std::as_const(node->children)) {
+        forgetSpinners(child);
+    }
+    if (spinningNodes.isEmpty()) {
+        spinnerIcon->stop();
+    }
+}
+
+QIcon ConnectionTreeModel::getIconForDatabaseType(DatabaseType type) const {
     switch (type) {
         case DatabaseType::SQLite:
             return QIcon(":/icons/assets/icons/sqlite.svg");
@@ -428,60 +1114,49 @@ QIcon ConnectionTreeModel::getIconForDatabaseType(DatabaseType type) {
     }
 }
 
-QIcon ConnectionTreeModel::getIconForType(TreeItemType type) {
+QIcon ConnectionTreeModel::getIconForType(TreeItemType type) const {
+    auto cached = typeIcons.constFind(static_cast<int>(type));
+    if (cached != typeIcons.constEnd()) {
+        return cached.value();
+    }
+
+    QIcon icon;
     switch (type) {
         case TreeItemType::Connection:
-            return QIcon(":/icons/assets/icons/connection.svg");
+            icon = QIcon(":/icons/assets/icons/connection.svg");
+            break;
         case TreeItemType::Database:
-            return QIcon(":/icons/assets/icons/database.svg");
+            icon = QIcon(":/icons/assets/icons/database.svg");
+            break;
         case TreeItemType::Schema:
-            return QIcon(":/icons/assets/icons/schema.svg");
+            icon = QIcon(":/icons/assets/icons/schema.svg");
+            break;
         case TreeItemType::TablesFolder:
         case TreeItemType::ViewsFolder:
         case TreeItemType::SequencesFolder:
-            return QIcon(":/icons/assets/icons/folder.svg");
+            icon = QIcon(":/icons/assets/icons/folder.svg");
+            break;
         case TreeItemType::Table:
-            return QIcon(":/icons/assets/icons/table.svg");
+            icon = QIcon(":/icons/assets/icons/table.svg");
+            break;
         case TreeItemType::View:
-            return QIcon(":/icons/assets/icons/view.svg");
+            icon = QIcon(":/icons/assets/icons/view.svg");
+            break;
         case TreeItemType::Sequence:
-            return QIcon(":/icons/assets/icons/sequence.svg");
+            icon = QIcon(":/icons/assets/icons/sequence.svg");
+            break;
+        case TreeItemType::Column:
+            icon = QIcon(":/icons/assets/icons/column.svg");
+            break;
+        case TreeItemType::Index:
+            icon = QIcon(":/icons/assets/icons/index.svg");
+            break;
+        case TreeItemType::ForeignKey:
+            icon = QIcon(":/icons/assets/icons/foreign_key.svg");
+            break;
         default:
-            return QIcon();
-    }
-}
-
-void ConnectionTreeModel::startSpinner(TreeItem *item) {
-    if (!item || spinningItems.contains(item)) {
-        return;
-    }
-
-    if (!item->data(kSpinnerOriginalIconRole).isValid()) {
-        item->setData(item->icon(), kSpinnerOriginalIconRole);
-    }
-
-    spinningItems[item] = true;
-    item->setIcon(spinnerIcon->getIcon());
-
-    if (!spinnerIcon->isRunning()) {
-        spinnerIcon->start();
-    }
-}
-
-void ConnectionTreeModel::stopSpinner(TreeItem *item) {
-    if (!item) {
-        return;
-    }
-
-    spinningItems.remove(item);
-
-    const QVariant originalIcon = item->data(kSpinnerOriginalIconRole);
-    if (originalIcon.isValid()) {
-        item->setIcon(originalIcon.value<QIcon>());
-        item->setData(QVariant(), kSpinnerOriginalIconRole);
-    }
-
-    if (spinningItems.isEmpty()) {
-        spinnerIcon->stop();
+            break;
     }
+    typeIcons.insert(static_cast<int>(type), icon);
+    return icon;
 }
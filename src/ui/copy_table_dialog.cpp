@@ -0,0 +1,101 @@
+#include "ui/copy_table_dialog.h"
+#include "core/connection_storage.h"
+#include "database/connection_manager.h"
+#include <QFormLayout>
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QLocale>
+
+CopyTableDialog::CopyTableDialog(const QString &sourceConnection, const QString &sourceTable, QWidget *parent)
+    : QDialog(parent), sourceConnection(sourceConnection), sourceTable(sourceTable) {
+    setupUI();
+    setWindowTitle("Copy Table to Connection");
+    resize(440, 0);
+}
+
+void CopyTableDialog::setupUI() {
+    auto *mainLayout = new QVBoxLayout(this);
+
+    mainLayout->addWidget(new QLabel(QString("Copy %1 from %2 to:").arg(sourceTable, sourceConnection), this));
+
+    auto *formLayout = new QFormLayout();
+
+    targetConnectionCombo = new QComboBox(this);
+    for (DatabaseConnection *conn : ConnectionManager::instance().getAllConnections()) {
+        if (conn->isConnected() && !conn->isScratchpad()) {
+            targetConnectionCombo->addItem(conn->getName());
+        }
+    }
+    // Copying within the same connection is possible but rarely what's wanted
+    const int other = targetConnectionCombo->findText(sourceConnection) == 0 ? 1 : 0;
+    if (other < targetConnectionCombo->count()) {
+        targetConnectionCombo->setCurrentIndex(other);
+    }
+    formLayout->addRow("Target connection:", targetConnectionCombo);
+
+    // Schemas rarely exist on the other side, so default to the bare table name
+    targetTableEdit = new QLineEdit(sourceTable.section('.', -1), this);
+    formLayout->addRow("Target table:", targetTableEdit);
+
+    batchRowsSpin = new QSpinBox(this);
+    batchRowsSpin->setRange(100, 1000000);
+    batchRowsSpin->setSingleStep(10000);
+    batchRowsSpin->setValue(TableCopier::kDefaultBatchRows);
+    formLayout->addRow("Rows per batch:", batchRowsSpin);
+
+    mainLayout->addLayout(formLayout);
+
+    resumeCheck = new QCheckBox(this);
+    mainLayout->addWidget(resumeCheck);
+
+    connect(targetConnectionCombo, &QComboBox::currentTextChanged, this, &CopyTableDialog::updateCheckpoint);
+    connect(targetTableEdit, &QLineEdit::textChanged, this, &CopyTableDialog::updateCheckpoint);
+
+    // Buttons
+    auto *buttonLayout = new QHBoxLayout();
+    buttonLayout->addStretch();
+
+    cancelButton = new QPushButton("Cancel", this);
+    connect(cancelButton, &QPushButton::clicked, this, &QDialog::reject);
+    buttonLayout->addWidget(cancelButton);
+
+    okButton = new QPushButton("Copy", this);
+    okButton->setDefault(true);
+    connect(okButton, &QPushButton::clicked, this, &QDialog::accept);
+    buttonLayout->addWidget(okButton);
+
+    mainLayout->addLayout(buttonLayout);
+
+    updateCheckpoint();
+}
+
+void CopyTableDialog::updateCheckpoint() {
+    const QString targetTable = targetTableEdit->text().trimmed();
+    const CopyCheckpoint checkpoint = ConnectionStorage::instance().loadCopyCheckpoint(
+        sourceConnection, sourceTable, targetConnectionCombo->currentText(), targetTable);
+
+    if (checkpoint.isValid()) {
+        resumeCheck->setText(QString("Resume after %1 = %2 (%3 rows already copied)")
+                                 .arg(checkpoint.keyColumn, checkpoint.lastKey.toString(),
+                                      QLocale().toString(checkpoint.rowsCopied)));
+        resumeCheck->setChecked(true);
+        resumeCheck->setVisible(true);
+    } else {
+        resumeCheck->setChecked(false);
+        resumeCheck->setVisible(false);
+    }
+
+    okButton->setEnabled(targetConnectionCombo->count() > 0 && !targetTable.isEmpty());
+}
+
+TableCopyOptions CopyTableDialog::getCopyOptions() const {
+    TableCopyOptions options;
+    options.sourceConnection = sourceConnection;
+    options.sourceTable = sourceTable;
+    options.targetConnection = targetConnectionCombo->currentText();
+    options.targetTable = targetTableEdit->text().trimmed();
+    options.batchRows = batchRowsSpin->value();
+    options.resume = resumeCheck->isChecked();
+    return options;
+}
@@ -0,0 +1,135 @@
+#include "ui/dump_dialog.h"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QFormLayout>
+#include <QFileDialog>
+#include <QLabel>
+#include <QDir>
+
+DumpDialog::DumpDialog(DatabaseType type, const QStringList &schemas, const QString &suggestedName,
+                       QWidget *parent)
+    : QDialog(parent), type(type), schemas(schemas), suggestedName(suggestedName) {
+    setupUI();
+    setWindowTitle("Dump to SQL");
+    resize(520, 0);
+}
+
+void DumpDialog::setupUI() {
+    auto *mainLayout = new QVBoxLayout(this);
+
+    if (type != DatabaseType::SQLite) {
+        auto *scopeLabel = new QLabel(QString("Dumping %1").arg(schemas.join(", ")), this);
+        scopeLabel->setWordWrap(true);
+        mainLayout->addWidget(scopeLabel);
+    }
+
+    auto *formLayout = new QFormLayout();
+
+    modeCombo = new QComboBox(this);
+    modeCombo->addItem("Single file");
+    modeCombo->addItem("One file per table");
+    connect(modeCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &DumpDialog::updateState);
+    formLayout->addRow("Output:", modeCombo);
+
+    auto *outputLayout = new QHBoxLayout();
+    outputEdit = new QLineEdit(QDir::home().filePath(suggestedName + ".sql"), this);
+    browseButton = new QPushButton("Browse...", this);
+    connect(browseButton, &QPushButton::clicked, this, &DumpDialog::browseForOutput);
+    connect(outputEdit, &QLineEdit::textChanged, this, &DumpDialog::updateState);
+    outputLayout->addWidget(outputEdit);
+    outputLayout->addWidget(browseButton);
+    formLayout->addRow("Path:", outputLayout);
+
+    compressionCombo = new QComboBox(this);
+    compressionCombo->addItem("None", QVariant::fromValue(int(Compression::None)));
+    for (Compression compression : {Compression::Gzip, Compression::Zstd}) {
+        if (CompressedFileWriter::isAvailable(compression)) {
+            compressionCombo->addItem(compression == Compression::Gzip ? "gzip (.gz)" : "zstd (.zst)",
+                                      QVariant::fromValue(int(compression)));
+        }
+    }
+    formLayout->addRow("Compression:", compressionCombo);
+
+    dataCheck = new QCheckBox("Include table data", this);
+    dataCheck->setChecked(true);
+    connect(dataCheck, &QCheckBox::toggled, this, &DumpDialog::updateState);
+    formLayout->addRow("", dataCheck);
+
+    copyCheck = new QCheckBox("Write data as COPY blocks", this);
+    copyCheck->setChecked(true);
+    copyCheck->setVisible(type == DatabaseType::PostgreSQL);
+    connect(copyCheck, &QCheckBox::toggled, this, &DumpDialog::updateState);
+    formLayout->addRow("", copyCheck);
+
+    rowsPerInsertSpin = new QSpinBox(this);
+    rowsPerInsertSpin->setRange(1, 10000);
+    rowsPerInsertSpin->setValue(DumpOptions().rowsPerInsert);
+    formLayout->addRow("Rows per INSERT:", rowsPerInsertSpin);
+
+    // SQLite is read through a single session
+    parallelSpin = new QSpinBox(this);
+    parallelSpin->setRange(1, 32);
+    parallelSpin->setValue(DumpOptions().parallelTables);
+    parallelSpin->setEnabled(type != DatabaseType::SQLite);
+    formLayout->addRow("Tables in parallel:", parallelSpin);
+
+    mainLayout->addLayout(formLayout);
+
+    // Buttons
+    auto *buttonLayout = new QHBoxLayout();
+    buttonLayout->addStretch();
+
+    cancelButton = new QPushButton("Cancel", this);
+    connect(cancelButton, &QPushButton::clicked, this, &QDialog::reject);
+    buttonLayout->addWidget(cancelButton);
+
+    okButton = new QPushButton("Dump", this);
+    okButton->setDefault(true);
+    connect(okButton, &QPushButton::clicked, this, &QDialog::accept);
+    buttonLayout->addWidget(okButton);
+
+    mainLayout->addLayout(buttonLayout);
+
+    updateState();
+}
+
+void DumpDialog::browseForOutput() {
+    QString path;
+    if (modeCombo->currentIndex() == 1) {
+        path = QFileDialog::getExistingDirectory(this, "Select Dump Directory", QDir::homePath());
+    } else {
+        path = QFileDialog::getSaveFileName(this, "Dump to File", outputEdit->text(),
+                                            "SQL Files (*.sql *.sql.gz *.sql.zst)");
+    }
+    if (path.isEmpty()) {
+        return;
+    }
+
+    outputEdit->setText(path);
+    const Compression compression = CompressedFileWriter::compressionForPath(path);
+    const int index = compressionCombo->findData(QVariant::fromValue(int(compression)));
+    if (compression != Compression::None && index >= 0) {
+        compressionCombo->setCurrentIndex(index);
+    }
+}
+
+void DumpDialog::updateState() {
+    const bool inserts = dataCheck->isChecked()
+        && !(type == DatabaseType::PostgreSQL && copyCheck->isChecked());
+    rowsPerInsertSpin->setEnabled(inserts);
+    copyCheck->setEnabled(dataCheck->isChecked());
+    okButton->setEnabled(!outputEdit->text().trimmed().isEmpty());
+}
+
+DumpOptions DumpDialog::getDumpOptions() const {
+    DumpOptions options;
+    options.schemas = schemas;
+    options.outputPath = outputEdit->text().trimmed();
+    options.filePerTable = modeCombo->currentIndex() == 1;
+    options.compression = Compression(compressionCombo->currentData().toInt());
+    options.includeData = dataCheck->isChecked();
+    options.useCopy = copyCheck->isChecked();
+    options.rowsPerInsert = rowsPerInsertSpin->value();
+    options.parallelTables = parallelSpin->value();
+    return options;
+}
@@ -0,0 +1,156 @@
+#include "ui/generate_data_dialog.h"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QFormLayout>
+#include <QComboBox>
+#include <QHeaderView>
+#include <QLabel>
+#include <QThread>
+
+namespace {
+enum Column {
+    NameColumn,
+    KindColumn,
+    MinimumColumn,
+    MaximumColumn,
+    NullColumn,
+    UniqueColumn
+};
+
+QString rangeText(const QVariant &value) {
+    switch (value.metaType().id()) {
+        case QMetaType::QDate:
+            return value.toDate().toString(Qt::ISODate);
+        case QMetaType::QDateTime:
+            return value.toDateTime().toString(Qt::ISODate);
+        case QMetaType::QTime:
+            return value.toTime().toString(Qt::ISODate);
+        default:
+            return value.toString();
+    }
+}
+} // namespace
+
+GenerateDataDialog::GenerateDataDialog(DatabaseType type, const QString &table,
+                                       const QList<ColumnGeneratorSpec> &specs, QWidget *parent)
+    : QDialog(parent), type(type), table(table), specs(specs) {
+    setupUI();
+    setWindowTitle(QString("Generate Data for %1").arg(table));
+    resize(760, 480);
+}
+
+void GenerateDataDialog::setupUI() {
+    auto *mainLayout = new QVBoxLayout(this);
+    auto *formLayout = new QFormLayout();
+
+    rowsSpin = new QSpinBox(this);
+    rowsSpin->setRange(1, 2000000000);
+    rowsSpin->setSingleStep(100000);
+    rowsSpin->setGroupSeparatorShown(true);
+    rowsSpin->setValue(int(DataGeneratorOptions().rowCount));
+    formLayout->addRow("Rows:", rowsSpin);
+
+    workersSpin = new QSpinBox(this);
+    workersSpin->setRange(1, 64);
+    workersSpin->setValue(qMax(1, QThread::idealThreadCount() / 2));
+    formLayout->addRow("Generating threads:", workersSpin);
+
+    // SQLite serializes writers, so it always gets one
+    writersSpin = new QSpinBox(this);
+    writersSpin->setRange(1, 64);
+    writersSpin->setValue(DataGeneratorOptions().writerSessions);
+    writersSpin->setEnabled(type != DatabaseType::SQLite);
+    formLayout->addRow("Writer sessions:", writersSpin);
+
+    seedSpin = new QSpinBox(this);
+    seedSpin->setRange(0, 999999999);
+    seedSpin->setValue(int(DataGeneratorOptions().seed));
+    formLayout->addRow("Seed:", seedSpin);
+
+    mainLayout->addLayout(formLayout);
+
+    auto *hint = new QLabel("Text columns take a length range; NULL % applies to every generator.", this);
+    hint->setWordWrap(true);
+    mainLayout->addWidget(hint);
+
+    columnTable = new QTableWidget(specs.size(), 6, this);
+    columnTable->setHorizontalHeaderLabels({"Column", "Generator", "Minimum", "Maximum", "NULL %", "Unique"});
+    columnTable->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    columnTable->horizontalHeader()->setStretchLastSection(true);
+    columnTable->verticalHeader()->hide();
+
+    const QList<GeneratorKind> kinds = {GeneratorKind::Skip, GeneratorKind::Sequence, GeneratorKind::Uniform,
+                                        GeneratorKind::Normal, GeneratorKind::Zipf, GeneratorKind::Sample,
+                                        GeneratorKind::Constant};
+    for (int row = 0; row < specs.size(); ++row) {
+        const ColumnGeneratorSpec &spec = specs.at(row);
+
+        auto *name = new QTableWidgetItem(spec.column);
+        name->setFlags(name->flags() & ~Qt::ItemIsEditable);
+        if (spec.kind == GeneratorKind::Sample) {
+            name->setToolTip(QString("References %1.%2").arg(spec.parentTable, spec.parentColumn));
+        }
+        columnTable->setItem(row, NameColumn, name);
+
+        auto *kindCombo = new QComboBox(columnTable);
+        for (GeneratorKind kind : kinds) {
+            // Parent values only make sense where there is a parent
+            if (kind == GeneratorKind::Sample && spec.parentTable.isEmpty()) {
+                continue;
+            }
+            kindCombo->addItem(DataGenerator::kindName(kind), QVariant::fromValue(int(kind)));
+        }
+        kindCombo->setCurrentIndex(kindCombo->findData(QVariant::fromValue(int(spec.kind))));
+        columnTable->setCellWidget(row, KindColumn, kindCombo);
+
+        columnTable->setItem(row, MinimumColumn, new QTableWidgetItem(rangeText(spec.minimum)));
+        columnTable->setItem(row, MaximumColumn, new QTableWidgetItem(rangeText(spec.maximum)));
+        columnTable->setItem(row, NullColumn, new QTableWidgetItem(QString::number(spec.nullRatio * 100.0)));
+
+        auto *unique = new QTableWidgetItem();
+        unique->setFlags(Qt::ItemIsUserCheckable | Qt::ItemIsEnabled);
+        unique->setCheckState(spec.unique ? Qt::Checked : Qt::Unchecked);
+        columnTable->setItem(row, UniqueColumn, unique);
+    }
+    mainLayout->addWidget(columnTable, 1);
+
+    // Buttons
+    auto *buttonLayout = new QHBoxLayout();
+    buttonLayout->addStretch();
+
+    cancelButton = new QPushButton("Cancel", this);
+    connect(cancelButton, &QPushButton::clicked, this, &QDialog::reject);
+    buttonLayout->addWidget(cancelButton);
+
+    okButton = new QPushButton("Generate", this);
+    okButton->setDefault(true);
+    connect(okButton, &QPushButton::clicked, this, &QDialog::accept);
+    buttonLayout->addWidget(okButton);
+
+    mainLayout->addLayout(buttonLayout);
+}
+
+DataGeneratorOptions GenerateDataDialog::getGeneratorOptions() const {
+    DataGeneratorOptions options;
+    options.table = table;
+    options.rowCount = rowsSpin->value();
+    options.workers = workersSpin->value();
+    options.writerSessions = writersSpin->value();
+    options.seed = quint64(seedSpin->value());
+
+    for (int row = 0; row < specs.size(); ++row) {
+        ColumnGeneratorSpec spec = specs.at(row);
+        auto *kindCombo = qobject_cast<QComboBox *>(columnTable->cellWidget(row, KindColumn));
+        spec.kind = GeneratorKind(kindCombo->currentData().toInt());
+
+        // Typed values are converted by the generator; empty means unset
+        const QString minimum = columnTable->item(row, MinimumColumn)->text().trimmed();
+        const QString maximum = columnTable->item(row, MaximumColumn)->text().trimmed();
+        spec.minimum = minimum.isEmpty() ? QVariant() : QVariant(minimum);
+        spec.maximum = maximum.isEmpty() ? QVariant() : QVariant(maximum);
+        spec.nullRatio = qBound(0.0, columnTable->item(row, NullColumn)->text().toDouble() / 100.0, 1.0);
+        spec.unique = columnTable->item(row, UniqueColumn)->checkState() == Qt::Checked;
+        options.columns << spec;
+    }
+    return options;
+}
@@ -0,0 +1,171 @@
+#include "ui/import_dialog.h"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QFormLayout>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QHeaderView>
+#include <QLabel>
+#include <QMessageBox>
+#include <QDir>
+
+namespace {
+constexpr int kPreviewRows = 20;
+}
+
+ImportDialog::ImportDialog(const QString &schema, QWidget *parent)
+    : QDialog(parent), schema(schema) {
+    setupUI();
+    setWindowTitle("Import CSV");
+    resize(700, 520);
+}
+
+void ImportDialog::setupUI() {
+    auto *mainLayout = new QVBoxLayout(this);
+    auto *formLayout = new QFormLayout();
+
+    // Source file
+    auto *fileLayout = new QHBoxLayout();
+    fileEdit = new QLineEdit(this);
+    browseButton = new QPushButton("Browse...", this);
+    connect(browseButton, &QPushButton::clicked, this, &ImportDialog::browseForFile);
+    connect(fileEdit, &QLineEdit::editingFinished, this, &ImportDialog::updatePreview);
+    fileLayout->addWidget(fileEdit);
+    fileLayout->addWidget(browseButton);
+    formLayout->addRow("File:", fileLayout);
+
+    delimiterCombo = new QComboBox(this);
+    delimiterCombo->addItem("Comma (,)", QVariant::fromValue(int(',')));
+    delimiterCombo->addItem("Tab", QVariant::fromValue(int('\t')));
+    delimiterCombo->addItem("Semicolon (;)", QVariant::fromValue(int(';')));
+    delimiterCombo->addItem("Pipe (|)", QVariant::fromValue(int('|')));
+    connect(delimiterCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &ImportDialog::updatePreview);
+    formLayout->addRow("Delimiter:", delimiterCombo);
+
+    headerCheck = new QCheckBox("First row contains column names", this);
+    headerCheck->setChecked(true);
+    connect(headerCheck, &QCheckBox::toggled, this, &ImportDialog::updatePreview);
+    formLayout->addRow("", headerCheck);
+
+    // Target
+    tableEdit = new QLineEdit(this);
+    tableEdit->setPlaceholderText("Created with TEXT columns if it doesn't exist");
+    formLayout->addRow("Target table:", tableEdit);
+
+    emptyIsNullCheck = new QCheckBox("Load empty unquoted fields as NULL", this);
+    emptyIsNullCheck->setChecked(true);
+    formLayout->addRow("", emptyIsNullCheck);
+
+    batchSpin = new QSpinBox(this);
+    batchSpin->setRange(100, 1000000);
+    batchSpin->setSingleStep(10000);
+    batchSpin->setValue(CsvImporter::kDefaultBatchRows);
+    batchSpin->setSuffix(" rows");
+    formLayout->addRow("Batch size:", batchSpin);
+
+    mainLayout->addLayout(formLayout);
+
+    mainLayout->addWidget(new QLabel("Preview:", this));
+    previewTable = new QTableWidget(this);
+    previewTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    previewTable->horizontalHeader()->setStretchLastSection(true);
+    mainLayout->addWidget(previewTable, 1);
+
+    // Buttons
+    auto *buttonLayout = new QHBoxLayout();
+    buttonLayout->addStretch();
+
+    cancelButton = new QPushButton("Cancel", this);
+    connect(cancelButton, &QPushButton::clicked, this, &QDialog::reject);
+    buttonLayout->addWidget(cancelButton);
+
+    okButton = new QPushButton("Import", this);
+    okButton->setDefault(true);
+    connect(okButton, &QPushButton::clicked, this, &ImportDialog::onAccept);
+    buttonLayout->addWidget(okButton);
+
+    mainLayout->addLayout(buttonLayout);
+}
+
+char ImportDialog::delimiter() const {
+    return char(delimiterCombo->currentData().toInt());
+}
+
+void ImportDialog::browseForFile() {
+    const QString filePath = QFileDialog::getOpenFileName(
+        this, "Select CSV File", QDir::homePath(), "CSV Files (*.csv *.tsv *.txt);;All Files (*)");
+    if (filePath.isEmpty()) {
+        return;
+    }
+
+    fileEdit->setText(filePath);
+    if (filePath.endsWith(".tsv", Qt::CaseInsensitive)) {
+        delimiterCombo->setCurrentIndex(1);
+    }
+    if (tableEdit->text().isEmpty()) {
+        const QString baseName = QFileInfo(filePath).baseName();
+        tableEdit->setText(schema.isEmpty() ? baseName : schema + "." + baseName);
+    }
+    updatePreview();
+}
+
+void ImportDialog::updatePreview() {
+    previewTable->clear();
+    previewTable->setRowCount(0);
+    previewTable->setColumnCount(0);
+
+    const QString filePath = fileEdit->text().trimmed();
+    if (filePath.isEmpty()) {
+        return;
+    }
+
+    QString error;
+    QList<QStringList> rows = CsvImporter::preview(filePath, delimiter(), kPreviewRows + 1, &error);
+    if (rows.isEmpty()) {
+        return;
+    }
+
+    int columnCount = 0;
+    for (const QStringList &row : rows) {
+        columnCount = qMax(columnCount, int(row.size()));
+    }
+    previewTable->setColumnCount(columnCount);
+
+    if (headerCheck->isChecked()) {
+        previewTable->setHorizontalHeaderLabels(rows.takeFirst());
+    } else if (rows.size() > kPreviewRows) {
+        rows.removeLast();
+    }
+
+    previewTable->setRowCount(rows.size());
+    for (int r = 0; r < rows.size(); ++r) {
+        for (int c = 0; c < rows[r].size(); ++c) {
+            const QString &value = rows[r][c];
+            previewTable->setItem(r, c, new QTableWidgetItem(value.isNull() ? QString("NULL") : value));
+        }
+    }
+}
+
+void ImportDialog::onAccept() {
+    if (!QFileInfo::exists(fileEdit->text().trimmed())) {
+        QMessageBox::warning(this, "Import CSV", "Please choose an existing file.");
+        return;
+    }
+    if (tableEdit->text().trimmed().isEmpty()) {
+        QMessageBox::warning(this, "Import CSV", "Please enter a target table.");
+        return;
+    }
+    accept();
+}
+
+CsvImportOptions ImportDialog::getImportOptions() const {
+    CsvImportOptions options;
+    options.filePath = fileEdit->text().trimmed();
+    options.delimiter = delimiter();
+    options.hasHeader = headerCheck->isChecked();
+    options.tableName = tableEdit->text().trimmed();
+    options.emptyIsNull = emptyIsNullCheck->isChecked();
+    options.batchRows = batchSpin->value();
+    return options;
+}
@@ -3,7 +3,12 @@
 #include "core/utils.h"
 #include "connection_manager.h"
 #include "core/connection_storage.h"
+#include "core/catalog_cache.h"
 #include "connection_dialog.h"
+#include "connection_group_dialog.h"
+#include "object_palette.h"
+#include "schema_diff_dialog.h"
+#include "transfer_runner.h"
 #include "sql_editor.h"
 #include "table_viewer.h"
 #include <QApplication>
@@ -23,6 +28,7 @@
 #include <QProgressDialog>
 #include <QTimer>
 #include <QtConcurrent>
+#include <memory>
 
 namespace {
 
@@ -82,6 +88,11 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
             "Failed to initialize connection storage. Connections will not be saved.");
     }
 
+    // Without the cache the tree just loads from the servers every time
+    if (!CatalogCache::instance().initialize()) {
+        qWarning() << "Catalog cache unavailable";
+    }
+
     setupUI();
     loadSavedConnections();
 }
@@ -129,6 +140,9 @@ void MainWindow::setupUI() {
     connect(tabWidget, &QTabWidget::tabCloseRequested, this, [this](int index) {
         QWidget *widget = tabWidget->widget(index);
         tabWidget->removeTab(index);
+        if (auto *editor = qobject_cast<SQLEditor*>(widget)) {
+            releaseScratchpad(editor->getConnectionName());
+        }
         widget->deleteLater();
     });
 
@@ -293,6 +307,8 @@ void MainWindow::setupUI() {
     // shortcuts
     auto *newConnShortcut = new QShortcut(QKeySequence(Qt::CTRL | Qt::Key_T), this);
     connect(newConnShortcut, &QShortcut::activated, this, &MainWindow::addNewConnection);
+    auto *objectPaletteShortcut = new QShortcut(QKeySequence(Qt::CTRL | Qt::Key_P), this);
+    connect(objectPaletteShortcut, &QShortcut::activated, this, &MainWindow::openObjectPalette);
 }
 
 void MainWindow::setupSidebar() {
@@ -330,6 +346,8 @@ void MainWindow::setupSidebar() {
     treeModel = new ConnectionTreeModel(this);
     connectionTree->setModel(treeModel);
     connectionTree->setHeaderHidden(true);
+    // Folders can hold tens of thousands of rows; skip measuring each one
+    connectionTree->setUniformRowHeights(true);
     connectionTree->setAnimated(true);
     connectionTree->setExpandsOnDoubleClick(false);
     connectionTree->setContextMenuPolicy(Qt::CustomContextMenu);
@@ -384,23 +402,26 @@ void MainWindow::setupSidebar() {
     connect(connectionTree, &QTreeView::doubleClicked, this, &MainWindow::onTreeItemDoubleClicked);
     connect(connectionTree, &QTreeView::customContextMenuRequested, this, &MainWindow::onTreeItemContextMenu);
     connect(connectionTree, &QTreeView::expanded, this, [this](const QModelIndex &index) {
-        auto *item = dynamic_cast<TreeItem*>(treeModel->itemFromIndex(index));
-        if (!item) return;
+        treeModel->setExpanded(index, true);
+        const TreeItem item = treeModel->itemAt(index);
+        if (!item.isValid()) return;
 
         // Handle connection node expansion
-        if (item->getType() == TreeItemType::Connection && !item->isLoaded()) {
-            treeModel->connectToDatabase(item);
+        if (item.getType() == TreeItemType::Connection && !item.isLoaded()) {
+            treeModel->connectToDatabase(index);
             return;
         }
 
-        // Handle folder expansion
-        if (item && !item->isLoaded() &&
-            (item->getType() == TreeItemType::TablesFolder ||
-             item->getType() == TreeItemType::ViewsFolder ||
-             item->getType() == TreeItemType::SequencesFolder)) {
-            treeModel->loadFolderContentsAsync(item);
+        // Handle folder expansion; loaded folders may have been left stale by a refresh
+        if (item.getType() == TreeItemType::TablesFolder ||
+            item.getType() == TreeItemType::ViewsFolder ||
+            item.getType() == TreeItemType::SequencesFolder) {
+            treeModel->loadFolderContentsAsync(index);
         }
     });
+    connect(connectionTree, &QTreeView::collapsed, this, [this](const QModelIndex &index) {
+        treeModel->setExpanded(index, false);
+    });
 
     connect(treeModel, &ConnectionTreeModel::connectionFinished, this, [this](const QString &name, bool success, const QString &error) {
         if (!success) {
@@ -481,15 +502,15 @@ void MainWindow::addNewConnection() {
 void MainWindow::onTreeItemDoubleClicked(const QModelIndex &index) {
     if (!index.isValid()) return;
 
-    auto *item = dynamic_cast<TreeItem*>(treeModel->itemFromIndex(index));
-    if (!item) return;
+    const TreeItem item = treeModel->itemAt(index);
+    if (!item.isValid()) return;
 
-    if (item->getType() == TreeItemType::Table) {
+    if (item.getType() == TreeItemType::Table) {
         // Load table data in a new tab
-        QString connectionName = item->getConnectionName();
-        QString tableName = item->text();
-        QString schemaName = item->getSchemaName();
-        QString databaseName = item->getDatabaseName();
+        QString connectionName = item.getConnectionName();
+        QString tableName = item.text();
+        QString schemaName = item.getSchemaName();
+        QString databaseName = item.getDatabaseName();
 
         // Get the actual database connection to verify it's connected
         DatabaseConnection *conn = ConnectionManager::instance().getConnection(connectionName);
@@ -509,43 +530,105 @@ void MainWindow::onTreeItemContextMenu(const QPoint &pos) {
     QModelIndex index = connectionTree->indexAt(pos);
     if (!index.isValid()) return;
 
-    auto *item = dynamic_cast<TreeItem*>(treeModel->itemFromIndex(index));
-    if (!item) return;
+    const TreeItem item = treeModel->itemAt(index);
+    if (!item.isValid()) return;
 
     QMenu contextMenu(this);
 
     // Add "Open SQL Editor" for connection, database, or schema items
-    if (item->getType() == TreeItemType::Connection ||
-        item->getType() == TreeItemType::Database ||
-        item->getType() == TreeItemType::Schema) {
+    if (item.getType() == TreeItemType::Connection ||
+        item.getType() == TreeItemType::Database ||
+        item.getType() == TreeItemType::Schema) {
 
         QAction *sqlEditorAction = contextMenu.addAction("Open SQL Editor");
         connect(sqlEditorAction, &QAction::triggered, this, [this, item]() {
             // Get connection
-            QString connectionName = item->getConnectionName();
+            QString connectionName = item.getConnectionName();
             DatabaseConnection *conn = ConnectionManager::instance().getConnection(connectionName);
             if (conn && conn->isConnected()) {
                 // Set context based on item type
-                QString database = item->getDatabaseName();
-                QString schema = item->getSchemaName();
+                QString database = item.getDatabaseName();
+                QString schema = item.getSchemaName();
                 openSQLEditor(connectionName, database, schema);
             }
         });
     }
 
+    if (item.getType() == TreeItemType::Table || item.getType() == TreeItemType::View) {
+        QAction *exportAction = contextMenu.addAction("Export to File...");
+        connect(exportAction, &QAction::triggered, this, [this, item]() {
+            TransferRunner::exportTable(this, item.getConnectionName(), item.text(), item.getOwnerName());
+        });
+
+        QAction *copyAction = contextMenu.addAction("Copy Table to Connection...");
+        connect(copyAction, &QAction::triggered, this, [this, item]() {
+            const QString table = item.getOwnerName().isEmpty()
+                ? item.text() : item.getOwnerName() + "." + item.text();
+            TransferRunner::copyTable(this, item.getConnectionName(), table);
+        });
+    }
+
+    if (item.getType() == TreeItemType::Table) {
+        QAction *compareAction = contextMenu.addAction("Compare Data with Table...");
+        connect(compareAction, &QAction::triggered, this, [this, item]() {
+            const QString table = item.getOwnerName().isEmpty()
+                ? item.text() : item.getOwnerName() + "." + item.text();
+            TransferRunner::compareTable(this, item.getConnectionName(), table);
+        });
+
+        QAction *generateAction = contextMenu.addAction("Generate Test Data...");
+        connect(generateAction, &QAction::triggered, this, [this, item]() {
+            const QString table = item.getOwnerName().isEmpty()
+                ? item.text() : item.getOwnerName() + "." + item.text();
+            TransferRunner::generateData(this, item.getConnectionName(), table);
+        });
+    }
+
+    if (item.getType() == TreeItemType::Connection ||
+        item.getType() == TreeItemType::Database ||
+        item.getType() == TreeItemType::Schema) {
+        QAction *importCsvAction = contextMenu.addAction("Import CSV...");
+        connect(importCsvAction, &QAction::triggered, this, [this, item]() {
+            TransferRunner::importCsvFile(this, item.getConnectionName(), item.getOwnerName());
+        });
+
+        QAction *importArrowAction = contextMenu.addAction("Import Arrow File...");
+        connect(importArrowAction, &QAction::triggered, this, [this, item]() {
+            TransferRunner::importArrowFile(this, item.getConnectionName(), item.getOwnerName());
+        });
+
+        QAction *dumpAction = contextMenu.addAction("Dump to SQL...");
+        connect(dumpAction, &QAction::triggered, this, [this, item]() {
+            TransferRunner::dumpSchema(this, item.getConnectionName(), item.getDatabaseName(),
+                                       item.getSchemaName());
+        });
+
+        QAction *compareSchemaAction = contextMenu.addAction("Compare Schema with...");
+        connect(compareSchemaAction, &QAction::triggered, this, [this, item]() {
+            openSchemaDiff(item);
+        });
+    }
+
+    if (item.getType() == TreeItemType::Connection) {
+        QAction *groupAction = contextMenu.addAction("Run on Connection Group...");
+        connect(groupAction, &QAction::triggered, this, [this, item]() {
+            openGroupSQLEditor(item.getConnectionName());
+        });
+    }
+
     // Add "Refresh" for all items
     contextMenu.addSeparator();
     QAction *refreshAction = contextMenu.addAction("Refresh");
     connect(refreshAction, &QAction::triggered, this, [this, item]() {
-        treeModel->refreshConnection(item->getConnectionName());
+        treeModel->refreshConnection(item.getConnectionName());
     });
 
     // Add "Delete Connection" for connection items
-    if (item->getType() == TreeItemType::Connection) {
+    if (item.getType() == TreeItemType::Connection) {
         contextMenu.addSeparator();
         QAction *deleteAction = contextMenu.addAction("Delete Connection");
         connect(deleteAction, &QAction::triggered, this, [this, item]() {
-            QString connectionName = item->getConnectionName();
+            QString connectionName = item.getConnectionName();
 
             QMessageBox::StandardButton reply = QMessageBox::question(
                 this,
@@ -557,13 +640,14 @@ void MainWindow::onTreeItemContextMenu(const QPoint &pos) {
             if (reply == QMessageBox::Yes) {
                 // Remove from storage
                 ConnectionStorage::instance().removeConnection(connectionName);
+                CatalogCache::instance().remove(connectionName);
+
+                // Remove from tree first, which cancels its pending loads
+                treeModel->removeConnection(connectionName);
 
                 // Remove from manager
                 ConnectionManager::instance().removeConnection(connectionName);
 
-                // Remove from tree
-                treeModel->removeConnection(connectionName);
-
                 qDebug() << "Deleted connection:" << connectionName;
             }
         });
@@ -594,10 +678,123 @@ void MainWindow::openSQLEditor(const QString &connectionName, const QString &dat
     // Create new SQL editor tab
     auto *sqlEditor = new SQLEditor(this);
     sqlEditor->setDatabaseContext(connectionName, database, schema);
+    connect(sqlEditor, &SQLEditor::scratchpadReady, this, [this](const QString &scratchpadName, const QString &tableName) {
+        openSQLEditor(scratchpadName);
+        if (auto *editor = qobject_cast<SQLEditor*>(tabWidget->currentWidget())) {
+            editor->setQueryText(QString("SELECT * FROM %1;").arg(tableName));
+        }
+    });
     int tabIndex = tabWidget->addTab(sqlEditor, tabName);
     tabWidget->setCurrentIndex(tabIndex);
 }
 
+void MainWindow::releaseScratchpad(const QString &connectionName) {
+    DatabaseConnection *conn = ConnectionManager::instance().getConnection(connectionName);
+    if (!conn || !conn->isScratchpad()) {
+        return;
+    }
+    for (int i = 0; i < tabWidget->count(); ++i) {
+        auto *editor = qobject_cast<SQLEditor*>(tabWidget->widget(i));
+        if (editor && editor->getConnectionName() == connectionName) {
+            return;
+        }
+    }
+    // Sessions of worker threads still holding the memory database close with their threads
+    ConnectionManager::instance().removeConnection(connectionName);
+}
+
+void MainWindow::openSchemaDiff(const TreeItem &item) {
+    const QString connectionName = item.getConnectionName();
+    DatabaseConnection *conn = ConnectionManager::instance().getConnection(connectionName);
+    if (!conn || !conn->isConnected()) {
+        QMessageBox::critical(this, "Compare Failed", "The connection is not open.");
+        return;
+    }
+
+    // MySQL's databases are its schemas; a connection stands for its default one
+    QString schema = item.getSchemaName();
+    if (schema.isEmpty() && conn->getType() == DatabaseType::MySQL) {
+        schema = item.getDatabaseName();
+    }
+    if (schema.isEmpty()) {
+        schema = conn->defaultSchema();
+    }
+
+    auto *dialog = new SchemaDiffDialog(connectionName, schema, this);
+    dialog->setAttribute(Qt::WA_DeleteOnClose);
+    connect(dialog, &SchemaDiffDialog::migrationRequested, this,
+            [this](const QString &targetConnection, const QString &targetSchema, const QString &script) {
+        // A tab of its own, so an open editor on the same schema keeps its text
+        auto *sqlEditor = new SQLEditor(this);
+        sqlEditor->setDatabaseContext(targetConnection, QString(), targetSchema);
+        sqlEditor->setQueryText(script);
+        const QString tabName = QString("Migration - %1").arg(targetSchema.isEmpty() ? targetConnection : targetSchema);
+        tabWidget->setCurrentIndex(tabWidget->addTab(sqlEditor, tabName));
+    });
+    dialog->show();
+}
+
+void MainWindow::openObjectPalette() {
+    treeModel->indexCachedCatalogs();
+
+    ObjectPalette palette(treeModel->objectIndex(), this);
+    connect(treeModel, &ConnectionTreeModel::objectIndexChanged, &palette, &ObjectPalette::refresh);
+    if (palette.exec() != QDialog::Accepted) {
+        return;
+    }
+    const ObjectSearchResult object = palette.getSelectedObject();
+    if (object.name.isEmpty()) {
+        return;
+    }
+
+    // scrollTo expands the parents, which loads whatever isn't loaded yet
+    const QModelIndex index = treeModel->revealObject(object.connection, object.schema, object.kind, object.name);
+    if (!index.isValid()) {
+        return;
+    }
+    connectionTree->scrollTo(index, QAbstractItemView::PositionAtCenter);
+    connectionTree->setCurrentIndex(index);
+    if (treeModel->itemAt(index).getType() != TreeItemType::Table) {
+        return;
+    }
+    DatabaseConnection *conn = ConnectionManager::instance().getConnection(object.connection);
+    if (conn && conn->isConnected()) {
+        onTreeItemDoubleClicked(index);
+        return;
+    }
+
+    // Revealing started connecting; the table opens once that succeeds, from the
+    // tree as it stands then
+    auto pending = std::make_shared<QMetaObject::Connection>();
+    *pending = connect(treeModel, &ConnectionTreeModel::connectionFinished, this,
+                       [this, object, pending](const QString &name, bool success) {
+        if (name != object.connection) {
+            return;
+        }
+        disconnect(*pending);
+        if (!success) {
+            return;
+        }
+        const QModelIndex table = treeModel->revealObject(object.connection, object.schema, object.kind, object.name);
+        if (table.isValid() && treeModel->itemAt(table).getType() == TreeItemType::Table) {
+            onTreeItemDoubleClicked(table);
+        }
+    });
+}
+
+void MainWindow::openGroupSQLEditor(const QString &initialConnection) {
+    ConnectionGroupDialog dialog(initialConnection, this);
+    if (dialog.exec() != QDialog::Accepted) {
+        return;
+    }
+
+    const QStringList connections = dialog.getSelectedConnections();
+    auto *sqlEditor = new SQLEditor(this);
+    sqlEditor->setConnectionGroup(connections, dialog.getMaxConcurrency());
+    int tabIndex = tabWidget->addTab(sqlEditor, QString("SQL Editor - Group (%1)").arg(connections.size()));
+    tabWidget->setCurrentIndex(tabIndex);
+}
+
 void MainWindow::openTableInTab(const QString &connectionName, const QString &tableName,
                                  const QString &databaseName, const QString &schemaName) {
     // Display just the table name in tab, but use full qualified name for query
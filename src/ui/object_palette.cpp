@@ -0,0 +1,87 @@
+#include "ui/object_palette.h"
+#include <QVBoxLayout>
+#include <QKeyEvent>
+#include <QIcon>
+#include <QCoreApplication>
+
+ObjectPalette::ObjectPalette(ObjectSearchIndex *index, QWidget *parent)
+    : QDialog(parent), index(index) {
+    setupUI();
+    setWindowTitle("Go to Object");
+    resize(560, 420);
+}
+
+void ObjectPalette::setupUI() {
+    auto *mainLayout = new QVBoxLayout(this);
+
+    queryEdit = new QLineEdit(this);
+    queryEdit->setPlaceholderText(QString("Search %1 objects...").arg(index->size()));
+    queryEdit->installEventFilter(this);
+    connect(queryEdit, &QLineEdit::textChanged, this, &ObjectPalette::updateResults);
+    mainLayout->addWidget(queryEdit);
+
+    resultList = new QListWidget(this);
+    resultList->setUniformItemSizes(true);
+    connect(resultList, &QListWidget::itemActivated, this, &QDialog::accept);
+    mainLayout->addWidget(resultList, 1);
+
+    queryEdit->setFocus();
+}
+
+void ObjectPalette::updateResults(const QString &query) {
+    results = index->search(query, kMaxResults);
+
+    resultList->clear();
+    for (const ObjectSearchResult &result : std::as_const(results)) {
+        // Where the object lives, after its name
+        QString location = result.connection;
+        if (!result.schema.isEmpty()) {
+            location += "." + result.schema;
+        }
+        auto *item = new QListWidgetItem(QString("%1    %2").arg(result.name, location), resultList);
+        item->setIcon(QIcon(result.kind == RelationKind::View ? ":/icons/assets/icons/view.svg"
+            : result.kind == RelationKind::Sequence ? ":/icons/assets/icons/sequence.svg"
+            : ":/icons/assets/icons/table.svg"));
+    }
+    if (resultList->count() > 0) {
+        resultList->setCurrentRow(0);
+    }
+}
+
+void ObjectPalette::refresh() {
+    queryEdit->setPlaceholderText(QString("Search %1 objects...").arg(index->size()));
+    const int row = resultList->currentRow();
+    updateResults(queryEdit->text());
+    if (row > 0 && row < resultList->count()) {
+        resultList->setCurrentRow(row);
+    }
+}
+
+bool ObjectPalette::eventFilter(QObject *watched, QEvent *event) {
+    // Arrow keys move through the results while typing continues in the edit
+    if (watched == queryEdit && event->type() == QEvent::KeyPress) {
+        auto *keyEvent = static_cast<QKeyEvent*>(event);
+        switch (keyEvent->key()) {
+            case Qt::Key_Up:
+            case Qt::Key_Down:
+            case Qt::Key_PageUp:
+            case Qt::Key_PageDown:
+                QCoreApplication::sendEvent(resultList, event);
+                return true;
+            case Qt::Key_Return:
+            case Qt::Key_Enter:
+                if (resultList->currentRow() >= 0) {
+                    accept();
+                }
+                return true;
+            default:
+                break;
+        }
+    }
+    return QDialog::eventFilter(watched, event);
+}
+
+ObjectSearchResult ObjectPalette::getSelectedObject() const {
+    const int row = resultList->currentRow();
+    return row >= 0 && row < results.size() ? results.at(row) : ObjectSearchResult();
+}
@@ -0,0 +1,259 @@
+#include "ui/result_copier.h"
+#include <QApplication>
+#include <QClipboard>
+#include <QFile>
+#include <QFileDialog>
+#include <QFutureWatcher>
+#include <QItemSelectionModel>
+#include <QKeyEvent>
+#include <QMessageBox>
+#include <QProgressDialog>
+#include <QPushButton>
+#include <QtConcurrent>
+#include <algorithm>
+#include <memory>
+
+namespace {
+constexpr int kChunkRows = 10000;
+constexpr int kFileThresholdRows = 100000;
+
+struct RowChunk {
+    int begin;
+    int end;
+};
+
+QVector<RowChunk> splitIntoChunks(int rowCount) {
+    QVector<RowChunk> chunks;
+    for (int begin = 0; begin < rowCount; begin += kChunkRows) {
+        chunks.append({begin, qMin(begin + kChunkRows, rowCount)});
+    }
+    return chunks;
+}
+
+QString fileFilterFor(ResultFormat format) {
+    switch (format) {
+        case ResultFormat::TSV:
+            return "TSV Files (*.tsv *.txt)";
+        case ResultFormat::CSV:
+            return "CSV Files (*.csv)";
+        case ResultFormat::Markdown:
+            return "Markdown Files (*.md)";
+        case ResultFormat::SqlInsert:
+            return "SQL Files (*.sql)";
+        case ResultFormat::NDJson:
+            return "JSON Lines Files (*.ndjson *.jsonl)";
+    }
+    return QString();
+}
+} // namespace
+
+ResultCopier::ResultCopier(QTableView *view, QWidget *dialogParent)
+    : QObject(dialogParent), view(view), dialogParent(dialogParent),
+      dialect(DatabaseType::SQLite), busy(false) {
+    view->installEventFilter(this);
+}
+
+void ResultCopier::setResult(const QueryResult &result, const QString &tableName,
+                             DatabaseType dialect) {
+    this->result = result;
+    this->tableName = tableName;
+    this->dialect = dialect;
+}
+
+void ResultCopier::clear() {
+    result = QueryResult();
+    tableName.clear();
+}
+
+void ResultCopier::addCopyActions(QMenu *menu) {
+    const QList<ResultFormat> formats = {ResultFormat::TSV, ResultFormat::CSV,
+                                         ResultFormat::Markdown, ResultFormat::SqlInsert,
+                                         ResultFormat::NDJson};
+    for (ResultFormat format : formats) {
+        QAction *action = menu->addAction(
+            QString("Copy as %1").arg(ResultSerializer::formatName(format)));
+        action->setEnabled(!busy && !result.records.isEmpty());
+        connect(action, &QAction::triggered, this, [this, format]() {
+            copySelection(format);
+        });
+    }
+}
+
+bool ResultCopier::eventFilter(QObject *watched, QEvent *event) {
+    if (watched == view && event->type() == QEvent::KeyPress) {
+        auto *keyEvent = static_cast<QKeyEvent*>(event);
+        if (keyEvent->matches(QKeySequence::Copy)) {
+            copySelection(ResultFormat::TSV);
+            return true;
+        }
+    }
+    return QObject::eventFilter(watched, event);
+}
+
+QVector<int> ResultCopier::selectedRows() const {
+    QVector<int> rows;
+    if (!view->selectionModel()) {
+        return rows;
+    }
+
+    // Walk selection ranges instead of selectedRows() so Ctrl+A on a huge
+    // result doesn't materialize one QModelIndex per cell
+    const int recordCount = result.records.size();
+    const QItemSelection selection = view->selectionModel()->selection();
+    for (const QItemSelectionRange &range : selection) {
+        const int bottom = qMin(range.bottom(), recordCount - 1);
+        for (int row = range.top(); row <= bottom; ++row) {
+            rows.append(row);
+        }
+    }
+
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+    return rows;
+}
+
+void ResultCopier::copySelection(ResultFormat format) {
+    if (busy || result.records.isEmpty()) {
+        return;
+    }
+
+    const QVector<int> rows = selectedRows();
+    if (rows.isEmpty()) {
+        return;
+    }
+
+    ResultSerializer serializer(format, result.columnNames, tableName, dialect);
+
+    if (rows.size() > kFileThresholdRows) {
+        QMessageBox box(dialogParent);
+        box.setIcon(QMessageBox::Question);
+        box.setWindowTitle("Copy Rows");
+        box.setText(QString("Copying %1 rows to the clipboard can use a lot of memory.\n"
+                            "Save them to a file instead?").arg(rows.size()));
+        QPushButton *fileButton = box.addButton("Save to File...", QMessageBox::AcceptRole);
+        QPushButton *clipboardButton = box.addButton("Copy Anyway", QMessageBox::ActionRole);
+        box.addButton(QMessageBox::Cancel);
+        box.setDefaultButton(fileButton);
+        box.exec();
+
+        if (box.clickedButton() == fileButton) {
+            QString filePath = QFileDialog::getSaveFileName(
+                dialogParent, "Save Rows", QString(), fileFilterFor(format));
+            if (!filePath.isEmpty()) {
+                copyToFile(serializer, rows, filePath);
+            }
+            return;
+        }
+        if (box.clickedButton() != clipboardButton) {
+            return;
+        }
+    }
+
+    copyToClipboard(serializer, rows);
+}
+
+void ResultCopier::copyToClipboard(const ResultSerializer &serializer, const QVector<int> &rows) {
+    busy = true;
+
+    const QList<QSqlRecord> records = result.records;
+    const QVector<RowChunk> chunks = splitIntoChunks(rows.size());
+
+    QFuture<QString> future = QtConcurrent::mappedReduced<QString>(
+        chunks,
+        [serializer, records, rows](const RowChunk &chunk) {
+            QString text;
+            for (int i = chunk.begin; i < chunk.end; ++i) {
+                serializer.appendRecord(text, records.at(rows.at(i)));
+            }
+            return text;
+        },
+        [](QString &text, const QString &part) {
+            text += part;
+        },
+        serializer.header(),
+        QtConcurrent::OrderedReduce | QtConcurrent::SequentialReduce);
+
+    auto *progress = new QProgressDialog(
+        QString("Copying %1 rows...").arg(rows.size()), "Cancel", 0, chunks.size(), dialogParent);
+    progress->setWindowModality(Qt::WindowModal);
+    progress->setMinimumDuration(300);
+    progress->setAutoClose(false);
+    progress->setAutoReset(false);
+
+    auto *watcher = new QFutureWatcher<QString>(this);
+    connect(watcher, &QFutureWatcher<QString>::progressValueChanged, progress, &QProgressDialog::setValue);
+    connect(progress, &QProgressDialog::canceled, watcher, &QFutureWatcher<QString>::cancel);
+    connect(watcher, &QFutureWatcher<QString>::finished, this, [this, watcher, progress, rows]() {
+        progress->close();
+        progress->deleteLater();
+        busy = false;
+
+        if (watcher->isCanceled()) {
+            emit statusMessage("Copy cancelled");
+        } else {
+            QApplication::clipboard()->setText(watcher->result());
+            emit statusMessage(QString("Copied %1 rows").arg(rows.size()));
+        }
+        watcher->deleteLater();
+    });
+    watcher->setFuture(future);
+}
+
+void ResultCopier::copyToFile(const ResultSerializer &serializer, const QVector<int> &rows,
+                              const QString &filePath) {
+    auto file = std::make_shared<QFile>(filePath);
+    if (!file->open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        QMessageBox::critical(dialogParent, "Save Failed",
+            QString("Could not open '%1':\n%2").arg(filePath, file->errorString()));
+        return;
+    }
+    file->write(serializer.header().toUtf8());
+
+    busy = true;
+
+    const QList<QSqlRecord> records = result.records;
+    const QVector<RowChunk> chunks = splitIntoChunks(rows.size());
+
+    // Chunks are serialized in parallel and appended to the file in order by the reducer,
+    // so at most a handful of chunks are held in memory at any time
+    QFuture<qint64> future = QtConcurrent::mappedReduced<qint64>(
+        chunks,
+        [serializer, records, rows](const RowChunk &chunk) {
+            QString text;
+            for (int i = chunk.begin; i < chunk.end; ++i) {
+                serializer.appendRecord(text, records.at(rows.at(i)));
+            }
+            return text.toUtf8();
+        },
+        [file](qint64 &written, const QByteArray &part) {
+            written += file->write(part);
+        },
+        qint64(0),
+        QtConcurrent::OrderedReduce | QtConcurrent::SequentialReduce);
+
+    auto *progress = new QProgressDialog(
+        QString("Saving %1 rows...").arg(rows.size()), "Cancel", 0, chunks.size(), dialogParent);
+    progress->setWindowModality(Qt::WindowModal);
+    progress->setMinimumDuration(300);
+    progress->setAutoClose(false);
+    progress->setAutoReset(false);
+
+    auto *watcher = new QFutureWatcher<qint64>(this);
+    connect(watcher, &QFutureWatcher<qint64>::progressValueChanged, progress, &QProgressDialog::setValue);
+    connect(progress, &QProgressDialog::canceled, watcher, &QFutureWatcher<qint64>::cancel);
+    connect(watcher, &QFutureWatcher<qint64>::finished, this, [this, watcher, progress, file, rows]() {
+        progress->close();
+        progress->deleteLater();
+        busy = false;
+
+        file->close();
+        if (watcher->isCanceled()) {
+            file->remove();
+            emit statusMessage("Save cancelled");
+        } else {
+            emit statusMessage(QString("Saved %1 rows to %2").arg(rows.size()).arg(file->fileName()));
+        }
+        watcher->deleteLater();
+    });
+    watcher->setFuture(future);
+}
@@ -0,0 +1,103 @@
+#include "ui/run_script_dialog.h"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QFormLayout>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QHash>
+#include <QDir>
+#include <QRegularExpressionValidator>
+
+namespace {
+QHash<QString, qint64> &resumeOffsets() {
+    static QHash<QString, qint64> offsets;
+    return offsets;
+}
+} // namespace
+
+RunScriptDialog::RunScriptDialog(QWidget *parent)
+    : QDialog(parent) {
+    setupUI();
+    setWindowTitle("Run SQL File");
+    resize(520, 0);
+}
+
+void RunScriptDialog::setupUI() {
+    auto *mainLayout = new QVBoxLayout(this);
+    auto *formLayout = new QFormLayout();
+
+    auto *fileLayout = new QHBoxLayout();
+    fileEdit = new QLineEdit(this);
+    browseButton = new QPushButton("Browse...", this);
+    connect(browseButton, &QPushButton::clicked, this, &RunScriptDialog::browseForFile);
+    connect(fileEdit, &QLineEdit::textChanged, this, &RunScriptDialog::updateState);
+    fileLayout->addWidget(fileEdit);
+    fileLayout->addWidget(browseButton);
+    formLayout->addRow("File:", fileLayout);
+
+    batchSpin = new QSpinBox(this);
+    batchSpin->setRange(1, 100000);
+    batchSpin->setValue(ScriptRunOptions().statementsPerTransaction);
+    batchSpin->setToolTip("1 commits every statement on its own");
+    formLayout->addRow("Statements per transaction:", batchSpin);
+
+    errorCombo = new QComboBox(this);
+    errorCombo->addItem("Stop at the first error");
+    errorCombo->addItem("Log the error and continue");
+    formLayout->addRow("On error:", errorCombo);
+
+    // Byte offsets outgrow QSpinBox
+    offsetEdit = new QLineEdit("0", this);
+    offsetEdit->setValidator(new QRegularExpressionValidator(QRegularExpression("\\d{1,18}"), this));
+    formLayout->addRow("Start at byte:", offsetEdit);
+
+    mainLayout->addLayout(formLayout);
+
+    // Buttons
+    auto *buttonLayout = new QHBoxLayout();
+    buttonLayout->addStretch();
+
+    cancelButton = new QPushButton("Cancel", this);
+    connect(cancelButton, &QPushButton::clicked, this, &QDialog::reject);
+    buttonLayout->addWidget(cancelButton);
+
+    okButton = new QPushButton("Run", this);
+    okButton->setDefault(true);
+    connect(okButton, &QPushButton::clicked, this, &QDialog::accept);
+    buttonLayout->addWidget(okButton);
+
+    mainLayout->addLayout(buttonLayout);
+
+    updateState();
+}
+
+void RunScriptDialog::browseForFile() {
+    const QString filePath = QFileDialog::getOpenFileName(
+        this, "Select SQL File", QDir::homePath(), "SQL Files (*.sql);;All Files (*)");
+    if (filePath.isEmpty()) {
+        return;
+    }
+    fileEdit->setText(filePath);
+}
+
+void RunScriptDialog::updateState() {
+    const QString filePath = QFileInfo(fileEdit->text().trimmed()).absoluteFilePath();
+    const qint64 offset = resumeOffsets().value(filePath, -1);
+    if (offset >= 0) {
+        offsetEdit->setText(QString::number(offset));
+    }
+    okButton->setEnabled(!fileEdit->text().trimmed().isEmpty());
+}
+
+ScriptRunOptions RunScriptDialog::getRunOptions() const {
+    ScriptRunOptions options;
+    options.filePath = fileEdit->text().trimmed();
+    options.startOffset = offsetEdit->text().toLongLong();
+    options.statementsPerTransaction = batchSpin->value();
+    options.stopOnError = errorCombo->currentIndex() == 0;
+    return options;
+}
+
+void RunScriptDialog::rememberResumeOffset(const QString &filePath, qint64 offset) {
+    resumeOffsets().insert(QFileInfo(filePath).absoluteFilePath(), offset);
+}
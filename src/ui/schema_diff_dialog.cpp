@@ -0,0 +1,181 @@
+#include "ui/schema_diff_dialog.h"
+#include "database/connection_manager.h"
+#include <QFormLayout>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLocale>
+#include <QSplitter>
+#include <QVBoxLayout>
+
+SchemaDiffDialog::SchemaDiffDialog(const QString &sourceConnection, const QString &sourceSchema, QWidget *parent)
+    : QDialog(parent), sourceConnection(sourceConnection), sourceSchema(sourceSchema) {
+    setupUI();
+    setWindowTitle("Compare Schemas");
+    resize(900, 640);
+}
+
+void SchemaDiffDialog::setupUI() {
+    auto *mainLayout = new QVBoxLayout(this);
+
+    const QString source = sourceSchema.isEmpty() ? sourceConnection
+                                                  : QString("%1 on %2").arg(sourceSchema, sourceConnection);
+    mainLayout->addWidget(new QLabel(QString("Compare %1 with:").arg(source), this));
+
+    auto *formLayout = new QFormLayout();
+
+    targetConnectionCombo = new QComboBox(this);
+    for (DatabaseConnection *conn : ConnectionManager::instance().getAllConnections()) {
+        if (conn->isConnected() && !conn->isScratchpad()) {
+            targetConnectionCombo->addItem(conn->getName());
+        }
+    }
+    // The usual question is whether staging and production agree
+    const int other = targetConnectionCombo->findText(sourceConnection) == 0 ? 1 : 0;
+    if (other < targetConnectionCombo->count()) {
+        targetConnectionCombo->setCurrentIndex(other);
+    }
+    formLayout->addRow("Target connection:", targetConnectionCombo);
+
+    targetSchemaEdit = new QLineEdit(sourceSchema, this);
+    targetSchemaEdit->setToolTip("Database for MySQL; SQLite files have a single schema");
+    formLayout->addRow("Target schema:", targetSchemaEdit);
+
+    mainLayout->addLayout(formLayout);
+
+    auto *compareLayout = new QHBoxLayout();
+    summaryLabel = new QLabel(this);
+    summaryLabel->setWordWrap(true);
+    compareLayout->addWidget(summaryLabel, 1);
+    compareButton = new QPushButton("Compare", this);
+    compareButton->setDefault(true);
+    connect(compareButton, &QPushButton::clicked, this, &SchemaDiffDialog::runCompare);
+    compareLayout->addWidget(compareButton);
+    mainLayout->addLayout(compareLayout);
+
+    auto *splitter = new QSplitter(Qt::Vertical, this);
+
+    differenceTree = new QTreeWidget(splitter);
+    differenceTree->setColumnCount(4);
+    differenceTree->setHeaderLabels({"Object", "Change", "Source", "Target"});
+    differenceTree->setUniformRowHeights(true);
+    differenceTree->header()->setSectionResizeMode(QHeaderView::Interactive);
+    differenceTree->setColumnWidth(0, 240);
+    differenceTree->setColumnWidth(1, 130);
+    differenceTree->setColumnWidth(2, 240);
+
+    migrationEdit = new QPlainTextEdit(splitter);
+    migrationEdit->setReadOnly(true);
+    migrationEdit->setLineWrapMode(QPlainTextEdit::NoWrap);
+    QFont font("Monaco");
+    font.setPointSize(12);
+    migrationEdit->setFont(font);
+    migrationEdit->setVisible(false);
+
+    splitter->addWidget(differenceTree);
+    splitter->addWidget(migrationEdit);
+    mainLayout->addWidget(splitter, 1);
+
+    // Buttons
+    auto *buttonLayout = new QHBoxLayout();
+    migrationCheck = new QCheckBox("Show migration DDL", this);
+    migrationCheck->setToolTip("Statements turning the target schema into the source one");
+    connect(migrationCheck, &QCheckBox::toggled, migrationEdit, &QWidget::setVisible);
+    buttonLayout->addWidget(migrationCheck);
+    buttonLayout->addStretch();
+
+    openMigrationButton = new QPushButton("Open in SQL Editor", this);
+    connect(openMigrationButton, &QPushButton::clicked, this, [this]() {
+        emit migrationRequested(comparedOptions.targetConnection, comparedOptions.targetSchema,
+                                migrationEdit->toPlainText());
+    });
+    buttonLayout->addWidget(openMigrationButton);
+
+    auto *closeButton = new QPushButton("Close", this);
+    connect(closeButton, &QPushButton::clicked, this, &QDialog::reject);
+    buttonLayout->addWidget(closeButton);
+
+    mainLayout->addLayout(buttonLayout);
+
+    watcher = new QFutureWatcher<SchemaDiff>(this);
+    connect(watcher, &QFutureWatcher<SchemaDiff>::finished, this, &SchemaDiffDialog::showDiff);
+
+    connect(targetConnectionCombo, &QComboBox::currentTextChanged, this, &SchemaDiffDialog::updateButtons);
+    connect(targetSchemaEdit, &QLineEdit::textChanged, this, &SchemaDiffDialog::updateButtons);
+
+    updateButtons();
+}
+
+void SchemaDiffDialog::updateButtons() {
+    DatabaseConnection *target = ConnectionManager::instance().getConnection(targetConnectionCombo->currentText());
+    const bool sqliteTarget = target && target->getType() == DatabaseType::SQLite;
+    if (sqliteTarget && !targetSchemaEdit->text().isEmpty()) {
+        targetSchemaEdit->clear();
+    }
+    targetSchemaEdit->setEnabled(!sqliteTarget);
+
+    const bool sameSchema = targetConnectionCombo->currentText() == sourceConnection
+        && targetSchemaEdit->text().trimmed() == sourceSchema;
+    compareButton->setEnabled(target && !sameSchema && !watcher->isRunning());
+    openMigrationButton->setEnabled(!watcher->isRunning() && !migrationEdit->toPlainText().isEmpty());
+}
+
+void SchemaDiffDialog::runCompare() {
+    comparedOptions.sourceConnection = sourceConnection;
+    comparedOptions.sourceSchema = sourceSchema;
+    comparedOptions.targetConnection = targetConnectionCombo->currentText();
+    comparedOptions.targetSchema = targetSchemaEdit->text().trimmed();
+
+    differenceTree->clear();
+    migrationEdit->clear();
+    summaryLabel->setText("Reading both catalogs...");
+    watcher->setFuture(SchemaDiffer::start(comparedOptions));
+    updateButtons();
+}
+
+void SchemaDiffDialog::showDiff() {
+    const SchemaDiff diff = watcher->result();
+    if (!diff.success) {
+        summaryLabel->setText("Compare failed: " + diff.errorMessage);
+        updateButtons();
+        return;
+    }
+
+    const QLocale locale;
+    if (diff.differences.isEmpty()) {
+        summaryLabel->setText(QString("The schemas match: %1 relations and %2 objects compared in %3 ms.")
+            .arg(locale.toString(diff.tablesCompared), locale.toString(diff.objectsCompared))
+            .arg(diff.elapsedMs));
+    } else {
+        summaryLabel->setText(QString("%1 differences; %2 of %3 common relations changed. "
+                                      "%4 objects compared in %5 ms.")
+            .arg(locale.toString(diff.differences.size()), locale.toString(diff.tablesChanged),
+                 locale.toString(diff.tablesCompared), locale.toString(diff.objectsCompared))
+            .arg(diff.elapsedMs));
+    }
+
+    // A relation on one side only is a row of its own; the differences inside a
+    // relation on both sides are grouped under it
+    QList<QTreeWidgetItem*> items;
+    QTreeWidgetItem *group = nullptr;
+    for (const SchemaDifference &difference : diff.differences) {
+        const QString change = QString("%1 %2").arg(SchemaDiffer::kindName(difference.kind),
+                                                    SchemaDiffer::objectTypeName(difference.objectType).toLower());
+        if (difference.objectType <= SchemaDifference::Sequence) {
+            items << new QTreeWidgetItem(QStringList{difference.table, change, difference.sourceDefinition,
+                                                    difference.targetDefinition});
+            group = nullptr;
+            continue;
+        }
+        if (!group || group->text(0) != difference.table) {
+            group = new QTreeWidgetItem(QStringList{difference.table, "Changed table"});
+            items << group;
+        }
+        new QTreeWidgetItem(group, QStringList{difference.name.isEmpty() ? QString("(unnamed)") : difference.name,
+                                               change, difference.sourceDefinition, difference.targetDefinition});
+    }
+    differenceTree->addTopLevelItems(items);
+    differenceTree->expandAll();
+
+    migrationEdit->setPlainText(diff.migration.join("\n"));
+    updateButtons();
+}
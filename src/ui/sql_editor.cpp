@@ -1,9 +1,19 @@
 #include "ui/sql_editor.h"
+#include "database/connection_manager.h"
+#include "core/scratchpad.h"
+#include "core/federated_query.h"
+#include "ui/transfer_runner.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QShortcut>
 #include <QFutureWatcher>
 #include <QHeaderView>
+#include <QMenu>
+#include <QMessageBox>
+#include <QAbstractItemView>
+#include <QKeyEvent>
+#include <QScrollBar>
+#include <QtConcurrent>
 
 // SQL Syntax Highlighter
 SQLHighlighter::SQLHighlighter(QTextDocument *parent)
@@ -65,11 +75,125 @@ void SQLHighlighter::highlightBlock(const QString &text) {
     }
 }
 
+// SQL Text Edit
+SQLTextEdit::SQLTextEdit(QWidget *parent)
+    : QPlainTextEdit(parent) {
+    completionModel = new QStandardItemModel(this);
+    completer = new QCompleter(completionModel, this);
+    completer->setWidget(this);
+    // The engine already picked and ordered the rows
+    completer->setCompletionMode(QCompleter::UnfilteredPopupCompletion);
+    completer->setCaseSensitivity(Qt::CaseInsensitive);
+    completer->setMaxVisibleItems(12);
+    connect(completer, QOverload<const QString &>::of(&QCompleter::activated), this, &SQLTextEdit::insertCompletion);
+
+    // Statement boundaries before an edit stay valid
+    connect(document(), &QTextDocument::contentsChange, this, [this](int position, int, int) {
+        completionEngine.invalidateFrom(position);
+    });
+}
+
+void SQLTextEdit::keyPressEvent(QKeyEvent *event) {
+    // While the list is open, these belong to it
+    if (completer->popup()->isVisible()) {
+        switch (event->key()) {
+            case Qt::Key_Enter:
+            case Qt::Key_Return:
+            case Qt::Key_Escape:
+            case Qt::Key_Tab:
+            case Qt::Key_Backtab:
+                event->ignore();
+                return;
+            default:
+                break;
+        }
+    }
+
+    if (event->key() == Qt::Key_Space && (event->modifiers() & Qt::ControlModifier)) {
+        updateCompletions(true);
+        return;
+    }
+    QPlainTextEdit::keyPressEvent(event);
+
+    const QString typed = event->text();
+    const bool editing = !typed.isEmpty() && !(event->modifiers() & (Qt::ControlModifier | Qt::AltModifier));
+    const bool identifier = editing && (typed.at(0).isLetterOrNumber() || typed.at(0) == '_' || typed.at(0) == '.');
+    if (identifier || (editing && completer->popup()->isVisible() && event->key() == Qt::Key_Backspace)) {
+        updateCompletions(false);
+    } else {
+        completer->popup()->hide();
+    }
+}
+
+void SQLTextEdit::updateCompletions(bool explicitRequest) {
+    const QString text = toPlainText();
+    const int position = textCursor().position();
+    const int start = SqlCompleter::wordStart(text, position);
+    const bool afterDot = start > 0 && text.at(start - 1) == '.';
+    if (!explicitRequest && !afterDot && position - start < kMinPrefixLength) {
+        completer->popup()->hide();
+        return;
+    }
+
+    emit completionRequested();
+    const QList<SqlCompletion> completions = completionEngine.complete(text, position);
+    if (completions.isEmpty()) {
+        completer->popup()->hide();
+        return;
+    }
+
+    const QIcon tableIcon(":/icons/assets/icons/table.svg");
+    const QIcon viewIcon(":/icons/assets/icons/view.svg");
+    const QIcon columnIcon(":/icons/assets/icons/column.svg");
+    const QIcon schemaIcon(":/icons/assets/icons/schema.svg");
+
+    completionModel->clear();
+    for (const SqlCompletion &completion : completions) {
+        auto *item = new QStandardItem(completion.text);
+        switch (completion.kind) {
+            case SqlCompletion::Table:
+                item->setIcon(tableIcon);
+                break;
+            case SqlCompletion::View:
+                item->setIcon(viewIcon);
+                break;
+            case SqlCompletion::Column:
+                item->setIcon(columnIcon);
+                break;
+            case SqlCompletion::Schema:
+                item->setIcon(schemaIcon);
+                break;
+            default:
+                break;
+        }
+        item->setToolTip(completion.detail);
+        completionModel->appendRow(item);
+    }
+
+    QAbstractItemView *popup = completer->popup();
+    QRect rect = cursorRect();
+    rect.setWidth(popup->sizeHintForColumn(0) + popup->verticalScrollBar()->sizeHint().width());
+    completer->complete(rect);
+    popup->setCurrentIndex(completionModel->index(0, 0));
+}
+
+void SQLTextEdit::insertCompletion(const QString &completion) {
+    QTextCursor cursor = textCursor();
+    const int position = cursor.position();
+    cursor.setPosition(SqlCompleter::wordStart(toPlainText(), position));
+    cursor.setPosition(position, QTextCursor::KeepAnchor);
+    cursor.insertText(completion);
+    setTextCursor(cursor);
+}
+
 // SQL Editor
 SQLEditor::SQLEditor(QWidget *parent)
-    : QWidget(parent) {
+    : QWidget(parent), groupConcurrency(0), groupShardsDone(0), groupShardsFailed(0), catalogLoading(false) {
     setupUI();
     queryExecutor = new QueryExecutor(this);
+    fanOutExecutor = new FanOutExecutor(this);
+    connect(fanOutExecutor, &FanOutExecutor::shardFinished, this, &SQLEditor::onShardFinished);
+    connect(fanOutExecutor, &FanOutExecutor::finished, this, &SQLEditor::onGroupFinished);
 }
 
 void SQLEditor::setupUI() {
@@ -92,6 +216,18 @@ void SQLEditor::setupUI() {
     topLayout->addWidget(contextLabel);
     topLayout->addWidget(contextCombo);
     topLayout->addStretch();
+    cancelButton = new QPushButton("Cancel", this);
+    cancelButton->hide();
+
+    runToFileButton = new QPushButton("Run to File...", this);
+    runToFileButton->setToolTip("Stream the query result straight to a file");
+
+    runFileButton = new QPushButton("Run File...", this);
+    runFileButton->setToolTip("Execute an SQL script file of any size without opening it");
+
+    topLayout->addWidget(cancelButton);
+    topLayout->addWidget(runFileButton);
+    topLayout->addWidget(runToFileButton);
     topLayout->addWidget(executeButton);
 
     mainLayout->addWidget(topBar);
@@ -100,7 +236,7 @@ void SQLEditor::setupUI() {
     auto *splitter = new QSplitter(Qt::Vertical, this);
 
     // SQL Editor
-    editor = new QPlainTextEdit(this);
+    editor = new SQLTextEdit(this);
     editor->setPlaceholderText("Enter SQL query here...");
     highlighter = new SQLHighlighter(editor->document());
 
@@ -125,8 +261,19 @@ void SQLEditor::setupUI() {
     resultView->horizontalHeader()->setStretchLastSection(true);
     resultView->setAlternatingRowColors(true);
     resultView->setSelectionBehavior(QAbstractItemView::SelectRows);
+    resultView->setContextMenuPolicy(Qt::CustomContextMenu);
+
+    resultCopier = new ResultCopier(resultView, this);
+    connect(resultCopier, &ResultCopier::statusMessage, statusLabel, &QLabel::setText);
+    connect(resultView, &QTableView::customContextMenuRequested, this, &SQLEditor::showResultContextMenu);
+
+    // Per-connection latency and errors, only shown in group mode
+    shardList = new QListWidget(this);
+    shardList->setMaximumHeight(120);
+    shardList->hide();
 
     resultsLayout->addWidget(statusLabel);
+    resultsLayout->addWidget(shardList);
     resultsLayout->addWidget(resultView);
 
     splitter->addWidget(resultsWidget);
@@ -137,6 +284,14 @@ void SQLEditor::setupUI() {
 
     // Connect signals
     connect(executeButton, &QPushButton::clicked, this, &SQLEditor::executeQuery);
+    connect(cancelButton, &QPushButton::clicked, this, &SQLEditor::cancelQuery);
+    connect(runToFileButton, &QPushButton::clicked, this, &SQLEditor::runQueryToFile);
+    connect(runFileButton, &QPushButton::clicked, this, &SQLEditor::runScriptFile);
+    connect(editor, &SQLTextEdit::completionRequested, this, [this]() {
+        if (!catalogAge.isValid() || catalogAge.elapsed() > kCatalogRefreshMs) {
+            refreshCompletionCatalog();
+        }
+    });
 }
 
 void SQLEditor::setDatabaseContext(const QString &connectionName, const QString &database, const QString &schema) {
@@ -155,6 +310,68 @@ void SQLEditor::setDatabaseContext(const QString &connectionName, const QString
 
     contextCombo->clear();
     contextCombo->addItem(contextText);
+
+    refreshCompletionCatalog();
+}
+
+void SQLEditor::refreshCompletionCatalog() {
+    DatabaseConnection *connection = ConnectionManager::instance().getConnection(currentConnectionName);
+    if (!connection || !connection->isConnected() || catalogLoading) {
+        return;
+    }
+    catalogLoading = true;
+    catalogAge.start();
+
+    const DatabaseType type = connection->getType();
+    QString schema = currentSchema;
+    if (schema.isEmpty() && type == DatabaseType::MySQL) {
+        schema = currentDatabase;
+    }
+    if (schema.isEmpty()) {
+        schema = connection->defaultSchema();
+    }
+
+    // The metadata thread serves the catalog from its cache; arranging it for lookups
+    // happens on a pool thread, so typing never waits for either
+    auto *catalogWatcher = new QFutureWatcher<QList<CatalogSnapshot>>(this);
+    connect(catalogWatcher, &QFutureWatcher<QList<CatalogSnapshot>>::finished, this,
+            [this, catalogWatcher, type, schema]() {
+        const QList<CatalogSnapshot> snapshots = catalogWatcher->result();
+        catalogWatcher->deleteLater();
+
+        auto *buildWatcher = new QFutureWatcher<SqlCompletionCatalogPtr>(this);
+        connect(buildWatcher, &QFutureWatcher<SqlCompletionCatalogPtr>::finished, this,
+                [this, buildWatcher, type, schema]() {
+            editor->sqlCompleter()->setCatalog(buildWatcher->result(), type, schema);
+            catalogLoading = false;
+            buildWatcher->deleteLater();
+        });
+        buildWatcher->setFuture(QtConcurrent::run([type, snapshots]() {
+            return SqlCompletionCatalog::build(type, snapshots);
+        }));
+    });
+    catalogWatcher->setFuture(connection->fetchCatalog());
+}
+
+void SQLEditor::setQueryText(const QString &text) {
+    editor->setPlainText(text);
+}
+
+void SQLEditor::setConnectionGroup(const QStringList &connectionNames, int maxConcurrency) {
+    groupConnections = connectionNames;
+    groupConcurrency = maxConcurrency;
+    currentConnectionName = connectionNames.value(0);
+    currentDatabase.clear();
+    currentSchema.clear();
+
+    contextCombo->clear();
+    contextCombo->addItem(QString("Group: %1 connections (%2 at a time)")
+                              .arg(connectionNames.size())
+                              .arg(maxConcurrency));
+    contextCombo->setToolTip(connectionNames.join("\n"));
+    shardList->show();
+    runToFileButton->hide();
+    runFileButton->hide();
 }
 
 void SQLEditor::executeQuery() {
@@ -163,25 +380,151 @@ void SQLEditor::executeQuery() {
         return;
     }
 
+    if (!groupConnections.isEmpty()) {
+        executeGroupQuery(query);
+        return;
+    }
+
     statusLabel->setText("Executing query...");
     executeButton->setEnabled(false);
 
-    QFuture<QueryResult> future = queryExecutor->executeQuery(currentConnectionName, query);
+    QFuture<QueryResult> future;
+    if (FederatedQuery::hasReferences(query)) {
+        // @connection.relation references: pull the relations and join them locally
+        statusLabel->setText("Pulling referenced relations...");
+        runningToken = std::make_shared<CancelToken>();
+        cancelButton->show();
+        future = FederatedQuery::execute(query, runningToken);
+    } else {
+        future = queryExecutor->executeQuery(currentConnectionName, query);
+    }
 
     auto *watcher = new QFutureWatcher<QueryResult>(this);
     connect(watcher, &QFutureWatcher<QueryResult>::finished, this, [this, watcher]() {
         displayQueryResult(watcher->result());
         executeButton->setEnabled(true);
+        cancelButton->hide();
+        runningToken.reset();
         watcher->deleteLater();
     });
     watcher->setFuture(future);
 }
 
+void SQLEditor::runQueryToFile() {
+    QString query = editor->toPlainText().trimmed();
+    if (query.isEmpty()) {
+        return;
+    }
+    TransferRunner::exportQuery(this, currentConnectionName, query, "result.csv");
+}
+
+void SQLEditor::runScriptFile() {
+    TransferRunner::runScriptFile(this, currentConnectionName);
+}
+
+void SQLEditor::executeGroupQuery(const QString &query) {
+    resultModel->clear();
+    resultCopier->clear();
+    shardList->clear();
+    lastResult = QueryResult();
+
+    groupResult = QueryResult();
+    groupResult.success = true;
+    groupResult.rowCount = 0;
+    groupResult.executionTimeMs = 0;
+    groupShardsDone = 0;
+    groupShardsFailed = 0;
+
+    statusLabel->setText(QString("Running on %1 connections...").arg(groupConnections.size()));
+    executeButton->setEnabled(false);
+    cancelButton->show();
+
+    fanOutExecutor->run(groupConnections, query, groupConcurrency);
+}
+
+void SQLEditor::onShardFinished(const ShardResult &shard, const QueryResult &result) {
+    ++groupShardsDone;
+
+    QString error = shard.errorMessage;
+    if (shard.success && !groupResult.columnNames.isEmpty() && result.columnNames != groupResult.columnNames) {
+        error = "Result columns differ from the other connections";
+    }
+
+    if (!shard.success || !error.isEmpty()) {
+        ++groupShardsFailed;
+        auto *item = new QListWidgetItem(QString("%1: failed after %2 ms - %3")
+                                             .arg(shard.connectionName)
+                                             .arg(shard.latencyMs)
+                                             .arg(error), shardList);
+        item->setForeground(Qt::red);
+    } else {
+        new QListWidgetItem(QString("%1: %2 rows in %3 ms")
+                                .arg(shard.connectionName)
+                                .arg(shard.rowCount)
+                                .arg(shard.latencyMs), shardList);
+
+        // The first successful shard defines the merged layout
+        if (groupResult.columnNames.isEmpty()) {
+            groupResult.columnNames = result.columnNames;
+            resultModel->setHorizontalHeaderLabels(result.columnNames);
+        }
+
+        for (const QSqlRecord &record : result.records) {
+            QList<QStandardItem*> row;
+            for (int i = 0; i < record.count(); ++i) {
+                row.append(new QStandardItem(record.value(i).toString()));
+            }
+            resultModel->appendRow(row);
+        }
+        groupResult.records.append(result.records);
+        groupResult.rowCount += result.rowCount;
+        groupResult.executionTimeMs = qMax(groupResult.executionTimeMs, shard.latencyMs);
+    }
+
+    statusLabel->setText(QString("%1 of %2 connections done | %3 rows")
+                             .arg(groupShardsDone)
+                             .arg(groupConnections.size())
+                             .arg(groupResult.rowCount));
+}
+
+void SQLEditor::onGroupFinished() {
+    executeButton->setEnabled(true);
+    cancelButton->hide();
+
+    DatabaseConnection *conn = ConnectionManager::instance().getConnection(currentConnectionName);
+    resultCopier->setResult(groupResult, QString(), conn ? conn->getType() : DatabaseType::SQLite);
+    lastResult = groupResult;
+
+    QString status = QString("%1 rows from %2 connections | Slowest: %3 ms")
+                         .arg(groupResult.rowCount)
+                         .arg(groupShardsDone - groupShardsFailed)
+                         .arg(groupResult.executionTimeMs);
+    if (groupShardsFailed > 0) {
+        status += QString(" | %1 failed").arg(groupShardsFailed);
+    }
+    statusLabel->setText(status);
+}
+
+void SQLEditor::cancelQuery() {
+    if (fanOutExecutor->isRunning()) {
+        fanOutExecutor->cancel();
+        statusLabel->setText("Cancelling...");
+        return;
+    }
+
+    if (runningToken) {
+        runningToken->cancel();
+        statusLabel->setText("Cancelling...");
+    }
+}
+
 void SQLEditor::displayQueryResult(const QueryResult &result) {
     if (!result.success) {
         statusLabel->setText("Error: " + result.errorMessage);
         emit errorOccurred(result.errorMessage);
         resultModel->clear();
+        resultCopier->clear();
+        lastResult = QueryResult();
         return;
     }
 
@@ -201,6 +544,10 @@ void SQLEditor::displayQueryResult(const QueryResult &result) {
         resultModel->appendRow(row);
     }
 
+    DatabaseConnection *conn = ConnectionManager::instance().getConnection(currentConnectionName);
+    resultCopier->setResult(result, QString(), conn ? conn->getType() : DatabaseType::SQLite);
+    lastResult = result;
+
     // Update status
     statusLabel->setText(
         QString("%1 rows returned | Execution time: %2 ms")
@@ -208,3 +555,58 @@ void SQLEditor::displayQueryResult(const QueryResult &result) {
             .arg(result.executionTimeMs)
     );
 }
+
+void SQLEditor::showResultContextMenu(const QPoint &pos) {
+    QMenu menu(this);
+    resultCopier->addCopyActions(&menu);
+
+    menu.addSeparator();
+    QAction *scratchpadAction = menu.addAction("Open Result in Scratchpad");
+    scratchpadAction->setEnabled(!lastResult.columnNames.isEmpty());
+    connect(scratchpadAction, &QAction::triggered, this, &SQLEditor::openResultInScratchpad);
+
+    menu.exec(resultView->viewport()->mapToGlobal(pos));
+}
+
+void SQLEditor::openResultInScratchpad() {
+    if (lastResult.columnNames.isEmpty()) {
+        return;
+    }
+
+    QString error;
+    const QString scratchpadName = Scratchpad::create(&error);
+    if (scratchpadName.isEmpty()) {
+        QMessageBox::critical(this, "Scratchpad", "Failed to create scratchpad:\n" + error);
+        return;
+    }
+
+    statusLabel->setText(QString("Loading %1 rows into %2...").arg(lastResult.rowCount).arg(scratchpadName));
+
+    const QString tableName = "result";
+    const QueryResult result = lastResult;
+    const ConnectionInfo connInfo = QueryExecutor::getConnectionInfo(scratchpadName);
+
+    auto future = QtConcurrent::run([connInfo, tableName, result]() -> QString {
+        QString loadError;
+        if (!Scratchpad::loadResult(connInfo, tableName, result, &loadError)) {
+            return loadError;
+        }
+        return QString();
+    });
+
+    auto *watcher = new QFutureWatcher<QString>(this);
+    connect(watcher, &QFutureWatcher<QString>::finished, this, [this, watcher, scratchpadName, tableName]() {
+        const QString loadError = watcher->result();
+        if (loadError.isEmpty()) {
+            statusLabel->setText(QString("Result loaded into %1").arg(scratchpadName));
+            emit scratchpadReady(scratchpadName, tableName);
+        } else {
+            // No editor was opened on it, so nothing else would release it
+            ConnectionManager::instance().removeConnection(scratchpadName);
+            statusLabel->setText("Error: " + loadError);
+            emit errorOccurred(loadError);
+        }
+        watcher->deleteLater();
+    });
+    watcher->setFuture(future);
+}
@@ -1,15 +1,28 @@
 #include "ui/table_viewer.h"
+#include "database/connection_manager.h"
+#include "core/table_statistics.h"
 #include <QHeaderView>
 #include <QHBoxLayout>
 #include <QFutureWatcher>
 #include <QStackedLayout>
+#include <QMenu>
+#include <QLocale>
+#include <QSignalBlocker>
+#include <limits>
 
 TableViewer::TableViewer(QWidget *parent)
-    : QWidget(parent), currentPage(0), pageSize(1000), totalRows(0) {
+    : QWidget(parent), currentPage(0), pageSize(1000), totalRows(0),
+      estimatedRows(-1), exactRows(-1), quickPeek(false) {
     setupUI();
     queryExecutor = new QueryExecutor(this);
 }
 
+TableViewer::~TableViewer() {
+    if (countToken) {
+        countToken->cancel();
+    }
+}
+
 void TableViewer::setupUI() {
     auto *mainLayout = new QVBoxLayout(this);
     mainLayout->setContentsMargins(0, 0, 0, 0);
@@ -22,10 +35,23 @@ void TableViewer::setupUI() {
 
     infoLabel = new QLabel("No data loaded", this);
     executionTimeLabel = new QLabel("", this);
+    rowCountLabel = new QLabel("", this);
+
+    countButton = new QPushButton("Count Rows", this);
+    countButton->setToolTip("Run an exact COUNT(*) in the background");
+    connect(countButton, &QPushButton::clicked, this, &TableViewer::countRows);
+
+    peekButton = new QPushButton("Quick Peek", this);
+    peekButton->setCheckable(true);
+    peekButton->setToolTip("Show a random sample spread over the whole table");
+    connect(peekButton, &QPushButton::toggled, this, &TableViewer::setQuickPeek);
 
     infoLayout->addWidget(infoLabel);
+    infoLayout->addWidget(rowCountLabel);
     infoLayout->addStretch();
     infoLayout->addWidget(executionTimeLabel);
+    infoLayout->addWidget(peekButton);
+    infoLayout->addWidget(countButton);
 
     mainLayout->addWidget(infoBar);
 
@@ -42,6 +68,11 @@ void TableViewer::setupUI() {
     tableView->setAlternatingRowColors(true);
     tableView->setSelectionBehavior(QAbstractItemView::SelectRows);
     tableView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    tableView->setContextMenuPolicy(Qt::CustomContextMenu);
+    connect(tableView, &QTableView::customContextMenuRequested, this, &TableViewer::showContextMenu);
+    resultCopier = new ResultCopier(tableView, this);
+    // Shown until the next page replaces it with the execution time
+    connect(resultCopier, &ResultCopier::statusMessage, executionTimeLabel, &QLabel::setText);
     stackedLayout->addWidget(tableView);
 
     // Loading spinner (QML)
@@ -63,7 +94,9 @@ void TableViewer::setupUI() {
     nextButton = new QPushButton("Next", this);
     pageSpinBox = new QSpinBox(this);
     pageSpinBox->setMinimum(1);
+    pageSpinBox->setMaximum(std::numeric_limits<int>::max());
     pageLabel = new QLabel("Page:", this);
+    pageCountLabel = new QLabel("", this);
 
     connect(prevButton, &QPushButton::clicked, this, &TableViewer::previousPage);
     connect(nextButton, &QPushButton::clicked, this, &TableViewer::nextPage);
@@ -74,21 +107,63 @@ void TableViewer::setupUI() {
     paginationLayout->addStretch();
     paginationLayout->addWidget(pageLabel);
     paginationLayout->addWidget(pageSpinBox);
+    paginationLayout->addWidget(pageCountLabel);
 
     mainLayout->addWidget(paginationBar);
 }
 
 void TableViewer::loadTableData(const QString &connectionName, const QString &tableName,
                                  const QString &databaseName, const QString &schemaName) {
+    // A count still running belongs to the previous table
+    if (countToken) {
+        countToken->cancel();
+        countToken.reset();
+        countButton->setText("Count Rows");
+    }
+
     currentConnectionName = connectionName;
     currentTableName = tableName;
+    currentDatabaseName = databaseName;
+    currentSchemaName = schemaName;
     currentPage = 0;
+    estimatedRows = -1;
+    exactRows = -1;
+
+    updateRowCountLabel();
+    loadEstimatedRowCount();
+    loadPage();
+}
+
+void TableViewer::splitCurrentTable(DatabaseType type, QString *table, QString *schema) const {
+    TableStatistics::splitTableName(currentTableName, table, schema);
+    // MySQL tables opened from a database node come unqualified
+    if (schema->isEmpty() && type == DatabaseType::MySQL) {
+        *schema = currentDatabaseName;
+    }
+}
 
+void TableViewer::loadPage() {
     showLoadingSpinner();
 
-    QFuture<QueryResult> future = queryExecutor->executeTableQuery(
-        connectionName, tableName, databaseName, schemaName, pageSize, currentPage * pageSize
-    );
+    QFuture<QueryResult> future;
+    if (quickPeek) {
+        DatabaseConnection *conn = ConnectionManager::instance().getConnection(currentConnectionName);
+        const DatabaseType type = conn ? conn->getType() : DatabaseType::SQLite;
+        const ConnectionInfo connInfo = QueryExecutor::getConnectionInfo(currentConnectionName);
+        QString table;
+        QString schema;
+        splitCurrentTable(type, &table, &schema);
+        const qint64 rows = exactRows >= 0 ? exactRows : estimatedRows;
+
+        future = QtConcurrent::run([connInfo, type, table, schema, rows]() {
+            return TableStatistics::samplePeek(connInfo, type, table, schema, rows);
+        });
+    } else {
+        future = queryExecutor->executeTableQuery(
+            currentConnectionName, currentTableName, currentDatabaseName, currentSchemaName,
+            pageSize, currentPage * pageSize
+        );
+    }
 
     auto *watcher = new QFutureWatcher<QueryResult>(this);
     connect(watcher, &QFutureWatcher<QueryResult>::finished, this, [this, watcher]() {
@@ -99,6 +174,96 @@ void TableViewer::loadTableData(const QString &connectionName, const QString &ta
     watcher->setFuture(future);
 }
 
+void TableViewer::loadEstimatedRowCount() {
+    DatabaseConnection *conn = ConnectionManager::instance().getConnection(currentConnectionName);
+    const DatabaseType type = conn ? conn->getType() : DatabaseType::SQLite;
+    const ConnectionInfo connInfo = QueryExecutor::getConnectionInfo(currentConnectionName);
+    QString table;
+    QString schema;
+    splitCurrentTable(type, &table, &schema);
+
+    const QString requestedTable = currentTableName;
+    auto future = QtConcurrent::run([connInfo, type, table, schema]() {
+        return TableStatistics::estimateRowCount(connInfo, type, table, schema);
+    });
+
+    auto *watcher = new QFutureWatcher<qint64>(this);
+    connect(watcher, &QFutureWatcher<qint64>::finished, this, [this, watcher, requestedTable]() {
+        if (requestedTable == currentTableName) {
+            estimatedRows = watcher->result();
+            updateRowCountLabel();
+            updatePaginationInfo();
+        }
+        watcher->deleteLater();
+    });
+    watcher->setFuture(future);
+}
+
+void TableViewer::countRows() {
+    if (countToken) {
+        countToken->cancel();
+        rowCountLabel->setText("Cancelling count...");
+        return;
+    }
+
+    DatabaseConnection *conn = ConnectionManager::instance().getConnection(currentConnectionName);
+    const DatabaseType type = conn ? conn->getType() : DatabaseType::SQLite;
+    const ConnectionInfo connInfo = QueryExecutor::getConnectionInfo(currentConnectionName);
+    QString table;
+    QString schema;
+    splitCurrentTable(type, &table, &schema);
+
+    countToken = std::make_shared<CancelToken>();
+    const CancelTokenPtr token = countToken;
+    countButton->setText("Cancel Count");
+    rowCountLabel->setText("Counting rows...");
+
+    auto future = QtConcurrent::run([connInfo, type, table, schema, token]() {
+        return TableStatistics::exactRowCount(connInfo, type, table, schema, token);
+    });
+
+    const QString requestedConnection = currentConnectionName;
+    const QString requestedTable = currentTableName;
+    auto *watcher = new QFutureWatcher<QueryResult>(this);
+    connect(watcher, &QFutureWatcher<QueryResult>::finished, this,
+            [this, watcher, token, requestedConnection, requestedTable]() {
+        const QueryResult result = watcher->result();
+        if (token == countToken && requestedConnection == currentConnectionName
+            && requestedTable == currentTableName) {
+            countToken.reset();
+            countButton->setText("Count Rows");
+            if (result.success && !result.records.isEmpty()) {
+                exactRows = result.records.first().value(0).toLongLong();
+            } else if (!token->isCancelled()) {
+                emit errorOccurred(result.errorMessage);
+            }
+            updateRowCountLabel();
+            updatePaginationInfo();
+        }
+        watcher->deleteLater();
+    });
+    watcher->setFuture(future);
+}
+
+void TableViewer::setQuickPeek(bool enabled) {
+    quickPeek = enabled;
+    currentPage = 0;
+    if (!currentTableName.isEmpty()) {
+        loadPage();
+    }
+}
+
+void TableViewer::updateRowCountLabel() {
+    const QLocale locale;
+    if (exactRows >= 0) {
+        rowCountLabel->setText(QString("| %1 rows in table").arg(locale.toString(exactRows)));
+    } else if (estimatedRows >= 0) {
+        rowCountLabel->setText(QString("| ~%1 rows in table (estimate)").arg(locale.toString(estimatedRows)));
+    } else {
+        rowCountLabel->setText(QString());
+    }
+}
+
 void TableViewer::displayQueryResult(const QueryResult &result) {
     if (!result.success) {
         emit errorOccurred(result.errorMessage);
@@ -121,9 +286,13 @@ void TableViewer::displayQueryResult(const QueryResult &result) {
         tableModel->appendRow(row);
     }
 
+    DatabaseConnection *conn = ConnectionManager::instance().getConnection(currentConnectionName);
+    resultCopier->setResult(result, currentTableName, conn ? conn->getType() : DatabaseType::SQLite);
+
     // Update info labels
     totalRows = result.rowCount;
-    infoLabel->setText(QString("%1 rows").arg(result.rowCount));
+    infoLabel->setText(quickPeek ? QString("%1 sampled rows").arg(result.rowCount)
+                                 : QString("%1 rows").arg(result.rowCount));
     executionTimeLabel->setText(QString("Execution time: %1 ms").arg(result.executionTimeMs));
 
     updatePaginationInfo();
@@ -131,30 +300,42 @@ void TableViewer::displayQueryResult(const QueryResult &result) {
 
 void TableViewer::nextPage() {
     currentPage++;
-    loadTableData(currentConnectionName, currentTableName);
+    loadPage();
 }
 
 void TableViewer::previousPage() {
     if (currentPage > 0) {
         currentPage--;
-        loadTableData(currentConnectionName, currentTableName);
+        loadPage();
     }
 }
 
 void TableViewer::goToPage() {
     int page = pageSpinBox->value() - 1; // 0-indexed
-    if (page >= 0) {
+    if (page >= 0 && page != currentPage) {
         currentPage = page;
-        loadTableData(currentConnectionName, currentTableName);
+        loadPage();
     }
 }
 
 void TableViewer::updatePaginationInfo() {
-    prevButton->setEnabled(currentPage > 0);
-    pageSpinBox->setValue(currentPage + 1);
+    prevButton->setEnabled(!quickPeek && currentPage > 0);
+    pageSpinBox->setEnabled(!quickPeek);
+    {
+        const QSignalBlocker blocker(pageSpinBox);
+        pageSpinBox->setValue(currentPage + 1);
+    }
 
     // Enable next button if we got full page of results
-    nextButton->setEnabled(totalRows >= pageSize);
+    nextButton->setEnabled(!quickPeek && totalRows >= pageSize);
+
+    const qint64 knownRows = exactRows >= 0 ? exactRows : estimatedRows;
+    if (quickPeek || knownRows < 0) {
+        pageCountLabel->setText(QString());
+    } else {
+        const qint64 pages = qMax<qint64>(1, (knownRows + pageSize - 1) / pageSize);
+        pageCountLabel->setText(QString("of %1%2").arg(QString(exactRows >= 0 ? "" : "~")).arg(QLocale().toString(pages)));
+    }
 }
 
 void TableViewer::showLoadingSpinner() {
@@ -167,3 +348,9 @@ void TableViewer::hideLoadingSpinner() {
     loadingSpinner->hide();
     tableView->show();
 }
+
+void TableViewer::showContextMenu(const QPoint &pos) {
+    QMenu menu(this);
+    resultCopier->addCopyActions(&menu);
+    menu.exec(tableView->viewport()->mapToGlobal(pos));
+}
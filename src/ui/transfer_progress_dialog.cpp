@@ -0,0 +1,73 @@
+#include "ui/transfer_progress_dialog.h"
+#include <QFutureWatcher>
+#include <QLocale>
+
+namespace {
+constexpr int kProgressIntervalMs = 250;
+}
+
+TransferProgressDialog::TransferProgressDialog(const QString &title, const TransferProgressPtr &progress,
+                                               const CancelTokenPtr &token, QWidget *parent)
+    : QProgressDialog(title, "Cancel", 0, 0, parent), title(title), unit("rows"), progress(progress), token(token) {
+    setWindowModality(Qt::WindowModal);
+    setMinimumDuration(300);
+    setAutoClose(false);
+    setAutoReset(false);
+
+    connect(this, &QProgressDialog::canceled, this, [this]() {
+        this->token->cancel();
+        setLabelText(this->title + "\nCancelling...");
+    });
+
+    timer = new QTimer(this);
+    connect(timer, &QTimer::timeout, this, &TransferProgressDialog::updateLabel);
+}
+
+TransferProgressDialog::~TransferProgressDialog() {
+    // Nothing is left to report to, so the job shouldn't run on unattended
+    if (running) {
+        token->cancel();
+    }
+}
+
+void TransferProgressDialog::watch(const QFuture<QueryResult> &future,
+                                   std::function<void(const QueryResult &)> onFinished) {
+    elapsed.start();
+    timer->start(kProgressIntervalMs);
+    running = true;
+
+    auto *watcher = new QFutureWatcher<QueryResult>(this);
+    connect(watcher, &QFutureWatcher<QueryResult>::finished, this, [this, watcher, onFinished]() {
+        running = false;
+        timer->stop();
+        close();
+        onFinished(watcher->result());
+        deleteLater();
+    });
+    watcher->setFuture(future);
+}
+
+void TransferProgressDialog::setUnit(const QString &unit) {
+    this->unit = unit;
+}
+
+QString TransferProgressDialog::throughputText(qint64 rows, qint64 bytes, qint64 elapsedMs, const QString &unit) {
+    const double seconds = qMax<qint64>(elapsedMs, 1) / 1000.0;
+    return QString("%1 %4 | %2 %4/s | %3 MB/s")
+        .arg(QLocale().toString(rows))
+        .arg(QLocale().toString(qint64(rows / seconds)))
+        .arg(bytes / seconds / (1024.0 * 1024.0), 0, 'f', 1)
+        .arg(unit);
+}
+
+void TransferProgressDialog::updateLabel() {
+    if (wasCanceled()) {
+        return;
+    }
+    const qint64 total = progress->totalBytes;
+    if (total > 0) {
+        setMaximum(1000);
+        setValue(int(qMin<qint64>(progress->bytes, total) * 1000 / total));
+    }
+    setLabelText(title + "\n" + throughputText(progress->rows, progress->bytes, elapsed.elapsed(), unit));
+}
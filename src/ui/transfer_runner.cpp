@@ -0,0 +1,485 @@
+#include "ui/transfer_runner.h"
+#include "ui/transfer_progress_dialog.h"
+#include "core/result_exporter.h"
+#include "core/arrow_io.h"
+#include "core/csv_importer.h"
+#include "core/table_copier.h"
+#include "core/table_comparer.h"
+#include "core/schema_dumper.h"
+#include "core/script_runner.h"
+#include "core/data_generator.h"
+#include "core/sql_dialect.h"
+#include "core/table_statistics.h"
+#include "ui/import_dialog.h"
+#include "ui/copy_table_dialog.h"
+#include "ui/compare_table_dialog.h"
+#include "ui/dump_dialog.h"
+#include "ui/run_script_dialog.h"
+#include "ui/generate_data_dialog.h"
+#include "database/connection_manager.h"
+#include <QDir>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QFutureWatcher>
+#include <QInputDialog>
+#include <QLocale>
+#include <QMessageBox>
+
+namespace {
+using ExportStarter = std::function<QFuture<QueryResult>(const ConnectionInfo &, const ExportOptions &,
+                                                         const TransferProgressPtr &, const CancelTokenPtr &)>;
+
+// Asks for the file and runs the export with progress. arrowQuery is what Arrow IPC
+// files are written from; every other format goes through start, which reads in key
+// ranges when scansTable.
+void runExport(QWidget *parent, const QString &connectionName, const QString &suggestedFileName,
+               const QString &tableName, const QString &arrowQuery, bool scansTable, const ExportStarter &start) {
+    QStringList filters = {
+        "CSV Files (*.csv *.csv.gz *.csv.zst)",
+        "TSV Files (*.tsv *.tsv.gz *.tsv.zst)",
+        "JSON Lines Files (*.ndjson *.jsonl *.ndjson.gz *.ndjson.zst)",
+        "SQL Files (*.sql *.sql.gz *.sql.zst)"
+    };
+    if (ArrowIO::isAvailable()) {
+        filters << "Arrow IPC Files (*.arrow *.feather)";
+    }
+
+    const QString filePath = QFileDialog::getSaveFileName(
+        parent, "Export to File", QDir::home().filePath(suggestedFileName), filters.join(";;"));
+    if (filePath.isEmpty()) {
+        return;
+    }
+
+    DatabaseConnection *conn = ConnectionManager::instance().getConnection(connectionName);
+    if (!conn || !conn->isConnected()) {
+        QMessageBox::critical(parent, "Export Failed", "The connection is not open.");
+        return;
+    }
+
+    ExportOptions options;
+    options.filePath = filePath;
+    options.format = ResultExporter::formatForPath(filePath);
+    options.compression = CompressedFileWriter::compressionForPath(filePath);
+    options.tableName = tableName;
+    options.dialect = conn->getType();
+
+    if (!CompressedFileWriter::isAvailable(options.compression)) {
+        QMessageBox::critical(parent, "Export Failed",
+            QString("This build cannot write '%1' files.").arg(QFileInfo(filePath).suffix()));
+        return;
+    }
+
+    const ConnectionInfo connInfo = QueryExecutor::getConnectionInfo(connectionName);
+    auto progress = std::make_shared<TransferProgress>();
+    auto token = std::make_shared<CancelToken>();
+
+    const QFuture<QueryResult> future = ArrowIO::isArrowPath(filePath)
+        ? ArrowIO::startExport(connInfo, arrowQuery, filePath, progress, token)
+        : start(connInfo, options, progress, token);
+
+    QString title = QString("Exporting to %1...").arg(QFileInfo(filePath).fileName());
+    if (options.dialect == DatabaseType::MySQL && (!scansTable || ArrowIO::isArrowPath(filePath))) {
+        // QMYSQL buffers a whole result on the client before handing over the first row
+        title += "\nMySQL sends the whole result first; it has to fit in memory.";
+    }
+    auto *dialog = new TransferProgressDialog(title, progress, token, parent);
+    dialog->watch(future, [parent, progress, filePath](const QueryResult &result) {
+        if (result.success) {
+            QMessageBox::information(parent, "Export Finished",
+                QString("Exported to %1\n%2 in %3 s")
+                    .arg(QDir::toNativeSeparators(filePath),
+                         TransferProgressDialog::throughputText(result.rowCount, progress->bytes,
+                                                                result.executionTimeMs))
+                    .arg(result.executionTimeMs / 1000.0, 0, 'f', 1));
+        } else if (result.errorMessage != "Export cancelled") {
+            QMessageBox::critical(parent, "Export Failed", result.errorMessage);
+        }
+    });
+}
+} // namespace
+
+void TransferRunner::exportQuery(QWidget *parent, const QString &connectionName, const QString &query,
+                               const QString &suggestedFileName, const QString &tableName) {
+    runExport(parent, connectionName, suggestedFileName, tableName, query, false,
+              [query](const ConnectionInfo &connInfo, const ExportOptions &options,
+                      const TransferProgressPtr &progress, const CancelTokenPtr &token) {
+        return ResultExporter::start(connInfo, query, options, progress, token);
+    });
+}
+
+void TransferRunner::exportTable(QWidget *parent, const QString &connectionName, const QString &table,
+                                 const QString &schema) {
+    DatabaseConnection *conn = ConnectionManager::instance().getConnection(connectionName);
+    if (!conn || !conn->isConnected()) {
+        QMessageBox::critical(parent, "Export Failed", "The connection is not open.");
+        return;
+    }
+
+    const DatabaseType type = conn->getType();
+    const QString qualified = schema.isEmpty() ? table : schema + "." + table;
+    const QString query = QString("SELECT * FROM %1").arg(SqlDialect::qualifiedName(type, table, schema));
+    runExport(parent, connectionName, table + ".csv", table, query, true,
+              [type, qualified](const ConnectionInfo &connInfo, const ExportOptions &options,
+                                const TransferProgressPtr &progress, const CancelTokenPtr &token) {
+        return ResultExporter::startTable(connInfo, type, qualified, options, progress, token);
+    });
+}
+
+void TransferRunner::importArrowFile(QWidget *parent, const QString &connectionName, const QString &schema) {
+    if (!ArrowIO::isAvailable()) {
+        QMessageBox::critical(parent, "Import Failed", "This build has no Apache Arrow support.");
+        return;
+    }
+
+    const QString filePath = QFileDialog::getOpenFileName(
+        parent, "Import Arrow File", QDir::homePath(), "Arrow IPC Files (*.arrow *.feather *.ipc)");
+    if (filePath.isEmpty()) {
+        return;
+    }
+
+    DatabaseConnection *conn = ConnectionManager::instance().getConnection(connectionName);
+    if (!conn || !conn->isConnected()) {
+        QMessageBox::critical(parent, "Import Failed", "The connection is not open.");
+        return;
+    }
+
+    bool ok = false;
+    QString tableName = QInputDialog::getText(parent, "Import Arrow File", "Target table:",
+                                              QLineEdit::Normal, QFileInfo(filePath).baseName(), &ok).trimmed();
+    if (!ok || tableName.isEmpty()) {
+        return;
+    }
+    if (!schema.isEmpty() && !tableName.contains('.')) {
+        tableName = schema + "." + tableName;
+    }
+
+    const ConnectionInfo connInfo = QueryExecutor::getConnectionInfo(connectionName);
+    auto progress = std::make_shared<TransferProgress>();
+    auto token = std::make_shared<CancelToken>();
+
+    auto *dialog = new TransferProgressDialog(
+        QString("Importing %1 into %2...").arg(QFileInfo(filePath).fileName(), tableName), progress, token, parent);
+    dialog->watch(ArrowIO::startImport(connInfo, conn->getType(), filePath, tableName, progress, token),
+                  [parent, progress, tableName](const QueryResult &result) {
+        if (result.success) {
+            QMessageBox::information(parent, "Import Finished",
+                QString("Imported into %1\n%2")
+                    .arg(tableName,
+                         TransferProgressDialog::throughputText(result.rowCount, progress->bytes,
+                                                                result.executionTimeMs)));
+        } else if (result.errorMessage != "Import cancelled") {
+            QMessageBox::critical(parent, "Import Failed", result.errorMessage);
+        }
+    });
+}
+
+void TransferRunner::importCsvFile(QWidget *parent, const QString &connectionName, const QString &schema) {
+    DatabaseConnection *conn = ConnectionManager::instance().getConnection(connectionName);
+    if (!conn || !conn->isConnected()) {
+        QMessageBox::critical(parent, "Import Failed", "The connection is not open.");
+        return;
+    }
+
+    ImportDialog dialog(schema, parent);
+    if (dialog.exec() != QDialog::Accepted) {
+        return;
+    }
+    const CsvImportOptions options = dialog.getImportOptions();
+
+    const ConnectionInfo connInfo = QueryExecutor::getConnectionInfo(connectionName);
+    auto progress = std::make_shared<TransferProgress>();
+    auto token = std::make_shared<CancelToken>();
+
+    auto *progressDialog = new TransferProgressDialog(
+        QString("Importing %1 into %2...").arg(QFileInfo(options.filePath).fileName(), options.tableName),
+        progress, token, parent);
+    progressDialog->watch(CsvImporter::start(connInfo, conn->getType(), options, progress, token),
+                          [parent, progress, options](const QueryResult &result) {
+        if (result.success) {
+            QMessageBox::information(parent, "Import Finished",
+                QString("Imported into %1\n%2")
+                    .arg(options.tableName,
+                         TransferProgressDialog::throughputText(result.rowCount, progress->bytes,
+                                                                result.executionTimeMs)));
+        } else if (result.errorMessage != "Import cancelled") {
+            QMessageBox::critical(parent, "Import Failed",
+                result.rowCount > 0
+                    ? QString("%1\n\n%2 rows were committed before the error.")
+                          .arg(result.errorMessage).arg(result.rowCount)
+                    : QString("%1\n\nNo rows were loaded.").arg(result.errorMessage));
+        }
+    });
+}
+
+void TransferRunner::copyTable(QWidget *parent, const QString &connectionName, const QString &table) {
+    DatabaseConnection *conn = ConnectionManager::instance().getConnection(connectionName);
+    if (!conn || !conn->isConnected()) {
+        QMessageBox::critical(parent, "Copy Failed", "The connection is not open.");
+        return;
+    }
+
+    CopyTableDialog dialog(connectionName, table, parent);
+    if (dialog.exec() != QDialog::Accepted) {
+        return;
+    }
+    const TableCopyOptions options = dialog.getCopyOptions();
+
+    auto progress = std::make_shared<TransferProgress>();
+    auto token = std::make_shared<CancelToken>();
+
+    auto *progressDialog = new TransferProgressDialog(
+        QString("Copying %1 to %2.%3...").arg(table, options.targetConnection, options.targetTable),
+        progress, token, parent);
+    progressDialog->watch(TableCopier::start(options, progress, token),
+                          [parent, progress, options](const QueryResult &result) {
+        if (result.success) {
+            QMessageBox::information(parent, "Copy Finished",
+                QString("Copied into %1 on %2\n%3")
+                    .arg(options.targetTable, options.targetConnection,
+                         TransferProgressDialog::throughputText(result.rowCount, progress->bytes,
+                                                                result.executionTimeMs)));
+        } else if (result.errorMessage != "Copy cancelled") {
+            QMessageBox::critical(parent, "Copy Failed",
+                QString("%1\n\n%2 rows were committed before the error. Tables with a single-column "
+                        "primary key can resume from the last committed key.")
+                    .arg(result.errorMessage)
+                    .arg(result.rowCount));
+        }
+    });
+}
+
+void TransferRunner::compareTable(QWidget *parent, const QString &connectionName, const QString &table) {
+    DatabaseConnection *conn = ConnectionManager::instance().getConnection(connectionName);
+    if (!conn || !conn->isConnected()) {
+        QMessageBox::critical(parent, "Compare Failed", "The connection is not open.");
+        return;
+    }
+
+    CompareTableDialog dialog(connectionName, table, parent);
+    if (dialog.exec() != QDialog::Accepted) {
+        return;
+    }
+    const TableCompareOptions options = dialog.getCompareOptions();
+
+    auto progress = std::make_shared<TransferProgress>();
+    auto report = std::make_shared<TableCompareReport>();
+    auto token = std::make_shared<CancelToken>();
+
+    auto *progressDialog = new TransferProgressDialog(
+        QString("Comparing %1 with %2.%3...").arg(table, options.targetConnection, options.targetTable),
+        progress, token, parent);
+    progressDialog->watch(TableComparer::start(options, progress, report, token),
+                          [parent, progress, report, options, table](const QueryResult &result) {
+        if (!result.success) {
+            if (result.errorMessage != "Compare cancelled") {
+                QMessageBox::critical(parent, "Compare Failed", result.errorMessage);
+            }
+            return;
+        }
+
+        const QString summary = QString("%1\n%2 of %3 key ranges differed%4.")
+            .arg(TransferProgressDialog::throughputText(result.rowCount, progress->bytes, result.executionTimeMs))
+            .arg(report->mismatchedChunks.load())
+            .arg(report->chunksCompared.load())
+            .arg(report->serverChecksums ? QString() : QString(" (rows hashed locally)"));
+        const qint64 differences = report->differenceCount;
+        if (differences == 0) {
+            QMessageBox::information(parent, "Tables Match",
+                QString("%1 on %2 matches %3 on %4\n%5")
+                    .arg(table, options.sourceConnection, options.targetTable, options.targetConnection, summary));
+            return;
+        }
+
+        QStringList lines;
+        for (const RowDifference &difference : report->differences.mid(0, 20)) {
+            lines << QString("%1: %2").arg(difference.key.toString(), TableComparer::kindName(difference.kind));
+        }
+        QMessageBox::warning(parent, "Tables Differ",
+            QString("%1 rows differ between %2 and %3 on %4.\n%5\n\nFirst differences by key:\n%6")
+                .arg(QLocale().toString(differences))
+                .arg(table, options.targetTable, options.targetConnection, summary)
+                .arg(lines.join("\n")));
+    });
+}
+
+void TransferRunner::generateData(QWidget *parent, const QString &connectionName, const QString &table) {
+    DatabaseConnection *conn = ConnectionManager::instance().getConnection(connectionName);
+    if (!conn || !conn->isConnected()) {
+        QMessageBox::critical(parent, "Generation Failed", "The connection is not open.");
+        return;
+    }
+
+    // The suggestions read keys and current maxima, so they are worked out off the GUI
+    // thread; the dialog opens once they are in
+    QString name;
+    QString schema;
+    TableStatistics::splitTableName(table, &name, &schema);
+    const DatabaseType type = conn->getType();
+    const ConnectionInfo connInfo = QueryExecutor::getConnectionInfo(connectionName);
+    using SpecsResult = QPair<QList<ColumnGeneratorSpec>, QString>;
+    auto *watcher = new QFutureWatcher<SpecsResult>(parent);
+    QObject::connect(watcher, &QFutureWatcher<SpecsResult>::finished, parent,
+                     [parent, watcher, connInfo, type, table]() {
+        watcher->deleteLater();
+        const SpecsResult specs = watcher->result();
+        if (specs.first.isEmpty()) {
+            QMessageBox::critical(parent, "Generation Failed", specs.second);
+            return;
+        }
+
+        GenerateDataDialog dialog(type, table, specs.first, parent);
+        if (dialog.exec() != QDialog::Accepted) {
+            return;
+        }
+        const DataGeneratorOptions options = dialog.getGeneratorOptions();
+
+        auto progress = std::make_shared<TransferProgress>();
+        auto token = std::make_shared<CancelToken>();
+
+        auto *progressDialog = new TransferProgressDialog(
+            QString("Generating %1 rows for %2...").arg(QLocale().toString(options.rowCount), table),
+            progress, token, parent);
+        progressDialog->watch(DataGenerator::start(connInfo, type, options, progress, token),
+                              [parent, progress, table](const QueryResult &result) {
+            if (result.success) {
+                QMessageBox::information(parent, "Generation Finished",
+                    QString("Generated rows in %1\n%2")
+                        .arg(table,
+                             TransferProgressDialog::throughputText(result.rowCount, progress->bytes,
+                                                                    result.executionTimeMs)));
+            } else if (result.errorMessage != "Generation cancelled") {
+                QMessageBox::critical(parent, "Generation Failed",
+                    QString("%1\n\n%2 rows were committed before the error.")
+                        .arg(result.errorMessage)
+                        .arg(result.rowCount));
+            }
+        });
+    });
+    watcher->setFuture(DataGenerator::startDefaultSpecs(connInfo, type, table, conn->fetchIndexes(schema, name)));
+}
+
+void TransferRunner::runScriptFile(QWidget *parent, const QString &connectionName) {
+    DatabaseConnection *conn = ConnectionManager::instance().getConnection(connectionName);
+    if (!conn || !conn->isConnected()) {
+        QMessageBox::critical(parent, "Run Failed", "The connection is not open.");
+        return;
+    }
+
+    RunScriptDialog dialog(parent);
+    if (dialog.exec() != QDialog::Accepted) {
+        return;
+    }
+    const ScriptRunOptions options = dialog.getRunOptions();
+
+    const ConnectionInfo connInfo = QueryExecutor::getConnectionInfo(connectionName);
+    auto progress = std::make_shared<TransferProgress>();
+    auto report = std::make_shared<ScriptRunReport>();
+    auto token = std::make_shared<CancelToken>();
+
+    auto *progressDialog = new TransferProgressDialog(
+        QString("Running %1...").arg(QFileInfo(options.filePath).fileName()), progress, token, parent);
+    progressDialog->setUnit("statements");
+    progressDialog->watch(ScriptRunner::start(connInfo, conn->getType(), options, progress, report, token),
+                          [parent, progress, report, options](const QueryResult &result) {
+        const qint64 resumeOffset = report->resumeOffset;
+        RunScriptDialog::rememberResumeOffset(options.filePath, result.success ? 0 : resumeOffset);
+
+        const QString summary = TransferProgressDialog::throughputText(result.rowCount, progress->bytes,
+                                                                       result.executionTimeMs, "statements");
+        QString details;
+        if (report->failedStatements > 0) {
+            details = QString("\n\n%1 statements failed. First errors:\n\n%2")
+                          .arg(report->failedStatements)
+                          .arg(report->errors.mid(0, 5).join("\n\n"));
+        }
+
+        if (result.success) {
+            QMessageBox::information(parent, "Script Finished",
+                QString("Ran %1\n%2%3").arg(QFileInfo(options.filePath).fileName(), summary, details));
+        } else if (result.errorMessage == "Script cancelled") {
+            QMessageBox::information(parent, "Script Cancelled",
+                QString("Everything before byte %1 is committed. Run the file again to resume there.")
+                    .arg(resumeOffset));
+        } else {
+            QMessageBox::critical(parent, "Script Failed",
+                QString("%1\n\nEverything before byte %2 is committed. Run the file again to resume there.%3")
+                    .arg(result.errorMessage)
+                    .arg(resumeOffset)
+                    .arg(report->failedStatements > 1 ? details : QString()));
+        }
+    });
+}
+
+void TransferRunner::dumpSchema(QWidget *parent, const QString &connectionName, const QString &database,
+                                const QString &schema) {
+    DatabaseConnection *conn = ConnectionManager::instance().getConnection(connectionName);
+    if (!conn || !conn->isConnected()) {
+        QMessageBox::critical(parent, "Dump Failed", "The connection is not open.");
+        return;
+    }
+
+    // Asks for the options and dumps schemas
+    const DatabaseType type = conn->getType();
+    auto runDump = [parent, connectionName, type](const QStringList &schemas) {
+        if (type != DatabaseType::SQLite && schemas.isEmpty()) {
+            QMessageBox::information(parent, "Dump", "There is nothing to dump on this connection.");
+            return;
+        }
+
+        DumpDialog dialog(type, schemas, schemas.size() == 1 ? schemas.first() : connectionName, parent);
+        if (dialog.exec() != QDialog::Accepted) {
+            return;
+        }
+        const DumpOptions options = dialog.getDumpOptions();
+
+        const ConnectionInfo connInfo = QueryExecutor::getConnectionInfo(connectionName);
+        auto progress = std::make_shared<TransferProgress>();
+        auto token = std::make_shared<CancelToken>();
+
+        auto *progressDialog = new TransferProgressDialog(
+            QString("Dumping to %1...").arg(QFileInfo(options.outputPath).fileName()), progress, token, parent);
+        progressDialog->watch(SchemaDumper::start(connInfo, type, options, progress, token),
+                              [parent, progress, options](const QueryResult &result) {
+            if (result.success) {
+                QMessageBox::information(parent, "Dump Finished",
+                    QString("Dumped to %1\n%2 in %3 s")
+                        .arg(QDir::toNativeSeparators(options.outputPath),
+                             TransferProgressDialog::throughputText(result.rowCount, progress->bytes,
+                                                                    result.executionTimeMs))
+                        .arg(result.executionTimeMs / 1000.0, 0, 'f', 1));
+            } else if (result.errorMessage != "Dump cancelled") {
+                QMessageBox::critical(parent, "Dump Failed", result.errorMessage);
+            }
+        });
+    };
+
+    if (!schema.isEmpty()) {
+        runDump({schema});
+        return;
+    }
+    if (type == DatabaseType::MySQL && !database.isEmpty()) {
+        runDump({database});
+        return;
+    }
+    if (type == DatabaseType::SQLite) {
+        runDump({});
+        return;
+    }
+
+    // Listing the schemas is a catalog query; don't wait for it on the GUI thread
+    auto *watcher = new QFutureWatcher<QStringList>(parent);
+    QObject::connect(watcher, &QFutureWatcher<QStringList>::finished, parent, [watcher, type, runDump]() {
+        watcher->deleteLater();
+        QStringList schemas;
+        for (const QString &name : watcher->result()) {
+            const bool system = type == DatabaseType::MySQL
+                ? QStringList{"information_schema", "mysql", "performance_schema", "sys"}.contains(name)
+                : name == "information_schema" || name.startsWith("pg_");
+            if (!system) {
+                schemas << name;
+            }
+        }
+        runDump(schemas);
+    });
+    watcher->setFuture(type == DatabaseType::MySQL ? conn->fetchDatabases() : conn->fetchSchemas(database));
+}